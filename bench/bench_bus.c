@@ -0,0 +1,114 @@
+// Multi-bus benchmark: time for one sweep of every sensor when the same
+// sensors are spread over 1-8 I2C buses, each with its own thread. The buses
+// are fake adapters that sleep for the wire time of each transfer at
+// 100 kHz, so sweeps on separate buses overlap the way real adapters do.
+// Pass --json for machine-readable output.
+#include "../src/sensor.h"
+#include "../src/latency.h"
+#include "bench_report.h"
+#include <stdio.h>
+#include <pthread.h>
+
+#define BENCH_SENSORS 16
+#define BENCH_ROUNDS 100
+#define BENCH_CLOCK_HZ 100000
+
+static bench_report_t report;
+static latency_hist_t hist;
+
+typedef struct {
+    i2c_fake_t fake;
+    i2c_bus_t bus;
+    sensor_due_t due[BENCH_SENSORS];
+    int count;
+    pthread_t tid;
+} bus_worker_t;
+
+static sensor_config_t sensors[BENCH_SENSORS];
+static bus_worker_t workers[CONFIG_MAX_BUSES];
+static pthread_barrier_t barrier;
+static int failures;
+
+static void *worker_main(void *arg) {
+    bus_worker_t *w = arg;
+    float temps[BENCH_SENSORS];
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        pthread_barrier_wait(&barrier);
+        sensor_read_tmp102_sweep(&w->bus, w->due, w->count, temps);
+        for (int i = 0; i < w->count; i++) {
+            if (temps[i] != 25.25f) {
+                __atomic_fetch_add(&failures, 1, __ATOMIC_RELAXED);
+            }
+        }
+        pthread_barrier_wait(&barrier);
+    }
+    return NULL;
+}
+
+static void bench_buses(int buses, double *one_bus_ms) {
+    const uint8_t temp[2] = { 0x19, 0x40 };   // 25.25 °C
+
+    // Sensor i goes on bus i % buses
+    for (int b = 0; b < buses; b++) {
+        bus_worker_t *w = &workers[b];
+        i2c_fake_init(&w->fake);
+        w->fake.clock_hz = BENCH_CLOCK_HZ;
+        i2c_bus_init(&w->bus, "fake", &i2c_fake_backend, &w->fake);
+        w->count = 0;
+    }
+    for (int i = 0; i < BENCH_SENSORS; i++) {
+        bus_worker_t *w = &workers[i % buses];
+        sensors[i] = (sensor_config_t){ .id = i + 1, .address = 0x48 + i / buses,
+                                        .interval_ms = 1000, .bus = i % buses };
+        i2c_fake_set_register(&w->fake, (uint16_t)sensors[i].address, 0x00, temp, 2);
+        w->due[w->count++] = (sensor_due_t){ .sensor = &sensors[i] };
+    }
+
+    failures = 0;
+    latency_hist_reset(&hist);
+    pthread_barrier_init(&barrier, NULL, (unsigned)buses + 1);
+    for (int b = 0; b < buses; b++) {
+        pthread_create(&workers[b].tid, NULL, worker_main, &workers[b]);
+    }
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        pthread_barrier_wait(&barrier);
+        uint64_t start = latency_now_ns();
+        pthread_barrier_wait(&barrier);
+        latency_hist_record(&hist, latency_now_ns() - start);
+    }
+    for (int b = 0; b < buses; b++) {
+        pthread_join(workers[b].tid, NULL);
+        i2c_bus_destroy(&workers[b].bus);
+    }
+    pthread_barrier_destroy(&barrier);
+
+    latency_summary_t summary;
+    latency_hist_summary(&hist, &summary);
+    double p50_ms = summary.p50_ns / 1e6;
+    if (buses == 1) {
+        *one_bus_ms = p50_ms;
+    }
+    double speedup = *one_bus_ms / p50_ms;
+
+    bench_report_text(&report, "%d bus%s  %2d sensors/bus  sweep p50 %.2f ms  p99 %.2f ms  "
+                      "speedup %.2fx  failures %d\n",
+                      buses, buses == 1 ? " " : "es", BENCH_SENSORS / buses, p50_ms,
+                      summary.p99_ns / 1e6, speedup, failures);
+    bench_report_result(&report, "\"buses\":%d,\"sensors\":%d,\"rounds\":%d,\"sweep_p50_ns\":%llu,"
+                        "\"sweep_p99_ns\":%llu,\"speedup\":%.2f,\"failures\":%d",
+                        buses, BENCH_SENSORS, BENCH_ROUNDS, (unsigned long long)summary.p50_ns,
+                        (unsigned long long)summary.p99_ns, speedup, failures);
+}
+
+int main(int argc, char **argv) {
+    bench_report_begin(&report, stdout, argc, argv, "bus");
+    bench_report_text(&report, "=== Multi-Bus Sweep Benchmark (%d sensors, fake buses at %d kHz) ===\n",
+                      BENCH_SENSORS, BENCH_CLOCK_HZ / 1000);
+    double one_bus_ms = 0;
+    const int bus_counts[] = { 1, 2, 4, 8 };
+    for (int i = 0; i < 4; i++) {
+        bench_buses(bus_counts[i], &one_bus_ms);
+    }
+    bench_report_end(&report);
+    return 0;
+}
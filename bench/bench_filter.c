@@ -0,0 +1,79 @@
+// Filter benchmark: cost per sample of each filter stage and of a full chain,
+// fed a synthetic 1 kHz trace (slow drift, quantized like a TMP102, with a
+// glitch every 500 samples). Pass --json for machine-readable output.
+#include "../src/filter.h"
+#include "../src/latency.h"
+#include "bench_report.h"
+#include <stdio.h>
+#include <stdint.h>
+
+#define BENCH_SAMPLES 10000000
+#define TRACE_LEN 4096
+
+static float trace[TRACE_LEN];
+
+static void make_trace(void) {
+    uint32_t seed = 12345;
+    for (int i = 0; i < TRACE_LEN; i++) {
+        seed = seed * 1103515245u + 12345u;
+        float noise = (float)((seed >> 16) % 3) - 1.0f;           // -1, 0 or +1 LSB
+        float level = 22.0f + (float)i / TRACE_LEN + noise * 0.0625f;
+        trace[i] = (float)(int)(level * 16) / 16;                 // 1/16 °C steps
+        if (i % 500 == 250) {
+            trace[i] = i % 1000 == 250 ? 0.0f : 127.9375f;
+        }
+    }
+}
+
+static void bench_chain(bench_report_t *report, const char *name, const filter_spec_t *specs,
+                        int count) {
+    filter_chain_t chain;
+    filter_chain_init(&chain, specs, count);
+
+    int rejected = 0;
+    double checksum = 0;
+    uint64_t start = latency_now_ns();
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        float value = trace[i % TRACE_LEN];
+        if (filter_chain_apply(&chain, (uint64_t)i, &value) != 0) {
+            rejected++;
+        } else {
+            checksum += value;
+        }
+    }
+    double elapsed = (latency_now_ns() - start) / 1e9;
+    double ns = elapsed * 1e9 / BENCH_SAMPLES;
+
+    bench_report_text(report, "%-26s  %.1f ns/sample  %.1fM samples/s  rejected %d  (checksum %.0f)\n",
+                      name, ns, BENCH_SAMPLES / elapsed / 1e6, rejected, checksum);
+    bench_report_result(report, "\"chain\":\"%s\",\"samples\":%d,\"ns_per_sample\":%.2f,"
+                        "\"samples_per_sec\":%.0f,\"rejected\":%d",
+                        name, BENCH_SAMPLES, ns, BENCH_SAMPLES / elapsed, rejected);
+}
+
+int main(int argc, char **argv) {
+    bench_report_t report;
+    bench_report_begin(&report, stdout, argc, argv, "filter");
+    bench_report_text(&report, "=== Filter Chain Benchmark (%d samples per chain) ===\n",
+                      BENCH_SAMPLES);
+    make_trace();
+
+    const filter_spec_t median5 = { .type = FILTER_MEDIAN, .param = 5 };
+    const filter_spec_t median15 = { .type = FILTER_MEDIAN, .param = 15 };
+    const filter_spec_t median31 = { .type = FILTER_MEDIAN, .param = CONFIG_FILTER_MEDIAN_MAX };
+    const filter_spec_t ewma = { .type = FILTER_EWMA, .param = 0.3f };
+    const filter_spec_t spike = { .type = FILTER_SPIKE, .param = 1.0f };
+    const filter_spec_t slew = { .type = FILTER_SLEW, .param = 1.0f };
+    const filter_spec_t full[] = { spike, median5, ewma, slew };
+
+    bench_chain(&report, "none", NULL, 0);
+    bench_chain(&report, "median:5", &median5, 1);
+    bench_chain(&report, "median:15", &median15, 1);
+    bench_chain(&report, "median:31", &median31, 1);
+    bench_chain(&report, "ewma:0.3", &ewma, 1);
+    bench_chain(&report, "spike:1", &spike, 1);
+    bench_chain(&report, "slew:1", &slew, 1);
+    bench_chain(&report, "spike,median:5,ewma,slew", full, 4);
+    bench_report_end(&report);
+    return 0;
+}
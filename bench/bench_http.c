@@ -0,0 +1,246 @@
+// HTTP benchmark: runs network_thread on a loopback port and drives it with
+// 1, 10 and 100 concurrent clients polling /json, once over keep-alive
+// connections and once with a new connection per request (the old
+// Connection: close behaviour). Reports requests/s, p50/p99 latency and the
+// server thread's CPU time per request. Pass --json for machine-readable output.
+#include "../src/network.h"
+#include "../src/utils.h"
+#include "../src/config.h"
+#include "bench_report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#define RUN_SECONDS 2.0
+
+typedef struct {
+    int keep_alive;
+    double *latencies;      // Seconds per request
+    long count;
+    long capacity;
+    long errors;
+} client_t;
+
+static int bench_port;
+static clockid_t server_clock;
+static atomic_int clients_stop;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Pick a free loopback port for the server
+static int find_free_port(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t len = sizeof(addr);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        getsockname(fd, (struct sockaddr *)&addr, &len) != 0) {
+        return -1;
+    }
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+static int connect_server(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(bench_port),
+                                .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// Send one request and read the whole response. Returns 0 on success.
+static int do_request(int fd, int keep_alive) {
+    static const char keep_req[] = "GET /json HTTP/1.1\r\nHost: bench\r\n\r\n";
+    static const char close_req[] = "GET /json HTTP/1.1\r\nHost: bench\r\nConnection: close\r\n\r\n";
+    const char *req = keep_alive ? keep_req : close_req;
+    size_t req_len = keep_alive ? sizeof(keep_req) - 1 : sizeof(close_req) - 1;
+    if (write(fd, req, req_len) != (ssize_t)req_len) {
+        return -1;
+    }
+
+    char buf[4096];
+    size_t len = 0;
+    long body_len = -1;
+    size_t head_len = 0;
+    while (body_len < 0 || len < head_len + (size_t)body_len) {
+        ssize_t n = read(fd, buf + len, sizeof(buf) - len - 1);
+        if (n <= 0) return -1;
+        len += (size_t)n;
+        buf[len] = '\0';
+        if (body_len < 0) {
+            char *end = strstr(buf, "\r\n\r\n");
+            char *cl = strstr(buf, "Content-Length:");
+            if (end && cl) {
+                head_len = (size_t)(end + 4 - buf);
+                body_len = strtol(cl + 15, NULL, 10);
+            }
+        }
+    }
+    return 0;
+}
+
+static void *client_thread(void *arg) {
+    client_t *c = arg;
+    int fd = -1;
+    while (!atomic_load(&clients_stop)) {
+        // Latency includes the TCP handshake whenever a request needs a new connection
+        double start = now_sec();
+        if (fd < 0 && (fd = connect_server()) < 0) {
+            c->errors++;
+            usleep(1000);
+            continue;
+        }
+        int rc = do_request(fd, c->keep_alive);
+        double latency = now_sec() - start;
+        if (!c->keep_alive || rc != 0) {
+            close(fd);
+            fd = -1;
+        }
+        if (rc != 0) {
+            c->errors++;
+            continue;
+        }
+        if (c->count == c->capacity) {
+            c->capacity = c->capacity ? c->capacity * 2 : 4096;
+            c->latencies = realloc(c->latencies, (size_t)c->capacity * sizeof(double));
+        }
+        c->latencies[c->count++] = latency;
+    }
+    if (fd >= 0) close(fd);
+    return NULL;
+}
+
+static double server_cpu_sec(void) {
+    struct timespec ts;
+    clock_gettime(server_clock, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void run(bench_report_t *report, int connections, int keep_alive) {
+    client_t *clients = calloc((size_t)connections, sizeof(client_t));
+    pthread_t *tids = calloc((size_t)connections, sizeof(pthread_t));
+    atomic_store(&clients_stop, 0);
+
+    double start = now_sec();
+    double cpu_start = server_cpu_sec();
+    for (int i = 0; i < connections; i++) {
+        clients[i].keep_alive = keep_alive;
+        pthread_create(&tids[i], NULL, client_thread, &clients[i]);
+    }
+    usleep((useconds_t)(RUN_SECONDS * 1e6));
+    atomic_store(&clients_stop, 1);
+    for (int i = 0; i < connections; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    double elapsed = now_sec() - start;
+    double server_cpu = server_cpu_sec() - cpu_start;
+
+    long total = 0, errors = 0;
+    for (int i = 0; i < connections; i++) {
+        total += clients[i].count;
+        errors += clients[i].errors;
+    }
+    double *all = malloc((size_t)(total ? total : 1) * sizeof(double));
+    long k = 0;
+    for (int i = 0; i < connections; i++) {
+        memcpy(all + k, clients[i].latencies, (size_t)clients[i].count * sizeof(double));
+        k += clients[i].count;
+        free(clients[i].latencies);
+    }
+    qsort(all, (size_t)total, sizeof(double), compare_double);
+    double p50 = total ? all[total / 2] : 0;
+    double p99 = total ? all[(long)(total * 0.99)] : 0;
+
+    double server_us = total ? server_cpu / total * 1e6 : 0.0;
+    bench_report_text(report, "%-10s conns=%-4d  %8.0f req/s  p50=%7.1fus  p99=%7.1fus  server=%5.2fus/req  errors=%ld\n",
+                      keep_alive ? "keep-alive" : "close", connections, total / elapsed,
+                      p50 * 1e6, p99 * 1e6, server_us, errors);
+    bench_report_result(report, "\"mode\":\"%s\",\"connections\":%d,\"requests_per_sec\":%.0f,"
+                        "\"p50_us\":%.1f,\"p99_us\":%.1f,\"server_us_per_request\":%.2f,\"errors\":%ld",
+                        keep_alive ? "keep-alive" : "close", connections, total / elapsed,
+                        p50 * 1e6, p99 * 1e6, server_us, errors);
+
+    free(all);
+    free(clients);
+    free(tids);
+}
+
+int main(int argc, char **argv) {
+    config_load_defaults();
+    bench_port = find_free_port();
+    if (bench_port < 0) {
+        perror("Finding a free port");
+        return 1;
+    }
+    g_config.network_port = bench_port;
+    g_config.network_backlog = 256;
+    g_config.network_max_connections = 256;
+
+    // Serve a realistic /json body
+    latest_reading_t latest = { .time_str = "2025-01-01 12:00:00", .average = 23.875f,
+                                .sensor_count = 2, .sensors = { 23.5f, 24.25f } };
+    latest_reading_publish(&latest);
+
+    // The server logs to stdout; keep results on the real stdout only
+    FILE *out = fdopen(dup(STDOUT_FILENO), "w");
+    int devnull = open("/dev/null", O_WRONLY);
+    if (!out || devnull < 0) {
+        perror("Redirecting output");
+        return 1;
+    }
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+
+    init_utils();
+    pthread_t server_tid;
+    pthread_create(&server_tid, NULL, network_thread, NULL);
+    pthread_getcpuclockid(server_tid, &server_clock);
+    for (int tries = 0; tries < 100; tries++) {
+        int fd = connect_server();
+        if (fd >= 0) {
+            close(fd);
+            break;
+        }
+        usleep(10000);
+    }
+
+    bench_report_t report;
+    bench_report_begin(&report, out, argc, argv, "http");
+    bench_report_text(&report, "=== HTTP Benchmark (GET /json, %.0fs per run) ===\n", RUN_SECONDS);
+    const int levels[] = { 1, 10, 100 };
+    for (int i = 0; i < 3; i++) {
+        run(&report, levels[i], 1);
+    }
+    for (int i = 0; i < 3; i++) {
+        run(&report, levels[i], 0);
+    }
+    bench_report_end(&report);
+
+    set_exit_flag();
+    network_wakeup();
+    pthread_join(server_tid, NULL);
+    fclose(out);
+    return 0;
+}
@@ -0,0 +1,156 @@
+// I2C read benchmark: system calls and latency per TMP102 sample when the
+// device is opened, addressed, written, read and closed for every sample vs.
+// one combined I2C_RDWR transaction on a persistent handle, and per sweep of
+// 1-21 sensors when each sensor gets its own transfer vs. one batched
+// transfer for the whole sweep. Runs against the fake backend, whose every
+// operation is a real system call on /dev/null. Pass --json for
+// machine-readable output.
+#include "../src/i2c_bus.h"
+#include "../src/latency.h"
+#include "bench_report.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+#define BENCH_SAMPLES 200000
+#define BENCH_SWEEPS 50000
+#define TMP102_ADDRESS 0x48
+
+static bench_report_t report;
+static latency_hist_t hist;
+
+// The old per-sample sequence: open, I2C_SLAVE, write the register pointer,
+// read two bytes, close
+static int legacy_read(i2c_bus_t *bus, uint8_t *data) {
+    uint8_t reg = 0x00;
+    struct i2c_msg write_msg = { .addr = TMP102_ADDRESS, .flags = 0, .len = 1, .buf = &reg };
+    struct i2c_msg read_msg = { .addr = TMP102_ADDRESS, .flags = I2C_M_RD, .len = 2, .buf = data };
+
+    if (bus->backend->open(bus) != 0) {
+        return -1;
+    }
+    // /dev/null rejects the ioctl, but the kernel crossing is what counts
+    bus->stats.syscalls++;
+    (void)ioctl(bus->fd, I2C_SLAVE, TMP102_ADDRESS);
+    int rc = bus->backend->transfer(bus, &write_msg, 1);
+    if (rc == 0) {
+        rc = bus->backend->transfer(bus, &read_msg, 1);
+    }
+    bus->backend->close(bus);
+    bus->fd = -1;
+    return rc;
+}
+
+static int persistent_read(i2c_bus_t *bus, uint8_t *data) {
+    return i2c_bus_read_register(bus, TMP102_ADDRESS, 0x00, data, 2);
+}
+
+static void bench_mode(const char *name, int (*read_fn)(i2c_bus_t *, uint8_t *)) {
+    static i2c_fake_t fake;
+    i2c_bus_t bus;
+    const uint8_t temp[2] = { 0x19, 0x40 };
+
+    i2c_fake_init(&fake);
+    i2c_fake_set_register(&fake, TMP102_ADDRESS, 0x00, temp, 2);
+    i2c_bus_init(&bus, "fake", &i2c_fake_backend, &fake);
+    latency_hist_reset(&hist);
+
+    int failures = 0;
+    uint64_t start = latency_now_ns();
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        uint8_t data[2];
+        uint64_t t0 = latency_now_ns();
+        if (read_fn(&bus, data) != 0 || data[0] != temp[0]) {
+            failures++;
+        }
+        latency_hist_record(&hist, latency_now_ns() - t0);
+    }
+    double elapsed = (latency_now_ns() - start) / 1e9;
+
+    i2c_bus_stats_t stats;
+    i2c_bus_get_stats(&bus, &stats);
+    i2c_bus_destroy(&bus);
+
+    latency_summary_t summary;
+    latency_hist_summary(&hist, &summary);
+    double syscalls = (double)stats.syscalls / BENCH_SAMPLES;
+
+    bench_report_text(&report, "%-10s  %d samples  %.2f syscalls/sample  %.0f samples/s  "
+                      "p50 %.2f us  p99 %.2f us  failures %d\n",
+                      name, BENCH_SAMPLES, syscalls, BENCH_SAMPLES / elapsed,
+                      summary.p50_ns / 1e3, summary.p99_ns / 1e3, failures);
+    bench_report_result(&report, "\"mode\":\"%s\",\"samples\":%d,\"syscalls_per_sample\":%.2f,"
+                        "\"samples_per_sec\":%.0f,\"p50_ns\":%llu,\"p99_ns\":%llu,\"failures\":%d",
+                        name, BENCH_SAMPLES, syscalls, BENCH_SAMPLES / elapsed,
+                        (unsigned long long)summary.p50_ns, (unsigned long long)summary.p99_ns,
+                        failures);
+}
+
+// Read sensors 0x48.. once per sweep, one transfer each or batched
+static void bench_sweep(int sensors, int batched) {
+    static i2c_fake_t fake;
+    i2c_bus_t bus;
+    const uint8_t temp[2] = { 0x19, 0x40 };
+    i2c_read_t reads[I2C_BUS_MAX_BATCH];
+    uint8_t data[I2C_BUS_MAX_BATCH][2];
+
+    i2c_fake_init(&fake);
+    for (int i = 0; i < sensors; i++) {
+        i2c_fake_set_register(&fake, (uint16_t)(TMP102_ADDRESS + i), 0x00, temp, 2);
+        reads[i] = (i2c_read_t){ .address = (uint16_t)(TMP102_ADDRESS + i), .reg = 0x00,
+                                 .buf = data[i], .len = 2 };
+    }
+    i2c_bus_init(&bus, "fake", &i2c_fake_backend, &fake);
+    latency_hist_reset(&hist);
+
+    int failures = 0;
+    uint64_t start = latency_now_ns();
+    for (int s = 0; s < BENCH_SWEEPS; s++) {
+        uint64_t t0 = latency_now_ns();
+        if (batched) {
+            failures += sensors - i2c_bus_read_registers(&bus, reads, sensors);
+        } else {
+            for (int i = 0; i < sensors; i++) {
+                failures += i2c_bus_read_register(&bus, reads[i].address, 0x00, data[i], 2) != 0;
+            }
+        }
+        latency_hist_record(&hist, latency_now_ns() - t0);
+    }
+    double elapsed = (latency_now_ns() - start) / 1e9;
+
+    i2c_bus_stats_t stats;
+    i2c_bus_get_stats(&bus, &stats);
+    i2c_bus_destroy(&bus);
+
+    latency_summary_t summary;
+    latency_hist_summary(&hist, &summary);
+    const char *name = batched ? "batched" : "per-sensor";
+    double syscalls = (double)stats.syscalls / BENCH_SWEEPS;
+
+    bench_report_text(&report, "sweep %-10s  %2d sensors  %.2f syscalls/sweep  %.0f sensor reads/s  "
+                      "p50 %.2f us  p99 %.2f us  failures %d\n",
+                      name, sensors, syscalls, (double)sensors * BENCH_SWEEPS / elapsed,
+                      summary.p50_ns / 1e3, summary.p99_ns / 1e3, failures);
+    bench_report_result(&report, "\"mode\":\"sweep-%s\",\"sensors\":%d,\"sweeps\":%d,"
+                        "\"syscalls_per_sweep\":%.2f,\"reads_per_sec\":%.0f,\"p50_ns\":%llu,"
+                        "\"p99_ns\":%llu,\"failures\":%d",
+                        name, sensors, BENCH_SWEEPS, syscalls,
+                        (double)sensors * BENCH_SWEEPS / elapsed,
+                        (unsigned long long)summary.p50_ns, (unsigned long long)summary.p99_ns,
+                        failures);
+}
+
+int main(int argc, char **argv) {
+    bench_report_begin(&report, stdout, argc, argv, "i2c");
+    bench_report_text(&report, "=== I2C Read Benchmark (fake bus) ===\n");
+    bench_mode("per-sample", legacy_read);
+    bench_mode("persistent", persistent_read);
+    const int sweep_sizes[] = { 1, 4, 8, I2C_BUS_MAX_BATCH };
+    for (int i = 0; i < 4; i++) {
+        bench_sweep(sweep_sizes[i], 0);
+        bench_sweep(sweep_sizes[i], 1);
+    }
+    bench_report_end(&report);
+    return 0;
+}
@@ -0,0 +1,138 @@
+// latest_reading contention benchmark: one writer publishing as fast as it can
+// against 1, 4 and 16 reader threads, comparing the previous mutex-protected
+// struct with the seqlock in utils.c. Reports reads/s, writes/s and the
+// writer's worst publish time (how long readers can hold it up). Pass --json
+// for machine-readable output.
+#include "../src/utils.h"
+#include "bench_report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#define RUN_SECONDS 1.0
+#define MAX_READERS 16
+
+typedef struct {
+    const char *name;
+    void (*publish)(const latest_reading_t *reading);
+    void (*read)(latest_reading_t *out);
+} latest_impl_t;
+
+// Baseline: the mutex-protected struct this replaced. Like the seqlock it
+// copies only the sensors in use.
+static latest_reading_t mutex_reading;
+static pthread_mutex_t mutex_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void mutex_publish(const latest_reading_t *reading) {
+    pthread_mutex_lock(&mutex_lock);
+    memcpy(&mutex_reading, reading, LATEST_READING_SIZE(reading->sensor_count));
+    pthread_mutex_unlock(&mutex_lock);
+}
+
+static void mutex_read(latest_reading_t *out) {
+    pthread_mutex_lock(&mutex_lock);
+    memcpy(out, &mutex_reading, LATEST_READING_SIZE(mutex_reading.sensor_count));
+    pthread_mutex_unlock(&mutex_lock);
+}
+
+static void seqlock_read(latest_reading_t *out) {
+    latest_reading_read(out);
+}
+
+static const latest_impl_t impls[] = {
+    { "mutex", mutex_publish, mutex_read },
+    { "seqlock", latest_reading_publish, seqlock_read },
+};
+
+static const latest_impl_t *impl;
+static atomic_int stop;
+
+typedef struct {
+    _Alignas(64) long ops;
+    double worst;
+} worker_t;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *writer_thread(void *arg) {
+    worker_t *w = arg;
+    latest_reading_t r = { .time_str = "2025-01-01 12:00:00", .sensor_count = 2 };
+    while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+        r.sensors[0] = r.sensors[1] = r.average = (float)w->ops;
+        double start = now_sec();
+        impl->publish(&r);
+        double elapsed = now_sec() - start;
+        if (elapsed > w->worst) w->worst = elapsed;
+        w->ops++;
+    }
+    return NULL;
+}
+
+static void *reader_thread(void *arg) {
+    worker_t *w = arg;
+    latest_reading_t snap;
+    float sink = 0.0f;
+    while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+        impl->read(&snap);
+        sink += snap.average;
+        w->ops++;
+    }
+    w->worst = sink;  // Keep the reads from being optimized away
+    return NULL;
+}
+
+static void run(bench_report_t *report, const latest_impl_t *which, int readers) {
+    impl = which;
+    atomic_store(&stop, 0);
+    worker_t writer = {0};
+    worker_t reader[MAX_READERS];
+    memset(reader, 0, sizeof(reader));
+    pthread_t writer_tid, reader_tids[MAX_READERS];
+
+    double start = now_sec();
+    for (int i = 0; i < readers; i++) {
+        pthread_create(&reader_tids[i], NULL, reader_thread, &reader[i]);
+    }
+    pthread_create(&writer_tid, NULL, writer_thread, &writer);
+    while (now_sec() - start < RUN_SECONDS) {
+        struct timespec ts = { 0, 10000000 };
+        nanosleep(&ts, NULL);
+    }
+    atomic_store(&stop, 1);
+    pthread_join(writer_tid, NULL);
+    for (int i = 0; i < readers; i++) {
+        pthread_join(reader_tids[i], NULL);
+    }
+    double elapsed = now_sec() - start;
+
+    long reads = 0;
+    for (int i = 0; i < readers; i++) {
+        reads += reader[i].ops;
+    }
+    bench_report_text(report, "%-8s readers=%-3d  %12.0f reads/s  %11.0f writes/s  worst publish=%8.1fus\n",
+                      which->name, readers, reads / elapsed, writer.ops / elapsed, writer.worst * 1e6);
+    bench_report_result(report, "\"impl\":\"%s\",\"readers\":%d,\"reads_per_sec\":%.0f,"
+                        "\"writes_per_sec\":%.0f,\"worst_publish_us\":%.1f",
+                        which->name, readers, reads / elapsed, writer.ops / elapsed, writer.worst * 1e6);
+}
+
+int main(int argc, char **argv) {
+    bench_report_t report;
+    bench_report_begin(&report, stdout, argc, argv, "latest");
+    bench_report_text(&report, "=== latest_reading Contention Benchmark (%.0fs per run, 1 writer) ===\n",
+                      RUN_SECONDS);
+    const int levels[] = { 1, 4, 16 };
+    for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); i++) {
+        for (int j = 0; j < 3; j++) {
+            run(&report, &impls[i], levels[j]);
+        }
+    }
+    bench_report_end(&report);
+    return 0;
+}
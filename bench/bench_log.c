@@ -0,0 +1,158 @@
+// Log benchmark: write cost through the asynchronous log writer and history
+// scan speed, CSV vs. the binary log format. Pass --json for machine-readable
+// output.
+#include "../src/log_writer.h"
+#include "../src/binlog.h"
+#include "../src/config.h"
+#include "bench_report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/stat.h>
+
+#define BENCH_RECORDS 500000
+
+static bench_report_t report;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long file_size(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+// Push BENCH_RECORDS rows through the writer and time until they are on disk
+static void bench_write(int format, const char *path) {
+    unlink(path);
+    config_load_defaults();
+    g_config.log_format = format;
+    g_config.log_buffer_records = 4096;
+
+    if (log_writer_start(path) != 0) {
+        return;
+    }
+
+    time_t base = time(NULL);
+    double start = now_sec();
+    for (int i = 0; i < BENCH_RECORDS; i++) {
+        log_record_t rec;
+        rec.timestamp = base + i / 10;
+        rec.sensor_id = 1 + i % 2;
+        rec.temperature = rec.sensor_id == 1 ? 20.0f + (float)(i % 160) * 0.0625f
+                                             : 21.0f + (float)(i % 96) * 0.0625f;
+        // Back off instead of dropping so every row is written
+        while (log_writer_append(&rec) != 0) {
+            sched_yield();
+        }
+    }
+    log_writer_stop();
+    double elapsed = now_sec() - start;
+
+    long size = file_size(path);
+    const char *name = format == LOG_FORMAT_BINARY ? "binary" : "csv";
+    bench_report_text(&report, "write  %-6s  %d rows  %.2f s  %.0f rows/s  %ld bytes  %.1f bytes/row\n",
+                      name, BENCH_RECORDS, elapsed, BENCH_RECORDS / elapsed, size,
+                      (double)size / BENCH_RECORDS);
+    bench_report_result(&report, "\"op\":\"write\",\"format\":\"%s\",\"rows\":%d,\"seconds\":%.3f,"
+                        "\"rows_per_sec\":%.0f,\"bytes\":%ld,\"bytes_per_row\":%.1f",
+                        name, BENCH_RECORDS, elapsed, BENCH_RECORDS / elapsed, size,
+                        (double)size / BENCH_RECORDS);
+}
+
+// Parse the CSV back and compute the mean of sensor1
+static void bench_scan_csv(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror("Opening CSV");
+        return;
+    }
+
+    char line[256];
+    double start = now_sec();
+    long rows = 0, n = 0;
+    double sum = 0;
+    if (!fgets(line, sizeof(line), f)) {  // Header
+        fclose(f);
+        return;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        // timestamp,sensor1,sensor2,average
+        char *field = strchr(line, ',');
+        if (!field) continue;
+        field++;
+        if (strncmp(field, "N/A", 3) != 0) {
+            sum += strtof(field, NULL);
+            n++;
+        }
+        rows++;
+    }
+    double elapsed = now_sec() - start;
+    fclose(f);
+
+    bench_report_text(&report, "scan   csv     %ld rows  %.3f s  %.1f Mrows/s  mean(sensor1)=%.3f\n",
+                      rows, elapsed, rows / elapsed / 1e6, n ? sum / n : 0.0);
+    bench_report_result(&report, "\"op\":\"scan\",\"format\":\"csv\",\"rows\":%ld,\"seconds\":%.3f,"
+                        "\"rows_per_sec\":%.0f", rows, elapsed, rows / elapsed);
+}
+
+// Map the binary log and compute the mean of sensor1
+static void bench_scan_binary(const char *path) {
+    double start = now_sec();
+    binlog_reader_t reader;
+    if (binlog_open(path, &reader) != 0) {
+        return;
+    }
+
+    long rows = 0, n = 0;
+    long sum = 0;
+    for (size_t i = 0; i < reader.count; i++) {
+        const binlog_record_t *rec = &reader.records[i];
+        if (rec->flags & BINLOG_FLAG_ROW_START) {
+            rows++;
+        }
+        if (rec->sensor_id == 1 && (rec->flags & BINLOG_FLAG_VALID)) {
+            sum += rec->temp_centi;
+            n++;
+        }
+    }
+    binlog_close(&reader);
+    double elapsed = now_sec() - start;
+
+    bench_report_text(&report, "scan   binary  %ld rows  %.3f s  %.1f Mrows/s  mean(sensor1)=%.3f\n",
+                      rows, elapsed, rows / elapsed / 1e6, n ? sum / 100.0 / n : 0.0);
+    bench_report_result(&report, "\"op\":\"scan\",\"format\":\"binary\",\"rows\":%ld,\"seconds\":%.3f,"
+                        "\"rows_per_sec\":%.0f", rows, elapsed, rows / elapsed);
+}
+
+int main(int argc, char **argv) {
+    char csv_path[] = "/tmp/bench_log_csv_XXXXXX";
+    char bin_path[] = "/tmp/bench_log_bin_XXXXXX";
+    int fd1 = mkstemp(csv_path);
+    int fd2 = mkstemp(bin_path);
+    if (fd1 < 0 || fd2 < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd1);
+    close(fd2);
+
+    bench_report_begin(&report, stdout, argc, argv, "log");
+    bench_report_text(&report, "=== Log Benchmark ===\n");
+    bench_write(LOG_FORMAT_CSV, csv_path);
+    bench_write(LOG_FORMAT_BINARY, bin_path);
+    bench_scan_csv(csv_path);
+    bench_scan_binary(bin_path);
+
+    bench_report_end(&report);
+
+    unlink(csv_path);
+    unlink(bin_path);
+    return 0;
+}
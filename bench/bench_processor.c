@@ -0,0 +1,135 @@
+// Processor benchmark: runs data_processor_thread against a synthetic producer
+// that pushes readings as fast as the queue accepts them, and reports the
+// sustained readings/s and the queue depth seen while it runs, with one row
+// per reading and with readings fused into one record per window. Pass --json
+// for machine-readable output.
+#include "../src/data_processor.h"
+#include "../src/queue.h"
+#include "../src/utils.h"
+#include "../src/config.h"
+#include "bench_report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define RUN_SECONDS 2.0
+#define QUEUE_CAPACITY 1024
+#define DEPTH_SAMPLE_US 1000
+
+static atomic_int producer_stop;
+static atomic_long produced;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *synthetic_producer(void *arg) {
+    (void)arg;
+    sensor_reading_t reading;
+    long n = 0;
+    while (!atomic_load(&producer_stop)) {
+        // Back off while full so the drop path doesn't dominate the numbers
+        if (queue_size(&sensor_queue) >= QUEUE_CAPACITY) {
+            sched_yield();
+            continue;
+        }
+        reading.sensor_id = (int)(n % 2) + 1;
+        reading.temperature = 20.0f + (float)(n % 100) * 0.0625f;
+        reading.timestamp = time(NULL);
+        if (queue_push(&sensor_queue, reading) == 0) {
+            n++;
+        }
+    }
+    atomic_store(&produced, n);
+    return NULL;
+}
+
+static void run(bench_report_t *report, int min_period_ms, int window_ms, const char *log_path) {
+    config_load_defaults();
+    g_config.processor_min_period_ms = min_period_ms;
+    g_config.processor_window_ms = window_ms;
+    snprintf(g_config.log_file, sizeof(g_config.log_file), "%s", log_path);
+
+    init_utils();
+    queue_init(&sensor_queue, QUEUE_CAPACITY);
+    atomic_store(&producer_stop, 0);
+    atomic_store(&produced, 0);
+
+    pthread_t processor_tid, producer_tid;
+    pthread_create(&processor_tid, NULL, data_processor_thread, NULL);
+    pthread_create(&producer_tid, NULL, synthetic_producer, NULL);
+
+    // Sample queue depth while the pipeline runs
+    double start = now_sec();
+    long samples = 0, depth_sum = 0;
+    int depth_max = 0;
+    while (now_sec() - start < RUN_SECONDS) {
+        int depth = queue_size(&sensor_queue);
+        depth_sum += depth;
+        if (depth > depth_max) depth_max = depth;
+        samples++;
+        usleep(DEPTH_SAMPLE_US);
+    }
+
+    atomic_store(&producer_stop, 1);
+    pthread_join(producer_tid, NULL);
+    int left = queue_size(&sensor_queue);
+    double elapsed = now_sec() - start;
+
+    set_exit_flag();
+    queue_wakeup(&sensor_queue);
+    pthread_join(processor_tid, NULL);
+    queue_destroy(&sensor_queue);
+
+    long processed = atomic_load(&produced) - left;
+    double depth_avg = samples ? (double)depth_sum / samples : 0.0;
+    bench_report_text(report, "min_period_ms=%-4d window_ms=%-4d  processed=%ld  %.0f readings/s  "
+                      "depth avg=%.1f max=%d\n",
+                      min_period_ms, window_ms, processed, processed / elapsed, depth_avg, depth_max);
+    bench_report_result(report, "\"min_period_ms\":%d,\"window_ms\":%d,\"processed\":%ld,"
+                        "\"readings_per_sec\":%.0f,\"depth_avg\":%.1f,\"depth_max\":%d",
+                        min_period_ms, window_ms, processed, processed / elapsed, depth_avg,
+                        depth_max);
+}
+
+int main(int argc, char **argv) {
+    char log_path[] = "/tmp/bench_processor_XXXXXX";
+    int fd = mkstemp(log_path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    // The processor prints every row; keep results on the real stdout only
+    FILE *out = fdopen(dup(STDOUT_FILENO), "w");
+    int devnull = open("/dev/null", O_WRONLY);
+    if (!out || devnull < 0) {
+        perror("Redirecting output");
+        return 1;
+    }
+    dup2(devnull, STDOUT_FILENO);
+    dup2(devnull, STDERR_FILENO);
+    close(devnull);
+
+    bench_report_t report;
+    bench_report_begin(&report, out, argc, argv, "processor");
+    bench_report_text(&report, "=== Processor Benchmark (%.0fs per run, queue capacity=%d) ===\n",
+                      RUN_SECONDS, QUEUE_CAPACITY);
+    run(&report, 0, 0, log_path);
+    run(&report, 10, 0, log_path);
+    run(&report, 100, 0, log_path);
+    run(&report, 0, 1000, log_path);
+    bench_report_end(&report);
+
+    unlink(log_path);
+    fclose(out);
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Quantile benchmark: cost of recording a reading for a sensor at 1 Hz and at
+// 1 kHz (the per-reading work added to the processor), the time to answer a
+// query for each window once its panes are full, and how far the estimates
+// are from the exact quantiles. Pass --json for machine-readable output.
+#include "../src/quantile.h"
+#include "../src/latency.h"
+#include "bench_report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#define BENCH_READINGS 86400        // A day at 1 Hz
+#define ADD_ROUNDS 20               // Days replayed for the add timing
+#define QUERY_ROUNDS 2000
+
+static float readings[BENCH_READINGS];
+static float sorted[BENCH_READINGS];
+
+static int compare_floats(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static void make_readings(void) {
+    uint32_t seed = 12345;
+    for (int i = 0; i < BENCH_READINGS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        float noise = (float)((seed >> 16) % 1000) / 1000.0f - 0.5f;
+        float day = (float)((i % 86400) - 43200) / 43200.0f;      // -1 at midnight, 0 at noon
+        readings[i] = (float)(int)((21.0f + 3.0f * (1 - day * day) + noise) * 16) / 16;
+    }
+}
+
+// Largest error of a few quantiles of the last day against the exact ones, in degrees
+static double day_error(time_t now) {
+    static const double qs[] = { 0.01, 0.5, 0.95, 0.99, 0.999 };
+    double out[5], worst = 0;
+    quantile_query(1, QUANTILE_WIN_24H, now, qs, 5, out);
+    for (int i = 0; i < 5; i++) {
+        double err = fabs(out[i] - sorted[(int)(qs[i] * (BENCH_READINGS - 1))]);
+        if (err > worst) worst = err;
+    }
+    return worst;
+}
+
+int main(int argc, char **argv) {
+    bench_report_t report;
+    bench_report_begin(&report, stdout, argc, argv, "quantile");
+    bench_report_text(&report, "=== Quantile Benchmark (t-digest, compression %d) ===\n",
+                      TDIGEST_COMPRESSION);
+    make_readings();
+
+    // Replay the day at 1 reading per second, ADD_ROUNDS times, then the same
+    // readings at 1 kHz on a fresh sensor
+    time_t base = 1700006400;
+    for (int rate = 1; rate <= 1000; rate *= 1000) {
+        quantile_init(1);
+        uint64_t start = latency_now_ns();
+        for (int r = 0; r < ADD_ROUNDS; r++) {
+            for (int i = 0; i < BENCH_READINGS; i++) {
+                long n = (long)r * BENCH_READINGS + i;
+                quantile_add(1, base + (time_t)(n / rate), readings[i]);
+            }
+        }
+        double ns = (double)(latency_now_ns() - start) / ((double)ADD_ROUNDS * BENCH_READINGS);
+        bench_report_text(&report, "add at %4d Hz  %.1f ns/reading\n", rate, ns);
+        bench_report_result(&report, "\"op\":\"add\",\"rate_hz\":%d,\"ns\":%.1f", rate, ns);
+    }
+
+    // Queries over two days at 1 Hz, so every pane is full
+    quantile_init(1);
+    for (int r = 0; r < 2; r++) {
+        for (int i = 0; i < BENCH_READINGS; i++) {
+            quantile_add(1, base + (time_t)r * BENCH_READINGS + i, readings[i]);
+        }
+    }
+    time_t now = base + 2 * BENCH_READINGS - 1;
+    const double qs[] = { 0.5, 0.95, 0.99 };
+    for (int w = 0; w < QUANTILE_WIN_COUNT; w++) {
+        double out[3];
+        long count = 0;
+        uint64_t start = latency_now_ns();
+        for (int r = 0; r < QUERY_ROUNDS; r++) {
+            count = quantile_query(1, (quantile_window_t)w, now, qs, 3, out);
+        }
+        double us = (double)(latency_now_ns() - start) / QUERY_ROUNDS / 1e3;
+        bench_report_text(&report, "query %-4s %.1f us over %ld readings  p50=%.2f p95=%.2f p99=%.2f\n",
+                          quantile_window_name((quantile_window_t)w), us, count, out[0], out[1],
+                          out[2]);
+        bench_report_result(&report, "\"op\":\"query\",\"window\":\"%s\",\"us\":%.1f,\"readings\":%ld",
+                            quantile_window_name((quantile_window_t)w), us, count);
+    }
+
+    for (int i = 0; i < BENCH_READINGS; i++) {
+        sorted[i] = readings[i];
+    }
+    qsort(sorted, BENCH_READINGS, sizeof(float), compare_floats);
+    double err = day_error(now);
+    bench_report_text(&report, "24h error  %.4f degrees worst of p1/p50/p95/p99/p99.9 "
+                      "(readings in 1/16 degree steps)\n", err);
+    bench_report_result(&report, "\"op\":\"accuracy\",\"window\":\"24h\",\"max_error\":%.4f", err);
+
+    quantile_destroy();
+    bench_report_end(&report);
+    return 0;
+}
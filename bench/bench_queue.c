@@ -0,0 +1,299 @@
+// Queue throughput benchmark: lock-free ring (queue_t) vs. the previous
+// malloc-per-node linked list, with 1..N producers and a single consumer.
+// The "batch" variant uses queue_push_batch/queue_pop_batch. Each item is
+// stamped before it is pushed, so the consumer also reports push-to-pop
+// latency. Pass --json for machine-readable output.
+#include "../src/queue.h"
+#include "../src/utils.h"
+#include "../src/latency.h"
+#include "bench_report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define ITEMS_PER_PRODUCER 200000
+#define MAX_PRODUCERS 4
+#define BENCH_CAPACITY 1024
+#define PUSH_BATCH 16
+#define POP_BATCH 64
+
+enum { MODE_LEGACY, MODE_RING, MODE_BATCH };
+static const char *mode_names[] = { "legacy", "ring", "batch" };
+
+// ---------------------------------------------------------------------------
+// Previous implementation, kept verbatim (apart from names) as the baseline
+// ---------------------------------------------------------------------------
+
+typedef struct legacy_node {
+    sensor_reading_t data;
+    struct legacy_node *next;
+} legacy_node_t;
+
+typedef struct {
+    legacy_node_t *head;
+    legacy_node_t *tail;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int size;
+    int max_size;
+} legacy_queue_t;
+
+static void legacy_queue_init(legacy_queue_t *q, int max_size) {
+    q->head = q->tail = NULL;
+    q->size = 0;
+    q->max_size = max_size;
+    pthread_mutex_init(&q->mutex, NULL);
+    pthread_cond_init(&q->cond, NULL);
+}
+
+static void legacy_queue_destroy(legacy_queue_t *q) {
+    legacy_node_t *current = q->head;
+    while (current) {
+        legacy_node_t *temp = current;
+        current = current->next;
+        free(temp);
+    }
+    pthread_mutex_destroy(&q->mutex);
+    pthread_cond_destroy(&q->cond);
+}
+
+static int legacy_queue_push(legacy_queue_t *q, sensor_reading_t item) {
+    legacy_node_t *new_node = malloc(sizeof(legacy_node_t));
+    if (!new_node) {
+        return -1;
+    }
+    new_node->data = item;
+    new_node->next = NULL;
+
+    pthread_mutex_lock(&q->mutex);
+    if (q->max_size > 0 && q->size >= q->max_size) {
+        pthread_mutex_unlock(&q->mutex);
+        free(new_node);
+        fprintf(stderr, "[Queue] Queue full (size=%d), dropping reading from sensor %d\n",
+                q->size, item.sensor_id);
+        return -1;
+    }
+    if (q->tail) {
+        q->tail->next = new_node;
+        q->tail = new_node;
+    } else {
+        q->head = q->tail = new_node;
+    }
+    q->size++;
+    pthread_cond_signal(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+    return 0;
+}
+
+static int legacy_queue_pop(legacy_queue_t *q, sensor_reading_t *item) {
+    pthread_mutex_lock(&q->mutex);
+    while (q->head == NULL && !should_exit()) {
+        pthread_cond_wait(&q->cond, &q->mutex);
+    }
+    if (q->head == NULL && should_exit()) {
+        pthread_mutex_unlock(&q->mutex);
+        return -1;
+    }
+    legacy_node_t *temp = q->head;
+    *item = temp->data;
+    q->head = temp->next;
+    if (q->head == NULL)
+        q->tail = NULL;
+    q->size--;
+    free(temp);
+    pthread_mutex_unlock(&q->mutex);
+    return 0;
+}
+
+static int legacy_queue_size(legacy_queue_t *q) {
+    pthread_mutex_lock(&q->mutex);
+    int size = q->size;
+    pthread_mutex_unlock(&q->mutex);
+    return size;
+}
+
+static void legacy_queue_wakeup(legacy_queue_t *q) {
+    pthread_mutex_lock(&q->mutex);
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+// ---------------------------------------------------------------------------
+// Harness
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    int mode;
+    queue_t ring;
+    legacy_queue_t legacy;
+    atomic_long dropped;
+    long consumed;
+    latency_hist_t latency;     // Push-to-pop, recorded by the consumer
+} bench_ctx_t;
+
+typedef struct {
+    bench_ctx_t *ctx;
+    int id;
+} producer_arg_t;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *producer(void *arg) {
+    producer_arg_t *pa = arg;
+    bench_ctx_t *ctx = pa->ctx;
+    sensor_reading_t batch[PUSH_BATCH];
+    long dropped = 0;
+
+    for (int i = 0; i < ITEMS_PER_PRODUCER; i += PUSH_BATCH) {
+        int n = ITEMS_PER_PRODUCER - i < PUSH_BATCH ? ITEMS_PER_PRODUCER - i : PUSH_BATCH;
+        for (int j = 0; j < n; j++) {
+            batch[j].sensor_id = pa->id;
+            batch[j].temperature = (float)(i + j);
+            batch[j].timestamp = 0;
+        }
+
+        // Back off while full so we measure queue handoff, not the drop path
+        while ((ctx->mode == MODE_LEGACY ? legacy_queue_size(&ctx->legacy)
+                                         : queue_size(&ctx->ring)) > BENCH_CAPACITY - n) {
+            sched_yield();
+        }
+
+        if (ctx->mode == MODE_BATCH) {
+            uint64_t stamp = latency_now_ns();
+            for (int j = 0; j < n; j++) {
+                batch[j].enqueue_ns = stamp;
+            }
+            dropped += n - queue_push_batch(&ctx->ring, batch, n);
+            continue;
+        }
+        for (int j = 0; j < n; j++) {
+            batch[j].enqueue_ns = latency_now_ns();
+            int rc = ctx->mode == MODE_RING ? queue_push(&ctx->ring, batch[j])
+                                            : legacy_queue_push(&ctx->legacy, batch[j]);
+            if (rc != 0) {
+                dropped++;
+            }
+        }
+    }
+    atomic_fetch_add(&ctx->dropped, dropped);
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    bench_ctx_t *ctx = arg;
+    sensor_reading_t batch[POP_BATCH];
+    long n = 0;
+    for (;;) {
+        int rc;
+        if (ctx->mode == MODE_BATCH) {
+            rc = queue_pop_batch(&ctx->ring, batch, POP_BATCH);
+            if (rc < 0) {
+                break;
+            }
+            uint64_t popped = latency_now_ns();
+            for (int i = 0; i < rc; i++) {
+                latency_hist_record(&ctx->latency, popped - batch[i].enqueue_ns);
+            }
+            n += rc;
+            continue;
+        }
+        rc = ctx->mode == MODE_RING ? queue_pop(&ctx->ring, &batch[0])
+                                    : legacy_queue_pop(&ctx->legacy, &batch[0]);
+        if (rc != 0) {
+            break;
+        }
+        latency_hist_record(&ctx->latency, latency_now_ns() - batch[0].enqueue_ns);
+        n++;
+    }
+    ctx->consumed = n;
+    return NULL;
+}
+
+static void run(bench_report_t *report, int mode, int producers) {
+    static bench_ctx_t ctx;  // Holds a ~9 KB histogram
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.mode = mode;
+    atomic_init(&ctx.dropped, 0);
+    if (mode != MODE_LEGACY) {
+        queue_init(&ctx.ring, BENCH_CAPACITY);
+    } else {
+        legacy_queue_init(&ctx.legacy, BENCH_CAPACITY);
+    }
+    init_utils();
+
+    pthread_t cons, prod[MAX_PRODUCERS];
+    producer_arg_t args[MAX_PRODUCERS];
+
+    double start = now_sec();
+    pthread_create(&cons, NULL, consumer, &ctx);
+    for (int p = 0; p < producers; p++) {
+        args[p].ctx = &ctx;
+        args[p].id = p;
+        pthread_create(&prod[p], NULL, producer, &args[p]);
+    }
+    for (int p = 0; p < producers; p++) {
+        pthread_join(prod[p], NULL);
+    }
+
+    // Let the consumer drain what is left, then stop it
+    set_exit_flag();
+    if (mode != MODE_LEGACY) {
+        queue_wakeup(&ctx.ring);
+    } else {
+        legacy_queue_wakeup(&ctx.legacy);
+    }
+    pthread_join(cons, NULL);
+    double elapsed = now_sec() - start;
+
+    long offered = (long)producers * ITEMS_PER_PRODUCER;
+    long dropped = atomic_load(&ctx.dropped);
+    latency_summary_t lat;
+    latency_hist_summary(&ctx.latency, &lat);
+    bench_report_text(report, "%-7s producers=%d  offered=%ld  consumed=%ld  dropped=%ld  %.2f Mops/s"
+                      "  latency p50=%.1fus p99=%.1fus\n",
+                      mode_names[mode], producers, offered, ctx.consumed, dropped,
+                      ctx.consumed / elapsed / 1e6, lat.p50_ns / 1e3, lat.p99_ns / 1e3);
+    bench_report_result(report, "\"mode\":\"%s\",\"producers\":%d,\"offered\":%ld,\"consumed\":%ld,"
+                        "\"dropped\":%ld,\"ops_per_sec\":%.0f,\"latency_p50_ns\":%llu,"
+                        "\"latency_p99_ns\":%llu,\"latency_max_ns\":%llu",
+                        mode_names[mode], producers, offered, ctx.consumed, dropped,
+                        ctx.consumed / elapsed, (unsigned long long)lat.p50_ns,
+                        (unsigned long long)lat.p99_ns, (unsigned long long)lat.max_ns);
+
+    if (mode != MODE_LEGACY) {
+        queue_destroy(&ctx.ring);
+    } else {
+        legacy_queue_destroy(&ctx.legacy);
+    }
+}
+
+int main(int argc, char **argv) {
+    // Both queues log every dropped reading to stderr; keep that out of the way
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) {
+        dup2(devnull, STDERR_FILENO);
+        close(devnull);
+    }
+
+    bench_report_t report;
+    bench_report_begin(&report, stdout, argc, argv, "queue");
+    bench_report_text(&report, "=== Queue Benchmark (capacity=%d, %d items/producer) ===\n",
+                      BENCH_CAPACITY, ITEMS_PER_PRODUCER);
+    for (int producers = 1; producers <= MAX_PRODUCERS; producers++) {
+        run(&report, MODE_LEGACY, producers);
+        run(&report, MODE_RING, producers);
+        run(&report, MODE_BATCH, producers);
+    }
+    bench_report_end(&report);
+    return 0;
+}
@@ -0,0 +1,78 @@
+// Shared result output for the benchmarks. By default each benchmark prints
+// a human-readable table; with --json it prints a single JSON document
+// instead, so results can be collected by the `bench` target and compared
+// over time:
+//
+//   {"bench":"queue","build_type":"Release","timestamp":1700000000,
+//    "results":[{...},{...}]}
+#ifndef BENCH_REPORT_H
+#define BENCH_REPORT_H
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef BENCH_BUILD_TYPE
+#define BENCH_BUILD_TYPE ""
+#endif
+
+typedef struct {
+    FILE *out;
+    int json;       // --json given
+    int results;    // Results printed so far
+} bench_report_t;
+
+// Start a report on out. Prints the JSON header when --json is among the arguments.
+static inline void bench_report_begin(bench_report_t *r, FILE *out, int argc, char **argv,
+                                      const char *name) {
+    r->out = out;
+    r->json = 0;
+    r->results = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            r->json = 1;
+        }
+    }
+    if (r->json) {
+        fprintf(out, "{\"bench\":\"%s\",\"build_type\":\"%s\",\"timestamp\":%lld,\"results\":[",
+                name, BENCH_BUILD_TYPE, (long long)time(NULL));
+    }
+}
+
+// Human-readable line (suppressed with --json)
+static inline void bench_report_text(bench_report_t *r, const char *fmt, ...) {
+    if (r->json) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(r->out, fmt, args);
+    va_end(args);
+    fflush(r->out);
+}
+
+// One result object; fmt gives its members, e.g. "\"threads\":%d,\"ops_per_sec\":%.0f"
+// (only printed with --json)
+static inline void bench_report_result(bench_report_t *r, const char *fmt, ...) {
+    if (!r->json) {
+        return;
+    }
+    fputs(r->results++ ? ",{" : "{", r->out);
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(r->out, fmt, args);
+    va_end(args);
+    fputc('}', r->out);
+    fflush(r->out);
+}
+
+// Close the JSON document
+static inline void bench_report_end(bench_report_t *r) {
+    if (r->json) {
+        fputs("]}\n", r->out);
+        fflush(r->out);
+    }
+}
+
+#endif // BENCH_REPORT_H
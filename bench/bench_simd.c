@@ -0,0 +1,76 @@
+// SIMD statistics benchmark: throughput of the min/max/mean/stddev kernels
+// for float and fixed-point arrays at sizes from an L1-resident minute of 1 Hz
+// readings up to a full history ring, under every kernel set the CPU
+// supports. Pass --json for machine-readable output.
+#include "../src/simd_stats.h"
+#include "../src/latency.h"
+#include "bench_report.h"
+#include <stdio.h>
+#include <stdint.h>
+
+#define BENCH_ELEMENTS 200000000ULL   // Elements reduced per measurement
+#define MAX_LEN 65536
+
+static float fdata[MAX_LEN];
+static int16_t idata[MAX_LEN];
+
+static void make_data(void) {
+    uint32_t seed = 12345;
+    for (int i = 0; i < MAX_LEN; i++) {
+        seed = seed * 1103515245u + 12345u;
+        idata[i] = (int16_t)(2200 + (int)((seed >> 16) % 300));   // Centi-degrees
+        fdata[i] = idata[i] / 100.0f;
+    }
+}
+
+static void bench_kernel(bench_report_t *report, simd_level_t level, int fixed, size_t n) {
+    size_t rounds = (size_t)(BENCH_ELEMENTS / n);
+    double checksum = 0;
+    uint64_t start = latency_now_ns();
+    for (size_t r = 0; r < rounds; r++) {
+        simd_stats_acc_t acc;
+        simd_stats_t st;
+        simd_stats_begin(&acc);
+        if (fixed) {
+            simd_stats_add_i16(&acc, idata, n, 0.01f);
+        } else {
+            simd_stats_add_f32(&acc, fdata, n);
+        }
+        simd_stats_end(&acc, &st);
+        checksum += st.stddev;
+    }
+    double elapsed = (latency_now_ns() - start) / 1e9;
+    double per_sec = (double)rounds * n / elapsed;
+    const char *type = fixed ? "i16" : "f32";
+
+    bench_report_text(report, "%-6s %s  %6zu elements  %7.0fM elements/s  %6.2f GB/s  (checksum %.3f)\n",
+                      simd_stats_level_name(level), type, n, per_sec / 1e6,
+                      per_sec * (fixed ? sizeof(int16_t) : sizeof(float)) / 1e9, checksum);
+    bench_report_result(report, "\"level\":\"%s\",\"type\":\"%s\",\"elements\":%zu,"
+                        "\"elements_per_sec\":%.0f",
+                        simd_stats_level_name(level), type, n, per_sec);
+}
+
+int main(int argc, char **argv) {
+    bench_report_t report;
+    bench_report_begin(&report, stdout, argc, argv, "simd");
+    bench_report_text(&report, "=== SIMD Statistics Benchmark (best kernel set: %s) ===\n",
+                      simd_stats_level_name(simd_stats_level()));
+    make_data();
+
+    static const size_t sizes[] = { 1024, 16384, MAX_LEN };
+    simd_level_t best = simd_stats_level();
+    for (int level = 0; level < SIMD_LEVEL_COUNT; level++) {
+        if (simd_stats_use((simd_level_t)level) != 0) {
+            continue;
+        }
+        for (int fixed = 0; fixed <= 1; fixed++) {
+            for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+                bench_kernel(&report, (simd_level_t)level, fixed, sizes[s]);
+            }
+        }
+    }
+    simd_stats_use(best);
+    bench_report_end(&report);
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include "binlog.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+void binlog_header_init(binlog_header_t *header, int sensor_count, time_t base_time) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, BINLOG_MAGIC, sizeof(header->magic));
+    header->version = BINLOG_VERSION;
+    header->record_size = sizeof(binlog_record_t);
+    header->sensor_count = (uint16_t)sensor_count;
+    header->base_time = (int64_t)base_time;
+}
+
+int binlog_header_check(const binlog_header_t *header) {
+    if (memcmp(header->magic, BINLOG_MAGIC, sizeof(header->magic)) != 0) {
+        fprintf(stderr, "[Binlog] Bad magic, not a binary sensor log\n");
+        return -1;
+    }
+    if (header->version != BINLOG_VERSION) {
+        fprintf(stderr, "[Binlog] Unsupported version %u (expected %u)\n",
+                header->version, BINLOG_VERSION);
+        return -1;
+    }
+    if (header->record_size != sizeof(binlog_record_t)) {
+        fprintf(stderr, "[Binlog] Unexpected record size %u\n", header->record_size);
+        return -1;
+    }
+    return 0;
+}
+
+int16_t binlog_to_centi(float temperature) {
+    float scaled = roundf(temperature * 100.0f);
+    if (scaled > INT16_MAX) return INT16_MAX;
+    if (scaled < INT16_MIN) return INT16_MIN;
+    return (int16_t)scaled;
+}
+
+float binlog_from_centi(int16_t centi) {
+    return centi / 100.0f;
+}
+
+// Records before the base time (clock stepped back) are pinned to it
+static uint32_t time_offset(const binlog_header_t *header, time_t timestamp) {
+    int64_t offset = (int64_t)timestamp - header->base_time;
+    if (offset < 0) offset = 0;
+    if (offset > UINT32_MAX) offset = UINT32_MAX;
+    return (uint32_t)offset;
+}
+
+void binlog_encode_reading(const binlog_header_t *header, time_t timestamp,
+                           int sensor_id, float temperature, binlog_record_t *out) {
+    out->time_offset = time_offset(header, timestamp);
+    out->sensor_id = (uint8_t)sensor_id;
+    out->flags = BINLOG_FLAG_VALID | BINLOG_FLAG_ROW_START;
+    out->temp_centi = binlog_to_centi(temperature);
+}
+
+time_t binlog_record_time(const binlog_header_t *header, const binlog_record_t *record) {
+    return (time_t)(header->base_time + record->time_offset);
+}
+
+int binlog_open(const char *path, binlog_reader_t *reader) {
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = -1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("[Binlog] Opening log file");
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror("[Binlog] fstat");
+        close(fd);
+        return -1;
+    }
+    if ((size_t)st.st_size < sizeof(binlog_header_t)) {
+        fprintf(stderr, "[Binlog] File too small for a header\n");
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("[Binlog] mmap");
+        close(fd);
+        return -1;
+    }
+    // Readers scan front to back
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    reader->fd = fd;
+    reader->map = map;
+    reader->map_size = (size_t)st.st_size;
+    reader->header = (const binlog_header_t *)reader->map;
+    if (binlog_header_check(reader->header) != 0) {
+        binlog_close(reader);
+        return -1;
+    }
+    reader->records = (const binlog_record_t *)(reader->map + sizeof(binlog_header_t));
+    // A trailing partial record (writer interrupted mid-write) is ignored
+    reader->count = (reader->map_size - sizeof(binlog_header_t)) / sizeof(binlog_record_t);
+    return 0;
+}
+
+void binlog_close(binlog_reader_t *reader) {
+    if (reader->map) {
+        munmap((void *)reader->map, reader->map_size);
+    }
+    if (reader->fd >= 0) {
+        close(reader->fd);
+    }
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = -1;
+}
@@ -0,0 +1,77 @@
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// Compact binary time-series log.
+//
+// Layout: one binlog_header_t followed by fixed-size 8-byte binlog_record_t
+// entries. Each processed row is stored as one record per valid sensor; the
+// first record of a row carries BINLOG_FLAG_ROW_START. Sensors that were not
+// valid for a row have no record. The row average is not stored, it is the
+// mean of the row's values. All fields are in host (little-endian) byte order.
+
+#define BINLOG_MAGIC "SHBL"
+#define BINLOG_VERSION 1
+
+// Record flags
+#define BINLOG_FLAG_VALID     0x01  // Temperature value is valid
+#define BINLOG_FLAG_ROW_START 0x02  // First record of a processed row
+
+typedef struct {
+    char magic[4];          // BINLOG_MAGIC
+    uint16_t version;       // BINLOG_VERSION
+    uint16_t record_size;   // sizeof(binlog_record_t)
+    uint16_t sensor_count;  // Highest sensor id that may appear in records
+    uint16_t reserved0;
+    uint32_t reserved1;
+    int64_t base_time;      // Unix time that record time offsets are relative to
+} binlog_header_t;
+
+typedef struct {
+    uint32_t time_offset;   // Seconds since header base_time
+    uint8_t sensor_id;      // 1-based sensor id
+    uint8_t flags;          // BINLOG_FLAG_* bits
+    int16_t temp_centi;     // Temperature in 1/100 °C
+} binlog_record_t;
+
+_Static_assert(sizeof(binlog_header_t) == 24, "binlog header layout changed");
+_Static_assert(sizeof(binlog_record_t) == 8, "binlog record layout changed");
+
+// Memory-mapped reader over a binary log file
+typedef struct {
+    int fd;
+    const uint8_t *map;
+    size_t map_size;
+    const binlog_header_t *header;
+    const binlog_record_t *records;
+    size_t count;           // Number of complete records
+} binlog_reader_t;
+
+// Fill in a header for a new file
+void binlog_header_init(binlog_header_t *header, int sensor_count, time_t base_time);
+
+// Check that a header is one this code can read. Returns 0 if valid, -1 otherwise.
+int binlog_header_check(const binlog_header_t *header);
+
+// Encode a reading from any sensor id (1-255) as a record that starts a row;
+// clear BINLOG_FLAG_ROW_START on the records that follow it in the same row
+void binlog_encode_reading(const binlog_header_t *header, time_t timestamp,
+                           int sensor_id, float temperature, binlog_record_t *out);
+
+// Convert between °C and the stored fixed-point representation
+int16_t binlog_to_centi(float temperature);
+float binlog_from_centi(int16_t centi);
+
+// Absolute timestamp of a record
+time_t binlog_record_time(const binlog_header_t *header, const binlog_record_t *record);
+
+// Map a binary log file for reading. Returns 0 on success, -1 on failure.
+int binlog_open(const char *path, binlog_reader_t *reader);
+
+// Unmap and close a reader
+void binlog_close(binlog_reader_t *reader);
+
+#endif // BINLOG_H
@@ -50,20 +50,136 @@ static int parse_int(const char *str, int *result) {
     return 1;
 }
 
+// Filter stage names, indexed by FILTER_*
+static const char *filter_names[] = { NULL, "median", "ewma", "spike", "slew" };
+
+// Parse a filter chain such as "median:5, spike:2.5, ewma:0.3" ("none" or
+// empty for no filtering). Returns 1 on success, 0 on error.
+static int parse_filters(const char *str, filter_spec_t *filters, int *count) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", str);
+    int n = 0;
+    char *saveptr;
+    for (char *tok = strtok_r(buf, ",", &saveptr); tok; tok = strtok_r(NULL, ",", &saveptr)) {
+        tok = trim(tok);
+        if (*tok == '\0' || strcmp(tok, "none") == 0) {
+            continue;
+        }
+        if (n == CONFIG_MAX_FILTERS) {
+            fprintf(stderr, "[Config] Error: More than %d filter stages\n", CONFIG_MAX_FILTERS);
+            return 0;
+        }
+        char *colon = strchr(tok, ':');
+        if (!colon) {
+            fprintf(stderr, "[Config] Error: Filter stage '%s' has no parameter\n", tok);
+            return 0;
+        }
+        *colon = '\0';
+        char *name = trim(tok);
+        char *arg = trim(colon + 1);
+
+        int type = 0;
+        for (int t = FILTER_MEDIAN; t <= FILTER_SLEW; t++) {
+            if (strcmp(name, filter_names[t]) == 0) {
+                type = t;
+            }
+        }
+        char *endptr;
+        errno = 0;
+        float param = strtof(arg, &endptr);
+        if (type == 0 || errno != 0 || endptr == arg || *endptr != '\0') {
+            fprintf(stderr, "[Config] Error: Invalid filter stage '%s:%s'\n", name, arg);
+            return 0;
+        }
+
+        int ok;
+        switch (type) {
+        case FILTER_MEDIAN:
+            ok = param >= 1 && param <= CONFIG_FILTER_MEDIAN_MAX && param == (int)param;
+            break;
+        case FILTER_EWMA:
+            ok = param > 0 && param <= 1;
+            break;
+        default:
+            ok = param > 0;
+            break;
+        }
+        if (!ok) {
+            fprintf(stderr, "[Config] Error: Filter parameter out of range in '%s:%s'\n", name, arg);
+            return 0;
+        }
+        filters[n++] = (filter_spec_t){ .type = type, .param = param };
+    }
+    *count = n;
+    return 1;
+}
+
+// Parse a whole number of seconds as milliseconds
+static int parse_seconds_ms(const char *str, int *result) {
+    int val;
+    if (!parse_int(str, &val) || val > INT_MAX / 1000 || val < INT_MIN / 1000) {
+        return 0;
+    }
+    *result = val * 1000;
+    return 1;
+}
+
 // Validate configuration values
 static int validate_config(void) {
     int valid = 1;
 
-    // Validate sensor intervals (must be positive)
-    if (g_config.sensor1_interval <= 0) {
-        fprintf(stderr, "[Config] Error: sensor1_interval must be > 0 (got %d)\n",
-                g_config.sensor1_interval);
+    // Validate the sensor table: at least one sensor, positive intervals,
+    // 7-bit I2C addresses (0x03-0x77) and no two sensors on one address of a bus
+    if (g_config.sensor_count < 1) {
+        fprintf(stderr, "[Config] Error: no sensors configured\n");
         valid = 0;
     }
-    if (g_config.sensor2_interval <= 0) {
-        fprintf(stderr, "[Config] Error: sensor2_interval must be > 0 (got %d)\n",
-                g_config.sensor2_interval);
-        valid = 0;
+    for (int i = 0; i < g_config.sensor_count; i++) {
+        const sensor_config_t *sensor = &g_config.sensors[i];
+        if (sensor->interval_ms <= 0) {
+            fprintf(stderr, "[Config] Error: sensor.%d interval_ms must be > 0 (got %d)\n",
+                    sensor->id, sensor->interval_ms);
+            valid = 0;
+        }
+        if (sensor->address < 0x03 || sensor->address > 0x77) {
+            fprintf(stderr, "[Config] Error: sensor.%d address 0x%02x outside typical I2C range (0x03-0x77)\n",
+                    sensor->id, sensor->address);
+            valid = 0;
+        }
+        for (int j = 0; j < i; j++) {
+            if (g_config.sensors[j].bus == sensor->bus && g_config.sensors[j].address == sensor->address) {
+                fprintf(stderr, "[Config] Error: sensor.%d and sensor.%d share address 0x%02x on bus %d\n",
+                        g_config.sensors[j].id, sensor->id, sensor->address, sensor->bus);
+                valid = 0;
+            }
+        }
+    }
+
+    // Every sensor's bus needs a device, and two buses in use may not share one
+    for (int i = 0; i < g_config.sensor_count; i++) {
+        const sensor_config_t *sensor = &g_config.sensors[i];
+        if (sensor->bus < 0 || sensor->bus >= CONFIG_MAX_BUSES ||
+            g_config.buses[sensor->bus].device[0] == '\0') {
+            fprintf(stderr, "[Config] Error: sensor.%d is on bus %d, which has no device\n",
+                    sensor->id, sensor->bus);
+            valid = 0;
+        }
+    }
+    for (int b = 0; b < CONFIG_MAX_BUSES; b++) {
+        if (g_config.buses[b].cpu < -1) {
+            fprintf(stderr, "[Config] Error: bus.%d cpu must be >= 0 or -1 (got %d)\n",
+                    b, g_config.buses[b].cpu);
+            valid = 0;
+        }
+        for (int c = 0; c < b; c++) {
+            if (g_config.buses[b].device[0] && config_bus_sensor_count(b) > 0 &&
+                config_bus_sensor_count(c) > 0 &&
+                strcmp(g_config.buses[b].device, g_config.buses[c].device) == 0) {
+                fprintf(stderr, "[Config] Error: bus.%d and bus.%d share device %s\n",
+                        c, b, g_config.buses[b].device);
+                valid = 0;
+            }
+        }
     }
 
     // Validate sensor timeout (must be positive)
@@ -87,6 +203,18 @@ static int validate_config(void) {
         valid = 0;
     }
 
+    // Validate connection limits (must be positive)
+    if (g_config.network_max_connections <= 0) {
+        fprintf(stderr, "[Config] Error: max_connections must be > 0 (got %d)\n",
+                g_config.network_max_connections);
+        valid = 0;
+    }
+    if (g_config.network_idle_timeout_ms <= 0) {
+        fprintf(stderr, "[Config] Error: idle_timeout_ms must be > 0 (got %d)\n",
+                g_config.network_idle_timeout_ms);
+        valid = 0;
+    }
+
     // Validate queue max size (must be non-negative)
     if (g_config.queue_max_size < 0) {
         fprintf(stderr, "[Config] Error: queue_max_size must be >= 0 (got %d)\n",
@@ -94,37 +222,147 @@ static int validate_config(void) {
         valid = 0;
     }
 
-    // Validate I2C addresses (0x03-0x77 for 7-bit addressing)
-    if (g_config.sensor1_address < 0x03 || g_config.sensor1_address > 0x77) {
-        fprintf(stderr, "[Config] Error: sensor1_address 0x%02x outside typical I2C range (0x03-0x77)\n",
-                g_config.sensor1_address);
+    // Validate processor throttle (must be non-negative)
+    if (g_config.processor_min_period_ms < 0) {
+        fprintf(stderr, "[Config] Error: processor min_period_ms must be >= 0 (got %d)\n",
+                g_config.processor_min_period_ms);
         valid = 0;
     }
-    if (g_config.sensor2_address < 0x03 || g_config.sensor2_address > 0x77) {
-        fprintf(stderr, "[Config] Error: sensor2_address 0x%02x outside typical I2C range (0x03-0x77)\n",
-                g_config.sensor2_address);
+    if (g_config.processor_window_ms < 0) {
+        fprintf(stderr, "[Config] Error: processor window_ms must be >= 0 (got %d)\n",
+                g_config.processor_window_ms);
+        valid = 0;
+    }
+
+    // Validate log writer settings
+    if (g_config.log_buffer_records <= 0) {
+        fprintf(stderr, "[Config] Error: buffer_records must be > 0 (got %d)\n",
+                g_config.log_buffer_records);
+        valid = 0;
+    } else if (g_config.log_buffer_records < g_config.sensor_max_id) {
+        // A row goes into one buffer as a whole
+        fprintf(stderr, "[Config] Error: buffer_records must be at least the number of sensors "
+                "(%d) (got %d)\n", g_config.sensor_max_id, g_config.log_buffer_records);
+        valid = 0;
+    }
+    if (g_config.log_flush_records < 0) {
+        fprintf(stderr, "[Config] Error: flush_records must be >= 0 (got %d)\n",
+                g_config.log_flush_records);
+        valid = 0;
+    }
+    if (g_config.log_flush_interval_ms < 0) {
+        fprintf(stderr, "[Config] Error: flush_interval_ms must be >= 0 (got %d)\n",
+                g_config.log_flush_interval_ms);
+        valid = 0;
+    }
+
+    // Validate segment and retention settings
+    if (g_config.log_segment_max_bytes < 0 || g_config.log_segment_interval_s < 0 ||
+        g_config.log_retention_segments < 0 || g_config.log_retention_s < 0) {
+        fprintf(stderr, "[Config] Error: segment and retention settings must be >= 0\n");
+        valid = 0;
+    }
+
+    // Validate history sizes (must be positive)
+    if (g_config.history_raw_samples <= 0 || g_config.history_seconds <= 0 ||
+        g_config.history_minutes <= 0 || g_config.history_hours <= 0) {
+        fprintf(stderr, "[Config] Error: history sizes must be > 0\n");
         valid = 0;
     }
 
     return valid;
 }
 
+int config_bus_sensor_count(int bus) {
+    int count = 0;
+    for (int i = 0; i < g_config.sensor_count; i++) {
+        count += g_config.sensors[i].bus == bus;
+    }
+    return count;
+}
+
+const sensor_config_t *config_find_sensor(int id) {
+    for (int i = 0; i < g_config.sensor_count; i++) {
+        if (g_config.sensors[i].id == id) {
+            return &g_config.sensors[i];
+        }
+    }
+    return NULL;
+}
+
+// Find a sensor table entry, adding one with default settings if the id is
+// new. Returns NULL if the table is full.
+static sensor_config_t *sensor_entry(int id) {
+    sensor_config_t *sensor = (sensor_config_t *)config_find_sensor(id);
+    if (sensor) {
+        return sensor;
+    }
+    if (g_config.sensor_count >= CONFIG_MAX_SENSORS) {
+        return NULL;
+    }
+    sensor = &g_config.sensors[g_config.sensor_count++];
+    memset(sensor, 0, sizeof(*sensor));
+    sensor->id = id;
+    sensor->interval_ms = 1000;
+    return sensor;
+}
+
+static int compare_sensor_ids(const void *a, const void *b) {
+    return ((const sensor_config_t *)a)->id - ((const sensor_config_t *)b)->id;
+}
+
+// Sort the sensor table by id and note the highest id
+static void finish_sensor_table(void) {
+    qsort(g_config.sensors, (size_t)g_config.sensor_count, sizeof(g_config.sensors[0]),
+          compare_sensor_ids);
+    g_config.sensor_max_id = g_config.sensor_count > 0
+                                 ? g_config.sensors[g_config.sensor_count - 1].id
+                                 : 0;
+}
+
 void config_load_defaults(void) {
     // Set default values
-    strncpy(g_config.i2c_device, "/dev/i2c-1", sizeof(g_config.i2c_device) - 1);
-    g_config.i2c_device[sizeof(g_config.i2c_device) - 1] = '\0';  // Ensure null termination
-
-    g_config.sensor1_address = 0x48;
-    g_config.sensor1_interval = 1;
-    g_config.sensor2_address = 0x49;
-    g_config.sensor2_interval = 2;
+    // One bus; [bus.N] sections add more
+    memset(g_config.buses, 0, sizeof(g_config.buses));
+    for (int b = 0; b < CONFIG_MAX_BUSES; b++) {
+        g_config.buses[b].cpu = -1;
+    }
+    strncpy(g_config.buses[0].device, "/dev/i2c-1", sizeof(g_config.buses[0].device) - 1);
+
+    // Two TMP102s, as on the reference board
+    memset(g_config.sensors, 0, sizeof(g_config.sensors));
+    g_config.sensors[0] = (sensor_config_t){ .id = 1, .address = 0x48, .interval_ms = 1000 };
+    g_config.sensors[1] = (sensor_config_t){ .id = 2, .address = 0x49, .interval_ms = 2000 };
+    g_config.sensor_count = 2;
+    g_config.sensor_max_id = 2;
     g_config.sensor_timeout = 10;
     g_config.network_port = 8080;
     g_config.network_backlog = 5;
+    g_config.network_max_connections = 128;
+    g_config.network_idle_timeout_ms = 10000;
     g_config.queue_max_size = 100;
+    g_config.processor_min_period_ms = 0;
+    g_config.processor_window_ms = 1000;
 
     strncpy(g_config.log_file, "sensor_log.csv", sizeof(g_config.log_file) - 1);
     g_config.log_file[sizeof(g_config.log_file) - 1] = '\0';  // Ensure null termination
+    g_config.log_format = LOG_FORMAT_CSV;
+    g_config.log_buffer_records = 1024;
+    g_config.log_flush_records = 64;
+    g_config.log_flush_interval_ms = 1000;
+    g_config.log_fsync_on_rotate = 0;
+    g_config.log_segment_max_bytes = 0;
+    g_config.log_segment_interval_s = 0;
+    g_config.log_retention_segments = 0;
+    g_config.log_retention_s = 0;
+
+    g_config.history_raw_samples = 3600;
+    g_config.history_seconds = 3600;
+    g_config.history_minutes = 1440;
+    g_config.history_hours = 168;
+
+    g_config.alerts_rules_file[0] = '\0';
+    snprintf(g_config.alerts_log_file, sizeof(g_config.alerts_log_file), "alerts.log");
 }
 
 int config_load(const char *filename) {
@@ -142,6 +380,13 @@ int config_load(const char *filename) {
     char section[64] = "";
     int line_num = 0;
 
+    // The first [sensor.N] section replaces the default sensor table; sensors
+    // set up with legacy [sensors] sensorN_* keys are kept
+    sensor_config_t *current_sensor = NULL;
+    bus_config_t *current_bus = NULL;
+    int sensor_sections = 0;
+    unsigned char legacy_sensor[CONFIG_MAX_SENSORS + 1] = {0};
+
     while (fgets(line, sizeof(line), file)) {
         line_num++;
         char *trimmed = trim(line);
@@ -159,6 +404,39 @@ int config_load(const char *filename) {
                 strncpy(section, trimmed + 1, sizeof(section) - 1);
                 section[sizeof(section) - 1] = '\0';  // Ensure null termination
             }
+            current_sensor = NULL;
+            current_bus = NULL;
+            if (strncmp(section, "bus.", 4) == 0) {
+                int bus;
+                if (!parse_int(section + 4, &bus) || bus < 0 || bus >= CONFIG_MAX_BUSES) {
+                    fprintf(stderr, "[Config] Line %d: Invalid bus number in [%s] (expected 0-%d), ignoring section\n",
+                            line_num, section, CONFIG_MAX_BUSES - 1);
+                    continue;
+                }
+                current_bus = &g_config.buses[bus];
+            } else if (strncmp(section, "sensor.", 7) == 0) {
+                int id;
+                if (!parse_int(section + 7, &id) || id < 1 || id > CONFIG_MAX_SENSORS) {
+                    fprintf(stderr, "[Config] Line %d: Invalid sensor id in [%s] (expected 1-%d), ignoring section\n",
+                            line_num, section, CONFIG_MAX_SENSORS);
+                    continue;
+                }
+                if (!sensor_sections) {
+                    int kept = 0;
+                    for (int i = 0; i < g_config.sensor_count; i++) {
+                        if (legacy_sensor[g_config.sensors[i].id]) {
+                            g_config.sensors[kept++] = g_config.sensors[i];
+                        }
+                    }
+                    g_config.sensor_count = kept;
+                    sensor_sections = 1;
+                }
+                current_sensor = sensor_entry(id);
+                if (!current_sensor) {
+                    fprintf(stderr, "[Config] Line %d: Too many sensors (max %d), ignoring [%s]\n",
+                            line_num, CONFIG_MAX_SENSORS, section);
+                }
+            }
             continue;
         }
 
@@ -180,42 +458,99 @@ int config_load(const char *filename) {
         // Parse based on section and key
         if (strcmp(section, "sensors") == 0) {
             if (strcmp(key, "i2c_device") == 0) {
-                strncpy(g_config.i2c_device, value, sizeof(g_config.i2c_device) - 1);
-                g_config.i2c_device[sizeof(g_config.i2c_device) - 1] = '\0';  // Ensure null termination
-            } else if (strcmp(key, "sensor1_address") == 0) {
+                strncpy(g_config.buses[0].device, value, sizeof(g_config.buses[0].device) - 1);
+                g_config.buses[0].device[sizeof(g_config.buses[0].device) - 1] = '\0';  // Ensure null termination
+            } else if (strcmp(key, "sensor_timeout") == 0) {
                 int val;
                 if (parse_int(value, &val)) {
-                    g_config.sensor1_address = val;
+                    g_config.sensor_timeout = val;
                 } else {
-                    fprintf(stderr, "[Config] Line %d: Invalid sensor1_address, using default\n", line_num);
+                    fprintf(stderr, "[Config] Line %d: Invalid sensor_timeout, using default\n", line_num);
                 }
-            } else if (strcmp(key, "sensor1_interval") == 0) {
+            } else {
+                // Legacy sensorN_address / sensorN_interval keys
+                int id, consumed = 0;
+                if (sscanf(key, "sensor%d_%n", &id, &consumed) == 1 && consumed > 0 &&
+                    id >= 1 && id <= CONFIG_MAX_SENSORS &&
+                    (strcmp(key + consumed, "address") == 0 || strcmp(key + consumed, "interval") == 0)) {
+                    sensor_config_t *sensor = sensor_entry(id);
+                    int val;
+                    if (!sensor) {
+                        fprintf(stderr, "[Config] Line %d: Too many sensors (max %d), ignoring %s\n",
+                                line_num, CONFIG_MAX_SENSORS, key);
+                    } else if (key[consumed] == 'a' ? !parse_int(value, &val)
+                                                    : !parse_seconds_ms(value, &val)) {
+                        fprintf(stderr, "[Config] Line %d: Invalid %s, using default\n", line_num, key);
+                    } else {
+                        if (key[consumed] == 'a') {
+                            sensor->address = val;
+                        } else {
+                            sensor->interval_ms = val;
+                        }
+                        legacy_sensor[id] = 1;
+                    }
+                }
+            }
+        } else if (strncmp(section, "sensor.", 7) == 0) {
+            if (!current_sensor) {
+                continue;
+            }
+            if (strcmp(key, "address") == 0) {
                 int val;
                 if (parse_int(value, &val)) {
-                    g_config.sensor1_interval = val;
+                    current_sensor->address = val;
                 } else {
-                    fprintf(stderr, "[Config] Line %d: Invalid sensor1_interval, using default\n", line_num);
+                    fprintf(stderr, "[Config] Line %d: Invalid address, using default\n", line_num);
                 }
-            } else if (strcmp(key, "sensor2_address") == 0) {
+            } else if (strcmp(key, "interval") == 0) {
+                // Whole seconds; interval_ms allows sub-second rates
+                int val;
+                if (parse_seconds_ms(value, &val)) {
+                    current_sensor->interval_ms = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid interval, using default\n", line_num);
+                }
+            } else if (strcmp(key, "interval_ms") == 0) {
                 int val;
                 if (parse_int(value, &val)) {
-                    g_config.sensor2_address = val;
+                    current_sensor->interval_ms = val;
                 } else {
-                    fprintf(stderr, "[Config] Line %d: Invalid sensor2_address, using default\n", line_num);
+                    fprintf(stderr, "[Config] Line %d: Invalid interval_ms, using default\n", line_num);
                 }
-            } else if (strcmp(key, "sensor2_interval") == 0) {
+            } else if (strcmp(key, "bus") == 0) {
                 int val;
                 if (parse_int(value, &val)) {
-                    g_config.sensor2_interval = val;
+                    current_sensor->bus = val;
                 } else {
-                    fprintf(stderr, "[Config] Line %d: Invalid sensor2_interval, using default\n", line_num);
+                    fprintf(stderr, "[Config] Line %d: Invalid bus, using default\n", line_num);
                 }
-            } else if (strcmp(key, "sensor_timeout") == 0) {
+            } else if (strcmp(key, "filter") == 0) {
+                filter_spec_t filters[CONFIG_MAX_FILTERS];
+                int count;
+                if (parse_filters(value, filters, &count)) {
+                    memcpy(current_sensor->filters, filters, sizeof(filters));
+                    current_sensor->filter_count = count;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid filter, using none\n", line_num);
+                    current_sensor->filter_count = 0;
+                }
+            } else if (strcmp(key, "name") == 0) {
+                strncpy(current_sensor->name, value, sizeof(current_sensor->name) - 1);
+                current_sensor->name[sizeof(current_sensor->name) - 1] = '\0';  // Ensure null termination
+            }
+        } else if (strncmp(section, "bus.", 4) == 0) {
+            if (!current_bus) {
+                continue;
+            }
+            if (strcmp(key, "device") == 0) {
+                strncpy(current_bus->device, value, sizeof(current_bus->device) - 1);
+                current_bus->device[sizeof(current_bus->device) - 1] = '\0';  // Ensure null termination
+            } else if (strcmp(key, "cpu") == 0) {
                 int val;
                 if (parse_int(value, &val)) {
-                    g_config.sensor_timeout = val;
+                    current_bus->cpu = val;
                 } else {
-                    fprintf(stderr, "[Config] Line %d: Invalid sensor_timeout, using default\n", line_num);
+                    fprintf(stderr, "[Config] Line %d: Invalid cpu, using default\n", line_num);
                 }
             }
         } else if (strcmp(section, "network") == 0) {
@@ -233,6 +568,20 @@ int config_load(const char *filename) {
                 } else {
                     fprintf(stderr, "[Config] Line %d: Invalid backlog, using default\n", line_num);
                 }
+            } else if (strcmp(key, "max_connections") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.network_max_connections = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid max_connections, using default\n", line_num);
+                }
+            } else if (strcmp(key, "idle_timeout_ms") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.network_idle_timeout_ms = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid idle_timeout_ms, using default\n", line_num);
+                }
             }
         } else if (strcmp(section, "queue") == 0) {
             if (strcmp(key, "max_size") == 0) {
@@ -243,15 +592,133 @@ int config_load(const char *filename) {
                     fprintf(stderr, "[Config] Line %d: Invalid max_size, using default\n", line_num);
                 }
             }
+        } else if (strcmp(section, "processor") == 0) {
+            if (strcmp(key, "min_period_ms") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.processor_min_period_ms = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid min_period_ms, using default\n", line_num);
+                }
+            } else if (strcmp(key, "window_ms") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.processor_window_ms = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid window_ms, using default\n", line_num);
+                }
+            }
         } else if (strcmp(section, "logging") == 0) {
             if (strcmp(key, "log_file") == 0) {
                 strncpy(g_config.log_file, value, sizeof(g_config.log_file) - 1);
                 g_config.log_file[sizeof(g_config.log_file) - 1] = '\0';  // Ensure null termination
+            } else if (strcmp(key, "format") == 0) {
+                if (strcmp(value, "csv") == 0) {
+                    g_config.log_format = LOG_FORMAT_CSV;
+                } else if (strcmp(value, "binary") == 0) {
+                    g_config.log_format = LOG_FORMAT_BINARY;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid format '%s' (expected csv or binary), using default\n",
+                            line_num, value);
+                }
+            } else if (strcmp(key, "buffer_records") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.log_buffer_records = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid buffer_records, using default\n", line_num);
+                }
+            } else if (strcmp(key, "flush_records") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.log_flush_records = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid flush_records, using default\n", line_num);
+                }
+            } else if (strcmp(key, "flush_interval_ms") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.log_flush_interval_ms = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid flush_interval_ms, using default\n", line_num);
+                }
+            } else if (strcmp(key, "fsync_on_rotate") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.log_fsync_on_rotate = val != 0;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid fsync_on_rotate, using default\n", line_num);
+                }
+            } else if (strcmp(key, "segment_max_bytes") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.log_segment_max_bytes = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid segment_max_bytes, using default\n", line_num);
+                }
+            } else if (strcmp(key, "segment_interval_s") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.log_segment_interval_s = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid segment_interval_s, using default\n", line_num);
+                }
+            } else if (strcmp(key, "retention_segments") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.log_retention_segments = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid retention_segments, using default\n", line_num);
+                }
+            } else if (strcmp(key, "retention_s") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.log_retention_s = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid retention_s, using default\n", line_num);
+                }
+            }
+        } else if (strcmp(section, "history") == 0) {
+            if (strcmp(key, "raw_samples") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.history_raw_samples = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid raw_samples, using default\n", line_num);
+                }
+            } else if (strcmp(key, "seconds") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.history_seconds = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid seconds, using default\n", line_num);
+                }
+            } else if (strcmp(key, "minutes") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.history_minutes = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid minutes, using default\n", line_num);
+                }
+            } else if (strcmp(key, "hours") == 0) {
+                int val;
+                if (parse_int(value, &val)) {
+                    g_config.history_hours = val;
+                } else {
+                    fprintf(stderr, "[Config] Line %d: Invalid hours, using default\n", line_num);
+                }
+            }
+        } else if (strcmp(section, "alerts") == 0) {
+            if (strcmp(key, "rules_file") == 0) {
+                snprintf(g_config.alerts_rules_file, sizeof(g_config.alerts_rules_file), "%s", value);
+            } else if (strcmp(key, "log_file") == 0) {
+                snprintf(g_config.alerts_log_file, sizeof(g_config.alerts_log_file), "%s", value);
             }
         }
     }
 
     fclose(file);
+    finish_sensor_table();
 
     // Validate all configuration values
     if (!validate_config()) {
@@ -261,12 +728,33 @@ int config_load(const char *filename) {
     }
 
     printf("[Config] Loaded configuration from '%s'\n", filename);
-    printf("  Sensor1: address=0x%02x, interval=%ds\n",
-           g_config.sensor1_address, g_config.sensor1_interval);
-    printf("  Sensor2: address=0x%02x, interval=%ds\n",
-           g_config.sensor2_address, g_config.sensor2_interval);
+    for (int i = 0; i < g_config.sensor_count; i++) {
+        const sensor_config_t *sensor = &g_config.sensors[i];
+        printf("  Sensor%d: bus=%d, address=0x%02x, interval=%dms%s%s", sensor->id, sensor->bus,
+               sensor->address, sensor->interval_ms, sensor->name[0] ? ", name=" : "", sensor->name);
+        for (int f = 0; f < sensor->filter_count; f++) {
+            printf("%s%s:%g", f == 0 ? ", filter=" : ",", filter_names[sensor->filters[f].type],
+                   sensor->filters[f].param);
+        }
+        printf("\n");
+    }
+    for (int b = 0; b < CONFIG_MAX_BUSES; b++) {
+        if (config_bus_sensor_count(b) > 0) {
+            printf("  Bus%d: device=%s, cpu=%d\n", b, g_config.buses[b].device, g_config.buses[b].cpu);
+        }
+    }
     printf("  Network: port=%d\n", g_config.network_port);
     printf("  Queue: max_size=%d\n", g_config.queue_max_size);
+    if (g_config.processor_min_period_ms > 0) {
+        printf("  Processor: min_period=%dms\n", g_config.processor_min_period_ms);
+    }
+    if (g_config.processor_window_ms > 0) {
+        printf("  Processor: window=%dms\n", g_config.processor_window_ms);
+    }
+    if (g_config.alerts_rules_file[0]) {
+        printf("  Alerts: rules=%s, log=%s\n", g_config.alerts_rules_file,
+               g_config.alerts_log_file[0] ? g_config.alerts_log_file : "(none)");
+    }
 
     return 0;
 }
@@ -1,25 +1,93 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+// Highest sensor id (ids start at 1). Bounded by the binary log's 8-bit sensor id.
+#define CONFIG_MAX_SENSORS 255
+
+// Most I2C buses ([bus.N] sections, N = 0 to CONFIG_MAX_BUSES-1)
+#define CONFIG_MAX_BUSES 8
+
+// Log file formats
+#define LOG_FORMAT_CSV 0
+#define LOG_FORMAT_BINARY 1
+
+// Most stages in a sensor's filter chain, and the longest median window
+#define CONFIG_MAX_FILTERS 4
+#define CONFIG_FILTER_MEDIAN_MAX 31
+
+// Filter stage types ([sensor.N] filter = median:5, spike:2, ...)
+#define FILTER_MEDIAN 1         // median:N  moving median of the last N samples
+#define FILTER_EWMA   2         // ewma:A    exponentially weighted mean, weight A on each new sample
+#define FILTER_SPIKE  3         // spike:D   drop samples more than D °C from the last accepted one
+#define FILTER_SLEW   4         // slew:R    limit the change to R °C per second
+
+// One stage of a filter chain
+typedef struct {
+    int type;                   // FILTER_*
+    float param;
+} filter_spec_t;
+
+// One entry of the sensor table, from a [sensor.N] section
+typedef struct {
+    int id;                     // 1-based sensor id (the N of [sensor.N])
+    int address;                // 7-bit I2C address
+    int interval_ms;            // Milliseconds between reads
+    int bus;                    // Index into g_config.buses
+    char name[32];              // Display name ("" = "SensorN")
+    filter_spec_t filters[CONFIG_MAX_FILTERS];  // Applied in order by the processor
+    int filter_count;
+} sensor_config_t;
+
+// One I2C adapter, from a [bus.N] section. Each bus with sensors gets its own
+// acquisition thread.
+typedef struct {
+    char device[256];           // e.g. /dev/i2c-1 ("" = not configured)
+    int cpu;                    // CPU to pin the bus thread to (-1 = not pinned)
+} bus_config_t;
+
 // Configuration structure
 typedef struct {
     // Sensor configuration
-    char i2c_device[256];
-    int sensor1_address;
-    int sensor1_interval;
-    int sensor2_address;
-    int sensor2_interval;
+    bus_config_t buses[CONFIG_MAX_BUSES];  // Bus 0 is [sensors] i2c_device
+    sensor_config_t sensors[CONFIG_MAX_SENSORS];  // Sorted by id
+    int sensor_count;           // Entries in sensors
+    int sensor_max_id;          // Highest configured sensor id
     int sensor_timeout;
 
     // Network configuration
     int network_port;
     int network_backlog;
+    int network_max_connections;  // Concurrent client connections served
+    int network_idle_timeout_ms;  // Close keep-alive connections idle this long
 
     // Queue configuration
     int queue_max_size;
 
+    // Processor configuration
+    int processor_min_period_ms;  // Minimum time per processing iteration (0 = no throttling)
+    int processor_window_ms;      // Fuse readings into one record per window (0 = one row per reading)
+
     // Logging configuration
     char log_file[256];
+    int log_format;             // LOG_FORMAT_CSV or LOG_FORMAT_BINARY
+    int log_buffer_records;     // Records per writer buffer (two are allocated)
+    int log_flush_records;      // Flush after this many pending records (0 = off)
+    int log_flush_interval_ms;  // Flush this long after the first pending record (0 = off)
+    int log_fsync_on_rotate;    // fsync the log file when it is rotated or closed
+    int log_segment_max_bytes;  // Roll over to a new segment at this size (0 = off)
+    int log_segment_interval_s; // Roll over to a new segment after this long (0 = off)
+    int log_retention_segments; // Keep at most this many segments (0 = no limit)
+    int log_retention_s;        // Delete segments whose data is older than this (0 = no limit)
+
+    // In-memory history configuration (per sensor)
+    int history_raw_samples;    // Raw samples kept
+    int history_seconds;        // 1 s buckets kept
+    int history_minutes;        // 1 min buckets kept
+    int history_hours;          // 1 h buckets kept
+
+    // Alert configuration
+    char alerts_rules_file[256];  // Alert rules, one per line ("" = no alerts)
+    char alerts_log_file[256];    // Append-only log of alerts firing and clearing
 } config_t;
 
 // Global configuration instance
@@ -32,4 +100,10 @@ int config_load(const char *filename);
 // Load default configuration
 void config_load_defaults(void);
 
+// Look up a sensor by id. Returns NULL if it is not configured.
+const sensor_config_t *config_find_sensor(int id);
+
+// Number of sensors on a bus
+int config_bus_sensor_count(int bus);
+
 #endif // CONFIG_H
@@ -2,136 +2,340 @@
 #include "queue.h"
 #include "utils.h"
 #include "config.h"
+#include "log_writer.h"
+#include "history.h"
+#include "quantile.h"
+#include "rules.h"
+#include "metrics.h"
+#include "latency.h"
+#include "fusion.h"
+#include "filter.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
-#include <unistd.h>
 #include <pthread.h>
 #include <string.h>
 
-// Data processor: collects readings from both sensors, computes the average temperature,
-// prints the result, logs it to a CSV file, and updates the latest reading for remote monitoring.
-// Now with timeout-based error recovery for single sensor failures.
+// Maximum number of readings drained from the queue per iteration
+#define PROCESSOR_BATCH_SIZE 64
+
+// How long a fusion window stays open past its end for readings still on
+// their way through the queue
+#define PROCESSOR_FUSION_GRACE_MS 100
+
+// Per-sensor processing state
+typedef struct {
+    float value;            // Latest temperature
+    time_t last_time;       // When the latest reading was processed
+    int live;               // Has a reading no older than sensor_timeout
+    int timeout_warned;
+} sensor_state_t;
+
+// Per-thread processing state carried across readings and batches
+typedef struct {
+    sensor_state_t sensors[CONFIG_MAX_SENSORS + 1];  // Indexed by sensor id
+    double live_sum;        // Sum of the live sensors' latest values
+    int live_count;
+    filter_chain_t *filters;  // Indexed by sensor id
+
+    // Time of the last row, published once the batch is done
+    int has_update;
+    time_t time_str_ts;
+    char time_str[64];
+    log_record_t row[CONFIG_MAX_SENSORS];  // The log row being built
+
+    // Windowed fusion ([processor] window_ms > 0): the last fused record,
+    // published in place of the per-sensor state
+    int fusing;
+    fusion_t fusion;
+    latest_reading_t fused;
+
+    // When the next stale alert rule can fire (0 = not before a reading)
+    uint64_t next_alert_ms;
+} processor_state_t;
+
+// Mark sensors that have been silent for longer than sensor_timeout as
+// unavailable, and recompute the live sum from scratch so the incremental
+// updates in process_reading cannot drift. Runs once per batch.
+static void check_timeouts(processor_state_t *st, time_t now) {
+    st->live_sum = 0;
+    st->live_count = 0;
+    for (int id = 1; id <= g_config.sensor_max_id; id++) {
+        sensor_state_t *sensor = &st->sensors[id];
+        if (!sensor->live) {
+            continue;
+        }
+        if ((now - sensor->last_time) > g_config.sensor_timeout) {
+            printf("[Processor] Warning: Sensor%d timeout (no data for %lds)\n",
+                   id, (long)(now - sensor->last_time));
+            sensor->live = 0;
+            sensor->timeout_warned = 1;
+            st->has_update = 1;
+            continue;
+        }
+        st->live_sum += sensor->value;
+        st->live_count++;
+    }
+}
+
+// Format t into st->time_str. Rows mostly share a second with their
+// predecessor, so strftime only re-runs on change.
+static void format_time(processor_state_t *st, time_t t) {
+    if (t != st->time_str_ts) {
+        struct tm tm_info;
+        localtime_r(&t, &tm_info);
+        strftime(st->time_str, sizeof(st->time_str), "%Y-%m-%d %H:%M:%S", &tm_info);
+        st->time_str_ts = t;
+    }
+}
+
+// Current CLOCK_REALTIME in Unix milliseconds
+static uint64_t wall_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// Wall-clock time at which a reading was taken, from its monotonic read start
+static uint64_t reading_time_ms(const sensor_reading_t *reading, uint64_t wall_ms,
+                                uint64_t mono_ns) {
+    if (reading->read_start_ns == 0 || reading->read_start_ns > mono_ns) {
+        return (uint64_t)reading->timestamp * 1000;
+    }
+    return wall_ms - (mono_ns - reading->read_start_ns) / 1000000;
+}
+
+// Fusion callback: print the window's record, log it as one row and keep it
+// for publishing once the batch is done
+static void emit_fused(const fusion_record_t *record, void *ctx) {
+    processor_state_t *st = ctx;
+    time_t start = (time_t)(record->start_ms / 1000);
+    format_time(st, start);
+    printf("[Processor] %s | Window average: %.2f°C (%d fresh, %d carried of %d sensors)\n",
+           st->time_str, record->average, record->fresh, record->carried,
+           g_config.sensor_count);
+
+    int count = 0;
+    for (int id = 1; id <= record->sensor_count; id++) {
+        if (record->sources[id - 1] != FUSION_SOURCE_NONE) {
+            st->row[count++] = (log_record_t){ .timestamp = start, .sensor_id = id,
+                                               .temperature = record->values[id - 1] };
+        }
+    }
+    log_writer_append_row(st->row, count);
+
+    snprintf(st->fused.time_str, sizeof(st->fused.time_str), "%s", st->time_str);
+    st->fused.sensor_count = record->sensor_count;
+    memcpy(st->fused.sensors, record->values, sizeof(float) * (size_t)record->sensor_count);
+    st->fused.average = record->average;
+    st->has_update = 1;
+}
+
+// Handle a single reading: run it through its sensor's filter chain, record
+// it in the history and quantiles, check its alert rules, update the sensor's
+// state and the running average, then either feed it to fusion or print the
+// row and hand it to the log writer.
+// Returns 1 if the reading was taken, 0 if it was unknown or filtered out.
+static int process_reading(processor_state_t *st, const sensor_reading_t *reading,
+                           time_t now, uint64_t wall_ms, uint64_t mono_ns) {
+    int id = reading->sensor_id;
+    if (id < 1 || id > g_config.sensor_max_id) {
+        fprintf(stderr, "[Processor] Ignoring reading from unknown sensor %d\n", id);
+        return 0;
+    }
+
+    // Filtered first, so a glitch never reaches the average, history, quantiles or log
+    uint64_t time_ms = reading_time_ms(reading, wall_ms, mono_ns);
+    float value = reading->temperature;
+    if (filter_chain_apply(&st->filters[id], time_ms, &value) != 0) {
+        metrics_sensor_rejected(id);
+        return 0;
+    }
+    history_add(id, reading->timestamp, value);
+    quantile_add(id, reading->timestamp, value);
+    rules_reading(id, time_ms, value);
+
+    sensor_state_t *sensor = &st->sensors[id];
+    if (sensor->live) {
+        st->live_sum += value - sensor->value;
+    } else {
+        st->live_sum += value;
+        st->live_count++;
+        sensor->live = 1;
+        if (sensor->timeout_warned) {
+            printf("[Processor] Sensor%d recovered\n", id);
+            sensor->timeout_warned = 0;
+        }
+    }
+    sensor->value = value;
+    sensor->last_time = now;
+
+    if (st->fusing) {
+        fusion_add(&st->fusion, id, time_ms, value);
+        return 1;
+    }
+
+    format_time(st, now);
+    float average = (float)(st->live_sum / st->live_count);
+    printf("[Processor] %s | Sensor%d: %.2f°C, Average: %.2f°C (%d of %d sensors)\n",
+           st->time_str, id, value, average, st->live_count, g_config.sensor_count);
+
+    // Log the row the console shows: every live sensor's latest value, so the
+    // row's average is the live average
+    int count = 0;
+    for (int live_id = 1; live_id <= g_config.sensor_max_id; live_id++) {
+        if (st->sensors[live_id].live) {
+            st->row[count++] = (log_record_t){ .timestamp = now, .sensor_id = live_id,
+                                               .temperature = st->sensors[live_id].value };
+        }
+    }
+    log_writer_append_row(st->row, count);
+    st->has_update = 1;
+    return 1;
+}
+
+// Snapshot every sensor for network monitoring; sensors that timed out or
+// have not reported yet are published as -999
+static void publish_latest(const processor_state_t *st) {
+    if (st->fusing) {
+        latest_reading_publish(&st->fused);
+        return;
+    }
+    latest_reading_t latest;
+    snprintf(latest.time_str, sizeof(latest.time_str), "%s", st->time_str);
+    latest.sensor_count = g_config.sensor_max_id;
+    for (int id = 1; id <= latest.sensor_count; id++) {
+        const sensor_state_t *sensor = &st->sensors[id];
+        latest.sensors[id - 1] = sensor->live ? sensor->value : -999;
+    }
+    latest.average = st->live_count > 0 ? (float)(st->live_sum / st->live_count) : -999;
+    latest_reading_publish(&latest);
+}
+
+// Data processor: takes readings off the queue in batches, waiting for them at
+// most until the earlier of the next fusion window close (PROCESSOR_FUSION_GRACE_MS
+// after the window ends) and the next stale alert rule that can fire. Each
+// reading goes through its sensor's filter chain ([sensor.N] filter), which
+// counts and drops the readings it rejects; the rest are recorded in the history
+// and quantiles, checked against their sensor's alert rules and kept in the
+// average over the sensors currently reporting (one silent for sensor_timeout
+// seconds drops out until it recovers). With [processor] window_ms = 0 each
+// reading prints and logs a row of the live sensors; otherwise readings are
+// fused into one record per window (see fusion.h), which is what gets printed,
+// logged and published. The latest reading is published and the I2C, queue and
+// processing latencies are recorded once per batch; file I/O happens on the log
+// writer thread. With [processor] min_period_ms set, a batch never starts sooner
+// than that after the previous one, though shutdown cuts the wait short.
 void *data_processor_thread(void *arg) {
     (void)arg;
-    float latest_temp1 = -999, latest_temp2 = -999;
-    int got_sensor1 = 0, got_sensor2 = 0;
-    time_t last_sensor1_time = 0, last_sensor2_time = 0;
-    int sensor1_timeout_warned = 0, sensor2_timeout_warned = 0;
-
-    FILE *log_file = fopen(g_config.log_file, "a");
-    if (!log_file) {
-        perror("Opening log file");
+    processor_state_t st;
+    memset(&st, 0, sizeof(st));
+
+    st.filters = calloc((size_t)g_config.sensor_max_id + 1, sizeof(filter_chain_t));
+    if (!st.filters) {
+        fprintf(stderr, "[Processor] Failed to allocate filter state\n");
         return NULL;
     }
-    // If file is empty, write CSV header
-    fseek(log_file, 0, SEEK_END);
-    if (ftell(log_file) == 0) {
-        fprintf(log_file, "timestamp,sensor1,sensor2,average\n");
-        fflush(log_file);
+    for (int i = 0; i < g_config.sensor_count; i++) {
+        const sensor_config_t *sensor = &g_config.sensors[i];
+        filter_chain_init(&st.filters[sensor->id], sensor->filters, sensor->filter_count);
+    }
+
+    if (log_writer_start(g_config.log_file) != 0) {
+        free(st.filters);
+        return NULL;
     }
 
+    if (g_config.processor_window_ms > 0) {
+        if (fusion_init(&st.fusion, g_config.sensor_max_id, g_config.processor_window_ms,
+                        g_config.sensor_timeout * 1000, emit_fused, &st) != 0) {
+            fprintf(stderr, "[Processor] Failed to set up fusion\n");
+            log_writer_stop();
+            free(st.filters);
+            return NULL;
+        }
+        st.fusing = 1;
+    }
+
+    st.next_alert_ms = rules_tick(wall_now_ms());
+
+    sensor_reading_t batch[PROCESSOR_BATCH_SIZE];
+    int64_t period_ns = (int64_t)g_config.processor_min_period_ms * 1000000;
+
     while (!should_exit()) {
-        sensor_reading_t reading;
-        if (queue_pop(&sensor_queue, &reading) != 0) {
+        uint64_t iter_start = latency_now_ns();
+
+        int count;
+        uint64_t next_close = st.fusing ? fusion_next_close_ms(&st.fusion) : 0;
+        uint64_t due_ms = next_close > 0 ? next_close + PROCESSOR_FUSION_GRACE_MS : 0;
+        if (st.next_alert_ms > 0 && (due_ms == 0 || st.next_alert_ms < due_ms)) {
+            due_ms = st.next_alert_ms;
+        }
+        if (due_ms > 0) {
+            // Wake up in time to close the next window or check a stale
+            // sensor even if nothing arrives
+            uint64_t wall_ms = wall_now_ms();
+            uint64_t wait_ns = due_ms > wall_ms ? (due_ms - wall_ms) * 1000000 : 0;
+            count = queue_pop_batch_until(&sensor_queue, batch, PROCESSOR_BATCH_SIZE,
+                                          latency_now_ns() + wait_ns);
+        } else {
+            count = queue_pop_batch(&sensor_queue, batch, PROCESSOR_BATCH_SIZE);
+        }
+        if (count < 0) {
             break;
         }
+        metrics_processor_iteration();
+        uint64_t dequeued = latency_now_ns();
+        uint64_t wall_ms = wall_now_ms();
 
         time_t now = time(NULL);
-
-        // Update latest value based on sensor ID
-        if (reading.sensor_id == 1) {
-            latest_temp1 = reading.temperature;
-            got_sensor1 = 1;
-            last_sensor1_time = now;
-            if (sensor1_timeout_warned) {
-                printf("[Processor] Sensor1 recovered\n");
-                sensor1_timeout_warned = 0;
-            }
-        } else if (reading.sensor_id == 2) {
-            latest_temp2 = reading.temperature;
-            got_sensor2 = 1;
-            last_sensor2_time = now;
-            if (sensor2_timeout_warned) {
-                printf("[Processor] Sensor2 recovered\n");
-                sensor2_timeout_warned = 0;
-            }
+        check_timeouts(&st, now);
+        for (int i = 0; i < count; i++) {
+            process_reading(&st, &batch[i], now, wall_ms, dequeued);
         }
+        if (st.fusing) {
+            fusion_advance(&st.fusion, wall_ms - PROCESSOR_FUSION_GRACE_MS);
+        }
+        st.next_alert_ms = rules_tick(wall_ms);
 
-        // Check for sensor timeouts on every reading
-        // Only check timeout for sensors that have sent at least one reading
-        int sensor1_timed_out = 0;
-        int sensor2_timed_out = 0;
-
-        if (got_sensor1 && last_sensor1_time > 0 &&
-            (now - last_sensor1_time) > g_config.sensor_timeout) {
-            sensor1_timed_out = 1;
-            if (!sensor1_timeout_warned) {
-                printf("[Processor] Warning: Sensor1 timeout (no data for %lds)\n",
-                       (long)(now - last_sensor1_time));
-                sensor1_timeout_warned = 1;
-            }
+        int published = st.has_update;
+        if (st.has_update) {
+            // Update the latest reading for network monitoring
+            publish_latest(&st);
+            st.has_update = 0;
         }
 
-        if (got_sensor2 && last_sensor2_time > 0 &&
-            (now - last_sensor2_time) > g_config.sensor_timeout) {
-            sensor2_timed_out = 1;
-            if (!sensor2_timeout_warned) {
-                printf("[Processor] Warning: Sensor2 timeout (no data for %lds)\n",
-                       (long)(now - last_sensor2_time));
-                sensor2_timeout_warned = 1;
+        // Every reading in the batch is reflected in what was just published
+        uint64_t visible = published ? latency_now_ns() : 0;
+        for (int i = 0; i < count; i++) {
+            latency_record(LATENCY_I2C_READ, batch[i].read_start_ns, batch[i].read_end_ns);
+            latency_record(LATENCY_QUEUE_WAIT, batch[i].enqueue_ns, dequeued);
+            if (published) {
+                latency_record(LATENCY_PROCESS, dequeued, visible);
+                latency_record(LATENCY_END_TO_END, batch[i].read_start_ns, visible);
             }
         }
 
-        // Process readings based on availability
-        int should_process = 0;
-        float average = 0;
-        char time_str[64];
-        struct tm tm_info;
-        localtime_r(&now, &tm_info);
-        strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &tm_info);
-
-        if (got_sensor1 && got_sensor2 && !sensor1_timed_out && !sensor2_timed_out) {
-            // Both sensors working - process normally
-            average = (latest_temp1 + latest_temp2) / 2.0f;
-            printf("[Processor] %s | Sensor1: %.2f°C, Sensor2: %.2f°C, Average: %.2f°C\n",
-                   time_str, latest_temp1, latest_temp2, average);
-            fprintf(log_file, "%s,%.2f,%.2f,%.2f\n", time_str, latest_temp1, latest_temp2, average);
-            should_process = 1;
-            got_sensor1 = got_sensor2 = 0;
-        } else if (got_sensor1 && (sensor2_timed_out || !got_sensor2)) {
-            // Only sensor1 available or sensor2 timed out
-            average = latest_temp1;  // Use sensor1 only
-            printf("[Processor] %s | Sensor1: %.2f°C, Sensor2: N/A, Average: %.2f°C (sensor2 unavailable)\n",
-                   time_str, latest_temp1, average);
-            fprintf(log_file, "%s,%.2f,N/A,%.2f\n", time_str, latest_temp1, average);
-            should_process = 1;
-            got_sensor1 = 0;
-        } else if (got_sensor2 && (sensor1_timed_out || !got_sensor1)) {
-            // Only sensor2 available or sensor1 timed out
-            average = latest_temp2;  // Use sensor2 only
-            printf("[Processor] %s | Sensor1: N/A, Sensor2: %.2f°C, Average: %.2f°C (sensor1 unavailable)\n",
-                   time_str, latest_temp2, average);
-            fprintf(log_file, "%s,N/A,%.2f,%.2f\n", time_str, latest_temp2, average);
-            should_process = 1;
-            got_sensor2 = 0;
+        if (period_ns > 0) {
+            // Throttle: don't start the next batch before the period has
+            // elapsed, but wake at once on shutdown
+            queue_sleep_until(&sensor_queue, iter_start + (uint64_t)period_ns);
         }
-
-        if (should_process) {
-            fflush(log_file);
-
-            // Update the latest reading for network monitoring
-            // Use timeout flags instead of got_sensorX (which are already reset)
-            pthread_mutex_lock(&latest_mutex);
-            snprintf(latest_reading.time_str, sizeof(latest_reading.time_str), "%s", time_str);
-            latest_reading.sensor1 = sensor1_timed_out ? -999 : latest_temp1;
-            latest_reading.sensor2 = sensor2_timed_out ? -999 : latest_temp2;
-            latest_reading.average = average;
-            pthread_mutex_unlock(&latest_mutex);
+    }
+    if (st.fusing) {
+        // Close the windows the last readings went into
+        fusion_advance(&st.fusion, wall_now_ms() + (uint64_t)g_config.processor_window_ms);
+        if (st.fusion.late > 0) {
+            printf("[Processor] Fusion: %lu late readings dropped\n", st.fusion.late);
         }
-
-        usleep(100000); // Simulate processing time (100 ms)
+        fusion_destroy(&st.fusion);
     }
-    fclose(log_file);
+    log_writer_stop();
+    free(st.filters);
+
+    log_writer_stats_t stats;
+    log_writer_get_stats(&stats);
+    printf("[Processor] Log writer: %lu records written, %lu dropped, %lu flushes\n",
+           stats.written, stats.dropped, stats.flushes);
     return NULL;
 }
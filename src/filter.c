@@ -0,0 +1,124 @@
+#include "filter.h"
+#include <string.h>
+
+void filter_chain_init(filter_chain_t *chain, const filter_spec_t *specs, int count) {
+    memset(chain, 0, sizeof(*chain));
+    chain->count = count < CONFIG_MAX_FILTERS ? count : CONFIG_MAX_FILTERS;
+    for (int i = 0; i < chain->count; i++) {
+        chain->stages[i].spec = specs[i];
+    }
+    filter_chain_reset(chain);
+}
+
+void filter_chain_reset(filter_chain_t *chain) {
+    for (int i = 0; i < chain->count; i++) {
+        filter_stage_t *stage = &chain->stages[i];
+        filter_spec_t spec = stage->spec;
+        memset(stage, 0, sizeof(*stage));
+        stage->spec = spec;
+        if (spec.type == FILTER_MEDIAN) {
+            int window = (int)spec.param;
+            stage->window = window < 1 ? 1
+                          : window > CONFIG_FILTER_MEDIAN_MAX ? CONFIG_FILTER_MEDIAN_MAX : window;
+        }
+    }
+}
+
+// First index in sorted[0..count) whose value is not less than x
+static int lower_bound(const float *sorted, int count, float x) {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (sorted[mid] < x) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static float median_apply(filter_stage_t *stage, float x) {
+    if (stage->count == stage->window) {
+        // Drop the oldest sample from the sorted copy
+        float oldest = stage->ring[stage->next];
+        int i = lower_bound(stage->sorted, stage->count, oldest);
+        memmove(&stage->sorted[i], &stage->sorted[i + 1],
+                sizeof(float) * (size_t)(stage->count - i - 1));
+        stage->count--;
+    }
+    stage->ring[stage->next] = x;
+    if (++stage->next == stage->window) {
+        stage->next = 0;
+    }
+
+    int i = lower_bound(stage->sorted, stage->count, x);
+    memmove(&stage->sorted[i + 1], &stage->sorted[i], sizeof(float) * (size_t)(stage->count - i));
+    stage->sorted[i] = x;
+    stage->count++;
+
+    int mid = stage->count / 2;
+    if (stage->count % 2) {
+        return stage->sorted[mid];
+    }
+    return (stage->sorted[mid - 1] + stage->sorted[mid]) / 2;
+}
+
+// Run one stage. Returns 0 with *x updated, or -1 to reject the sample.
+static int stage_apply(filter_stage_t *stage, uint64_t time_ms, float *x) {
+    float param = stage->spec.param;
+    switch (stage->spec.type) {
+    case FILTER_MEDIAN:
+        *x = median_apply(stage, *x);
+        return 0;
+
+    case FILTER_EWMA:
+        stage->y = stage->primed ? stage->y + param * (*x - stage->y) : *x;
+        stage->primed = 1;
+        *x = stage->y;
+        return 0;
+
+    case FILTER_SPIKE: {
+        float delta = *x - stage->y;
+        if (stage->primed && (delta > param || delta < -param) &&
+            stage->rejects < FILTER_SPIKE_MAX_REJECTS) {
+            stage->rejects++;
+            return -1;
+        }
+        stage->y = *x;
+        stage->primed = 1;
+        stage->rejects = 0;
+        return 0;
+    }
+
+    case FILTER_SLEW:
+        if (stage->primed) {
+            // Samples out of order or at the same time may not move at all
+            uint64_t dt_ms = time_ms > stage->last_ms ? time_ms - stage->last_ms : 0;
+            float limit = param * (float)dt_ms / 1000.0f;
+            if (*x > stage->y + limit) {
+                *x = stage->y + limit;
+            } else if (*x < stage->y - limit) {
+                *x = stage->y - limit;
+            }
+        }
+        stage->y = *x;
+        if (!stage->primed || time_ms > stage->last_ms) {
+            stage->last_ms = time_ms;
+        }
+        stage->primed = 1;
+        return 0;
+
+    default:
+        return 0;
+    }
+}
+
+int filter_chain_apply(filter_chain_t *chain, uint64_t time_ms, float *value) {
+    for (int i = 0; i < chain->count; i++) {
+        if (stage_apply(&chain->stages[i], time_ms, value) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stdint.h>
+#include "config.h"
+
+// Per-sensor streaming filter chains ([sensor.N] filter).
+//
+// A chain runs each sample through its stages in order; every stage keeps a
+// fixed amount of state and either passes on a (possibly changed) value or
+// rejects the sample, which ends the chain for it:
+//
+//   median:N  Median of the last N samples. Removes isolated glitches without
+//             smoothing steps, at the cost of (N - 1) / 2 samples of delay.
+//             O(N) per sample with N <= CONFIG_FILTER_MEDIAN_MAX: two binary
+//             searches and at most N floats moved.
+//   ewma:A    y += A * (x - y). A = 1 passes samples through; smaller A
+//             smooths more. O(1).
+//   spike:D   Rejects a sample more than D °C from the last accepted one.
+//             After FILTER_SPIKE_MAX_REJECTS rejections in a row the next
+//             sample is accepted as a genuine step. O(1).
+//   slew:R    Limits the change to R °C per second of sample time. O(1).
+//
+// Chains are not thread-safe; the processor owns one per sensor.
+
+// Consecutive rejections after which spike accepts the new level
+#define FILTER_SPIKE_MAX_REJECTS 3
+
+typedef struct {
+    filter_spec_t spec;
+    int primed;                 // Has seen a sample
+    float y;                    // ewma/slew output, spike reference
+    uint64_t last_ms;           // slew: time of the last sample
+    int rejects;                // spike: rejections in a row
+    int window;                 // median: N
+    int count;                  // median: samples in the window
+    int next;                   // median: ring slot of the oldest sample
+    float ring[CONFIG_FILTER_MEDIAN_MAX];    // median: samples in arrival order
+    float sorted[CONFIG_FILTER_MEDIAN_MAX];  // median: the same samples, sorted
+} filter_stage_t;
+
+typedef struct {
+    int count;
+    filter_stage_t stages[CONFIG_MAX_FILTERS];
+} filter_chain_t;
+
+// Set up a chain of count stages (0 = pass everything through)
+void filter_chain_init(filter_chain_t *chain, const filter_spec_t *specs, int count);
+
+// Forget every sample seen so far
+void filter_chain_reset(filter_chain_t *chain);
+
+// Run a sample taken at time_ms through the chain, replacing *value with the
+// filtered one. Returns 0 if the sample passed, -1 if a stage rejected it
+// (*value is then unspecified).
+int filter_chain_apply(filter_chain_t *chain, uint64_t time_ms, float *value);
+
+#endif // FILTER_H
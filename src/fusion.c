@@ -0,0 +1,135 @@
+#include "fusion.h"
+#include <stdlib.h>
+#include <string.h>
+
+int fusion_init(fusion_t *f, int sensor_count, int window_ms, int max_age_ms,
+                fusion_emit_fn emit, void *ctx) {
+    memset(f, 0, sizeof(*f));
+    if (sensor_count < 0 || sensor_count > CONFIG_MAX_SENSORS || window_ms <= 0 || max_age_ms < 0) {
+        return -1;
+    }
+    f->sensors = calloc((size_t)sensor_count + 1, sizeof(fusion_sensor_t));
+    if (!f->sensors) {
+        return -1;
+    }
+    f->sensor_count = sensor_count;
+    f->window_ms = (uint64_t)window_ms;
+    f->max_age_ms = (uint64_t)max_age_ms;
+    f->emit = emit;
+    f->ctx = ctx;
+    return 0;
+}
+
+void fusion_destroy(fusion_t *f) {
+    free(f->sensors);
+    f->sensors = NULL;
+}
+
+// Close the oldest open window and emit its record, unless no sensor has a value
+static void close_window(fusion_t *f) {
+    uint64_t k = f->open;
+    uint64_t end_ms = (k + 1) * f->window_ms;
+    fusion_record_t *rec = &f->record;
+    rec->start_ms = k * f->window_ms;
+    rec->sensor_count = f->sensor_count;
+    rec->fresh = 0;
+    rec->carried = 0;
+
+    double sum = 0;
+    for (int id = 1; id <= f->sensor_count; id++) {
+        fusion_sensor_t *s = &f->sensors[id];
+        fusion_acc_t *acc = &s->acc[k & 1];
+        float value = FUSION_MISSING;
+        unsigned char source = FUSION_SOURCE_NONE;
+        if (acc->count > 0 && acc->window == k) {
+            value = (float)(acc->sum / acc->count);
+            source = FUSION_SOURCE_FRESH;
+            rec->fresh++;
+            s->last = value;
+            s->last_ms = acc->newest_ms;
+            s->has_last = 1;
+            if (s->last_ms + f->max_age_ms > f->carry_until) {
+                f->carry_until = s->last_ms + f->max_age_ms;
+            }
+            acc->count = 0;
+            acc->sum = 0;
+        } else if (s->has_last && end_ms - s->last_ms <= f->max_age_ms) {
+            value = s->last;
+            source = FUSION_SOURCE_CARRIED;
+            rec->carried++;
+        }
+        rec->values[id - 1] = value;
+        rec->sources[id - 1] = source;
+        if (source != FUSION_SOURCE_NONE) {
+            sum += value;
+        }
+    }
+    f->pending[k & 1] = 0;
+    f->open = k + 1;
+
+    int available = rec->fresh + rec->carried;
+    if (available > 0 && f->emit) {
+        rec->average = (float)(sum / available);
+        f->emit(rec, f->ctx);
+    }
+}
+
+// Close windows until target is the oldest open one
+static void close_until(fusion_t *f, uint64_t target) {
+    while (f->open < target) {
+        // Nothing pending and nothing left to carry: the rest would all be empty
+        if (f->pending[0] == 0 && f->pending[1] == 0 &&
+            (f->open + 1) * f->window_ms > f->carry_until) {
+            f->open = target;
+            return;
+        }
+        close_window(f);
+    }
+}
+
+int fusion_add(fusion_t *f, int sensor_id, uint64_t time_ms, float value) {
+    if (sensor_id < 1 || sensor_id > f->sensor_count) {
+        return -1;
+    }
+    uint64_t w = time_ms / f->window_ms;
+    if (!f->started) {
+        f->open = w;
+        f->started = 1;
+    }
+    if (w < f->open) {
+        f->late++;
+        return -1;
+    }
+    if (w > f->open + 1) {
+        close_until(f, w - 1);
+    }
+
+    fusion_acc_t *acc = &f->sensors[sensor_id].acc[w & 1];
+    if (acc->count == 0) {
+        acc->window = w;
+        acc->sum = 0;
+        acc->newest_ms = time_ms;
+    }
+    acc->sum += value;
+    acc->count++;
+    if (time_ms > acc->newest_ms) {
+        acc->newest_ms = time_ms;
+    }
+    f->pending[w & 1]++;
+    return 0;
+}
+
+void fusion_advance(fusion_t *f, uint64_t watermark_ms) {
+    if (f->started) {
+        close_until(f, watermark_ms / f->window_ms);
+    }
+}
+
+uint64_t fusion_next_close_ms(const fusion_t *f) {
+    uint64_t end_ms = (f->open + 1) * f->window_ms;
+    if (!f->started ||
+        (f->pending[0] == 0 && f->pending[1] == 0 && end_ms > f->carry_until)) {
+        return 0;
+    }
+    return end_ms;
+}
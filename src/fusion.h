@@ -0,0 +1,94 @@
+#ifndef FUSION_H
+#define FUSION_H
+
+#include <stdint.h>
+#include "config.h"
+
+// Time-aligned fusion of readings from any number of sensors.
+//
+// Time is cut into fixed windows [k * window_ms, (k + 1) * window_ms) of Unix
+// milliseconds, and each window yields exactly one fused record. A sensor's
+// value in a window is the mean of its readings in that window or, if it had
+// none, its last window value carried forward while the reading behind it is
+// no older than max_age_ms at the window's end; otherwise it is missing.
+//
+// Readings may arrive up to one window ahead of the oldest open window.
+// Windows close in order, when fusion_advance's watermark passes their end
+// or a reading for a later window needs the room, and every record is handed
+// to the emit callback. Readings for a window that has already closed are
+// counted as late and dropped. The output depends only on the sequence of
+// calls, never on the clock.
+//
+// Adding a reading is O(1) and closing a window O(sensors). Stretches with no
+// readings and nothing left to carry forward are skipped without emitting
+// records.
+
+// Value of a missing sensor
+#define FUSION_MISSING -999
+
+// Where a sensor's value in a record came from
+#define FUSION_SOURCE_NONE    0  // Missing
+#define FUSION_SOURCE_FRESH   1  // Readings in this window
+#define FUSION_SOURCE_CARRIED 2  // Carried forward from an earlier window
+
+typedef struct {
+    uint64_t start_ms;                          // Window start (Unix ms)
+    int sensor_count;                           // Entries in use (the highest sensor id)
+    int fresh;                                  // Sensors with readings in the window
+    int carried;                                // Sensors carried forward
+    float average;                              // Mean of the available values, or FUSION_MISSING
+    float values[CONFIG_MAX_SENSORS];           // Indexed by sensor id - 1, or FUSION_MISSING
+    unsigned char sources[CONFIG_MAX_SENSORS];  // FUSION_SOURCE_*
+} fusion_record_t;
+
+typedef void (*fusion_emit_fn)(const fusion_record_t *record, void *ctx);
+
+// Readings of one sensor in one window
+typedef struct {
+    uint64_t window;        // Window index
+    double sum;
+    unsigned int count;
+    uint64_t newest_ms;     // Time of the newest reading
+} fusion_acc_t;
+
+typedef struct {
+    fusion_acc_t acc[2];    // Open window and the one after it, by window parity
+    float last;             // Value of the last window with readings
+    uint64_t last_ms;       // Time of the newest reading behind last
+    int has_last;
+} fusion_sensor_t;
+
+typedef struct {
+    int sensor_count;
+    uint64_t window_ms;
+    uint64_t max_age_ms;
+    uint64_t open;          // Index of the oldest window not yet closed
+    int started;            // open is set (by the first reading)
+    uint64_t carry_until;   // No carried value is usable in windows ending after this time
+    unsigned int pending[2];  // Readings accumulated per window parity
+    unsigned long late;     // Readings dropped because their window had closed
+    fusion_sensor_t *sensors; // Indexed by sensor id
+    fusion_record_t record; // Scratch record handed to emit
+    fusion_emit_fn emit;
+    void *ctx;
+} fusion_t;
+
+// Set up fusion for sensor ids 1..sensor_count. Returns 0 on success, -1 on failure.
+int fusion_init(fusion_t *f, int sensor_count, int window_ms, int max_age_ms,
+                fusion_emit_fn emit, void *ctx);
+
+// Free the sensor state
+void fusion_destroy(fusion_t *f);
+
+// Add a reading taken at time_ms. May first close windows to make room.
+// Returns 0 if the reading was taken, -1 if it was late or its sensor unknown.
+int fusion_add(fusion_t *f, int sensor_id, uint64_t time_ms, float value);
+
+// Close every window that ends at or before watermark_ms
+void fusion_advance(fusion_t *f, uint64_t watermark_ms);
+
+// End of the oldest open window that will produce a record, or 0 if there is
+// none (nothing pending and nothing to carry forward)
+uint64_t fusion_next_close_ms(const fusion_t *f);
+
+#endif // FUSION_H
@@ -0,0 +1,282 @@
+#include "history.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// Rollup bucket as stored; the mean is derived from sum/count when queried
+typedef struct {
+    time_t start;
+    float min;
+    float max;
+    double sum;
+    unsigned int count;
+} rollup_slot_t;
+
+// Ring of buckets at one resolution. The bucket starting at t lives in slot
+// (t / seconds) % slots, so lookups and updates never search.
+typedef struct {
+    int seconds;
+    int slots;
+    rollup_slot_t *buckets;
+} rollup_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+
+    // Raw samples, stored as two arrays so range scans only touch timestamps
+    time_t *timestamps;
+    float *values;
+    int capacity;
+    int head;           // Next slot to write
+    int count;
+
+    time_t newest;      // Newest timestamp seen, bounds rollup queries
+    rollup_t rollups[HISTORY_RES_COUNT];  // Index HISTORY_RES_RAW is unused
+} sensor_history_t;
+
+static const int rollup_seconds[HISTORY_RES_COUNT] = { 0, 1, 60, 3600 };
+static const char *resolution_names[HISTORY_RES_COUNT] = { "raw", "1s", "1m", "1h" };
+
+static sensor_history_t histories[HISTORY_MAX_SENSORS];
+static int history_sensors = 0;
+
+static void free_sensor(sensor_history_t *h) {
+    free(h->timestamps);
+    free(h->values);
+    for (int r = HISTORY_RES_1S; r < HISTORY_RES_COUNT; r++) {
+        free(h->rollups[r].buckets);
+    }
+    memset(h, 0, sizeof(*h));
+}
+
+int history_init(int sensor_count, int raw_samples, int seconds, int minutes, int hours) {
+    if (sensor_count < 1 || sensor_count > HISTORY_MAX_SENSORS || raw_samples < 1 ||
+        seconds < 1 || minutes < 1 || hours < 1) {
+        fprintf(stderr, "[History] Invalid history sizes\n");
+        return -1;
+    }
+    history_destroy();
+
+    const int slots[HISTORY_RES_COUNT] = { 0, seconds, minutes, hours };
+    for (int s = 0; s < sensor_count; s++) {
+        sensor_history_t *h = &histories[s];
+        h->timestamps = malloc((size_t)raw_samples * sizeof(*h->timestamps));
+        h->values = malloc((size_t)raw_samples * sizeof(*h->values));
+        h->capacity = raw_samples;
+        int ok = h->timestamps && h->values;
+        for (int r = HISTORY_RES_1S; r < HISTORY_RES_COUNT; r++) {
+            h->rollups[r].seconds = rollup_seconds[r];
+            h->rollups[r].slots = slots[r];
+            h->rollups[r].buckets = calloc((size_t)slots[r], sizeof(rollup_slot_t));
+            ok = ok && h->rollups[r].buckets;
+        }
+        if (!ok) {
+            fprintf(stderr, "[History] Allocation failure\n");
+            for (int i = 0; i <= s; i++) {
+                free_sensor(&histories[i]);
+            }
+            return -1;
+        }
+        pthread_mutex_init(&h->mutex, NULL);
+    }
+    history_sensors = sensor_count;
+    return 0;
+}
+
+void history_destroy(void) {
+    for (int s = 0; s < history_sensors; s++) {
+        pthread_mutex_destroy(&histories[s].mutex);
+        free_sensor(&histories[s]);
+    }
+    history_sensors = 0;
+}
+
+static sensor_history_t *get_sensor(int sensor_id) {
+    if (sensor_id < 1 || sensor_id > history_sensors) {
+        return NULL;
+    }
+    return &histories[sensor_id - 1];
+}
+
+static time_t bucket_start(time_t timestamp, int seconds) {
+    time_t rem = timestamp % seconds;
+    return timestamp - (rem < 0 ? rem + seconds : rem);
+}
+
+static rollup_slot_t *bucket_slot(const rollup_t *rollup, time_t start) {
+    long long index = (long long)(start / rollup->seconds) % rollup->slots;
+    if (index < 0) index += rollup->slots;
+    return &rollup->buckets[index];
+}
+
+void history_add(int sensor_id, time_t timestamp, float value) {
+    sensor_history_t *h = get_sensor(sensor_id);
+    if (!h) {
+        return;
+    }
+
+    pthread_mutex_lock(&h->mutex);
+
+    h->timestamps[h->head] = timestamp;
+    h->values[h->head] = value;
+    h->head = (h->head + 1) % h->capacity;
+    if (h->count < h->capacity) {
+        h->count++;
+    }
+    if (timestamp > h->newest) {
+        h->newest = timestamp;
+    }
+
+    for (int r = HISTORY_RES_1S; r < HISTORY_RES_COUNT; r++) {
+        const rollup_t *rollup = &h->rollups[r];
+        time_t start = bucket_start(timestamp, rollup->seconds);
+        rollup_slot_t *slot = bucket_slot(rollup, start);
+        if (slot->count == 0 || slot->start < start) {
+            // Slot holds an expired bucket (or nothing): start over
+            slot->start = start;
+            slot->min = slot->max = value;
+            slot->sum = value;
+            slot->count = 1;
+        } else if (slot->start == start) {
+            if (value < slot->min) slot->min = value;
+            if (value > slot->max) slot->max = value;
+            slot->sum += value;
+            slot->count++;
+        }
+        // Otherwise the reading is older than the ring covers at this resolution
+    }
+
+    pthread_mutex_unlock(&h->mutex);
+}
+
+int history_query_raw(int sensor_id, time_t from, time_t to, history_sample_t *out, int max) {
+    sensor_history_t *h = get_sensor(sensor_id);
+    if (!h) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&h->mutex);
+    // Walk newest to oldest so the newest max samples are kept
+    int n = 0;
+    for (int i = 0; i < h->count && n < max; i++) {
+        int idx = (h->head - 1 - i + h->capacity) % h->capacity;
+        time_t ts = h->timestamps[idx];
+        if (ts >= from && ts <= to) {
+            out[n].timestamp = ts;
+            out[n].value = h->values[idx];
+            n++;
+        }
+    }
+    pthread_mutex_unlock(&h->mutex);
+
+    for (int i = 0, j = n - 1; i < j; i++, j--) {
+        history_sample_t tmp = out[i];
+        out[i] = out[j];
+        out[j] = tmp;
+    }
+    return n;
+}
+
+// Slot of the i-th oldest raw sample
+static int raw_slot(const sensor_history_t *h, int i) {
+    return (h->head - h->count + i + 2 * h->capacity) % h->capacity;
+}
+
+// Number of raw samples, oldest first, with timestamp < t (or <= t if inclusive).
+// A sensor's readings arrive in time order, so the ring is sorted oldest to newest.
+static int raw_bound(const sensor_history_t *h, time_t t, int inclusive) {
+    int lo = 0, hi = h->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        time_t ts = h->timestamps[raw_slot(h, mid)];
+        if (ts < t || (inclusive && ts == t)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int history_query_stats(int sensor_id, time_t from, time_t to, simd_stats_t *out) {
+    sensor_history_t *h = get_sensor(sensor_id);
+    if (!h) {
+        return -1;
+    }
+
+    simd_stats_acc_t acc;
+    simd_stats_begin(&acc);
+
+    pthread_mutex_lock(&h->mutex);
+    int first = raw_bound(h, from, 0);
+    int last = raw_bound(h, to, 1);
+    if (first < last) {
+        // The matching run wraps around the end of the ring at most once
+        int start = raw_slot(h, first);
+        int n = last - first;
+        int run = n < h->capacity - start ? n : h->capacity - start;
+        simd_stats_add_f32(&acc, &h->values[start], (size_t)run);
+        simd_stats_add_f32(&acc, h->values, (size_t)(n - run));
+    }
+    pthread_mutex_unlock(&h->mutex);
+
+    simd_stats_end(&acc, out);
+    return 0;
+}
+
+int history_query_buckets(int sensor_id, history_res_t res, time_t from, time_t to,
+                          history_bucket_t *out, int max) {
+    sensor_history_t *h = get_sensor(sensor_id);
+    if (!h || res <= HISTORY_RES_RAW || res >= HISTORY_RES_COUNT) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&h->mutex);
+    const rollup_t *rollup = &h->rollups[res];
+    int n = 0;
+    if (h->count > 0 && from <= to) {
+        // Only the last `slots` buckets up to the newest reading can be present
+        time_t hi = bucket_start(to < h->newest ? to : h->newest, rollup->seconds);
+        time_t oldest = hi - (time_t)(rollup->slots - 1) * rollup->seconds;
+        time_t lo = bucket_start(from, rollup->seconds);
+        if (lo < oldest) lo = oldest;
+
+        for (time_t start = hi; start >= lo && n < max; start -= rollup->seconds) {
+            const rollup_slot_t *slot = bucket_slot(rollup, start);
+            if (slot->count == 0 || slot->start != start) {
+                continue;
+            }
+            out[n].start = start;
+            out[n].min = slot->min;
+            out[n].max = slot->max;
+            out[n].mean = (float)(slot->sum / slot->count);
+            out[n].count = slot->count;
+            n++;
+        }
+    }
+    pthread_mutex_unlock(&h->mutex);
+
+    for (int i = 0, j = n - 1; i < j; i++, j--) {
+        history_bucket_t tmp = out[i];
+        out[i] = out[j];
+        out[j] = tmp;
+    }
+    return n;
+}
+
+int history_parse_resolution(const char *name) {
+    for (int r = 0; r < HISTORY_RES_COUNT; r++) {
+        if (strcmp(name, resolution_names[r]) == 0) {
+            return r;
+        }
+    }
+    return -1;
+}
+
+const char *history_resolution_name(history_res_t res) {
+    if (res < 0 || res >= HISTORY_RES_COUNT) {
+        return "unknown";
+    }
+    return resolution_names[res];
+}
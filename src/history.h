@@ -0,0 +1,72 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <time.h>
+#include "config.h"
+#include "simd_stats.h"
+
+// In-memory per-sensor history.
+//
+// Each sensor keeps a fixed-size ring of raw samples plus rollup rings of
+// min/max/mean/count buckets at 1 s, 1 min and 1 h resolution. All memory is
+// allocated by history_init; history_add updates the raw ring and every rollup
+// in O(1), so the processor can record each reading as it arrives.
+
+// Highest sensor id that can be recorded (ids start at 1)
+#define HISTORY_MAX_SENSORS CONFIG_MAX_SENSORS
+
+typedef enum {
+    HISTORY_RES_RAW = 0,
+    HISTORY_RES_1S,
+    HISTORY_RES_1M,
+    HISTORY_RES_1H,
+    HISTORY_RES_COUNT
+} history_res_t;
+
+typedef struct {
+    time_t timestamp;
+    float value;
+} history_sample_t;
+
+typedef struct {
+    time_t start;       // Bucket start time (a multiple of the resolution)
+    float min;
+    float max;
+    float mean;
+    unsigned int count; // Samples in the bucket
+} history_bucket_t;
+
+// Allocate history for sensors 1..sensor_count. raw_samples, seconds, minutes
+// and hours are the number of raw samples and 1 s / 1 min / 1 h buckets kept
+// per sensor. Returns 0 on success, -1 on failure.
+int history_init(int sensor_count, int raw_samples, int seconds, int minutes, int hours);
+
+// Free all history memory
+void history_destroy(void);
+
+// Record a reading. Readings for unknown sensors or before history_init are ignored.
+void history_add(int sensor_id, time_t timestamp, float value);
+
+// Copy raw samples with from <= timestamp <= to into out, oldest first.
+// If more than max match, the newest max are returned. Returns the number copied,
+// or -1 for an unknown sensor.
+int history_query_raw(int sensor_id, time_t from, time_t to, history_sample_t *out, int max);
+
+// Min/max/mean/stddev of the raw samples with from <= timestamp <= to, reduced
+// with the SIMD kernels straight out of the ring. Returns 0 (out->count is 0 if
+// nothing matched), or -1 for an unknown sensor.
+int history_query_stats(int sensor_id, time_t from, time_t to, simd_stats_t *out);
+
+// Copy non-empty rollup buckets overlapping [from, to] at resolution res into out,
+// oldest first, keeping the newest max. Returns the number copied, or -1 for an
+// unknown sensor or resolution.
+int history_query_buckets(int sensor_id, history_res_t res, time_t from, time_t to,
+                          history_bucket_t *out, int max);
+
+// Parse a resolution name ("raw", "1s", "1m", "1h"). Returns -1 if unknown.
+int history_parse_resolution(const char *name);
+
+// Name of a resolution, as accepted by history_parse_resolution
+const char *history_resolution_name(history_res_t res);
+
+#endif // HISTORY_H
@@ -0,0 +1,350 @@
+#include "i2c_bus.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+// Most buses a process opens through i2c_bus_get
+#define I2C_MAX_BUSES 8
+
+int i2c_bus_init(i2c_bus_t *bus, const char *device, const i2c_backend_t *backend, void *ctx) {
+    memset(bus, 0, sizeof(*bus));
+    snprintf(bus->device, sizeof(bus->device), "%s", device);
+    bus->backend = backend;
+    bus->ctx = ctx;
+    bus->fd = -1;
+    bus->max_batch = I2C_BUS_MAX_BATCH;
+    if (pthread_mutex_init(&bus->lock, NULL) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+void i2c_bus_destroy(i2c_bus_t *bus) {
+    if (bus->fd >= 0) {
+        bus->backend->close(bus);
+        bus->fd = -1;
+    }
+    pthread_mutex_destroy(&bus->lock);
+}
+
+// Errors where the device NACKed or timed out. The handle is still good, so
+// reopening would only add syscalls to every read of an absent sensor.
+static int is_device_error(int err) {
+    return err == -ENXIO || err == -EREMOTEIO || err == -ETIMEDOUT || err == -EAGAIN;
+}
+
+// Errors where the adapter refused the transfer as a whole
+static int is_rejected(int err) {
+    return err == -EOPNOTSUPP || err == -EINVAL;
+}
+
+// i2c_bus_transfer with bus->lock held
+static int transfer_locked(i2c_bus_t *bus, struct i2c_msg *msgs, int count) {
+    int rc = 0;
+    // A broken handle gets one reopen and retry within the same call
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (bus->fd < 0) {
+            rc = bus->backend->open(bus);
+            if (rc != 0) {
+                break;
+            }
+            bus->stats.opens++;
+        }
+        bus->stats.transfers++;
+        rc = bus->backend->transfer(bus, msgs, count);
+        if (rc == 0) {
+            break;
+        }
+        bus->stats.errors++;
+        if (is_device_error(rc) || is_rejected(rc)) {
+            break;
+        }
+        bus->backend->close(bus);
+        bus->fd = -1;
+    }
+    return rc;
+}
+
+int i2c_bus_transfer(i2c_bus_t *bus, struct i2c_msg *msgs, int count) {
+    pthread_mutex_lock(&bus->lock);
+    int rc = transfer_locked(bus, msgs, count);
+    pthread_mutex_unlock(&bus->lock);
+    return rc;
+}
+
+int i2c_bus_read_register(i2c_bus_t *bus, uint16_t address, uint8_t reg, uint8_t *buf,
+                          uint16_t len) {
+    struct i2c_msg msgs[2] = {
+        { .addr = address, .flags = 0, .len = 1, .buf = &reg },
+        { .addr = address, .flags = I2C_M_RD, .len = len, .buf = buf },
+    };
+    return i2c_bus_transfer(bus, msgs, 2);
+}
+
+// Register pointer write and data read for each of count reads
+static void fill_read_msgs(struct i2c_msg *msgs, i2c_read_t *const *reads, int count) {
+    for (int i = 0; i < count; i++) {
+        msgs[2 * i] = (struct i2c_msg){ .addr = reads[i]->address, .flags = 0, .len = 1,
+                                        .buf = &reads[i]->reg };
+        msgs[2 * i + 1] = (struct i2c_msg){ .addr = reads[i]->address, .flags = I2C_M_RD,
+                                            .len = reads[i]->len, .buf = reads[i]->buf };
+    }
+}
+
+static int is_failing(const i2c_bus_t *bus, uint16_t address) {
+    return address < I2C_BUS_ADDRESSES && (bus->failing[address / 8] >> (address % 8)) & 1;
+}
+
+static void set_failing(i2c_bus_t *bus, uint16_t address, int failing) {
+    if (address >= I2C_BUS_ADDRESSES) {
+        return;
+    }
+    uint8_t bit = (uint8_t)(1u << (address % 8));
+    if (failing) {
+        bus->failing[address / 8] |= bit;
+    } else {
+        bus->failing[address / 8] &= (uint8_t)~bit;
+    }
+}
+
+// One register read in its own transfer. A device that NACKs is kept out of
+// batches until a read of its own succeeds. Returns 1 if the read succeeded.
+static int read_alone(i2c_bus_t *bus, i2c_read_t *read, struct i2c_msg *msgs) {
+    fill_read_msgs(msgs, &read, 1);
+    read->result = transfer_locked(bus, msgs, 2);
+    if (read->result == 0) {
+        set_failing(bus, read->address, 0);
+    } else if (is_device_error(read->result)) {
+        set_failing(bus, read->address, 1);
+    }
+    return read->result == 0;
+}
+
+// Up to bus->max_batch register reads in one transfer. Returns the number that
+// succeeded.
+static int read_batch(i2c_bus_t *bus, i2c_read_t **batch, int n, struct i2c_msg *msgs) {
+    if (n == 1) {
+        return read_alone(bus, batch[0], msgs);
+    }
+    fill_read_msgs(msgs, batch, n);
+    int rc = transfer_locked(bus, msgs, 2 * n);
+    // Nothing to retry per device if the bus itself could not be opened
+    if (rc == 0 || bus->fd < 0) {
+        for (int i = 0; i < n; i++) {
+            batch[i]->result = rc;
+        }
+        return rc == 0 ? n : 0;
+    }
+
+    // The transfer stopped at some NACK without saying whose, or the adapter
+    // cannot do multi-message transfers: redo it one read at a time
+    bus->stats.fallbacks++;
+    if (is_rejected(rc)) {
+        fprintf(stderr, "[I2C] %s rejected a %d-message transfer, reading one device at a time\n",
+                bus->device, 2 * n);
+        bus->max_batch = 1;
+    }
+    int succeeded = 0;
+    for (int i = 0; i < n; i++) {
+        succeeded += read_alone(bus, batch[i], msgs);
+    }
+    return succeeded;
+}
+
+int i2c_bus_read_registers(i2c_bus_t *bus, i2c_read_t *reads, int count) {
+    struct i2c_msg msgs[2 * I2C_BUS_MAX_BATCH];
+    i2c_read_t *batch[I2C_BUS_MAX_BATCH];
+    int succeeded = 0;
+
+    pthread_mutex_lock(&bus->lock);
+    // Devices that NACKed before are read on their own rather than failing the
+    // batch for everyone else each sweep; they rejoin once they answer
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        if (is_failing(bus, reads[i].address)) {
+            succeeded += read_alone(bus, &reads[i], msgs);
+            continue;
+        }
+        batch[n++] = &reads[i];
+        if (n >= bus->max_batch) {
+            succeeded += read_batch(bus, batch, n, msgs);
+            n = 0;
+        }
+    }
+    if (n > 0) {
+        succeeded += read_batch(bus, batch, n, msgs);
+    }
+    pthread_mutex_unlock(&bus->lock);
+    return succeeded;
+}
+
+void i2c_bus_get_stats(i2c_bus_t *bus, i2c_bus_stats_t *stats) {
+    pthread_mutex_lock(&bus->lock);
+    *stats = bus->stats;
+    pthread_mutex_unlock(&bus->lock);
+}
+
+// ---------------------------------------------------------------------------
+// Shared handles
+// ---------------------------------------------------------------------------
+
+static struct {
+    pthread_mutex_t lock;
+    i2c_bus_t buses[I2C_MAX_BUSES];
+    int count;
+} registry = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+i2c_bus_t *i2c_bus_get(const char *device) {
+    i2c_bus_t *bus = NULL;
+    pthread_mutex_lock(&registry.lock);
+    for (int i = 0; i < registry.count; i++) {
+        if (strcmp(registry.buses[i].device, device) == 0) {
+            bus = &registry.buses[i];
+            break;
+        }
+    }
+    if (!bus && registry.count < I2C_MAX_BUSES &&
+        i2c_bus_init(&registry.buses[registry.count], device, &i2c_linux_backend, NULL) == 0) {
+        bus = &registry.buses[registry.count++];
+    }
+    pthread_mutex_unlock(&registry.lock);
+    if (!bus) {
+        fprintf(stderr, "[I2C] Cannot open more than %d buses (%s)\n", I2C_MAX_BUSES, device);
+    }
+    return bus;
+}
+
+void i2c_bus_release_all(void) {
+    pthread_mutex_lock(&registry.lock);
+    for (int i = 0; i < registry.count; i++) {
+        i2c_bus_destroy(&registry.buses[i]);
+    }
+    registry.count = 0;
+    pthread_mutex_unlock(&registry.lock);
+}
+
+// ---------------------------------------------------------------------------
+// Linux i2c-dev backend
+// ---------------------------------------------------------------------------
+
+static int linux_open(i2c_bus_t *bus) {
+    bus->stats.syscalls++;
+    bus->fd = open(bus->device, O_RDWR | O_CLOEXEC);
+    if (bus->fd < 0) {
+        int err = errno;
+        perror("Opening I2C device");
+        return -err;
+    }
+    return 0;
+}
+
+static void linux_close(i2c_bus_t *bus) {
+    bus->stats.syscalls++;
+    close(bus->fd);
+}
+
+static int linux_transfer(i2c_bus_t *bus, struct i2c_msg *msgs, int count) {
+    struct i2c_rdwr_ioctl_data data = { .msgs = msgs, .nmsgs = (__u32)count };
+    bus->stats.syscalls++;
+    if (ioctl(bus->fd, I2C_RDWR, &data) < 0) {
+        return -errno;
+    }
+    return 0;
+}
+
+const i2c_backend_t i2c_linux_backend = {
+    .name = "linux",
+    .open = linux_open,
+    .close = linux_close,
+    .transfer = linux_transfer,
+};
+
+// ---------------------------------------------------------------------------
+// Fake backend
+// ---------------------------------------------------------------------------
+
+void i2c_fake_init(i2c_fake_t *fake) {
+    memset(fake, 0, sizeof(*fake));
+}
+
+void i2c_fake_set_register(i2c_fake_t *fake, uint16_t address, uint8_t reg, const uint8_t *data,
+                           int len) {
+    if (address >= I2C_FAKE_ADDRESSES) {
+        return;
+    }
+    fake->present[address] = 1;
+    for (int i = 0; i < len; i++) {
+        fake->regs[address][(uint8_t)(reg + i)] = data[i];
+    }
+}
+
+static int fake_open(i2c_bus_t *bus) {
+    bus->stats.syscalls++;
+    bus->fd = open("/dev/null", O_RDWR | O_CLOEXEC);
+    return bus->fd < 0 ? -errno : 0;
+}
+
+static void fake_close(i2c_bus_t *bus) {
+    bus->stats.syscalls++;
+    close(bus->fd);
+}
+
+static int fake_transfer(i2c_bus_t *bus, struct i2c_msg *msgs, int count) {
+    i2c_fake_t *fake = bus->ctx;
+
+    // One real kernel crossing, standing in for the I2C_RDWR ioctl
+    bus->stats.syscalls++;
+    if (write(bus->fd, msgs, 0) < 0) {
+        return -errno;
+    }
+    if (fake->fail_next) {
+        int err = fake->fail_next;
+        fake->fail_next = 0;
+        return err;
+    }
+    if (fake->max_msgs > 0 && count > fake->max_msgs) {
+        return -EOPNOTSUPP;
+    }
+    if (fake->clock_hz > 0) {
+        // 9 clocks per byte (address byte included), plus start and stop
+        uint64_t bits = 2;
+        for (int i = 0; i < count; i++) {
+            bits += 9 * (1 + (uint64_t)msgs[i].len);
+        }
+        uint64_t ns = bits * 1000000000ULL / (uint64_t)fake->clock_hz;
+        struct timespec wire = { (time_t)(ns / 1000000000ULL), (long)(ns % 1000000000ULL) };
+        nanosleep(&wire, NULL);
+    }
+
+    for (int i = 0; i < count; i++) {
+        struct i2c_msg *msg = &msgs[i];
+        if (msg->addr >= I2C_FAKE_ADDRESSES || !fake->present[msg->addr]) {
+            return -ENXIO;
+        }
+        uint8_t *regs = fake->regs[msg->addr];
+        uint8_t *pointer = &fake->pointer[msg->addr];
+        if (msg->flags & I2C_M_RD) {
+            for (int j = 0; j < msg->len; j++) {
+                msg->buf[j] = regs[(uint8_t)(*pointer + j)];
+            }
+        } else if (msg->len > 0) {
+            *pointer = msg->buf[0];
+            for (int j = 1; j < msg->len; j++) {
+                regs[(uint8_t)(*pointer + j - 1)] = msg->buf[j];
+            }
+        }
+    }
+    return 0;
+}
+
+const i2c_backend_t i2c_fake_backend = {
+    .name = "fake",
+    .open = fake_open,
+    .close = fake_close,
+    .transfer = fake_transfer,
+};
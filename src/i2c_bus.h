@@ -0,0 +1,138 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <linux/i2c.h>
+
+// Shared I2C bus handles.
+//
+// Each bus device (/dev/i2c-N) is opened once and kept open; every access
+// goes through the bus mutex, so sensors on the same bus never interleave
+// their transactions. A register read is a single I2C_RDWR ioctl carrying
+// the register write and the data read as one combined transaction, instead
+// of open, I2C_SLAVE, write, read and close per sample. After an error that
+// points at the handle rather than the device (the adapter went away, the fd
+// is bad) the handle is closed and the next transfer reopens it.
+//
+// A sweep over several sensors (i2c_bus_read_registers) bundles all their
+// register reads into one I2C_RDWR with two messages per device. Adapters
+// that reject multi-message transfers drop the bus to one read per transfer.
+// A device that NACKs is left out of later batches and read on its own until
+// it answers again, so one absent sensor does not fail every sweep's batch.
+//
+// The kernel interface sits behind a small backend vtable so the same code
+// runs against a fake bus in tests and benchmarks.
+
+typedef struct i2c_bus i2c_bus_t;
+
+typedef struct {
+    const char *name;
+    // Open the device; set bus->fd. Returns 0 or -errno.
+    int (*open)(i2c_bus_t *bus);
+    // Close bus->fd
+    void (*close)(i2c_bus_t *bus);
+    // Run count messages as one combined transaction. Returns 0 or -errno.
+    int (*transfer)(i2c_bus_t *bus, struct i2c_msg *msgs, int count);
+} i2c_backend_t;
+
+// Bus counters (snapshots)
+typedef struct {
+    unsigned long transfers;  // Transactions attempted
+    unsigned long errors;     // Transactions that failed
+    unsigned long opens;      // Times the device was opened
+    unsigned long syscalls;   // System calls made by the backend
+    unsigned long fallbacks;  // Batched transfers redone one read at a time
+} i2c_bus_stats_t;
+
+// Most register reads bundled into one transfer (I2C_RDWR takes at most 42
+// messages, two per read)
+#define I2C_BUS_MAX_BATCH 21
+
+// 7-bit device addresses; only these are tracked as failing
+#define I2C_BUS_ADDRESSES 128
+
+// One register read in a sweep
+typedef struct {
+    uint16_t address;
+    uint8_t reg;
+    uint8_t *buf;
+    uint16_t len;
+    int result;               // Set by i2c_bus_read_registers: 0 or -errno
+} i2c_read_t;
+
+struct i2c_bus {
+    char device[256];
+    const i2c_backend_t *backend;
+    void *ctx;                // Backend state (the fake device model)
+    int fd;                   // -1 while closed
+    int max_batch;            // Reads per transfer, 1 once the adapter rejects batches
+    uint8_t failing[I2C_BUS_ADDRESSES / 8];  // Bitmap of devices read outside batches
+    pthread_mutex_t lock;
+    i2c_bus_stats_t stats;    // Guarded by lock; backends count syscalls here
+};
+
+// The Linux i2c-dev interface
+extern const i2c_backend_t i2c_linux_backend;
+
+// Set up a bus on device. Nothing is opened until the first transfer.
+// Returns 0 on success, -1 on failure.
+int i2c_bus_init(i2c_bus_t *bus, const char *device, const i2c_backend_t *backend, void *ctx);
+
+// Close the device and free the lock
+void i2c_bus_destroy(i2c_bus_t *bus);
+
+// Run count messages as one transaction, opening the device if needed.
+// Returns 0 on success or -errno.
+int i2c_bus_transfer(i2c_bus_t *bus, struct i2c_msg *msgs, int count);
+
+// Write the register pointer reg of the device at address, then read len
+// bytes, as one transaction. Returns 0 on success or -errno.
+int i2c_bus_read_register(i2c_bus_t *bus, uint16_t address, uint8_t reg, uint8_t *buf,
+                          uint16_t len);
+
+// Run count register reads with as few transfers as the adapter allows,
+// setting each read's result. Returns the number of reads that succeeded.
+int i2c_bus_read_registers(i2c_bus_t *bus, i2c_read_t *reads, int count);
+
+// Copy the bus counters
+void i2c_bus_get_stats(i2c_bus_t *bus, i2c_bus_stats_t *stats);
+
+// Shared handle for device, created with the Linux backend on first use.
+// Returns NULL if no more buses can be opened.
+i2c_bus_t *i2c_bus_get(const char *device);
+
+// Close every bus handed out by i2c_bus_get
+void i2c_bus_release_all(void);
+
+// ---------------------------------------------------------------------------
+// Fake backend: a bus of register-file devices with no hardware behind it
+// ---------------------------------------------------------------------------
+
+#define I2C_FAKE_ADDRESSES 128
+
+// Each present device has 256 one-byte registers. A write sets the device's
+// register pointer from its first byte and stores any further bytes; a read
+// returns bytes from the pointer onwards. Absent addresses NACK (-ENXIO).
+// The device fd is really /dev/null and every transfer makes one real system
+// call on it, so syscall counts and their cost match the Linux backend.
+// Like a real adapter, a transfer stops at the first NACK.
+typedef struct {
+    unsigned char present[I2C_FAKE_ADDRESSES];
+    uint8_t pointer[I2C_FAKE_ADDRESSES];
+    uint8_t regs[I2C_FAKE_ADDRESSES][256];
+    int fail_next;            // Fail the next transfer with this -errno (0 = none)
+    int max_msgs;             // Reject longer transfers with -EOPNOTSUPP (0 = no limit)
+    int clock_hz;             // Sleep for the wire time at this SCL rate (0 = instant)
+} i2c_fake_t;
+
+extern const i2c_backend_t i2c_fake_backend;
+
+// Start with no devices
+void i2c_fake_init(i2c_fake_t *fake);
+
+// Add a device at address, or replace its registers
+void i2c_fake_set_register(i2c_fake_t *fake, uint16_t address, uint8_t reg, const uint8_t *data,
+                           int len);
+
+#endif // I2C_BUS_H
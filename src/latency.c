@@ -0,0 +1,143 @@
+#include "latency.h"
+#include <time.h>
+
+static latency_hist_t stages[LATENCY_STAGE_COUNT];
+static const char *stage_names[LATENCY_STAGE_COUNT] = {
+    "i2c_read", "queue_wait", "process", "end_to_end"
+};
+
+uint64_t latency_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Bucket of a value: values below LATENCY_SUB_COUNT map to themselves; above
+// that, group g >= 1 covers [2^(g+SUB_BITS-1), 2^(g+SUB_BITS)) in
+// LATENCY_SUB_COUNT equal steps.
+static int bucket_index(uint64_t ns) {
+    if (ns < LATENCY_SUB_COUNT) {
+        return (int)ns;
+    }
+    int msb = 63 - __builtin_clzll(ns);
+    if (msb >= LATENCY_MAX_BITS) {
+        return LATENCY_BUCKETS - 1;
+    }
+    int group = msb - LATENCY_SUB_BITS + 1;
+    int sub = (int)(ns >> (msb - LATENCY_SUB_BITS)) - LATENCY_SUB_COUNT;
+    return group * LATENCY_SUB_COUNT + sub;
+}
+
+// Largest value that maps to bucket index
+static uint64_t bucket_highest(int index) {
+    int group = index / LATENCY_SUB_COUNT;
+    int sub = index % LATENCY_SUB_COUNT;
+    if (group == 0) {
+        return (uint64_t)sub;
+    }
+    uint64_t width = 1ULL << (group - 1);
+    return ((uint64_t)(LATENCY_SUB_COUNT + sub) << (group - 1)) + width - 1;
+}
+
+void latency_hist_reset(latency_hist_t *hist) {
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        atomic_store_explicit(&hist->counts[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&hist->max_ns, 0, memory_order_relaxed);
+}
+
+void latency_hist_record(latency_hist_t *hist, uint64_t ns) {
+    atomic_fetch_add_explicit(&hist->counts[bucket_index(ns)], 1, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&hist->max_ns, memory_order_relaxed);
+    while (ns > max &&
+           !atomic_compare_exchange_weak_explicit(&hist->max_ns, &max, ns,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+// Snapshot the bucket counts; returns the total
+static unsigned long snapshot(latency_hist_t *hist, unsigned long *counts) {
+    unsigned long total = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        counts[i] = atomic_load_explicit(&hist->counts[i], memory_order_relaxed);
+        total += counts[i];
+    }
+    return total;
+}
+
+static uint64_t quantile_of(const unsigned long *counts, unsigned long total, uint64_t max,
+                            double q) {
+    if (total == 0) {
+        return 0;
+    }
+    double exact = q * (double)total;
+    unsigned long rank = (unsigned long)exact;
+    if ((double)rank < exact || rank == 0) {
+        rank++;
+    }
+    if (rank > total) {
+        rank = total;
+    }
+    unsigned long seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint64_t value = bucket_highest(i);
+            return value < max ? value : max;
+        }
+    }
+    return max;
+}
+
+uint64_t latency_hist_quantile(latency_hist_t *hist, double q) {
+    unsigned long counts[LATENCY_BUCKETS];
+    unsigned long total = snapshot(hist, counts);
+    uint64_t max = atomic_load_explicit(&hist->max_ns, memory_order_relaxed);
+    return quantile_of(counts, total, max, q);
+}
+
+void latency_hist_summary(latency_hist_t *hist, latency_summary_t *summary) {
+    unsigned long counts[LATENCY_BUCKETS];
+    unsigned long total = snapshot(hist, counts);
+    uint64_t max = atomic_load_explicit(&hist->max_ns, memory_order_relaxed);
+    summary->count = total;
+    summary->p50_ns = quantile_of(counts, total, max, 0.50);
+    summary->p99_ns = quantile_of(counts, total, max, 0.99);
+    summary->p999_ns = quantile_of(counts, total, max, 0.999);
+    summary->max_ns = total ? max : 0;
+}
+
+void latency_record(latency_stage_t stage, uint64_t start_ns, uint64_t end_ns) {
+    if (stage < 0 || stage >= LATENCY_STAGE_COUNT || start_ns == 0 || end_ns < start_ns) {
+        return;
+    }
+    latency_hist_record(&stages[stage], end_ns - start_ns);
+}
+
+void latency_stage_summary(latency_stage_t stage, latency_summary_t *summary) {
+    if (stage < 0 || stage >= LATENCY_STAGE_COUNT) {
+        summary->count = 0;
+        summary->p50_ns = summary->p99_ns = summary->p999_ns = summary->max_ns = 0;
+        return;
+    }
+    latency_hist_summary(&stages[stage], summary);
+}
+
+const char *latency_stage_name(latency_stage_t stage) {
+    if (stage < 0 || stage >= LATENCY_STAGE_COUNT) {
+        return "unknown";
+    }
+    return stage_names[stage];
+}
+
+void latency_dump(FILE *out) {
+    fprintf(out, "[Latency] %-10s %10s %12s %12s %12s %12s\n",
+            "stage", "count", "p50_us", "p99_us", "p999_us", "max_us");
+    for (int s = 0; s < LATENCY_STAGE_COUNT; s++) {
+        latency_summary_t sum;
+        latency_stage_summary((latency_stage_t)s, &sum);
+        fprintf(out, "[Latency] %-10s %10lu %12.1f %12.1f %12.1f %12.1f\n",
+                stage_names[s], sum.count, sum.p50_ns / 1e3, sum.p99_ns / 1e3,
+                sum.p999_ns / 1e3, sum.max_ns / 1e3);
+    }
+}
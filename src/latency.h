@@ -0,0 +1,73 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Fixed-memory latency histograms for the reading pipeline.
+//
+// Values are nanoseconds in log-linear (HDR-style) buckets: exact below 32 ns,
+// then 32 sub-buckets per power of two, so any recorded value is reported
+// within 1/32 (about 3%) of its true value. Values above 2^40 ns (about 18
+// minutes) land in the top bucket. A histogram is about 9 KB and never
+// allocates; recording is a bucket index computation and a relaxed increment.
+
+#define LATENCY_SUB_BITS 5
+#define LATENCY_SUB_COUNT (1 << LATENCY_SUB_BITS)
+#define LATENCY_MAX_BITS 40
+#define LATENCY_BUCKETS ((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT)
+
+typedef struct {
+    atomic_ulong counts[LATENCY_BUCKETS];
+    _Atomic uint64_t max_ns;
+} latency_hist_t;
+
+typedef struct {
+    unsigned long count;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+} latency_summary_t;
+
+// Pipeline stages a reading passes through
+typedef enum {
+    LATENCY_I2C_READ = 0,   // I2C transaction start to end
+    LATENCY_QUEUE_WAIT,     // Enqueued by the sensor thread to dequeued by the processor
+    LATENCY_PROCESS,        // Dequeued to published in latest_reading
+    LATENCY_END_TO_END,     // I2C start to published (visible over HTTP)
+    LATENCY_STAGE_COUNT
+} latency_stage_t;
+
+// CLOCK_MONOTONIC in nanoseconds
+uint64_t latency_now_ns(void);
+
+// Reset a histogram to empty
+void latency_hist_reset(latency_hist_t *hist);
+
+// Record one value. Safe to call from several threads at once.
+void latency_hist_record(latency_hist_t *hist, uint64_t ns);
+
+// Value at quantile q (0..1): the highest value equivalent to the bucket that
+// holds the ceil(q * count)-th smallest sample, capped at the maximum.
+// Returns 0 for an empty histogram.
+uint64_t latency_hist_quantile(latency_hist_t *hist, double q);
+
+// Count, p50/p99/p99.9 and maximum of a histogram
+void latency_hist_summary(latency_hist_t *hist, latency_summary_t *summary);
+
+// Record a stage latency from two timestamps. Pairs where either stamp is
+// missing (0) or end precedes start are ignored.
+void latency_record(latency_stage_t stage, uint64_t start_ns, uint64_t end_ns);
+
+// Summary of one pipeline stage
+void latency_stage_summary(latency_stage_t stage, latency_summary_t *summary);
+
+// Name of a stage, as used in /api/latency
+const char *latency_stage_name(latency_stage_t stage);
+
+// Print one line per stage (count, p50, p99, p99.9, max in microseconds)
+void latency_dump(FILE *out);
+
+#endif // LATENCY_H
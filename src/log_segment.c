@@ -0,0 +1,205 @@
+#include "log_segment.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <unistd.h>
+
+// Split a log path into directory, stem and extension:
+// "logs/sensor_log.csv" -> "logs", "sensor_log", ".csv"
+static void split_log_path(const char *log_file, char *dir, size_t dir_size,
+                           char *stem, size_t stem_size, char *ext, size_t ext_size) {
+    const char *slash = strrchr(log_file, '/');
+    const char *base = slash ? slash + 1 : log_file;
+
+    if (slash) {
+        size_t len = (size_t)(slash - log_file);
+        if (len == 0) len = 1;  // Root directory
+        if (len >= dir_size) len = dir_size - 1;
+        memcpy(dir, log_file, len);
+        dir[len] = '\0';
+    } else {
+        snprintf(dir, dir_size, ".");
+    }
+
+    const char *dot = strrchr(base, '.');
+    if (!dot || dot == base) {
+        dot = base + strlen(base);
+    }
+    size_t stem_len = (size_t)(dot - base);
+    if (stem_len >= stem_size) stem_len = stem_size - 1;
+    memcpy(stem, base, stem_len);
+    stem[stem_len] = '\0';
+    snprintf(ext, ext_size, "%s", dot);
+}
+
+int logseg_path(const char *log_file, time_t start, char *out, size_t size) {
+    char dir[256], stem[256], ext[32];
+    split_log_path(log_file, dir, sizeof(dir), stem, sizeof(stem), ext, sizeof(ext));
+    int n = snprintf(out, size, "%s/%s-%lld%s", dir, stem, (long long)start, ext);
+    return (n < 0 || (size_t)n >= size) ? -1 : 0;
+}
+
+static int compare_segments(const void *a, const void *b) {
+    const logseg_info_t *sa = a;
+    const logseg_info_t *sb = b;
+    return (sa->start > sb->start) - (sa->start < sb->start);
+}
+
+int logseg_list(const char *log_file, logseg_info_t **segments) {
+    char dir[256], stem[256], ext[32];
+    split_log_path(log_file, dir, sizeof(dir), stem, sizeof(stem), ext, sizeof(ext));
+    size_t stem_len = strlen(stem);
+    size_t ext_len = strlen(ext);
+
+    *segments = NULL;
+    DIR *d = opendir(dir);
+    if (!d) {
+        perror("[LogSegment] Opening log directory");
+        return -1;
+    }
+
+    int count = 0, capacity = 0;
+    logseg_info_t *list = NULL;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        // Match "<stem>-<digits><ext>" exactly; index files fail the suffix check
+        const char *name = entry->d_name;
+        size_t len = strlen(name);
+        if (len <= stem_len + 1 + ext_len ||
+            strncmp(name, stem, stem_len) != 0 || name[stem_len] != '-' ||
+            strcmp(name + len - ext_len, ext) != 0) {
+            continue;
+        }
+        const char *digits = name + stem_len + 1;
+        size_t digits_len = len - stem_len - 1 - ext_len;
+        int ok = digits_len > 0;
+        for (size_t i = 0; i < digits_len && ok; i++) {
+            ok = isdigit((unsigned char)digits[i]);
+        }
+        if (!ok) {
+            continue;
+        }
+
+        if (count == capacity) {
+            int new_capacity = capacity ? capacity * 2 : 16;
+            logseg_info_t *grown = realloc(list, (size_t)new_capacity * sizeof(*list));
+            if (!grown) {
+                free(list);
+                closedir(d);
+                return -1;
+            }
+            list = grown;
+            capacity = new_capacity;
+        }
+        list[count].start = (time_t)strtoll(digits, NULL, 10);
+        snprintf(list[count].path, sizeof(list[count].path), "%s/%s", dir, name);
+        count++;
+    }
+    closedir(d);
+
+    qsort(list, (size_t)count, sizeof(*list), compare_segments);
+    *segments = list;
+    return count;
+}
+
+static void remove_segment(const logseg_info_t *segment) {
+    char index_path[sizeof(segment->path) + sizeof(LOGSEG_INDEX_SUFFIX)];
+    snprintf(index_path, sizeof(index_path), "%s%s", segment->path, LOGSEG_INDEX_SUFFIX);
+    if (unlink(segment->path) != 0) {
+        perror("[LogSegment] Removing segment");
+    }
+    unlink(index_path);
+}
+
+int logseg_apply_retention(const char *log_file, int keep_segments, int keep_seconds, time_t now) {
+    if (keep_segments <= 0 && keep_seconds <= 0) {
+        return 0;
+    }
+
+    logseg_info_t *segments;
+    int count = logseg_list(log_file, &segments);
+    if (count <= 1) {
+        free(segments);
+        return 0;
+    }
+
+    int removed = 0;
+    for (int i = 0; i < count - 1; i++) {
+        int over_count = keep_segments > 0 && count - i > keep_segments;
+        // Everything in segment i predates the start of segment i + 1
+        int too_old = keep_seconds > 0 && segments[i + 1].start <= now - keep_seconds;
+        if (!over_count && !too_old) {
+            break;
+        }
+        printf("[LogSegment] Retention: removing %s\n", segments[i].path);
+        remove_segment(&segments[i]);
+        removed++;
+    }
+    free(segments);
+    return removed;
+}
+
+uint64_t logseg_index_lookup(const char *segment_path, time_t from) {
+    char index_path[600];
+    snprintf(index_path, sizeof(index_path), "%s%s", segment_path, LOGSEG_INDEX_SUFFIX);
+    FILE *f = fopen(index_path, "rb");
+    if (!f) {
+        return 0;  // No index: scan the segment from the start
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    size_t count = size > 0 ? (size_t)size / sizeof(logseg_index_entry_t) : 0;
+    uint64_t offset = 0;
+
+    size_t lo = 0, hi = count;  // Find first entry with timestamp >= from
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        logseg_index_entry_t entry;
+        if (fseek(f, (long)(mid * sizeof(entry)), SEEK_SET) != 0 ||
+            fread(&entry, sizeof(entry), 1, f) != 1) {
+            break;
+        }
+        if (entry.timestamp < (int64_t)from) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo > 0) {
+        logseg_index_entry_t entry;
+        if (fseek(f, (long)((lo - 1) * sizeof(entry)), SEEK_SET) == 0 &&
+            fread(&entry, sizeof(entry), 1, f) == 1) {
+            offset = entry.offset;
+        }
+    }
+    fclose(f);
+    return offset;
+}
+
+int logseg_seek(const char *log_file, time_t from, char *segment_path, size_t size,
+                uint64_t *offset) {
+    logseg_info_t *segments;
+    int count = logseg_list(log_file, &segments);
+    if (count <= 0) {
+        free(segments);
+        return -1;
+    }
+
+    // Last segment that started at or before from; earlier queries start at the first
+    int pick = 0;
+    for (int i = 0; i < count; i++) {
+        if (segments[i].start <= from) {
+            pick = i;
+        } else {
+            break;
+        }
+    }
+
+    snprintf(segment_path, size, "%s", segments[pick].path);
+    *offset = segments[pick].start < from ? logseg_index_lookup(segments[pick].path, from) : 0;
+    free(segments);
+    return 0;
+}
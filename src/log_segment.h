@@ -0,0 +1,57 @@
+#ifndef LOG_SEGMENT_H
+#define LOG_SEGMENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// Segmented logs.
+//
+// With segmentation enabled, [logging] log_file names a family of segment files
+// rather than one file: "dir/sensor_log.csv" becomes "dir/sensor_log-<start>.csv",
+// where <start> is the Unix time of the segment's first row. Each segment has a
+// sparse time index next to it ("<segment>.idx") holding one entry every
+// LOGSEG_INDEX_INTERVAL rows, so a time-range lookup can pick the segment from
+// its name and seek inside it without scanning.
+
+// Rows between index entries
+#define LOGSEG_INDEX_INTERVAL 64
+
+// Index file suffix appended to the segment path
+#define LOGSEG_INDEX_SUFFIX ".idx"
+
+typedef struct {
+    int64_t timestamp;  // Timestamp of the indexed row
+    uint64_t offset;    // Byte offset of the row within the segment file
+} logseg_index_entry_t;
+
+typedef struct {
+    time_t start;       // Segment start time (from the file name)
+    char path[512];
+} logseg_info_t;
+
+// Build the path of the segment starting at start. Returns 0 on success, -1 if it does not fit.
+int logseg_path(const char *log_file, time_t start, char *out, size_t size);
+
+// List the segments of log_file sorted by start time. On success *segments is
+// a malloc'd array the caller frees; returns the number of segments or -1.
+int logseg_list(const char *log_file, logseg_info_t **segments);
+
+// Delete the oldest segments (and their indexes) so that at most keep_segments
+// remain (0 = no limit) and none holds only data older than now - keep_seconds
+// (0 = no limit). The newest segment is never deleted. Returns segments removed.
+int logseg_apply_retention(const char *log_file, int keep_segments, int keep_seconds, time_t now);
+
+// Byte offset to start reading segment_path at for rows with timestamp >= from.
+// Uses the last index entry strictly before from, so rows with timestamp == from
+// that precede the next entry are not skipped. Returns 0 (scan from the start)
+// if the segment has no index.
+uint64_t logseg_index_lookup(const char *segment_path, time_t from);
+
+// Find where rows with timestamp >= from start: the segment to open and the
+// byte offset of an indexed row at or before the first such row.
+// Returns 0 on success, -1 if there are no segments.
+int logseg_seek(const char *log_file, time_t from, char *segment_path, size_t size,
+                uint64_t *offset);
+
+#endif // LOG_SEGMENT_H
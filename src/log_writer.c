@@ -0,0 +1,489 @@
+#include "log_writer.h"
+#include "config.h"
+#include "binlog.h"
+#include "log_segment.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// Asynchronous log writer. The processor appends records to the active buffer
+// under a short mutex hold; the writer thread swaps buffers and writes the
+// full one out with a single flush (group commit), so disk latency never
+// reaches the processing loop. Rows are written as CSV or, with
+// [logging] format = binary, as binlog records. With segmentation enabled the
+// writer rolls over to a new segment file by size or age, maintains each
+// segment's sparse time index and applies the retention policy.
+static struct {
+    log_record_t *buffers[2];
+    int counts[2];
+    int active;                   // Buffer the processor appends to
+    int capacity;                 // Records per buffer
+    int flush_records;            // Flush once this many records are pending (0 = off)
+    int64_t flush_interval_ns;    // Flush this long after the first pending record (0 = off)
+    struct timespec first_pending;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+    int running;
+    int stopping;
+    FILE *file;
+    int format;                   // LOG_FORMAT_*
+    int sensor_count;             // Sensor columns (the highest sensor id)
+    binlog_header_t bin_header;   // Header of the open binary log
+    char log_path[256];           // Configured log path (segment family name when segmented)
+    int segmented;
+    FILE *index;                  // Sparse time index of the current segment
+    time_t segment_start;
+    unsigned long segment_bytes;  // Current size of the open file
+    unsigned long rows_since_index;
+    time_t cached_ts;             // Last timestamp formatted into time_str
+    char time_str[64];
+    int in_row;                   // The previous record continues into the next one
+    float row_values[CONFIG_MAX_SENSORS + 1];         // CSV row being collected, by sensor id
+    unsigned char row_set[CONFIG_MAX_SENSORS + 1];
+    atomic_ulong appended;
+    atomic_ulong dropped;         // Rejected by log_writer_append
+    atomic_ulong discarded;       // Accepted but lost because no file was open
+    atomic_ulong written;
+    atomic_ulong bytes_written;
+    atomic_ulong flushes;
+    atomic_ulong rotations;
+} lw;
+
+static void timespec_add_ns(struct timespec *ts, int64_t ns) {
+    ts->tv_sec += (time_t)(ns / 1000000000);
+    ts->tv_nsec += (long)(ns % 1000000000);
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static int timespec_reached(const struct timespec *deadline) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec > deadline->tv_sec ||
+           (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec);
+}
+
+// Encode and write one record in binary format. Returns bytes written.
+static unsigned long write_row_binary(const log_record_t *r) {
+    binlog_record_t out;
+    binlog_encode_reading(&lw.bin_header, r->timestamp, r->sensor_id, r->temperature, &out);
+    if (lw.in_row) {
+        out.flags &= (uint8_t)~BINLOG_FLAG_ROW_START;
+    }
+    size_t written = fwrite(&out, sizeof(binlog_record_t), 1, lw.file);
+    return written * sizeof(binlog_record_t);
+}
+
+// Collect one record into the CSV row and write the row once it is complete.
+// Returns bytes written.
+static unsigned long write_row_csv(const log_record_t *r) {
+    if (r->sensor_id >= 1 && r->sensor_id <= lw.sensor_count) {
+        lw.row_values[r->sensor_id] = r->temperature;
+        lw.row_set[r->sensor_id] = 1;
+    }
+    if (r->flags & LOG_RECORD_CONTINUES) {
+        return 0;
+    }
+
+    // Rows mostly share a second with their predecessor; only re-run strftime on change
+    if (r->timestamp != lw.cached_ts) {
+        struct tm tm_info;
+        localtime_r(&r->timestamp, &tm_info);
+        strftime(lw.time_str, sizeof(lw.time_str), "%Y-%m-%d %H:%M:%S", &tm_info);
+        lw.cached_ts = r->timestamp;
+    }
+
+    // timestamp,sensor1,...,sensorN,average with N/A for sensors not in the row
+    char value[16];
+    unsigned long n = strlen(lw.time_str);
+    double sum = 0;
+    int count = 0;
+    fputs(lw.time_str, lw.file);
+    for (int id = 1; id <= lw.sensor_count; id++) {
+        if (lw.row_set[id]) {
+            int value_len = snprintf(value, sizeof(value), ",%.2f", lw.row_values[id]);
+            fputs(value, lw.file);
+            n += (unsigned long)value_len;
+            sum += lw.row_values[id];
+            count++;
+            lw.row_set[id] = 0;
+        } else {
+            fputs(",N/A", lw.file);
+            n += 4;
+        }
+    }
+    int value_len = count > 0 ? snprintf(value, sizeof(value), ",%.2f\n", sum / count)
+                              : snprintf(value, sizeof(value), ",N/A\n");
+    fputs(value, lw.file);
+    return n + (unsigned long)value_len;
+}
+
+// Write the CSV header line. Returns bytes written.
+static long write_csv_header(void) {
+    long n = fprintf(lw.file, "timestamp");
+    for (int id = 1; id <= lw.sensor_count; id++) {
+        n += fprintf(lw.file, ",sensor%d", id);
+    }
+    n += fprintf(lw.file, ",average\n");
+    return n;
+}
+
+// Open a log file for appending and write the CSV or binlog header if it is new.
+// An existing binary log must have a compatible header.
+static int open_log_file(const char *path) {
+    lw.file = fopen(path, lw.format == LOG_FORMAT_BINARY ? "a+b" : "a");
+    if (!lw.file) {
+        perror("Opening log file");
+        return -1;
+    }
+
+    fseek(lw.file, 0, SEEK_END);
+    long size = ftell(lw.file);
+
+    if (lw.format == LOG_FORMAT_BINARY) {
+        if (size == 0) {
+            binlog_header_init(&lw.bin_header, lw.sensor_count, time(NULL));
+            fwrite(&lw.bin_header, sizeof(lw.bin_header), 1, lw.file);
+            fflush(lw.file);
+            lw.segment_bytes = sizeof(lw.bin_header);
+            return 0;
+        }
+        fseek(lw.file, 0, SEEK_SET);
+        if (fread(&lw.bin_header, sizeof(lw.bin_header), 1, lw.file) != 1 ||
+            binlog_header_check(&lw.bin_header) != 0) {
+            fprintf(stderr, "[LogWriter] '%s' is not a compatible binary log\n", path);
+            fclose(lw.file);
+            lw.file = NULL;
+            return -1;
+        }
+        if (lw.bin_header.sensor_count < lw.sensor_count) {
+            fprintf(stderr, "[LogWriter] '%s' was started with %u sensors; readings from higher ids will not be exported\n",
+                    path, lw.bin_header.sensor_count);
+        }
+        // Switching from reading to writing requires a seek
+        fseek(lw.file, 0, SEEK_END);
+        lw.segment_bytes = (unsigned long)size;
+        return 0;
+    }
+
+    // If file is empty, write CSV header
+    if (size == 0) {
+        size = write_csv_header();
+        fflush(lw.file);
+    }
+    lw.segment_bytes = size > 0 ? (unsigned long)size : 0;
+    return 0;
+}
+
+// Open (or continue) the segment that starts at start, with its index
+static int open_segment(time_t start) {
+    char path[512];
+    if (logseg_path(lw.log_path, start, path, sizeof(path)) != 0) {
+        fprintf(stderr, "[LogWriter] Segment path too long for '%s'\n", lw.log_path);
+        return -1;
+    }
+    if (open_log_file(path) != 0) {
+        return -1;
+    }
+
+    char index_path[sizeof(path) + sizeof(LOGSEG_INDEX_SUFFIX)];
+    snprintf(index_path, sizeof(index_path), "%s%s", path, LOGSEG_INDEX_SUFFIX);
+    lw.index = fopen(index_path, "ab");
+    if (!lw.index) {
+        // Lookups fall back to scanning this segment
+        perror("[LogWriter] Opening segment index");
+    }
+    lw.segment_start = start;
+    lw.rows_since_index = 0;
+    return 0;
+}
+
+static void close_segment(void) {
+    if (lw.file) {
+        fflush(lw.file);
+        if (g_config.log_fsync_on_rotate && fsync(fileno(lw.file)) != 0) {
+            perror("[LogWriter] fsync");
+        }
+        fclose(lw.file);
+        lw.file = NULL;
+    }
+    if (lw.index) {
+        fflush(lw.index);
+        if (g_config.log_fsync_on_rotate && fsync(fileno(lw.index)) != 0) {
+            perror("[LogWriter] fsync index");
+        }
+        fclose(lw.index);
+        lw.index = NULL;
+    }
+}
+
+// Roll over to a new segment if the current one is full or too old
+static void maybe_rotate(time_t timestamp) {
+    int by_size = g_config.log_segment_max_bytes > 0 &&
+                  lw.segment_bytes >= (unsigned long)g_config.log_segment_max_bytes;
+    int by_age = g_config.log_segment_interval_s > 0 &&
+                 timestamp >= lw.segment_start + g_config.log_segment_interval_s;
+    if (lw.file && !by_size && !by_age) {
+        return;
+    }
+
+    close_segment();
+    // Segment names must be unique and increasing
+    time_t start = timestamp > lw.segment_start ? timestamp : lw.segment_start + 1;
+    if (open_segment(start) != 0) {
+        return;
+    }
+    atomic_fetch_add_explicit(&lw.rotations, 1, memory_order_relaxed);
+    logseg_apply_retention(lw.log_path, g_config.log_retention_segments,
+                           g_config.log_retention_s, time(NULL));
+}
+
+// Write one batch and flush it. Called without the mutex held.
+static void write_batch(const log_record_t *records, int count) {
+    unsigned long bytes = 0;
+    unsigned long written = 0;
+
+    for (int i = 0; i < count; i++) {
+        const log_record_t *r = &records[i];
+        // Segments and index entries only ever start at a row boundary
+        if (lw.segmented && !lw.in_row) {
+            maybe_rotate(r->timestamp);
+        }
+        if (!lw.file) {
+            // Could not open a segment; retried on the next row
+            atomic_fetch_add_explicit(&lw.discarded, 1, memory_order_relaxed);
+            lw.in_row = (r->flags & LOG_RECORD_CONTINUES) != 0;
+            continue;
+        }
+
+        if (!lw.in_row) {
+            if (lw.index && lw.rows_since_index == 0) {
+                logseg_index_entry_t entry = { (int64_t)r->timestamp, lw.segment_bytes };
+                fwrite(&entry, sizeof(entry), 1, lw.index);
+            }
+            lw.rows_since_index = (lw.rows_since_index + 1) % LOGSEG_INDEX_INTERVAL;
+        }
+
+        unsigned long n = lw.format == LOG_FORMAT_BINARY ? write_row_binary(r) : write_row_csv(r);
+        lw.in_row = (r->flags & LOG_RECORD_CONTINUES) != 0;
+        lw.segment_bytes += n;
+        bytes += n;
+        written++;
+    }
+
+    if (lw.file && fflush(lw.file) != 0) {
+        perror("[LogWriter] Flushing log file");
+    }
+    if (lw.index) {
+        fflush(lw.index);
+    }
+    atomic_fetch_add_explicit(&lw.written, written, memory_order_relaxed);
+    atomic_fetch_add_explicit(&lw.bytes_written, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&lw.flushes, 1, memory_order_relaxed);
+}
+
+// Decide whether the active buffer should be written now. Caller holds the mutex.
+static int flush_due(void) {
+    int pending = lw.counts[lw.active];
+    if (pending == 0) {
+        return 0;
+    }
+    if (lw.stopping) {
+        return 1;
+    }
+    if (lw.flush_records > 0 && pending >= lw.flush_records) {
+        return 1;
+    }
+    if (pending >= lw.capacity) {
+        return 1;
+    }
+    if (lw.flush_interval_ns > 0) {
+        struct timespec deadline = lw.first_pending;
+        timespec_add_ns(&deadline, lw.flush_interval_ns);
+        return timespec_reached(&deadline);
+    }
+    // Neither policy configured: write every record as it arrives
+    return lw.flush_records <= 0;
+}
+
+static void *writer_thread(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&lw.mutex);
+    for (;;) {
+        while (!flush_due() && !(lw.stopping && lw.counts[lw.active] == 0)) {
+            if (lw.counts[lw.active] > 0 && lw.flush_interval_ns > 0) {
+                struct timespec deadline = lw.first_pending;
+                timespec_add_ns(&deadline, lw.flush_interval_ns);
+                pthread_cond_timedwait(&lw.cond, &lw.mutex, &deadline);
+            } else {
+                pthread_cond_wait(&lw.cond, &lw.mutex);
+            }
+        }
+        if (lw.stopping && lw.counts[lw.active] == 0) {
+            break;
+        }
+
+        // Swap buffers; the other one was emptied by the previous pass
+        int idx = lw.active;
+        int count = lw.counts[idx];
+        lw.active ^= 1;
+        pthread_mutex_unlock(&lw.mutex);
+
+        write_batch(lw.buffers[idx], count);
+
+        pthread_mutex_lock(&lw.mutex);
+        lw.counts[idx] = 0;
+    }
+    pthread_mutex_unlock(&lw.mutex);
+    return NULL;
+}
+
+// Continue the newest segment if it is not due for rotation, else start a new one
+static int open_initial_segment(time_t now) {
+    logseg_info_t *segments;
+    int count = logseg_list(lw.log_path, &segments);
+    time_t start = now;
+    if (count > 0) {
+        time_t newest = segments[count - 1].start;
+        int too_old = g_config.log_segment_interval_s > 0 &&
+                      now >= newest + g_config.log_segment_interval_s;
+        start = too_old ? (now > newest ? now : newest + 1) : newest;
+    }
+    free(segments);
+
+    if (open_segment(start) != 0) {
+        return -1;
+    }
+    if (g_config.log_segment_max_bytes > 0 &&
+        lw.segment_bytes >= (unsigned long)g_config.log_segment_max_bytes) {
+        // Continued segment is already full
+        close_segment();
+        if (open_segment(now > start ? now : start + 1) != 0) {
+            return -1;
+        }
+    }
+    logseg_apply_retention(lw.log_path, g_config.log_retention_segments,
+                           g_config.log_retention_s, now);
+    return 0;
+}
+
+int log_writer_start(const char *path) {
+    memset(&lw, 0, sizeof(lw));
+
+    lw.format = g_config.log_format;
+    lw.sensor_count = g_config.sensor_max_id;
+    lw.cached_ts = (time_t)-1;
+    snprintf(lw.log_path, sizeof(lw.log_path), "%s", path);
+    lw.segmented = g_config.log_segment_max_bytes > 0 || g_config.log_segment_interval_s > 0;
+    if ((lw.segmented ? open_initial_segment(time(NULL)) : open_log_file(path)) != 0) {
+        return -1;
+    }
+
+    lw.capacity = g_config.log_buffer_records;
+    lw.flush_records = g_config.log_flush_records;
+    lw.flush_interval_ns = (int64_t)g_config.log_flush_interval_ms * 1000000;
+    for (int i = 0; i < 2; i++) {
+        lw.buffers[i] = calloc((size_t)lw.capacity, sizeof(log_record_t));
+        if (!lw.buffers[i]) {
+            fprintf(stderr, "[LogWriter] Allocation failure\n");
+            free(lw.buffers[0]);
+            close_segment();
+            return -1;
+        }
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&lw.cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&lw.mutex, NULL);
+
+    if (pthread_create(&lw.thread, NULL, writer_thread, NULL) != 0) {
+        perror("Failed to create log writer thread");
+        pthread_cond_destroy(&lw.cond);
+        pthread_mutex_destroy(&lw.mutex);
+        free(lw.buffers[0]);
+        free(lw.buffers[1]);
+        close_segment();
+        return -1;
+    }
+    lw.running = 1;
+    return 0;
+}
+
+int log_writer_append(const log_record_t *record) {
+    return log_writer_append_row(record, 1);
+}
+
+int log_writer_append_row(const log_record_t *records, int count) {
+    if (count <= 0) {
+        return 0;
+    }
+    pthread_mutex_lock(&lw.mutex);
+    int idx = lw.active;
+    if (!lw.running || lw.counts[idx] + count > lw.capacity) {
+        pthread_mutex_unlock(&lw.mutex);
+        atomic_fetch_add_explicit(&lw.dropped, (unsigned long)count, memory_order_relaxed);
+        return -1;
+    }
+
+    int first = lw.counts[idx];
+    if (first == 0) {
+        clock_gettime(CLOCK_MONOTONIC, &lw.first_pending);
+    }
+    for (int i = 0; i < count; i++) {
+        log_record_t *r = &lw.buffers[idx][first + i];
+        *r = records[i];
+        r->flags = i + 1 < count ? LOG_RECORD_CONTINUES : 0;
+    }
+    lw.counts[idx] += count;
+    atomic_fetch_add_explicit(&lw.appended, (unsigned long)count, memory_order_relaxed);
+
+    // Wake the writer to arm its interval timer or because a flush is due
+    if (first == 0 || flush_due()) {
+        pthread_cond_signal(&lw.cond);
+    }
+    pthread_mutex_unlock(&lw.mutex);
+    return 0;
+}
+
+void log_writer_stop(void) {
+    if (!lw.running) {
+        return;
+    }
+
+    pthread_mutex_lock(&lw.mutex);
+    lw.stopping = 1;
+    pthread_cond_signal(&lw.cond);
+    pthread_mutex_unlock(&lw.mutex);
+    pthread_join(lw.thread, NULL);
+    lw.running = 0;
+
+    close_segment();
+
+    pthread_cond_destroy(&lw.cond);
+    pthread_mutex_destroy(&lw.mutex);
+    free(lw.buffers[0]);
+    free(lw.buffers[1]);
+    lw.buffers[0] = lw.buffers[1] = NULL;
+}
+
+void log_writer_get_stats(log_writer_stats_t *stats) {
+    stats->appended = atomic_load_explicit(&lw.appended, memory_order_relaxed);
+    unsigned long discarded = atomic_load_explicit(&lw.discarded, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&lw.dropped, memory_order_relaxed) + discarded;
+    stats->written = atomic_load_explicit(&lw.written, memory_order_relaxed);
+    stats->bytes_written = atomic_load_explicit(&lw.bytes_written, memory_order_relaxed);
+    stats->flushes = atomic_load_explicit(&lw.flushes, memory_order_relaxed);
+    stats->rotations = atomic_load_explicit(&lw.rotations, memory_order_relaxed);
+    unsigned long done = stats->written + discarded;
+    stats->pending = stats->appended > done ? stats->appended - done : 0;
+}
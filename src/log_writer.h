@@ -0,0 +1,51 @@
+#ifndef LOG_WRITER_H
+#define LOG_WRITER_H
+
+#include <time.h>
+
+// One sensor value as handed off by the processor. A record is a log row of
+// its own unless it is appended as part of a row with log_writer_append_row.
+// Sensors without a record in a row are N/A in CSV and absent in binary logs;
+// the row average is the mean of the row's values.
+typedef struct {
+    time_t timestamp;
+    int sensor_id;       // 1-based sensor id
+    float temperature;
+    int flags;           // LOG_RECORD_* (set by the writer)
+} log_record_t;
+
+// More records of the same row follow this one
+#define LOG_RECORD_CONTINUES 0x01
+
+// Writer counters (all values are snapshots)
+typedef struct {
+    unsigned long appended;       // Records accepted from the processor
+    unsigned long dropped;        // Records rejected (buffers full or log file unavailable)
+    unsigned long pending;        // Records accepted but not yet written
+    unsigned long written;        // Records written to the file
+    unsigned long bytes_written;  // Bytes written to the file
+    unsigned long flushes;        // Group commits performed
+    unsigned long rotations;      // Segment rollovers (segmented logs only)
+} log_writer_stats_t;
+
+// Open the log file and start the writer thread. Flush behaviour comes from
+// the [logging] section of g_config, and the number of sensor columns from its
+// highest sensor id. Returns 0 on success, -1 on failure.
+int log_writer_start(const char *path);
+
+// Hand a record to the writer. Never blocks on I/O.
+// Returns 0 on success, -1 if the record was dropped (buffers full).
+int log_writer_append(const log_record_t *record);
+
+// Hand count records with the same timestamp to the writer as one row, all or
+// nothing. Never blocks on I/O.
+// Returns 0 on success, -1 if the row was dropped (buffers full).
+int log_writer_append_row(const log_record_t *records, int count);
+
+// Write out everything pending, stop the writer thread and close the file
+void log_writer_stop(void);
+
+// Get current writer counters
+void log_writer_get_stats(log_writer_stats_t *stats);
+
+#endif // LOG_WRITER_H
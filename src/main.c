@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <signal.h>
 #include <pthread.h>
 #include <unistd.h>
@@ -9,9 +10,16 @@
 #include "utils.h"
 #include "queue.h"
 #include "config.h"
+#include "history.h"
+#include "quantile.h"
+#include "rules.h"
+#include "latency.h"
+#include "i2c_bus.h"
 
 // Thread identifiers
-pthread_t sensor1_tid, sensor2_tid, processor_tid, network_tid;
+pthread_t processor_tid, network_tid;
+pthread_t sensor_tids[CONFIG_MAX_BUSES];
+int sensor_threads = 0;
 
 // Signal handler for SIGINT (Ctrl+C)
 void sigint_handler(int signum) {
@@ -19,9 +27,8 @@ void sigint_handler(int signum) {
     printf("\nSIGINT received, shutting down...\n");
     set_exit_flag();
     // Wake up any threads waiting on the queue
-    pthread_mutex_lock(&sensor_queue.mutex);
-    pthread_cond_broadcast(&sensor_queue.cond);
-    pthread_mutex_unlock(&sensor_queue.mutex);
+    queue_wakeup(&sensor_queue);
+    network_wakeup();
 }
 
 int main(int argc, char *argv[]) {
@@ -41,22 +48,56 @@ int main(int argc, char *argv[]) {
     init_utils();
 
     // Initialize the sensor queue with configured max size
-    queue_init(&sensor_queue, g_config.queue_max_size);
-    printf("[Main] Queue initialized with max_size=%d\n",
-           g_config.queue_max_size == 0 ? -1 : g_config.queue_max_size);
+    if (queue_init(&sensor_queue, g_config.queue_max_size) != 0) {
+        fprintf(stderr, "Failed to initialize sensor queue\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("[Main] Queue initialized with capacity=%zu\n", sensor_queue.capacity);
 
-    // Register signal handler
-    signal(SIGINT, sigint_handler);
+    // Allocate the in-memory history served by /api/history
+    if (history_init(g_config.sensor_max_id, g_config.history_raw_samples, g_config.history_seconds,
+                     g_config.history_minutes, g_config.history_hours) != 0) {
+        fprintf(stderr, "Failed to initialize sensor history\n");
+        exit(EXIT_FAILURE);
+    }
 
-    // Create sensor threads
-    if (pthread_create(&sensor1_tid, NULL, sensor1_thread, NULL) != 0) {
-        perror("Failed to create sensor1 thread");
+    // Allocate the quantile windows served by /api/quantiles
+    if (quantile_init(g_config.sensor_max_id) != 0) {
+        fprintf(stderr, "Failed to initialize sensor quantiles\n");
         exit(EXIT_FAILURE);
     }
-    if (pthread_create(&sensor2_tid, NULL, sensor2_thread, NULL) != 0) {
-        perror("Failed to create sensor2 thread");
+
+    // Load the alert rules the processor evaluates on every reading
+    rule_t *rules = NULL;
+    int rule_count = 0;
+    if (g_config.alerts_rules_file[0]) {
+        rule_count = rules_load_file(g_config.alerts_rules_file, &rules);
+    }
+    if (rule_count < 0 ||
+        rules_init(rules, rule_count, g_config.sensor_max_id, g_config.alerts_log_file) != 0) {
+        fprintf(stderr, "Failed to load alert rules\n");
         exit(EXIT_FAILURE);
     }
+    free(rules);
+    if (rule_count > 0) {
+        printf("[Main] %d alert rules loaded\n", rules_count());
+    }
+
+    // Register signal handler
+    signal(SIGINT, sigint_handler);
+
+    // Create one sensor thread per I2C bus with sensors on it
+    for (int bus = 0; bus < CONFIG_MAX_BUSES; bus++) {
+        if (config_bus_sensor_count(bus) == 0) {
+            continue;
+        }
+        if (pthread_create(&sensor_tids[sensor_threads], NULL, sensor_bus_thread,
+                           (void *)(intptr_t)bus) != 0) {
+            perror("Failed to create sensor bus thread");
+            exit(EXIT_FAILURE);
+        }
+        sensor_threads++;
+    }
 
     // Create data processing thread
     if (pthread_create(&processor_tid, NULL, data_processor_thread, NULL) != 0) {
@@ -73,13 +114,19 @@ int main(int argc, char *argv[]) {
     printf("[Main] All threads started successfully\n");
 
     // Wait for all threads to complete
-    pthread_join(sensor1_tid, NULL);
-    pthread_join(sensor2_tid, NULL);
+    for (int i = 0; i < sensor_threads; i++) {
+        pthread_join(sensor_tids[i], NULL);
+    }
     pthread_join(processor_tid, NULL);
     pthread_join(network_tid, NULL);
 
     // Clean up the sensor queue
+    latency_dump(stdout);
     queue_destroy(&sensor_queue);
+    history_destroy();
+    quantile_destroy();
+    rules_destroy();
+    i2c_bus_release_all();
 
     printf("All threads terminated. Exiting program.\n");
     return 0;
@@ -0,0 +1,35 @@
+#include "metrics.h"
+
+metrics_t metrics;
+
+void metrics_sensor_read(int sensor_id, int ok) {
+    if (sensor_id < 1 || sensor_id > METRICS_MAX_SENSORS) {
+        return;
+    }
+    atomic_ulong *counter = ok ? &metrics.sensor_reads[sensor_id] : &metrics.sensor_failures[sensor_id];
+    atomic_fetch_add_explicit(counter, 1, memory_order_relaxed);
+}
+
+void metrics_sensor_schedule(int sensor_id, uint64_t late_ns, unsigned int missed) {
+    if (sensor_id < 1 || sensor_id > METRICS_MAX_SENSORS) {
+        return;
+    }
+    if (missed > 0) {
+        atomic_fetch_add_explicit(&metrics.sensor_missed[sensor_id], missed, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&metrics.sensor_jitter_count[sensor_id], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&metrics.sensor_jitter_sum_ns[sensor_id], late_ns, memory_order_relaxed);
+    _Atomic uint64_t *max_ns = &metrics.sensor_jitter_max_ns[sensor_id];
+    uint64_t max = atomic_load_explicit(max_ns, memory_order_relaxed);
+    while (late_ns > max &&
+           !atomic_compare_exchange_weak_explicit(max_ns, &max, late_ns,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void metrics_sensor_rejected(int sensor_id) {
+    if (sensor_id < 1 || sensor_id > METRICS_MAX_SENSORS) {
+        return;
+    }
+    atomic_fetch_add_explicit(&metrics.sensor_rejected[sensor_id], 1, memory_order_relaxed);
+}
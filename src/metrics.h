@@ -0,0 +1,55 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include "config.h"
+
+// Process-wide counters exported on /metrics.
+//
+// Every counter is an atomic bumped with memory_order_relaxed, so the threads
+// that update them never take a lock or order anything; readers get a
+// snapshot that may be a few increments behind. Queue and log writer counters
+// live with those modules (queue_get_stats, log_writer_get_stats) and HTTP
+// counters with the network thread.
+
+// Highest sensor id with its own read counters (ids start at 1)
+#define METRICS_MAX_SENSORS CONFIG_MAX_SENSORS
+
+typedef struct {
+    atomic_ulong sensor_reads[METRICS_MAX_SENSORS + 1];     // Indexed by sensor id
+    atomic_ulong sensor_failures[METRICS_MAX_SENSORS + 1];
+    // Schedule adherence: deadlines skipped after falling behind, and how late
+    // each sweep started relative to the sensor's deadline
+    atomic_ulong sensor_missed[METRICS_MAX_SENSORS + 1];
+    atomic_ulong sensor_jitter_count[METRICS_MAX_SENSORS + 1];
+    _Atomic uint64_t sensor_jitter_sum_ns[METRICS_MAX_SENSORS + 1];
+    _Atomic uint64_t sensor_jitter_max_ns[METRICS_MAX_SENSORS + 1];
+    atomic_ulong sensor_rejected[METRICS_MAX_SENSORS + 1];   // Readings dropped by the filter chain
+    atomic_ulong processor_iterations;                       // Batches taken off the queue
+} metrics_t;
+
+extern metrics_t metrics;
+
+// Count the outcome of one sensor's register read in a bus sweep (ok = a
+// temperature was decoded). Unknown ids are ignored.
+void metrics_sensor_read(int sensor_id, int ok);
+
+// Record when a sensor's scheduled read started, late_ns after its deadline,
+// and how many deadlines it skipped before it. Unknown ids are ignored.
+void metrics_sensor_schedule(int sensor_id, uint64_t late_ns, unsigned int missed);
+
+// Count one reading rejected by its sensor's filter chain. Unknown ids are ignored.
+void metrics_sensor_rejected(int sensor_id);
+
+// Count one data processor loop iteration
+static inline void metrics_processor_iteration(void) {
+    atomic_fetch_add_explicit(&metrics.processor_iterations, 1, memory_order_relaxed);
+}
+
+// Relaxed read of a counter
+static inline unsigned long metrics_get(atomic_ulong *counter) {
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+#endif // METRICS_H
@@ -1,6 +1,12 @@
 #include "network.h"
 #include "utils.h"
 #include "config.h"
+#include "history.h"
+#include "quantile.h"
+#include "rules.h"
+#include "metrics.h"
+#include "log_writer.h"
+#include "latency.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,11 +14,154 @@
 #include <pthread.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/tcp.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdint.h>
+#include <strings.h>
 #include <ctype.h>
+#include <limits.h>
+#include <time.h>
+#include <stdarg.h>
 
 #define BUFFER_SIZE 2048
+#define REQUEST_MAX 4096        // Largest request head accepted
+#define OUTPUT_MAX 65536        // Unsent output above which a client's requests wait
+#define EPOLL_BATCH 64          // Events handled per epoll_wait
+#define SWEEP_INTERVAL_MS 1000  // How often idle connections are looked for
+#define STREAM_PING_MS 15000    // Comment line sent to quiet /api/stream subscribers
 #define INVALID_TEMP -999.0f
 
+// Largest status page body: a line per sensor on top of the fixed markup
+#define STATUS_BODY_SIZE (1024 + CONFIG_MAX_SENSORS * 96)
+
+// Maximum samples or buckets returned by one /api/history request
+#define HISTORY_QUERY_MAX 3600
+
+// Longest /json?wait= long-poll accepted, in milliseconds
+#define LONG_POLL_MAX_MS 60000
+
+// Routes counted separately in /metrics
+typedef enum {
+    ROUTE_INDEX = 0,
+    ROUTE_JSON,
+    ROUTE_STREAM,
+    ROUTE_HISTORY,
+    ROUTE_STATS,
+    ROUTE_QUANTILES,
+    ROUTE_ALERTS,
+    ROUTE_METRICS,
+    ROUTE_LATENCY,
+    ROUTE_OTHER,
+    ROUTE_COUNT
+} route_t;
+
+static const char *route_names[ROUTE_COUNT] = {
+    "/", "/json", "/api/stream", "/api/history", "/api/stats", "/api/quantiles", "/api/alerts", "/metrics", "/api/latency", "other"
+};
+
+// Response statuses counted in /metrics
+static const int counted_statuses[] = { 200, 304, 400, 404, 405, 431, 500, 503 };
+#define STATUS_COUNT (sizeof(counted_statuses) / sizeof(counted_statuses[0]))
+
+// The parts of a request head the router looks at
+typedef struct {
+    char method[16];
+    char path[256];            // Without the query string
+    const char *query;         // Points into path; "" if there is none
+    int keep_alive;            // From the HTTP version and Connection header
+    char if_none_match[128];   // If-None-Match header value, "" if absent
+} http_request_t;
+
+// One client connection. Requests are read into `in` until a full head has
+// arrived; responses are queued in `out` and written as the socket allows.
+typedef struct connection {
+    int fd;
+    char in[REQUEST_MAX];
+    size_t in_len;
+    char *out;
+    size_t out_len;
+    size_t out_sent;
+    size_t out_cap;
+    int close_after_write;     // Close once out has been written
+    int peer_closed;           // The client shut down its side; close once answered
+    int input_held;            // Requests wait for the output to drain below OUTPUT_MAX
+    int streaming;             // Subscribed to /api/stream; input is ignored
+    unsigned long stream_version;  // Last event version sent to this subscriber
+    int waiting;               // Parked in a /json?wait= long-poll; input is held back
+    unsigned long wait_version;    // Reading version the long-poll waits to see replaced
+    long long wait_deadline_ms;    // When the long-poll is answered regardless
+    int wait_not_modified;     // The client already holds wait_version (answer 304 on timeout)
+    route_t route;             // Route of the request being answered
+    uint32_t events;           // Events registered with epoll
+    long long last_active_ms;
+    struct connection *prev;
+    struct connection *next;
+} connection_t;
+
+static connection_t *connections = NULL;  // All open connections
+static int connection_count = 0;
+static int wakeup_fd = -1;                // eventfd used to interrupt epoll_wait
+static int update_fd = -1;                // eventfd signalled by latest_reading_publish
+static int stream_subscribers = 0;        // Connections with streaming set
+static int long_polls = 0;                // Connections with waiting set
+static long long long_poll_deadline = 0;  // Earliest wait_deadline_ms (may be stale-early)
+static unsigned long stream_dropped = 0;  // Events skipped for subscribers with full buffers
+
+// Responses by route and status. Only the network thread touches these, so
+// they are plain counters.
+static unsigned long http_responses[ROUTE_COUNT][STATUS_COUNT];
+
+static void count_response(route_t route, int status) {
+    for (size_t i = 0; i < STATUS_COUNT; i++) {
+        if (counted_statuses[i] == status) {
+            http_responses[route][i]++;
+            return;
+        }
+    }
+}
+
+// A fully rendered 200 response for one endpoint, plus the 304 sent to clients
+// whose If-None-Match already names it. The bytes are rebuilt only when the
+// latest reading's version moves on, so polling between updates is a lookup and
+// a single sendmsg.
+typedef struct {
+    int valid;
+    unsigned long version;   // Latest reading version the bytes were rendered from
+    char etag[48];           // Quoted boot and version, e.g. "18f3a2c4b5d6e7f8-42"
+    char head[208];          // Status line, Content-Type, Content-Length and ETag
+    size_t head_len;
+    char not_modified[80];   // 304 status line and ETag
+    size_t not_modified_len;
+    char body[STATUS_BODY_SIZE];
+    size_t body_len;
+} cached_response_t;
+
+static cached_response_t html_cache;
+static cached_response_t json_cache;
+
+// Prefix of every entity tag, set from the wall clock when the server starts.
+// Reading versions restart at 0 with the process, so without it a tag kept
+// from an earlier run could name different data.
+static char etag_boot[24];
+
+// The current /api/stream event, serialized once and shared by every subscriber
+static struct {
+    int valid;
+    unsigned long version;
+    char data[STATUS_BODY_SIZE + 64];
+    size_t len;
+} stream_event;
+
+static const char stream_headers[] = "HTTP/1.1 200 OK\r\n"
+                                     "Content-Type: text/event-stream\r\n"
+                                     "Cache-Control: no-cache\r\n"
+                                     "Connection: keep-alive\r\n"
+                                     "\r\n";
+
 // Helper function to HTML-escape a string to prevent XSS
 static void html_escape(const char *src, char *dest, size_t dest_size) {
     size_t j = 0;
@@ -78,9 +227,24 @@ static void html_escape(const char *src, char *dest, size_t dest_size) {
     dest[j] = '\0';
 }
 
-// Helper function to parse HTTP request and extract method and path
+// Copy a header value (up to the end of its line, without surrounding blanks)
+static void copy_header_value(const char *value, char *dest, size_t dest_size) {
+    while (*value == ' ' || *value == '\t') value++;
+    size_t len = strcspn(value, "\r\n");
+    while (len > 0 && (value[len - 1] == ' ' || value[len - 1] == '\t')) len--;
+    if (len >= dest_size) len = dest_size - 1;
+    memcpy(dest, value, len);
+    dest[len] = '\0';
+}
+
+// Helper function to parse an HTTP request head: the request line, the query
+// string and the headers the server acts on.
 // Prevents buffer overflow by limiting field widths
-static void parse_http_request(const char *request, char *method, char *path) {
+static void parse_http_request(const char *request, http_request_t *req) {
+    memset(req, 0, sizeof(*req));
+    char *method = req->method;
+    char *path = req->path;
+
     // Limit method to 15 chars, path to 255 chars (leaving space for null terminator)
     sscanf(request, "%15s %255s", method, path);
     // Check for truncation: if method or path is at max length and next char is not space/end
@@ -97,69 +261,135 @@ static void parse_http_request(const char *request, char *method, char *path) {
             path[0] = '\0'; // Invalidate path
         }
     }
-}
 
-// Helper function to send HTTP response
-static void send_response(int socket, const char *status, const char *content_type,
-                         const char *body) {
-    char response[BUFFER_SIZE];
-    int body_len = strlen(body);
+    // Split off the query string
+    char *query = strchr(path, '?');
+    if (query) {
+        *query++ = '\0';
+        req->query = query;
+    } else {
+        req->query = "";
+    }
 
-    snprintf(response, sizeof(response),
-             "HTTP/1.1 %s\r\n"
-             "Content-Type: %s\r\n"
-             "Content-Length: %d\r\n"
-             "Connection: close\r\n"
-             "\r\n"
-             "%s",
-             status, content_type, body_len, body);
+    // HTTP/1.1 defaults to keep-alive, HTTP/1.0 to close; a Connection header overrides
+    const char *line_end = strstr(request, "\r\n");
+    req->keep_alive = line_end && line_end - request >= 8 && strncmp(line_end - 8, "HTTP/1.1", 8) == 0;
 
-    ssize_t sent = write(socket, response, strlen(response));
-    if (sent < 0) {
-        perror("[Network] Failed to send response");
+    const char *line = line_end ? line_end + 2 : NULL;
+    while (line && *line && strncmp(line, "\r\n", 2) != 0) {
+        if (strncasecmp(line, "Connection:", 11) == 0) {
+            const char *value = line + 11;
+            while (*value == ' ' || *value == '\t') value++;
+            if (strncasecmp(value, "close", 5) == 0) {
+                req->keep_alive = 0;
+            } else if (strncasecmp(value, "keep-alive", 10) == 0) {
+                req->keep_alive = 1;
+            }
+        } else if (strncasecmp(line, "If-None-Match:", 14) == 0) {
+            copy_header_value(line + 14, req->if_none_match, sizeof(req->if_none_match));
+        }
+        line = strstr(line, "\r\n");
+        if (line) line += 2;
     }
 }
 
-// Generate HTML status page
-static void generate_html_response(char *buffer, size_t size) {
-    pthread_mutex_lock(&latest_mutex);
+// Does an If-None-Match header value match etag? Weak comparison, as RFC 9110
+// requires for If-None-Match; "*" matches any current representation.
+static int etag_matches(const char *if_none_match, const char *etag) {
+    size_t etag_len = strlen(etag);
+    const char *p = if_none_match;
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        if (*p == '*') {
+            return 1;
+        }
+        if (strncmp(p, "W/", 2) == 0) {
+            p += 2;
+        }
+        size_t len = strcspn(p, ", \t");
+        if (len == etag_len && strncmp(p, etag, len) == 0) {
+            return 1;
+        }
+        p += len;
+    }
+    return 0;
+}
+
+// Append printf-style text to a response body, stopping once it is full
+static void body_printf(char *body, size_t size, size_t *len, const char *fmt, ...) {
+    if (*len >= size) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(body + *len, size - *len, fmt, args);
+    va_end(args);
+    if (n < 0) {
+        return;
+    }
+    // vsnprintf returns the untruncated length: stop at the terminator
+    if ((size_t)n >= size - *len) {
+        *len = size - 1;
+    } else {
+        *len += (size_t)n;
+    }
+}
 
+// Latest value of a configured sensor, INVALID_TEMP if it has none
+static float sensor_value(const latest_reading_t *latest, int id) {
+    return id <= latest->sensor_count ? latest->sensors[id - 1] : INVALID_TEMP;
+}
+
+// Generate HTML status page
+static void generate_html_response(const latest_reading_t *latest, char *buffer, size_t size) {
     // Check if we have valid data
-    int has_data = (latest_reading.time_str[0] != '\0');
+    int has_data = (latest->time_str[0] != '\0');
 
     if (has_data) {
-        // Format sensor values (handle N/A cases)
-        char sensor1_str[32], sensor2_str[32];
+        size_t len = 0;
+        body_printf(buffer, size, &len,
+                    "<!DOCTYPE html>"
+                    "<html><head><title>SensorHub Status</title>"
+                    "<style>body{font-family:Arial,sans-serif;margin:40px;}"
+                    "h1{color:#333;}.status{background:#f0f0f0;padding:20px;border-radius:5px;}"
+                    ".sensor{margin:10px 0;}</style></head>"
+                    "<body>"
+                    "<h1>SensorHub Status</h1>"
+                    "<div class='status'>"
+                    "<div class='sensor'><strong>Last Update:</strong> %s</div>",
+                    latest->time_str);
 
-        if (latest_reading.sensor1 == INVALID_TEMP) {
-            snprintf(sensor1_str, sizeof(sensor1_str), "N/A");
-        } else {
-            snprintf(sensor1_str, sizeof(sensor1_str), "%.2f &deg;C", latest_reading.sensor1);
+        // One line per configured sensor (handle N/A cases)
+        for (int i = 0; i < g_config.sensor_count; i++) {
+            const sensor_config_t *sensor = &g_config.sensors[i];
+            char label[sizeof(sensor->name) * 6];
+            if (sensor->name[0]) {
+                html_escape(sensor->name, label, sizeof(label));
+            } else {
+                snprintf(label, sizeof(label), "Sensor%d", sensor->id);
+            }
+            float value = sensor_value(latest, sensor->id);
+            if (value == INVALID_TEMP) {
+                body_printf(buffer, size, &len,
+                            "<div class='sensor'><strong>%s:</strong> N/A</div>", label);
+            } else {
+                body_printf(buffer, size, &len,
+                            "<div class='sensor'><strong>%s:</strong> %.2f &deg;C</div>",
+                            label, value);
+            }
         }
 
-        if (latest_reading.sensor2 == INVALID_TEMP) {
-            snprintf(sensor2_str, sizeof(sensor2_str), "N/A");
+        if (latest->average == INVALID_TEMP) {
+            body_printf(buffer, size, &len, "<div class='sensor'><strong>Average:</strong> N/A</div>");
         } else {
-            snprintf(sensor2_str, sizeof(sensor2_str), "%.2f &deg;C", latest_reading.sensor2);
+            body_printf(buffer, size, &len,
+                        "<div class='sensor'><strong>Average:</strong> %.2f &deg;C</div>",
+                        latest->average);
         }
-
-        snprintf(buffer, size,
-                 "<!DOCTYPE html>"
-                 "<html><head><title>SensorHub Status</title>"
-                 "<style>body{font-family:Arial,sans-serif;margin:40px;}"
-                 "h1{color:#333;}.status{background:#f0f0f0;padding:20px;border-radius:5px;}"
-                 ".sensor{margin:10px 0;}</style></head>"
-                 "<body>"
-                 "<h1>SensorHub Status</h1>"
-                 "<div class='status'>"
-                 "<div class='sensor'><strong>Last Update:</strong> %s</div>"
-                 "<div class='sensor'><strong>Sensor1:</strong> %s</div>"
-                 "<div class='sensor'><strong>Sensor2:</strong> %s</div>"
-                 "<div class='sensor'><strong>Average:</strong> %.2f &deg;C</div>"
-                 "</div>"
-                 "<p><a href='/json'>JSON API</a></p>"
-                 "</body></html>",
-                 latest_reading.time_str, sensor1_str, sensor2_str, latest_reading.average);
+        body_printf(buffer, size, &len,
+                    "</div>"
+                    "<p><a href='/json'>JSON API</a></p>"
+                    "</body></html>");
     } else {
         snprintf(buffer, size,
                  "<!DOCTYPE html>"
@@ -169,49 +399,35 @@ static void generate_html_response(char *buffer, size_t size) {
                  "<p>No sensor data available yet. Please wait...</p>"
                  "</body></html>");
     }
-
-    pthread_mutex_unlock(&latest_mutex);
 }
 
-// Generate JSON status response
-static void generate_json_response(char *buffer, size_t size) {
-    pthread_mutex_lock(&latest_mutex);
-
+// Generate JSON status response: one "sensorN" member per configured sensor
+static void generate_json_response(const latest_reading_t *latest, char *buffer, size_t size) {
     // Check if we have valid data
-    int has_data = (latest_reading.time_str[0] != '\0');
+    int has_data = (latest->time_str[0] != '\0');
 
     if (has_data) {
-        // Format sensor values (handle N/A cases)
-        char sensor1_str[32], sensor2_str[32];
+        size_t len = 0;
+        body_printf(buffer, size, &len, "{\"timestamp\":\"%s\",", latest->time_str);
 
-        if (latest_reading.sensor1 == INVALID_TEMP) {
-            snprintf(sensor1_str, sizeof(sensor1_str), "null");
-        } else {
-            snprintf(sensor1_str, sizeof(sensor1_str), "%.2f", latest_reading.sensor1);
-        }
-
-        if (latest_reading.sensor2 == INVALID_TEMP) {
-            snprintf(sensor2_str, sizeof(sensor2_str), "null");
-        } else {
-            snprintf(sensor2_str, sizeof(sensor2_str), "%.2f", latest_reading.sensor2);
+        // Unavailable sensors are null
+        for (int i = 0; i < g_config.sensor_count; i++) {
+            int id = g_config.sensors[i].id;
+            float value = sensor_value(latest, id);
+            if (value == INVALID_TEMP) {
+                body_printf(buffer, size, &len, "\"sensor%d\":null,", id);
+            } else {
+                body_printf(buffer, size, &len, "\"sensor%d\":%.2f,", id, value);
+            }
         }
 
-        // Handle average: output null if both sensors are unavailable
-        char average_str[32];
-        if (latest_reading.sensor1 == INVALID_TEMP && latest_reading.sensor2 == INVALID_TEMP) {
-            snprintf(average_str, sizeof(average_str), "null");
+        // Handle average: output null if every sensor is unavailable
+        if (latest->average == INVALID_TEMP) {
+            body_printf(buffer, size, &len, "\"average\":null,");
         } else {
-            snprintf(average_str, sizeof(average_str), "%.2f", latest_reading.average);
+            body_printf(buffer, size, &len, "\"average\":%.2f,", latest->average);
         }
-        snprintf(buffer, size,
-                 "{"
-                 "\"timestamp\":\"%s\","
-                 "\"sensor1\":%s,"
-                 "\"sensor2\":%s,"
-                 "\"average\":%s,"
-                 "\"status\":\"ok\""
-                 "}",
-                 latest_reading.time_str, sensor1_str, sensor2_str, average_str);
+        body_printf(buffer, size, &len, "\"status\":\"ok\"}");
     } else {
         snprintf(buffer, size,
                  "{"
@@ -219,21 +435,1000 @@ static void generate_json_response(char *buffer, size_t size) {
                  "\"message\":\"No sensor data available yet\""
                  "}");
     }
+}
+
+// Find a parameter in a URL query string ("a=1&b=2"). Returns 1 if present.
+static int get_query_param(const char *query, const char *name, char *value, size_t size) {
+    size_t name_len = strlen(name);
+    const char *p = query;
+    while (p && *p) {
+        const char *end = strchr(p, '&');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len > name_len && strncmp(p, name, name_len) == 0 && p[name_len] == '=') {
+            size_t value_len = len - name_len - 1;
+            if (value_len >= size) value_len = size - 1;
+            memcpy(value, p + name_len + 1, value_len);
+            value[value_len] = '\0';
+            return 1;
+        }
+        p = end ? end + 1 : NULL;
+    }
+    return 0;
+}
+
+// Parse an optional integer query parameter. Returns 0 if absent or valid, -1 if invalid.
+static int get_query_long(const char *query, const char *name, long long *result) {
+    char value[32];
+    if (!get_query_param(query, name, value, sizeof(value))) {
+        return 0;
+    }
+    char *endptr;
+    long long val = strtoll(value, &endptr, 10);
+    if (endptr == value || *endptr != '\0') {
+        return -1;
+    }
+    *result = val;
+    return 0;
+}
+
+// Serve /api/history?sensor=&res=&from=&to=&limit= from the in-memory history.
+// Returns a malloc'd JSON body and sets *status.
+static char *generate_history_response(const char *query, const char **status) {
+    long long sensor = 0, from = 0, to = LLONG_MAX, limit = HISTORY_QUERY_MAX;
+    char res_name[8] = "raw";
+    int res = HISTORY_RES_RAW;
+    const char *error = NULL;
+
+    if (get_query_long(query, "sensor", &sensor) != 0 || sensor < 1 ||
+        sensor > HISTORY_MAX_SENSORS || !config_find_sensor((int)sensor)) {
+        error = "sensor must be a configured sensor id";
+    } else if (get_query_long(query, "from", &from) != 0 ||
+               get_query_long(query, "to", &to) != 0) {
+        error = "from and to must be Unix timestamps";
+    } else if (get_query_long(query, "limit", &limit) != 0 || limit < 1) {
+        error = "limit must be a positive integer";
+    } else if (get_query_param(query, "res", res_name, sizeof(res_name)) &&
+               (res = history_parse_resolution(res_name)) < 0) {
+        error = "res must be one of raw, 1s, 1m, 1h";
+    }
+    if (limit > HISTORY_QUERY_MAX) {
+        limit = HISTORY_QUERY_MAX;
+    }
+
+    // Every entry fits in 96 bytes of JSON
+    size_t size = error ? 256 : 128 + (size_t)limit * 96;
+    char *body = malloc(size);
+    if (!body) {
+        *status = "500 Internal Server Error";
+        return NULL;
+    }
+    if (error) {
+        *status = "400 Bad Request";
+        snprintf(body, size, "{\"status\":\"error\",\"message\":\"%s\"}", error);
+        return body;
+    }
+
+    size_t len = (size_t)snprintf(body, size, "{\"sensor\":%lld,\"resolution\":\"%s\",",
+                                  sensor, history_resolution_name(res));
+    int n;
+    if (res == HISTORY_RES_RAW) {
+        history_sample_t *samples = malloc((size_t)limit * sizeof(*samples));
+        n = samples ? history_query_raw((int)sensor, (time_t)from, (time_t)to, samples, (int)limit) : 0;
+        len += (size_t)snprintf(body + len, size - len, "\"count\":%d,\"samples\":[", n > 0 ? n : 0);
+        for (int i = 0; i < n; i++) {
+            len += (size_t)snprintf(body + len, size - len, "%s{\"t\":%lld,\"value\":%.2f}",
+                                    i ? "," : "", (long long)samples[i].timestamp,
+                                    samples[i].value);
+        }
+        free(samples);
+    } else {
+        history_bucket_t *buckets = malloc((size_t)limit * sizeof(*buckets));
+        n = buckets ? history_query_buckets((int)sensor, (history_res_t)res, (time_t)from,
+                                            (time_t)to, buckets, (int)limit) : 0;
+        len += (size_t)snprintf(body + len, size - len, "\"count\":%d,\"buckets\":[", n > 0 ? n : 0);
+        for (int i = 0; i < n; i++) {
+            len += (size_t)snprintf(body + len, size - len,
+                                    "%s{\"t\":%lld,\"min\":%.2f,\"max\":%.2f,\"mean\":%.2f,\"count\":%u}",
+                                    i ? "," : "", (long long)buckets[i].start, buckets[i].min,
+                                    buckets[i].max, buckets[i].mean, buckets[i].count);
+        }
+        free(buckets);
+    }
+    snprintf(body + len, size - len, "],\"status\":\"ok\"}");
+    *status = "200 OK";
+    return body;
+}
+
+// Serve /api/stats?sensor=&from=&to= from the in-memory raw history: count,
+// min, max, mean and stddev of every sample in the range. Writes the JSON body
+// and returns the HTTP status.
+static const char *generate_stats_response(const char *query, char *buffer, size_t size) {
+    long long sensor = 0, from = 0, to = LLONG_MAX;
+    const char *error = NULL;
+
+    if (get_query_long(query, "sensor", &sensor) != 0 || sensor < 1 ||
+        sensor > HISTORY_MAX_SENSORS || !config_find_sensor((int)sensor)) {
+        error = "sensor must be a configured sensor id";
+    } else if (get_query_long(query, "from", &from) != 0 ||
+               get_query_long(query, "to", &to) != 0) {
+        error = "from and to must be Unix timestamps";
+    }
+
+    simd_stats_t st;
+    if (!error && history_query_stats((int)sensor, (time_t)from, (time_t)to, &st) != 0) {
+        error = "no history for this sensor";
+    }
+    if (error) {
+        snprintf(buffer, size, "{\"status\":\"error\",\"message\":\"%s\"}", error);
+        return "400 Bad Request";
+    }
+
+    snprintf(buffer, size,
+             "{\"sensor\":%lld,\"from\":%lld,\"to\":%lld,\"count\":%zu,\"min\":%.2f,"
+             "\"max\":%.2f,\"mean\":%.3f,\"stddev\":%.3f,\"status\":\"%s\"}",
+             sensor, from, to, st.count, st.min, st.max, st.mean, st.stddev,
+             st.count ? "ok" : "no_data");
+    return "200 OK";
+}
+
+// Parse a comma-separated list of quantiles, each in [0, 1], into qs.
+// Returns how many there are, or -1 if the list is empty, too long or invalid.
+static int parse_quantile_list(const char *list, double *qs, int max) {
+    int n = 0;
+    const char *p = list;
+    while (n < max) {
+        char *endptr;
+        double q = strtod(p, &endptr);
+        if (endptr == p || !(q >= 0 && q <= 1) || (*endptr != ',' && *endptr != '\0')) {
+            return -1;
+        }
+        qs[n++] = q;
+        if (*endptr == '\0') {
+            return n;
+        }
+        p = endptr + 1;
+    }
+    return -1;
+}
+
+// Serve /api/quantiles?sensor=&q=&window= from the per-sensor t-digests: the
+// estimated quantiles over the last minute, hour and day, or just the one
+// window asked for. Writes the JSON body and returns the HTTP status.
+static const char *generate_quantiles_response(const char *query, char *buffer, size_t size) {
+    long long sensor = 0;
+    double qs[QUANTILE_QUERY_MAX] = { 0.5, 0.95, 0.99 };
+    int n = 3, first = 0, last = QUANTILE_WIN_COUNT - 1;
+    char list[256], window[8];
+    const char *error = NULL;
+
+    if (get_query_long(query, "sensor", &sensor) != 0 || sensor < 1 ||
+        sensor > QUANTILE_MAX_SENSORS || !config_find_sensor((int)sensor)) {
+        error = "sensor must be a configured sensor id";
+    } else if (get_query_param(query, "q", list, sizeof(list)) &&
+               (n = parse_quantile_list(list, qs, QUANTILE_QUERY_MAX)) < 0) {
+        error = "q must be a comma-separated list of up to 16 values in [0, 1]";
+    } else if (get_query_param(query, "window", window, sizeof(window)) &&
+               (first = last = quantile_parse_window(window)) < 0) {
+        error = "window must be one of 1m, 1h, 24h";
+    }
+    if (error) {
+        snprintf(buffer, size, "{\"status\":\"error\",\"message\":\"%s\"}", error);
+        return "400 Bad Request";
+    }
+
+    time_t now = time(NULL);
+    size_t len = (size_t)snprintf(buffer, size, "{\"sensor\":%lld,\"windows\":[", sensor);
+    for (int w = first; w <= last && len < size; w++) {
+        double out[QUANTILE_QUERY_MAX];
+        long count = quantile_query((int)sensor, (quantile_window_t)w, now, qs, n, out);
+        len += (size_t)snprintf(buffer + len, size - len,
+                                "%s{\"window\":\"%s\",\"count\":%ld,\"quantiles\":[",
+                                w > first ? "," : "", quantile_window_name((quantile_window_t)w),
+                                count > 0 ? count : 0);
+        for (int i = 0; i < n && len < size; i++) {
+            // No readings in the window: null rather than NaN, which is not JSON
+            if (count > 0) {
+                len += (size_t)snprintf(buffer + len, size - len, "%s{\"q\":%g,\"value\":%.2f}",
+                                        i ? "," : "", qs[i], out[i]);
+            } else {
+                len += (size_t)snprintf(buffer + len, size - len, "%s{\"q\":%g,\"value\":null}",
+                                        i ? "," : "", qs[i]);
+            }
+        }
+        if (len < size) {
+            len += (size_t)snprintf(buffer + len, size - len, "]}");
+        }
+    }
+    if (len < size) {
+        snprintf(buffer + len, size - len, "],\"status\":\"ok\"}");
+    }
+    return "200 OK";
+}
+
+// Serve /api/alerts: the alerts firing now and the most recent alerts firing
+// and clearing, oldest first. Returns a malloc'd JSON body.
+static char *generate_alerts_response(void) {
+    int active = rules_active(NULL, 0);
+    rules_alert_t *alerts = malloc(((size_t)active + 1) * sizeof(*alerts));
+    rules_event_t events[RULES_EVENTS];
+    if (!alerts) {
+        return NULL;
+    }
+    active = rules_active(alerts, active);
+    int event_count = rules_events(events, RULES_EVENTS);
+
+    // Names and conditions need no escaping (see rule_parse)
+    size_t size = 256 + (size_t)active * (RULES_NAME_MAX + RULES_EXPR_MAX + 128) +
+                  (size_t)event_count * (RULES_NAME_MAX + 96);
+    char *body = malloc(size);
+    if (!body) {
+        free(alerts);
+        return NULL;
+    }
+    size_t len = (size_t)snprintf(body, size, "{\"rules\":%d,\"active\":[", rules_count());
+    for (int i = 0; i < active; i++) {
+        len += (size_t)snprintf(body + len, size - len,
+                                "%s{\"rule\":\"%s\",\"sensor\":%d,\"condition\":\"%s\","
+                                "\"since\":%.3f,\"value\":%.2f}",
+                                i ? "," : "", alerts[i].name, alerts[i].sensor, alerts[i].expr,
+                                alerts[i].since_ms / 1e3, alerts[i].value);
+    }
+    len += (size_t)snprintf(body + len, size - len, "],\"events\":[");
+    for (int i = 0; i < event_count; i++) {
+        len += (size_t)snprintf(body + len, size - len,
+                                "%s{\"t\":%.3f,\"rule\":\"%s\",\"sensor\":%d,\"state\":\"%s\","
+                                "\"value\":%.2f}",
+                                i ? "," : "", events[i].time_ms / 1e3, events[i].name,
+                                events[i].sensor, events[i].firing ? "firing" : "cleared",
+                                events[i].value);
+    }
+    snprintf(body + len, size - len, "],\"status\":\"ok\"}");
+    free(alerts);
+    return body;
+}
+
+// Serve /api/latency: count and p50/p99/p99.9/max in microseconds for each
+// pipeline stage
+static void generate_latency_response(char *buffer, size_t size) {
+    size_t len = (size_t)snprintf(buffer, size, "{\"stages\":[");
+    for (int s = 0; s < LATENCY_STAGE_COUNT && len < size; s++) {
+        latency_summary_t sum;
+        latency_stage_summary((latency_stage_t)s, &sum);
+        len += (size_t)snprintf(buffer + len, size - len,
+                                "%s{\"stage\":\"%s\",\"count\":%lu,\"p50_us\":%.1f,"
+                                "\"p99_us\":%.1f,\"p999_us\":%.1f,\"max_us\":%.1f}",
+                                s ? "," : "", latency_stage_name((latency_stage_t)s), sum.count,
+                                sum.p50_ns / 1e3, sum.p99_ns / 1e3, sum.p999_ns / 1e3,
+                                sum.max_ns / 1e3);
+    }
+    if (len < size) {
+        snprintf(buffer + len, size - len, "],\"status\":\"ok\"}");
+    }
+}
+
+// Render /metrics in the Prometheus text exposition format. Returns a malloc'd body.
+static char *generate_metrics_response(void) {
+    size_t size = 4096 + ROUTE_COUNT * STATUS_COUNT * 96 + (size_t)g_config.sensor_count * 512;
+    char *body = malloc(size);
+    if (!body) {
+        return NULL;
+    }
+    size_t len = 0;
+
+    queue_stats_t queue;
+    queue_get_stats(&sensor_queue, &queue);
+    body_printf(body, size, &len,
+                "# HELP sensorhub_queue_depth Readings waiting in the sensor queue.\n"
+                "# TYPE sensorhub_queue_depth gauge\n"
+                "sensorhub_queue_depth %zu\n"
+                "# HELP sensorhub_queue_high_water Deepest the sensor queue has been.\n"
+                "# TYPE sensorhub_queue_high_water gauge\n"
+                "sensorhub_queue_high_water %zu\n"
+                "# HELP sensorhub_queue_capacity Sensor queue capacity.\n"
+                "# TYPE sensorhub_queue_capacity gauge\n"
+                "sensorhub_queue_capacity %zu\n"
+                "# HELP sensorhub_queue_dropped_total Readings dropped because the queue was full.\n"
+                "# TYPE sensorhub_queue_dropped_total counter\n"
+                "sensorhub_queue_dropped_total %lu\n",
+                queue.depth, queue.high_water, queue.capacity, queue.dropped);
+
+    body_printf(body, size, &len,
+                "# HELP sensorhub_sensor_reads_total Sensor reads by result.\n"
+                "# TYPE sensorhub_sensor_reads_total counter\n");
+    for (int i = 0; i < g_config.sensor_count; i++) {
+        int id = g_config.sensors[i].id;
+        body_printf(body, size, &len,
+                    "sensorhub_sensor_reads_total{sensor=\"%d\",result=\"ok\"} %lu\n"
+                    "sensorhub_sensor_reads_total{sensor=\"%d\",result=\"error\"} %lu\n",
+                    id, metrics_get(&metrics.sensor_reads[id]),
+                    id, metrics_get(&metrics.sensor_failures[id]));
+    }
+
+    body_printf(body, size, &len,
+                "# HELP sensorhub_sensor_missed_deadlines_total Read deadlines dropped because the sensor fell behind.\n"
+                "# TYPE sensorhub_sensor_missed_deadlines_total counter\n");
+    for (int i = 0; i < g_config.sensor_count; i++) {
+        int id = g_config.sensors[i].id;
+        body_printf(body, size, &len, "sensorhub_sensor_missed_deadlines_total{sensor=\"%d\"} %lu\n",
+                    id, metrics_get(&metrics.sensor_missed[id]));
+    }
+    body_printf(body, size, &len,
+                "# HELP sensorhub_sensor_rejected_total Readings dropped by the sensor's filter chain.\n"
+                "# TYPE sensorhub_sensor_rejected_total counter\n");
+    for (int i = 0; i < g_config.sensor_count; i++) {
+        int id = g_config.sensors[i].id;
+        body_printf(body, size, &len, "sensorhub_sensor_rejected_total{sensor=\"%d\"} %lu\n",
+                    id, metrics_get(&metrics.sensor_rejected[id]));
+    }
+    body_printf(body, size, &len,
+                "# HELP sensorhub_sensor_jitter_seconds How late scheduled reads started after their deadline.\n"
+                "# TYPE sensorhub_sensor_jitter_seconds summary\n");
+    for (int i = 0; i < g_config.sensor_count; i++) {
+        int id = g_config.sensors[i].id;
+        uint64_t sum = atomic_load_explicit(&metrics.sensor_jitter_sum_ns[id], memory_order_relaxed);
+        body_printf(body, size, &len,
+                    "sensorhub_sensor_jitter_seconds_sum{sensor=\"%d\"} %.9f\n"
+                    "sensorhub_sensor_jitter_seconds_count{sensor=\"%d\"} %lu\n",
+                    id, sum / 1e9, id, metrics_get(&metrics.sensor_jitter_count[id]));
+    }
+    body_printf(body, size, &len,
+                "# HELP sensorhub_sensor_jitter_max_seconds Latest start of a scheduled read after its deadline.\n"
+                "# TYPE sensorhub_sensor_jitter_max_seconds gauge\n");
+    for (int i = 0; i < g_config.sensor_count; i++) {
+        int id = g_config.sensors[i].id;
+        uint64_t max = atomic_load_explicit(&metrics.sensor_jitter_max_ns[id], memory_order_relaxed);
+        body_printf(body, size, &len, "sensorhub_sensor_jitter_max_seconds{sensor=\"%d\"} %.9f\n",
+                    id, max / 1e9);
+    }
+
+    log_writer_stats_t log;
+    log_writer_get_stats(&log);
+    body_printf(body, size, &len,
+                "# HELP sensorhub_processor_iterations_total Batches taken off the queue by the processor.\n"
+                "# TYPE sensorhub_processor_iterations_total counter\n"
+                "sensorhub_processor_iterations_total %lu\n"
+                "# HELP sensorhub_log_bytes_written_total Bytes written to the data log.\n"
+                "# TYPE sensorhub_log_bytes_written_total counter\n"
+                "sensorhub_log_bytes_written_total %lu\n"
+                "# HELP sensorhub_log_records_written_total Rows written to the data log.\n"
+                "# TYPE sensorhub_log_records_written_total counter\n"
+                "sensorhub_log_records_written_total %lu\n"
+                "# HELP sensorhub_log_records_dropped_total Rows the log writer could not keep.\n"
+                "# TYPE sensorhub_log_records_dropped_total counter\n"
+                "sensorhub_log_records_dropped_total %lu\n",
+                metrics_get(&metrics.processor_iterations), log.bytes_written,
+                log.written, log.dropped);
+
+    body_printf(body, size, &len,
+                "# HELP sensorhub_http_responses_total HTTP responses by route and status.\n"
+                "# TYPE sensorhub_http_responses_total counter\n");
+    for (int r = 0; r < ROUTE_COUNT; r++) {
+        for (size_t i = 0; i < STATUS_COUNT; i++) {
+            if (http_responses[r][i] > 0) {
+                body_printf(body, size, &len,
+                            "sensorhub_http_responses_total{route=\"%s\",status=\"%d\"} %lu\n",
+                            route_names[r], counted_statuses[i], http_responses[r][i]);
+            }
+        }
+    }
+    body_printf(body, size, &len,
+                "# HELP sensorhub_http_connections Open HTTP connections.\n"
+                "# TYPE sensorhub_http_connections gauge\n"
+                "sensorhub_http_connections %d\n",
+                connection_count);
+    return body;
+}
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags < 0 ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// Append data to a connection's output buffer. Returns 0 on success, -1 on allocation failure.
+static int conn_append(connection_t *conn, const char *data, size_t len) {
+    if (conn->out_len + len > conn->out_cap) {
+        size_t cap = conn->out_cap ? conn->out_cap : 1024;
+        while (cap < conn->out_len + len) cap *= 2;
+        char *grown = realloc(conn->out, cap);
+        if (!grown) {
+            fprintf(stderr, "[Network] Allocation failure\n");
+            return -1;
+        }
+        conn->out = grown;
+        conn->out_cap = cap;
+    }
+    memcpy(conn->out + conn->out_len, data, len);
+    conn->out_len += len;
+    return 0;
+}
+
+// Send the pieces of a response with one sendmsg (a writev that cannot raise
+// SIGPIPE). Whatever the socket does not take, or everything if earlier output
+// is still queued, is appended to the connection's output buffer.
+static void send_iov(connection_t *conn, struct iovec *iov, int count) {
+    size_t sent = 0;
+    if (conn->out_len == 0) {
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = (size_t)count };
+        ssize_t n = sendmsg(conn->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        // On errors, queue everything; the next write reports the failure
+        sent = n > 0 ? (size_t)n : 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (sent >= iov[i].iov_len) {
+            sent -= iov[i].iov_len;
+            continue;
+        }
+        if (conn_append(conn, (const char *)iov[i].iov_base + sent, iov[i].iov_len - sent) != 0) {
+            conn->close_after_write = 1;
+            return;
+        }
+        sent = 0;
+    }
+}
+
+static const char keep_alive_line[] = "Connection: keep-alive\r\n\r\n";
+static const char close_line[] = "Connection: close\r\n\r\n";
+
+// Send head, Connection line and body; the Connection line is the only per-request part
+static void send_parts(connection_t *conn, const char *head, size_t head_len,
+                       const char *body, size_t body_len) {
+    count_response(conn->route, atoi(head + 9));  // Status code after "HTTP/1.1 "
+    struct iovec iov[3] = {
+        { (void *)head, head_len },
+        { conn->close_after_write ? (void *)close_line : (void *)keep_alive_line,
+          conn->close_after_write ? sizeof(close_line) - 1 : sizeof(keep_alive_line) - 1 },
+        { (void *)body, body_len },
+    };
+    send_iov(conn, iov, 3);
+}
+
+// Helper function to send an HTTP response on a connection
+static void send_response(connection_t *conn, const char *status, const char *content_type,
+                          const char *body) {
+    char head[256];
+    size_t body_len = strlen(body);
+
+    int head_len = snprintf(head, sizeof(head),
+                            "HTTP/1.1 %s\r\n"
+                            "Content-Type: %s\r\n"
+                            "Content-Length: %zu\r\n",
+                            status, content_type, body_len);
+    send_parts(conn, head, (size_t)head_len, body, body_len);
+}
+
+// Re-render a cached status page if the latest reading has changed since it was built
+static void refresh_cache(cached_response_t *cache, const char *content_type,
+                          void (*generate)(const latest_reading_t *, char *, size_t)) {
+    if (cache->valid && cache->version == latest_reading_version()) {
+        return;
+    }
+    latest_reading_t latest;
+    cache->version = latest_reading_read(&latest);
+    generate(&latest, cache->body, sizeof(cache->body));
+    cache->body_len = strlen(cache->body);
+    // The reading version changes exactly when the body does
+    snprintf(cache->etag, sizeof(cache->etag), "\"%s-%lu\"", etag_boot, cache->version);
+    cache->head_len = (size_t)snprintf(cache->head, sizeof(cache->head),
+                                       "HTTP/1.1 200 OK\r\n"
+                                       "Content-Type: %s\r\n"
+                                       "Content-Length: %zu\r\n"
+                                       "ETag: %s\r\n",
+                                       content_type, cache->body_len, cache->etag);
+    cache->not_modified_len = (size_t)snprintf(cache->not_modified, sizeof(cache->not_modified),
+                                               "HTTP/1.1 304 Not Modified\r\n"
+                                               "ETag: %s\r\n",
+                                               cache->etag);
+    cache->valid = 1;
+}
+
+// Serve a status page from its cache, or a bodyless 304 if the client's
+// If-None-Match (may be "") names the current version
+static void send_cached(connection_t *conn, cached_response_t *cache, const char *content_type,
+                        void (*generate)(const latest_reading_t *, char *, size_t),
+                        const char *if_none_match) {
+    refresh_cache(cache, content_type, generate);
+    if (if_none_match[0] && etag_matches(if_none_match, cache->etag)) {
+        send_parts(conn, cache->not_modified, cache->not_modified_len, NULL, 0);
+    } else {
+        send_parts(conn, cache->head, cache->head_len, cache->body, cache->body_len);
+    }
+}
+
+// Bring the shared stream event up to date: the /json body as an SSE event
+// whose id is the reading version. Returns 0 if there is no reading yet.
+static int refresh_stream_event(void) {
+    refresh_cache(&json_cache, "application/json", generate_json_response);
+    if (json_cache.version == 0) {
+        return 0;
+    }
+    if (!stream_event.valid || stream_event.version != json_cache.version) {
+        stream_event.len = (size_t)snprintf(stream_event.data, sizeof(stream_event.data),
+                                            "id: %lu\nevent: reading\ndata: %s\n\n",
+                                            json_cache.version, json_cache.body);
+        stream_event.version = json_cache.version;
+        stream_event.valid = 1;
+    }
+    return 1;
+}
+
+// Only ask the processor for notifications while a stream subscriber or
+// long-poll is listening. Call watch before counting a listener, unwatch after.
+static void watch_updates(void) {
+    if (stream_subscribers + long_polls == 0) {
+        latest_reading_set_notify_fd(update_fd);
+    }
+}
+
+static void unwatch_updates(void) {
+    if (stream_subscribers + long_polls == 0) {
+        latest_reading_set_notify_fd(-1);
+    }
+}
+
+// Turn a connection into an /api/stream subscriber
+static void start_stream(connection_t *conn) {
+    conn->streaming = 1;
+    conn->close_after_write = 0;
+    watch_updates();
+    stream_subscribers++;
+    count_response(ROUTE_STREAM, 200);
+
+    struct iovec iov[2] = { { (void *)stream_headers, sizeof(stream_headers) - 1 }, { NULL, 0 } };
+    int count = 1;
+    if (refresh_stream_event()) {
+        iov[1].iov_base = stream_event.data;
+        iov[1].iov_len = stream_event.len;
+        conn->stream_version = stream_event.version;
+        count = 2;
+    }
+    send_iov(conn, iov, count);
+}
+
+static void process_input(connection_t *conn);
+
+// Answer a parked long-poll with the current /json, or a 304 if the client
+// already holds it, then carry on with any requests pipelined behind it
+static void finish_long_poll(connection_t *conn) {
+    conn->waiting = 0;
+    long_polls--;
+    unwatch_updates();
+
+    refresh_cache(&json_cache, "application/json", generate_json_response);
+    if (conn->wait_not_modified && json_cache.version == conn->wait_version) {
+        send_parts(conn, json_cache.not_modified, json_cache.not_modified_len, NULL, 0);
+    } else {
+        send_parts(conn, json_cache.head, json_cache.head_len, json_cache.body, json_cache.body_len);
+    }
+    process_input(conn);
+}
+
+// /json?wait=<ms>: if the client is up to date (its If-None-Match names the
+// current reading, or it sent none), hold the response until a newer reading
+// is published or wait_ms passes. A client with an older ETag is answered at once.
+static void start_long_poll(connection_t *conn, const http_request_t *req, long long wait_ms) {
+    refresh_cache(&json_cache, "application/json", generate_json_response);
+    int has_current = req->if_none_match[0] && etag_matches(req->if_none_match, json_cache.etag);
+    if (req->if_none_match[0] && !has_current) {
+        send_parts(conn, json_cache.head, json_cache.head_len, json_cache.body, json_cache.body_len);
+        return;
+    }
+
+    conn->waiting = 1;
+    conn->wait_version = json_cache.version;
+    conn->wait_deadline_ms = now_ms() + (wait_ms < LONG_POLL_MAX_MS ? wait_ms : LONG_POLL_MAX_MS);
+    conn->wait_not_modified = has_current;
+    watch_updates();
+    if (long_polls++ == 0 || conn->wait_deadline_ms < long_poll_deadline) {
+        long_poll_deadline = conn->wait_deadline_ms;
+    }
+
+    // A reading published before notifications were enabled sends no signal
+    if (latest_reading_version() != conn->wait_version) {
+        finish_long_poll(conn);
+    }
+}
+
+// Route one complete request head and queue the response
+static void handle_request(connection_t *conn, const char *head) {
+    // Parse HTTP request
+    http_request_t req;
+    parse_http_request(head, &req);
+    const char *path = req.path;
+
+    char response_body[BUFFER_SIZE];
+
+    // Route based on method and path
+    conn->route = ROUTE_OTHER;
+    if (strcmp(req.method, "GET") == 0) {
+        if (!req.keep_alive) {
+            conn->close_after_write = 1;
+        }
+
+        if (strcmp(path, "/") == 0 || strcmp(path, "/index.html") == 0) {
+            // HTML status page
+            conn->route = ROUTE_INDEX;
+            send_cached(conn, &html_cache, "text/html; charset=utf-8", generate_html_response,
+                        req.if_none_match);
+        } else if (strcmp(path, "/json") == 0 || strcmp(path, "/api/status") == 0) {
+            // JSON API, optionally long-polling for the next reading
+            conn->route = ROUTE_JSON;
+            long long wait_ms = 0;
+            if (get_query_long(req.query, "wait", &wait_ms) != 0 || wait_ms < 0) {
+                send_response(conn, "400 Bad Request", "application/json",
+                              "{\"status\":\"error\",\"message\":\"wait must be a number of milliseconds\"}");
+            } else if (wait_ms > 0) {
+                start_long_poll(conn, &req, wait_ms);
+            } else {
+                send_cached(conn, &json_cache, "application/json", generate_json_response,
+                            req.if_none_match);
+            }
+        } else if (strcmp(path, "/api/stream") == 0) {
+            // Server-Sent Events: one event per processed reading
+            start_stream(conn);
+        } else if (strcmp(path, "/api/history") == 0) {
+            // Sensor history from memory
+            conn->route = ROUTE_HISTORY;
+            const char *status;
+            char *body = generate_history_response(req.query, &status);
+            send_response(conn, status, "application/json", body ? body : "{}");
+            free(body);
+        } else if (strcmp(path, "/api/stats") == 0) {
+            // Range statistics over the raw history
+            conn->route = ROUTE_STATS;
+            const char *status = generate_stats_response(req.query, response_body,
+                                                         sizeof(response_body));
+            send_response(conn, status, "application/json", response_body);
+        } else if (strcmp(path, "/api/quantiles") == 0) {
+            // Streaming quantiles over the last minute, hour and day
+            conn->route = ROUTE_QUANTILES;
+            const char *status = generate_quantiles_response(req.query, response_body,
+                                                             sizeof(response_body));
+            send_response(conn, status, "application/json", response_body);
+        } else if (strcmp(path, "/api/alerts") == 0) {
+            // Alert rules firing now and recent transitions
+            conn->route = ROUTE_ALERTS;
+            char *body = generate_alerts_response();
+            if (body) {
+                send_response(conn, "200 OK", "application/json", body);
+            } else {
+                send_response(conn, "500 Internal Server Error", "application/json",
+                              "{\"status\":\"error\",\"message\":\"out of memory\"}");
+            }
+            free(body);
+        } else if (strcmp(path, "/api/latency") == 0) {
+            // Pipeline latency percentiles
+            conn->route = ROUTE_LATENCY;
+            generate_latency_response(response_body, sizeof(response_body));
+            send_response(conn, "200 OK", "application/json", response_body);
+        } else if (strcmp(path, "/metrics") == 0) {
+            // Pipeline counters in Prometheus text format
+            conn->route = ROUTE_METRICS;
+            char *body = generate_metrics_response();
+            if (body) {
+                send_response(conn, "200 OK", "text/plain; version=0.0.4", body);
+            } else {
+                send_response(conn, "500 Internal Server Error", "text/plain", "Out of memory\n");
+            }
+            free(body);
+        } else {
+            // 404 Not Found - HTML escape the path to prevent XSS
+            char escaped_path[512];
+            html_escape(path, escaped_path, sizeof(escaped_path));
+
+            snprintf(response_body, sizeof(response_body),
+                     "<!DOCTYPE html><html><head><title>404 Not Found</title></head>"
+                     "<body><h1>404 Not Found</h1><p>The requested path '%s' was not found.</p>"
+                     "<p><a href='/'>Go to homepage</a></p></body></html>",
+                     escaped_path);
+            send_response(conn, "404 Not Found", "text/html; charset=utf-8", response_body);
+        }
+    } else {
+        // 405 Method Not Allowed; any request body is not read, so close afterwards
+        conn->close_after_write = 1;
+        snprintf(response_body, sizeof(response_body),
+                 "<!DOCTYPE html><html><head><title>405 Method Not Allowed</title></head>"
+                 "<body><h1>405 Method Not Allowed</h1><p>Only GET requests are supported.</p></body></html>");
+        send_response(conn, "405 Method Not Allowed", "text/html; charset=utf-8", response_body);
+    }
+}
+
+// Length of the request head (through the blank line) at the start of buf, or 0 if incomplete
+static size_t find_head_end(const char *buf, size_t len) {
+    for (size_t i = 3; i < len; i++) {
+        if (buf[i] == '\n' && buf[i - 1] == '\r' && buf[i - 2] == '\n' && buf[i - 3] == '\r') {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// Handle every complete request buffered on the connection (pipelined requests
+// are answered in order)
+static void process_input(connection_t *conn) {
+    char head[REQUEST_MAX + 1];
+    while (!conn->close_after_write) {
+        if (conn->streaming) {
+            // Subscribers only listen; anything they send is discarded
+            conn->in_len = 0;
+            return;
+        }
+        if (conn->waiting) {
+            // Later requests wait for the long-poll's response
+            return;
+        }
+        if (conn->out_len - conn->out_sent > OUTPUT_MAX) {
+            // The client is not reading its responses: stop answering until it does
+            conn->input_held = 1;
+            return;
+        }
+        size_t head_len = find_head_end(conn->in, conn->in_len);
+        if (head_len == 0) {
+            if (conn->in_len == sizeof(conn->in)) {
+                conn->route = ROUTE_OTHER;
+                conn->close_after_write = 1;
+                send_response(conn, "431 Request Header Fields Too Large", "text/plain",
+                              "Request header too large\n");
+            }
+            return;
+        }
+        memcpy(head, conn->in, head_len);
+        head[head_len] = '\0';
+        conn->in_len -= head_len;
+        memmove(conn->in, conn->in + head_len, conn->in_len);
+        // After a half-close, the last complete request ends the connection
+        if (conn->peer_closed && find_head_end(conn->in, conn->in_len) == 0) {
+            conn->close_after_write = 1;
+        }
+        handle_request(conn, head);
+    }
+}
+
+// Write as much queued output as the socket takes, answering requests held
+// back by a full output buffer as it drains. Returns -1 if the connection
+// should be closed.
+static int flush_output(int epoll_fd, connection_t *conn) {
+    for (;;) {
+        while (conn->out_sent < conn->out_len) {
+            ssize_t sent = send(conn->fd, conn->out + conn->out_sent,
+                                conn->out_len - conn->out_sent, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return -1;
+            }
+            conn->out_sent += (size_t)sent;
+        }
+        if (conn->out_sent == conn->out_len) {
+            conn->out_len = conn->out_sent = 0;
+        }
+        if (!conn->input_held || conn->out_len - conn->out_sent > OUTPUT_MAX) {
+            break;
+        }
+        conn->input_held = 0;
+        process_input(conn);
+    }
+
+    int pending = conn->out_len > 0;
+    if (!pending) {
+        if ((conn->close_after_write || conn->peer_closed) && !conn->waiting) {
+            return -1;
+        }
+    }
+    // Only ask for EPOLLOUT while output is waiting, and stop reading at end of
+    // input or while requests are held back
+    int reading = !conn->peer_closed && !conn->input_held;
+    uint32_t events = (reading ? EPOLLIN : 0) | (pending ? EPOLLOUT : 0);
+    if (events != conn->events) {
+        struct epoll_event ev = { .events = events, .data.ptr = conn };
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+        conn->events = events;
+    }
+    return 0;
+}
+
+// Read what the client has sent. Returns -1 if the connection should be closed.
+// A client that shuts down its side still gets answers to the requests it sent;
+// flush_output closes the connection once they are written.
+static int handle_readable(connection_t *conn) {
+    while (conn->in_len < sizeof(conn->in)) {
+        ssize_t n = recv(conn->fd, conn->in + conn->in_len, sizeof(conn->in) - conn->in_len, 0);
+        if (n > 0) {
+            conn->in_len += (size_t)n;
+        } else if (n == 0) {
+            conn->peer_closed = 1;
+            break;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else {
+            return -1;
+        }
+    }
+    process_input(conn);
+    if (conn->waiting && conn->in_len == sizeof(conn->in)) {
+        return -1;  // Pipelined past a long-poll until the buffer filled
+    }
+    if (conn->peer_closed && conn->streaming) {
+        return -1;  // Subscribers that hang up are gone
+    }
+    return 0;
+}
+
+static void close_connection(int epoll_fd, connection_t *conn) {
+    if (conn->streaming) {
+        stream_subscribers--;
+        unwatch_updates();
+    }
+    if (conn->waiting) {
+        long_polls--;
+        unwatch_updates();
+    }
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+    if (conn->prev) conn->prev->next = conn->next;
+    else connections = conn->next;
+    if (conn->next) conn->next->prev = conn->prev;
+    connection_count--;
+    free(conn->out);
+    free(conn);
+}
+
+// Accept every pending connection
+static void accept_connections(int epoll_fd, int server_fd) {
+    while (1) {
+        int fd = accept(server_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("[Network] Accept failed");
+            }
+            return;
+        }
+
+        if (connection_count >= g_config.network_max_connections) {
+            static const char busy[] = "HTTP/1.1 503 Service Unavailable\r\n"
+                                       "Content-Length: 0\r\nConnection: close\r\n\r\n";
+            send(fd, busy, sizeof(busy) - 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+            count_response(ROUTE_OTHER, 503);
+            close(fd);
+            continue;
+        }
+
+        connection_t *conn = calloc(1, sizeof(*conn));
+        int one = 1;
+        if (!conn || set_nonblocking(fd) != 0) {
+            fprintf(stderr, "[Network] Failed to set up connection\n");
+            free(conn);
+            close(fd);
+            continue;
+        }
+        // Responses are written in one piece; don't let Nagle hold them back
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        conn->fd = fd;
+        conn->last_active_ms = now_ms();
+        conn->events = EPOLLIN;
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = conn };
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            perror("[Network] epoll_ctl");
+            free(conn);
+            close(fd);
+            continue;
+        }
+        conn->next = connections;
+        if (connections) connections->prev = conn;
+        connections = conn;
+        connection_count++;
+    }
+}
+
+// Close connections that have been idle longer than the configured timeout.
+// Long-polls end at their own deadline. Stream subscribers are not timed out;
+// they get a comment line instead so dead clients are noticed when the write fails.
+static void close_idle_connections(int epoll_fd, long long now) {
+    static const char ping[] = ": ping\n\n";
+    connection_t *conn = connections;
+    while (conn) {
+        connection_t *next = conn->next;
+        if (conn->streaming) {
+            if (now - conn->last_active_ms >= STREAM_PING_MS && conn->out_len == 0) {
+                struct iovec iov = { (void *)ping, sizeof(ping) - 1 };
+                send_iov(conn, &iov, 1);
+                conn->last_active_ms = now;
+                if (flush_output(epoll_fd, conn) != 0) {
+                    close_connection(epoll_fd, conn);
+                }
+            }
+        } else if (!conn->waiting && now - conn->last_active_ms >= g_config.network_idle_timeout_ms) {
+            close_connection(epoll_fd, conn);
+        }
+        conn = next;
+    }
+}
+
+// Push the latest reading to every stream subscriber. The event is serialized
+// once; subscribers that still have unsent output (their socket buffer is
+// full) skip it rather than queueing, and catch up with a later event.
+static void broadcast_update(int epoll_fd, long long now) {
+    if (stream_subscribers == 0 || !refresh_stream_event()) {
+        return;
+    }
+    unsigned long version = stream_event.version;
+
+    connection_t *conn = connections;
+    while (conn) {
+        connection_t *next = conn->next;
+        if (conn->streaming && conn->stream_version != version) {
+            if (conn->out_len > 0) {
+                stream_dropped++;
+            } else {
+                struct iovec iov = { stream_event.data, stream_event.len };
+                send_iov(conn, &iov, 1);
+                conn->stream_version = version;
+                conn->last_active_ms = now;
+                if (flush_output(epoll_fd, conn) != 0) {
+                    close_connection(epoll_fd, conn);
+                }
+            }
+        }
+        conn = next;
+    }
+}
+
+// Answer long-polls whose reading has been replaced or whose deadline has
+// passed, and recompute the earliest remaining deadline
+static void service_long_polls(int epoll_fd, long long now) {
+    unsigned long version = latest_reading_version();
+    connection_t *conn = connections;
+    while (conn) {
+        connection_t *next = conn->next;
+        if (conn->waiting && (conn->wait_version != version || now >= conn->wait_deadline_ms)) {
+            finish_long_poll(conn);
+            conn->last_active_ms = now;
+            if (flush_output(epoll_fd, conn) != 0) {
+                close_connection(epoll_fd, conn);
+                conn = next;
+                continue;
+            }
+        }
+        // Still (or again, for a pipelined request) waiting
+        if (conn->waiting && conn->wait_deadline_ms < long_poll_deadline) {
+            long_poll_deadline = conn->wait_deadline_ms;
+        }
+        conn = next;
+    }
+}
 
-    pthread_mutex_unlock(&latest_mutex);
+void network_wakeup(void) {
+    // Only write(2) here: this is called from the SIGINT handler
+    int fd = wakeup_fd;
+    if (fd >= 0) {
+        uint64_t one = 1;
+        ssize_t n = write(fd, &one, sizeof(one));
+        (void)n;
+    }
 }
 
-// The network thread listens on a TCP port and serves HTTP responses
+// The network thread serves HTTP on a TCP port from a single epoll event loop.
+// Sockets are non-blocking and connections stay open between requests
+// (HTTP/1.1 keep-alive) until the client closes them or they sit idle for
+// [network] idle_timeout_ms, so a slow client never holds up the others.
 void *network_thread(void *arg) {
     (void)arg;
-    int server_fd, new_socket;
+    int server_fd;
     struct sockaddr_in address;
     int opt = 1;
-    int addrlen = sizeof(address);
-    char buffer[BUFFER_SIZE];
 
     // Create socket file descriptor
-    if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
+    if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
         perror("[Network] Socket creation failed");
         return NULL;
     }
@@ -245,6 +1440,7 @@ void *network_thread(void *arg) {
         return NULL;
     }
 
+    memset(&address, 0, sizeof(address));
     address.sin_family = AF_INET;
     address.sin_addr.s_addr = INADDR_ANY;
     address.sin_port = htons(g_config.network_port);
@@ -256,73 +1452,122 @@ void *network_thread(void *arg) {
         return NULL;
     }
 
-    if (listen(server_fd, g_config.network_backlog) < 0) {
+    if (listen(server_fd, g_config.network_backlog) < 0 || set_nonblocking(server_fd) != 0) {
         perror("[Network] Listen failed");
         close(server_fd);
         return NULL;
     }
 
+    int epoll_fd = epoll_create1(0);
+    int event_fd = eventfd(0, EFD_NONBLOCK);
+    update_fd = eventfd(0, EFD_NONBLOCK);
+    if (epoll_fd < 0 || event_fd < 0 || update_fd < 0) {
+        perror("[Network] Event loop setup failed");
+        if (epoll_fd >= 0) close(epoll_fd);
+        if (event_fd >= 0) close(event_fd);
+        if (update_fd >= 0) close(update_fd);
+        update_fd = -1;
+        close(server_fd);
+        return NULL;
+    }
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, server_fd, &ev);
+    ev.data.ptr = &wakeup_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, event_fd, &ev);
+    ev.data.ptr = &update_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, update_fd, &ev);
+    wakeup_fd = event_fd;
+
+    struct timespec boot;
+    clock_gettime(CLOCK_REALTIME, &boot);
+    snprintf(etag_boot, sizeof(etag_boot), "%llx",
+             (unsigned long long)boot.tv_sec * 1000000000ULL + (unsigned long long)boot.tv_nsec);
+
     printf("[Network] Server listening on port %d\n", g_config.network_port);
 
+    struct epoll_event events[EPOLL_BATCH];
+    long long last_sweep = now_ms();
     while (!should_exit()) {
-        new_socket = accept(server_fd, (struct sockaddr *)&address, (socklen_t*)&addrlen);
-
-        if (new_socket < 0) {
-            if (should_exit()) break;
-            perror("[Network] Accept failed");
-            continue;
+        // The timeout bounds how late idle connections and long-poll deadlines are noticed
+        int timeout = SWEEP_INTERVAL_MS;
+        if (long_polls > 0) {
+            long long until = long_poll_deadline - now_ms();
+            if (until < timeout) timeout = until > 0 ? (int)until : 0;
         }
-
-        // Read HTTP request
-        memset(buffer, 0, BUFFER_SIZE);
-        ssize_t bytes_read = read(new_socket, buffer, BUFFER_SIZE - 1);
-
-        if (bytes_read < 0) {
-            perror("[Network] Read failed");
-            close(new_socket);
-            continue;
+        int n = epoll_wait(epoll_fd, events, EPOLL_BATCH, timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("[Network] epoll_wait failed");
+            break;
         }
 
-        // Parse HTTP request
-        char method[16] = {0};
-        char path[256] = {0};
-        parse_http_request(buffer, method, path);
-
-        char response_body[BUFFER_SIZE];
+        long long now = now_ms();
+        int update_ready = 0;
+        for (int i = 0; i < n; i++) {
+            void *ptr = events[i].data.ptr;
+            if (ptr == NULL) {
+                accept_connections(epoll_fd, server_fd);
+                continue;
+            }
+            if (ptr == &wakeup_fd) {
+                uint64_t count;
+                ssize_t r = read(event_fd, &count, sizeof(count));
+                (void)r;
+                continue;
+            }
+            if (ptr == &update_fd) {
+                uint64_t count;
+                ssize_t r = read(update_fd, &count, sizeof(count));
+                (void)r;
+                update_ready = 1;
+                continue;
+            }
 
-        // Route based on method and path
-        if (strcmp(method, "GET") == 0) {
-            if (strcmp(path, "/") == 0 || strcmp(path, "/index.html") == 0) {
-                // HTML status page
-                generate_html_response(response_body, sizeof(response_body));
-                send_response(new_socket, "200 OK", "text/html; charset=utf-8", response_body);
-            } else if (strcmp(path, "/json") == 0 || strcmp(path, "/api/status") == 0) {
-                // JSON API
-                generate_json_response(response_body, sizeof(response_body));
-                send_response(new_socket, "200 OK", "application/json", response_body);
-            } else {
-                // 404 Not Found - HTML escape the path to prevent XSS
-                char escaped_path[512];
-                html_escape(path, escaped_path, sizeof(escaped_path));
-
-                snprintf(response_body, sizeof(response_body),
-                         "<!DOCTYPE html><html><head><title>404 Not Found</title></head>"
-                         "<body><h1>404 Not Found</h1><p>The requested path '%s' was not found.</p>"
-                         "<p><a href='/'>Go to homepage</a></p></body></html>",
-                         escaped_path);
-                send_response(new_socket, "404 Not Found", "text/html; charset=utf-8", response_body);
+            connection_t *conn = ptr;
+            conn->last_active_ms = now;
+            int rc = 0;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                rc = -1;
+            }
+            if (rc == 0 && (events[i].events & EPOLLIN)) {
+                rc = handle_readable(conn);
+            }
+            if (rc == 0) {
+                rc = flush_output(epoll_fd, conn);
+            }
+            if (rc != 0) {
+                close_connection(epoll_fd, conn);
             }
-        } else {
-            // 405 Method Not Allowed
-            snprintf(response_body, sizeof(response_body),
-                     "<!DOCTYPE html><html><head><title>405 Method Not Allowed</title></head>"
-                     "<body><h1>405 Method Not Allowed</h1><p>Only GET requests are supported.</p></body></html>");
-            send_response(new_socket, "405 Method Not Allowed", "text/html; charset=utf-8", response_body);
         }
 
-        close(new_socket);
+        // Fan out after the batch, since it may close connections that
+        // later events in the batch refer to
+        if (update_ready) {
+            latest_reading_notify_ack();
+            broadcast_update(epoll_fd, now);
+        }
+        if (long_polls > 0 && (update_ready || now >= long_poll_deadline)) {
+            long_poll_deadline = LLONG_MAX;
+            service_long_polls(epoll_fd, now);
+        }
+
+        if (now - last_sweep >= SWEEP_INTERVAL_MS) {
+            close_idle_connections(epoll_fd, now);
+            last_sweep = now;
+        }
     }
 
+    wakeup_fd = -1;
+    while (connections) {
+        close_connection(epoll_fd, connections);
+    }
+    if (stream_dropped > 0) {
+        printf("[Network] Stream events skipped for slow subscribers: %lu\n", stream_dropped);
+    }
+    close(update_fd);
+    update_fd = -1;
+    close(event_fd);
+    close(epoll_fd);
     close(server_fd);
     printf("[Network] Server shut down\n");
     return NULL;
@@ -4,4 +4,8 @@
 // Thread function for the network interface (HTTP server)
 void *network_thread(void *arg);
 
+// Interrupt the network thread's event loop so it notices shutdown promptly.
+// Async-signal-safe.
+void network_wakeup(void);
+
 #endif // NETWORK_H
\ No newline at end of file
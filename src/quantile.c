@@ -0,0 +1,506 @@
+#include "quantile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#define TDIGEST_POINTS (TDIGEST_CENTROIDS + TDIGEST_BUFFER)
+#define TDIGEST_PI 3.14159265358979323846
+
+// ---------------------------------------------------------------------------
+// t-digest
+// ---------------------------------------------------------------------------
+
+void tdigest_init(tdigest_t *t) {
+    t->count = 0;
+    t->buffered = 0;
+    t->total = 0;
+    t->min = t->max = 0;
+}
+
+// Insertion sort by mean. The buffer is small, and what is merged in from
+// other digests arrives mostly in order.
+static void sort_points(tdigest_centroid_t *p, int n) {
+    for (int i = 1; i < n; i++) {
+        tdigest_centroid_t x = p[i];
+        int j = i;
+        while (j > 0 && p[j - 1].mean > x.mean) {
+            p[j] = p[j - 1];
+            j--;
+        }
+        p[j] = x;
+    }
+}
+
+// Map a float to a key whose unsigned order is the float order, and back
+static uint32_t float_key(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return (u & 0x80000000u) ? ~u : u | 0x80000000u;
+}
+
+static float key_float(uint32_t k) {
+    uint32_t u = (k & 0x80000000u) ? k & 0x7FFFFFFFu : ~k;
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// Below this many keys an insertion sort beats clearing radix histograms
+#define RADIX_MIN 32
+
+// LSD radix sort, a byte per pass. Temperatures share their upper bytes, so
+// passes where every key has the same byte are skipped.
+static void radix_sort(uint32_t *keys, uint32_t *tmp, int n) {
+    if (n < RADIX_MIN) {
+        for (int i = 1; i < n; i++) {
+            uint32_t x = keys[i];
+            int j = i;
+            while (j > 0 && keys[j - 1] > x) {
+                keys[j] = keys[j - 1];
+                j--;
+            }
+            keys[j] = x;
+        }
+        return;
+    }
+    uint32_t *src = keys, *dst = tmp;
+    for (int shift = 0; shift < 32; shift += 8) {
+        int counts[256] = { 0 };
+        for (int i = 0; i < n; i++) {
+            counts[(src[i] >> shift) & 0xFF]++;
+        }
+        if (counts[(src[0] >> shift) & 0xFF] == n) {
+            continue;
+        }
+        for (int b = 0, pos = 0; b < 256; b++) {
+            int c = counts[b];
+            counts[b] = pos;
+            pos += c;
+        }
+        for (int i = 0; i < n; i++) {
+            dst[counts[(src[i] >> shift) & 0xFF]++] = src[i];
+        }
+        uint32_t *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != keys) {
+        memcpy(keys, src, sizeof(*keys) * (size_t)n);
+    }
+}
+
+// Scale function k1, k(q) = d / (2 pi) * asin(2q - 1): a centroid may span one
+// unit of k, which is a small range of q near 0 and 1 and a large one around
+// the median. Returns the q one unit of k above q0, using
+// sin(a + b) = sin a cos b + cos a sin b with a = asin(2 q0 - 1), so the merge
+// loop needs a square root instead of two trig calls per centroid.
+static double next_limit(double q0, double cos_b, double sin_b) {
+    double s = 2 * q0 - 1;
+    if (s >= cos_b) {
+        return 1;
+    }
+    return (s * cos_b + sqrt(1 - s * s) * sin_b + 1) / 2;
+}
+
+// Replace the centroids with sorted[0..n), greedily merging neighbours while
+// a merged centroid stays within one unit of k from where it starts. t->total
+// must already count everything in sorted.
+static void rebuild(tdigest_t *t, const tdigest_centroid_t *sorted, int n) {
+    const double cos_b = cos(2 * TDIGEST_PI / TDIGEST_COMPRESSION);
+    const double sin_b = sin(2 * TDIGEST_PI / TDIGEST_COMPRESSION);
+    double total = (double)t->total;
+    double q0 = 0, room = next_limit(0, cos_b, sin_b) * total;   // Weight that still fits
+    double sum = 0, weight = 0;     // Of the centroid being built
+    int out = 0;
+    for (int i = 0; i < n; i++) {
+        double w = sorted[i].weight;
+        if (weight == 0 || weight + w <= room || out == TDIGEST_CENTROIDS - 1) {
+            weight += w;
+            sum += (double)sorted[i].mean * w;
+        } else {
+            t->points[out++] = (tdigest_centroid_t){ (float)(sum / weight), (uint32_t)weight };
+            q0 += weight / total;
+            room = (next_limit(q0, cos_b, sin_b) - q0) * total;
+            sum = (double)sorted[i].mean * w;
+            weight = w;
+        }
+    }
+    t->points[out++] = (tdigest_centroid_t){ (float)(sum / weight), (uint32_t)weight };
+    t->count = out;
+    t->buffered = 0;
+}
+
+void tdigest_compress(tdigest_t *t) {
+    if (t->buffered == 0) {
+        return;
+    }
+
+    // The centroids are sorted already; sort the buffer and merge the two runs
+    tdigest_centroid_t *buf = &t->points[t->count];
+    sort_points(buf, t->buffered);
+    tdigest_centroid_t sorted[TDIGEST_POINTS];
+    int n = t->count + t->buffered;
+    for (int i = 0, a = 0, b = 0; i < n; i++) {
+        if (b == t->buffered || (a < t->count && t->points[a].mean <= buf[b].mean)) {
+            sorted[i] = t->points[a++];
+        } else {
+            sorted[i] = buf[b++];
+        }
+    }
+    rebuild(t, sorted, n);
+}
+
+void tdigest_add_batch(tdigest_t *t, const float *values, int n) {
+    while (n > 0) {
+        int chunk = n < TDIGEST_BATCH ? n : TDIGEST_BATCH;
+        uint32_t keys[TDIGEST_BATCH], tmp[TDIGEST_BATCH];
+        for (int i = 0; i < chunk; i++) {
+            keys[i] = float_key(values[i]);
+        }
+        radix_sort(keys, tmp, chunk);
+
+        tdigest_compress(t);
+        float lo = key_float(keys[0]), hi = key_float(keys[chunk - 1]);
+        if (t->total == 0 || lo < t->min) t->min = lo;
+        if (t->total == 0 || hi > t->max) t->max = hi;
+        t->total += (uint64_t)chunk;
+
+        tdigest_centroid_t sorted[TDIGEST_CENTROIDS + TDIGEST_BATCH];
+        int total = t->count + chunk;
+        for (int i = 0, a = 0, b = 0; i < total; i++) {
+            float v = b < chunk ? key_float(keys[b]) : 0;
+            if (b == chunk || (a < t->count && t->points[a].mean <= v)) {
+                sorted[i] = t->points[a++];
+            } else {
+                sorted[i] = (tdigest_centroid_t){ v, 1 };
+                b++;
+            }
+        }
+        rebuild(t, sorted, total);
+
+        values += chunk;
+        n -= chunk;
+    }
+}
+
+void tdigest_add(tdigest_t *t, float value, uint32_t weight) {
+    if (weight == 0) {
+        return;
+    }
+    if (t->total == 0) {
+        t->min = t->max = value;
+    } else {
+        if (value < t->min) t->min = value;
+        if (value > t->max) t->max = value;
+    }
+    if (t->count + t->buffered == TDIGEST_POINTS) {
+        tdigest_compress(t);
+    }
+    t->points[t->count + t->buffered] = (tdigest_centroid_t){ value, weight };
+    t->buffered++;
+    t->total += weight;
+}
+
+void tdigest_merge(tdigest_t *dst, const tdigest_t *src) {
+    if (src->total == 0) {
+        return;
+    }
+    tdigest_t in = *src;
+    tdigest_compress(&in);
+    tdigest_compress(dst);
+    if (dst->total == 0 || in.min < dst->min) dst->min = in.min;
+    if (dst->total == 0 || in.max > dst->max) dst->max = in.max;
+    dst->total += in.total;
+
+    // Both are sorted runs of centroids: merge them and rebuild once
+    tdigest_centroid_t sorted[2 * TDIGEST_CENTROIDS];
+    int n = dst->count + in.count;
+    for (int i = 0, a = 0, b = 0; i < n; i++) {
+        if (b == in.count || (a < dst->count && dst->points[a].mean <= in.points[b].mean)) {
+            sorted[i] = dst->points[a++];
+        } else {
+            sorted[i] = in.points[b++];
+        }
+    }
+    rebuild(dst, sorted, n);
+}
+
+double tdigest_quantile(tdigest_t *t, double q) {
+    if (t->total == 0) {
+        return NAN;
+    }
+    tdigest_compress(t);
+    if (q <= 0) {
+        return t->min;
+    }
+    if (q >= 1) {
+        return t->max;
+    }
+    const tdigest_centroid_t *c = t->points;
+    if (t->count == 1) {
+        return c[0].mean;
+    }
+
+    // Each centroid's mean sits at the middle of its weight; interpolate
+    // between neighbouring middles, and out to min/max at the ends
+    double index = q * (double)t->total;
+    double half = c[0].weight / 2.0;
+    if (index < half) {
+        return t->min + (c[0].mean - t->min) * index / half;
+    }
+    double cum = half;
+    for (int i = 0; i < t->count - 1; i++) {
+        double step = (c[i].weight + c[i + 1].weight) / 2.0;
+        if (index < cum + step) {
+            return c[i].mean + (c[i + 1].mean - c[i].mean) * (index - cum) / step;
+        }
+        cum += step;
+    }
+    const tdigest_centroid_t *last = &c[t->count - 1];
+    half = last->weight / 2.0;
+    double frac = (index - cum) / half;
+    return last->mean + (t->max - last->mean) * (frac < 1 ? frac : 1);
+}
+
+// ---------------------------------------------------------------------------
+// Per-sensor windows
+// ---------------------------------------------------------------------------
+
+// One pane: the digest of readings with start <= timestamp < start + seconds
+typedef struct {
+    time_t start;
+    tdigest_t digest;
+} pane_t;
+
+// Ring of panes for one window. The pane starting at t lives in slot
+// (t / seconds) % slots, as history rollups do. Readings go into the open
+// pane of the finest ring only; when a pane closes it is merged into the
+// open pane of the next ring, so each reading is added to one digest.
+typedef struct {
+    int seconds;
+    int slots;
+    pane_t *open;       // Newest pane, not yet merged into the next ring
+    pane_t *panes;
+} pane_ring_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pane_ring_t rings[QUANTILE_WIN_COUNT];
+    float batch[TDIGEST_BATCH];     // Readings for the open 5 s pane not yet in its digest
+    int batched;
+} sensor_quantiles_t;
+
+static const int pane_seconds[QUANTILE_WIN_COUNT] = { 5, 60, 3600 };
+static const int pane_slots[QUANTILE_WIN_COUNT] = { 12, 60, 24 };
+static const char *window_names[QUANTILE_WIN_COUNT] = { "1m", "1h", "24h" };
+
+static sensor_quantiles_t sensors[QUANTILE_MAX_SENSORS];
+static int quantile_sensors = 0;
+
+static void free_sensor(sensor_quantiles_t *s) {
+    for (int w = 0; w < QUANTILE_WIN_COUNT; w++) {
+        free(s->rings[w].panes);
+    }
+    memset(s, 0, sizeof(*s));
+}
+
+int quantile_init(int sensor_count) {
+    if (sensor_count < 1 || sensor_count > QUANTILE_MAX_SENSORS) {
+        fprintf(stderr, "[Quantile] Invalid sensor count\n");
+        return -1;
+    }
+    quantile_destroy();
+
+    for (int i = 0; i < sensor_count; i++) {
+        sensor_quantiles_t *s = &sensors[i];
+        int ok = 1;
+        for (int w = 0; w < QUANTILE_WIN_COUNT; w++) {
+            s->rings[w].seconds = pane_seconds[w];
+            s->rings[w].slots = pane_slots[w];
+            s->rings[w].panes = calloc((size_t)pane_slots[w], sizeof(pane_t));
+            ok = ok && s->rings[w].panes;
+        }
+        if (!ok) {
+            fprintf(stderr, "[Quantile] Allocation failure\n");
+            for (int j = 0; j <= i; j++) {
+                free_sensor(&sensors[j]);
+            }
+            return -1;
+        }
+        pthread_mutex_init(&s->mutex, NULL);
+    }
+    quantile_sensors = sensor_count;
+    return 0;
+}
+
+void quantile_destroy(void) {
+    for (int i = 0; i < quantile_sensors; i++) {
+        pthread_mutex_destroy(&sensors[i].mutex);
+        free_sensor(&sensors[i]);
+    }
+    quantile_sensors = 0;
+}
+
+static sensor_quantiles_t *get_sensor(int sensor_id) {
+    if (sensor_id < 1 || sensor_id > quantile_sensors) {
+        return NULL;
+    }
+    return &sensors[sensor_id - 1];
+}
+
+static time_t pane_start(time_t timestamp, int seconds) {
+    time_t rem = timestamp % seconds;
+    return timestamp - (rem < 0 ? rem + seconds : rem);
+}
+
+static pane_t *pane_slot(const pane_ring_t *ring, time_t start) {
+    long long index = (long long)(start / ring->seconds) % ring->slots;
+    if (index < 0) index += ring->slots;
+    return &ring->panes[index];
+}
+
+static void add_digest(sensor_quantiles_t *s, int ring, time_t timestamp, const tdigest_t *d);
+
+// Find the pane of ring that data from timestamp belongs in. A timestamp past
+// the open pane closes it (merging it into the next ring) and opens a new one.
+// An earlier one goes to its closed pane, or nowhere if the ring no longer
+// holds it; *closed is then set, as the data must also go to the next ring.
+static pane_t *pane_for(sensor_quantiles_t *s, int ring, time_t timestamp, int *closed) {
+    pane_ring_t *r = &s->rings[ring];
+    time_t start = pane_start(timestamp, r->seconds);
+    *closed = 0;
+    if (r->open && r->open->start == start) {
+        return r->open;
+    }
+    if (r->open && r->open->start > start) {
+        *closed = 1;
+        pane_t *pane = pane_slot(r, start);
+        return pane->start == start ? pane : NULL;
+    }
+
+    pane_t *done = r->open;
+    if (done && ring + 1 < QUANTILE_WIN_COUNT) {
+        add_digest(s, ring + 1, done->start, &done->digest);
+    }
+    pane_t *pane = pane_slot(r, start);
+    pane->start = start;
+    tdigest_init(&pane->digest);
+    r->open = pane;
+    return pane;
+}
+
+static void add_digest(sensor_quantiles_t *s, int ring, time_t timestamp, const tdigest_t *d) {
+    for (int closed = 1; closed && ring < QUANTILE_WIN_COUNT; ring++) {
+        pane_t *pane = pane_for(s, ring, timestamp, &closed);
+        if (pane) {
+            tdigest_merge(&pane->digest, d);
+        }
+    }
+}
+
+// Move the batched readings into the open 5 s pane
+static void flush_batch(sensor_quantiles_t *s) {
+    if (s->batched > 0) {
+        tdigest_add_batch(&s->rings[0].open->digest, s->batch, s->batched);
+        s->batched = 0;
+    }
+}
+
+void quantile_add(int sensor_id, time_t timestamp, float value) {
+    sensor_quantiles_t *s = get_sensor(sensor_id);
+    if (!s) {
+        return;
+    }
+
+    pthread_mutex_lock(&s->mutex);
+    const pane_ring_t *fine = &s->rings[0];
+    if (fine->open && fine->open->start == pane_start(timestamp, fine->seconds)) {
+        // The common case: batch it for the open pane
+        s->batch[s->batched++] = value;
+        if (s->batched == TDIGEST_BATCH) {
+            flush_batch(s);
+        }
+    } else {
+        // A new pane, or a late reading: the batch belongs in the open pane
+        // before it can close
+        flush_batch(s);
+        for (int ring = 0, closed = 1; closed && ring < QUANTILE_WIN_COUNT; ring++) {
+            pane_t *pane = pane_for(s, ring, timestamp, &closed);
+            if (pane) {
+                tdigest_add(&pane->digest, value, 1);
+            }
+        }
+    }
+    pthread_mutex_unlock(&s->mutex);
+}
+
+// Merge a pane of r (its open pane if slot < 0) into merged if it is in
+// [oldest, newest] at the window's resolution. Copied under the lock and
+// merged outside it, so the processor is never held up for a whole query.
+static void merge_pane(sensor_quantiles_t *s, const pane_ring_t *r, int slot, int seconds,
+                       time_t oldest, time_t newest, tdigest_t *merged) {
+    tdigest_t copy;
+    int in_window = 0;
+    pthread_mutex_lock(&s->mutex);
+    const pane_t *pane = slot < 0 ? r->open : &r->panes[slot];
+    if (pane && pane->digest.total > 0) {
+        time_t start = pane_start(pane->start, seconds);
+        in_window = start >= oldest && start <= newest;
+    }
+    if (in_window) {
+        copy = pane->digest;
+    }
+    pthread_mutex_unlock(&s->mutex);
+    if (in_window) {
+        tdigest_merge(merged, &copy);
+    }
+}
+
+long quantile_query(int sensor_id, quantile_window_t window, time_t now,
+                    const double *qs, int n, double *out) {
+    sensor_quantiles_t *s = get_sensor(sensor_id);
+    if (!s || window < 0 || window >= QUANTILE_WIN_COUNT) {
+        return -1;
+    }
+
+    // The window is the pane holding now and the slots - 1 before it, plus
+    // whatever the finer rings' open panes hold that has not been merged in
+    pthread_mutex_lock(&s->mutex);
+    flush_batch(s);
+    pthread_mutex_unlock(&s->mutex);
+
+    const pane_ring_t *ring = &s->rings[window];
+    time_t newest = pane_start(now, ring->seconds);
+    time_t oldest = newest - (time_t)(ring->slots - 1) * ring->seconds;
+    tdigest_t merged;
+    tdigest_init(&merged);
+    for (int i = 0; i < ring->slots; i++) {
+        merge_pane(s, ring, i, ring->seconds, oldest, newest, &merged);
+    }
+    for (int finer = 0; finer < (int)window; finer++) {
+        merge_pane(s, &s->rings[finer], -1, ring->seconds, oldest, newest, &merged);
+    }
+
+    for (int i = 0; i < n; i++) {
+        out[i] = tdigest_quantile(&merged, qs[i]);
+    }
+    return (long)merged.total;
+}
+
+int quantile_parse_window(const char *name) {
+    for (int w = 0; w < QUANTILE_WIN_COUNT; w++) {
+        if (strcmp(name, window_names[w]) == 0) {
+            return w;
+        }
+    }
+    return -1;
+}
+
+const char *quantile_window_name(quantile_window_t window) {
+    if (window < 0 || window >= QUANTILE_WIN_COUNT) {
+        return "unknown";
+    }
+    return window_names[window];
+}
@@ -0,0 +1,98 @@
+#ifndef QUANTILE_H
+#define QUANTILE_H
+
+#include <stdint.h>
+#include <time.h>
+#include "config.h"
+
+// Streaming quantiles per sensor.
+//
+// Each sensor keeps a ring of t-digest panes per window: 12 panes of 5 s for
+// the last minute, 60 panes of 1 min for the last hour and 24 panes of 1 h for
+// the last day. quantile_add batches readings for the current 5 s pane and
+// merges each batch in one pass, O(1) per reading amortized; a pane that
+// closes is merged into the current pane of the next window, and a query
+// merges the panes that make up the window. Memory is fixed at quantile_init,
+// about 70 KB per sensor.
+//
+// A t-digest keeps at most TDIGEST_CENTROIDS weighted centroids, small near
+// the tails and larger in the middle, so tail quantiles (p99) are more precise
+// than the median. Single values go to a small buffer that is sorted and
+// merged into the centroids when it fills; batches are radix-sorted and merged
+// directly.
+
+// Highest sensor id that can be tracked (ids start at 1)
+#define QUANTILE_MAX_SENSORS CONFIG_MAX_SENSORS
+
+// Most quantiles accepted by one query
+#define QUANTILE_QUERY_MAX 16
+
+#define TDIGEST_COMPRESSION 50
+#define TDIGEST_CENTROIDS (TDIGEST_COMPRESSION + 1)
+#define TDIGEST_BUFFER 32
+#define TDIGEST_BATCH 256
+
+typedef struct {
+    float mean;
+    uint32_t weight;
+} tdigest_centroid_t;
+
+typedef struct {
+    int count;          // Merged centroids, sorted by mean, at the start of points
+    int buffered;       // Unmerged points after them
+    uint64_t total;     // Weight of everything added
+    float min;
+    float max;
+    tdigest_centroid_t points[TDIGEST_CENTROIDS + TDIGEST_BUFFER];
+} tdigest_t;
+
+typedef enum {
+    QUANTILE_WIN_1M = 0,
+    QUANTILE_WIN_1H,
+    QUANTILE_WIN_24H,
+    QUANTILE_WIN_COUNT
+} quantile_window_t;
+
+// Empty a digest
+void tdigest_init(tdigest_t *t);
+
+// Add a value with the given weight
+void tdigest_add(tdigest_t *t, float value, uint32_t weight);
+
+// Add n values of weight 1 at once: radix-sorted and merged into the
+// centroids in one pass, O(1) per value amortized
+void tdigest_add_batch(tdigest_t *t, const float *values, int n);
+
+// Add everything in src to dst
+void tdigest_merge(tdigest_t *dst, const tdigest_t *src);
+
+// Merge the buffered points into the centroids
+void tdigest_compress(tdigest_t *t);
+
+// Estimate the q-quantile (0 <= q <= 1). Compresses first. NAN if empty.
+double tdigest_quantile(tdigest_t *t, double q);
+
+// Allocate quantile windows for sensors 1..sensor_count. Returns 0 on
+// success, -1 on failure.
+int quantile_init(int sensor_count);
+
+// Free all quantile memory
+void quantile_destroy(void);
+
+// Record a reading. Readings for unknown sensors, before quantile_init or
+// older than a window's ring are ignored (by that window).
+void quantile_add(int sensor_id, time_t timestamp, float value);
+
+// Estimate quantiles qs[0..n) of the sensor's readings in the window ending at
+// now, into out. Returns the number of readings the estimate is over (out is
+// NAN when it is 0), or -1 for an unknown sensor or window.
+long quantile_query(int sensor_id, quantile_window_t window, time_t now,
+                    const double *qs, int n, double *out);
+
+// Parse a window name ("1m", "1h", "24h"). Returns -1 if unknown.
+int quantile_parse_window(const char *name);
+
+// Name of a window, as accepted by quantile_parse_window
+const char *quantile_window_name(quantile_window_t window);
+
+#endif // QUANTILE_H
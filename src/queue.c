@@ -1,83 +1,277 @@
 #include "queue.h"
 #include "utils.h"  // For should_exit()
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <errno.h>
+#include <time.h>
 
-void queue_init(queue_t *q, int max_size) {
-    q->head = q->tail = NULL;
-    q->size = 0;
+int queue_init(queue_t *q, int max_size) {
     q->max_size = max_size;
+    q->capacity = max_size > 0 ? (size_t)max_size : QUEUE_DEFAULT_CAPACITY;
+
+    // Round the allocation up to whole cache lines so the ring never shares
+    // a line with unrelated heap data.
+    size_t bytes = q->capacity * sizeof(queue_cell_t);
+    bytes = (bytes + QUEUE_CACHE_LINE - 1) & ~(size_t)(QUEUE_CACHE_LINE - 1);
+    void *mem = NULL;
+    if (posix_memalign(&mem, QUEUE_CACHE_LINE, bytes) != 0) {
+        fprintf(stderr, "[Queue] Allocation failure (capacity=%zu)\n", q->capacity);
+        q->cells = NULL;
+        q->capacity = 0;
+        return -1;
+    }
+    q->cells = mem;
+    for (size_t i = 0; i < q->capacity; i++) {
+        atomic_init(&q->cells[i].seq, i);
+    }
+
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->head, 0);
+    atomic_init(&q->sleeping, 0);
+    atomic_init(&q->dropped, 0);
+    atomic_init(&q->high_water, 0);
     pthread_mutex_init(&q->mutex, NULL);
-    pthread_cond_init(&q->cond, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&q->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    return 0;
 }
 
 void queue_destroy(queue_t *q) {
-    // Free all nodes in the queue
-    node_t *current = q->head;
-    while (current) {
-        node_t *temp = current;
-        current = current->next;
-        free(temp);
-    }
+    free(q->cells);
+    q->cells = NULL;
+    q->capacity = 0;
     pthread_mutex_destroy(&q->mutex);
     pthread_cond_destroy(&q->cond);
 }
 
+// Wake the consumer if it is parked. The fence pairs with the one in
+// queue_wait so either the consumer sees the new item or we see it sleeping.
+static void queue_notify(queue_t *q) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&q->sleeping, memory_order_relaxed)) {
+        pthread_mutex_lock(&q->mutex);
+        pthread_cond_signal(&q->cond);
+        pthread_mutex_unlock(&q->mutex);
+    }
+}
+
 int queue_push(queue_t *q, sensor_reading_t item) {
-    node_t *new_node = malloc(sizeof(node_t));
-    if (!new_node) {
-        fprintf(stderr, "[Queue] Allocation failure\n");
-        return -1;
+    size_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    queue_cell_t *cell;
+
+    for (;;) {
+        cell = &q->cells[pos % q->capacity];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            // Slot is free for this lap; try to claim it
+            if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Slot still holds an unread item from the previous lap: ring is full
+            atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+            fprintf(stderr, "[Queue] Queue full (size=%d), dropping reading from sensor %d\n",
+                    queue_size(q), item.sensor_id);
+            return -1;
+        } else {
+            // Another producer claimed this slot first
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        }
     }
-    new_node->data = item;
-    new_node->next = NULL;
 
-    pthread_mutex_lock(&q->mutex);
+    cell->data = item;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    queue_notify(q);
+    return 0;
+}
 
-    // Check queue size limit
-    if (q->max_size > 0 && q->size >= q->max_size) {
-        pthread_mutex_unlock(&q->mutex);
-        free(new_node);
-        fprintf(stderr, "[Queue] Queue full (size=%d), dropping reading from sensor %d\n",
-                q->size, item.sensor_id);
-        return -1;
+int queue_push_batch(queue_t *q, const sensor_reading_t *items, int count) {
+    if (count <= 0) {
+        return 0;
+    }
+
+    size_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    size_t n;
+
+    for (;;) {
+        // The consumer releases slots in order before advancing head, so every
+        // position below head + capacity is free once claimed.
+        size_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+        if (head > pos) {
+            // Our tail snapshot is stale
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+            continue;
+        }
+        size_t used = pos - head;
+        size_t free_slots = used < q->capacity ? q->capacity - used : 0;
+        n = (size_t)count < free_slots ? (size_t)count : free_slots;
+        if (n == 0) {
+            atomic_fetch_add_explicit(&q->dropped, (unsigned long)count, memory_order_relaxed);
+            fprintf(stderr, "[Queue] Queue full (size=%d), dropping %d readings\n",
+                    queue_size(q), count);
+            return 0;
+        }
+        if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + n,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        queue_cell_t *cell = &q->cells[(pos + i) % q->capacity];
+        cell->data = items[i];
+        atomic_store_explicit(&cell->seq, pos + i + 1, memory_order_release);
+    }
+    queue_notify(q);
+
+    if (n < (size_t)count) {
+        atomic_fetch_add_explicit(&q->dropped, (unsigned long)count - n, memory_order_relaxed);
+        fprintf(stderr, "[Queue] Queue full (size=%d), dropping %d readings\n",
+                queue_size(q), count - (int)n);
+    }
+    return (int)n;
+}
+
+// Record the depth the consumer finds before taking from position pos. Only
+// the consumer writes high_water, so a plain load/store pair is enough.
+static void queue_note_depth(queue_t *q, size_t pos) {
+    size_t depth = atomic_load_explicit(&q->tail, memory_order_relaxed) - pos;
+    if (depth > atomic_load_explicit(&q->high_water, memory_order_relaxed)) {
+        atomic_store_explicit(&q->high_water, depth, memory_order_relaxed);
     }
+}
+
+// Non-blocking pop for the single consumer. Returns 1 if an item was taken.
+static int queue_try_pop(queue_t *q, sensor_reading_t *item) {
+    size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    queue_cell_t *cell = &q->cells[pos % q->capacity];
+    if (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + 1) {
+        return 0;
+    }
+    queue_note_depth(q, pos);
+    *item = cell->data;
+    // Hand the slot back to producers for the next lap
+    atomic_store_explicit(&cell->seq, pos + q->capacity, memory_order_release);
+    atomic_store_explicit(&q->head, pos + 1, memory_order_release);
+    return 1;
+}
 
-    if (q->tail) {
-        q->tail->next = new_node;
-        q->tail = new_node;
-    } else {
-        q->head = q->tail = new_node;
+// Check whether the next slot holds a published item (consumer side)
+static int queue_ready(queue_t *q) {
+    size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    queue_cell_t *cell = &q->cells[pos % q->capacity];
+    return atomic_load_explicit(&cell->seq, memory_order_acquire) == pos + 1;
+}
+
+// Park the consumer until the ring is non-empty, shutdown is signaled or the
+// CLOCK_MONOTONIC deadline (if not NULL) passes. Returns 0 on timeout, else 1.
+static int queue_wait(queue_t *q, const struct timespec *deadline) {
+    int rc = 0;
+    pthread_mutex_lock(&q->mutex);
+    atomic_store_explicit(&q->sleeping, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!queue_ready(q) && !should_exit()) {
+        rc = deadline ? pthread_cond_timedwait(&q->cond, &q->mutex, deadline)
+                      : pthread_cond_wait(&q->cond, &q->mutex);
     }
-    q->size++;
-    pthread_cond_signal(&q->cond);
+    atomic_store_explicit(&q->sleeping, 0, memory_order_relaxed);
     pthread_mutex_unlock(&q->mutex);
-    return 0;
+    return rc != ETIMEDOUT;
 }
 
 int queue_pop(queue_t *q, sensor_reading_t *item) {
-    pthread_mutex_lock(&q->mutex);
-    while (q->head == NULL && !should_exit()) {
-        pthread_cond_wait(&q->cond, &q->mutex);
+    for (;;) {
+        if (queue_try_pop(q, item)) {
+            return 0;
+        }
+        if (should_exit()) {
+            return -1;
+        }
+        queue_wait(q, NULL);
     }
-    if (q->head == NULL && should_exit()) {
-        pthread_mutex_unlock(&q->mutex);
-        return -1;
+}
+
+// queue_pop_batch and queue_pop_batch_until; deadline NULL waits forever
+static int pop_batch(queue_t *q, sensor_reading_t *items, int max_items,
+                     const struct timespec *deadline) {
+    if (max_items <= 0) {
+        return 0;
+    }
+
+    for (;;) {
+        size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        int n = 0;
+        while (n < max_items) {
+            queue_cell_t *cell = &q->cells[(pos + n) % q->capacity];
+            if (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + n + 1) {
+                break;
+            }
+            items[n] = cell->data;
+            atomic_store_explicit(&cell->seq, pos + n + q->capacity, memory_order_release);
+            n++;
+        }
+        if (n > 0) {
+            queue_note_depth(q, pos);
+            atomic_store_explicit(&q->head, pos + n, memory_order_release);
+            return n;
+        }
+        if (should_exit()) {
+            return -1;
+        }
+        if (!queue_wait(q, deadline) && !queue_ready(q)) {
+            return 0;
+        }
+    }
+}
+
+int queue_pop_batch(queue_t *q, sensor_reading_t *items, int max_items) {
+    return pop_batch(q, items, max_items, NULL);
+}
+
+int queue_pop_batch_until(queue_t *q, sensor_reading_t *items, int max_items,
+                          uint64_t deadline_ns) {
+    struct timespec deadline = { (time_t)(deadline_ns / 1000000000ULL),
+                                 (long)(deadline_ns % 1000000000ULL) };
+    return pop_batch(q, items, max_items, &deadline);
+}
+
+int queue_sleep_until(queue_t *q, uint64_t deadline_ns) {
+    struct timespec deadline = { (time_t)(deadline_ns / 1000000000ULL),
+                                 (long)(deadline_ns % 1000000000ULL) };
+    int rc = 0;
+    // sleeping stays clear, so producers do not wake us; only shutdown does
+    pthread_mutex_lock(&q->mutex);
+    while (!should_exit() && rc != ETIMEDOUT) {
+        rc = pthread_cond_timedwait(&q->cond, &q->mutex, &deadline);
     }
-    node_t *temp = q->head;
-    *item = temp->data;
-    q->head = temp->next;
-    if (q->head == NULL)
-        q->tail = NULL;
-    q->size--;
-    free(temp);
     pthread_mutex_unlock(&q->mutex);
-    return 0;
+    return should_exit() ? -1 : 0;
 }
 
 int queue_size(queue_t *q) {
+    size_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    // tail may be observed behind head while a pop races with this read
+    return tail > head ? (int)(tail - head) : 0;
+}
+
+void queue_get_stats(queue_t *q, queue_stats_t *stats) {
+    stats->depth = (size_t)queue_size(q);
+    stats->high_water = atomic_load_explicit(&q->high_water, memory_order_relaxed);
+    stats->capacity = q->capacity;
+    stats->dropped = atomic_load_explicit(&q->dropped, memory_order_relaxed);
+}
+
+void queue_wakeup(queue_t *q) {
     pthread_mutex_lock(&q->mutex);
-    int size = q->size;
+    pthread_cond_broadcast(&q->cond);
     pthread_mutex_unlock(&q->mutex);
-    return size;
 }
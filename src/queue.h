@@ -2,43 +2,100 @@
 #define QUEUE_H
 
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <time.h>
 
+// Cache line size used to keep producer and consumer state apart
+#define QUEUE_CACHE_LINE 64
+
+// Capacity used when max_size is 0 ("unbounded"); the ring is preallocated
+// so it cannot grow, this just picks a generous bound.
+#define QUEUE_DEFAULT_CAPACITY 4096
+
 // Data type for sensor readings
 typedef struct {
-    int sensor_id;      // 1 for sensor1, 2 for sensor2
+    int sensor_id;      // 1-based id of a [sensor.N] entry
     float temperature;  // Temperature reading in °C
     time_t timestamp;   // Time of the reading
+    // CLOCK_MONOTONIC stamps (ns, 0 if unknown) for the latency histograms
+    uint64_t read_start_ns;  // I2C transaction started
+    uint64_t read_end_ns;    // I2C transaction finished
+    uint64_t enqueue_ns;     // Handed to queue_push
 } sensor_reading_t;
 
-typedef struct node {
+// One ring slot. seq tells producers/consumer whose turn it is (Vyukov scheme).
+typedef struct {
+    atomic_size_t seq;
     sensor_reading_t data;
-    struct node* next;
-} node_t;
+} queue_cell_t;
 
+// Bounded multi-producer / single-consumer ring buffer.
+// Producers claim slots with a CAS on tail; the single consumer advances head.
+// The mutex/condvar pair is only used to park the consumer when the ring is empty.
 typedef struct {
-    node_t* head;
-    node_t* tail;
+    _Alignas(QUEUE_CACHE_LINE) atomic_size_t tail;  // Next position to claim (producers)
+    _Alignas(QUEUE_CACHE_LINE) atomic_size_t head;  // Next position to read (consumer)
+    _Alignas(QUEUE_CACHE_LINE) atomic_int sleeping; // Consumer is (about to be) parked on cond
+    _Alignas(QUEUE_CACHE_LINE) atomic_ulong dropped;  // Items rejected because the ring was full
+    atomic_size_t high_water;  // Deepest the ring has been when the consumer looked
+    queue_cell_t *cells;
+    size_t capacity;
+    int max_size;       // Configured maximum queue size (0 = default capacity)
     pthread_mutex_t mutex;
     pthread_cond_t cond;
-    int size;           // Current queue size
-    int max_size;       // Maximum queue size (0 = unbounded)
 } queue_t;
 
-// Initialize the queue
-void queue_init(queue_t *q, int max_size);
+// Initialize the queue. All storage is allocated here; push/pop never allocate.
+// Returns 0 on success, -1 on allocation failure.
+int queue_init(queue_t *q, int max_size);
 
-// Destroy the queue and free all nodes
+// Destroy the queue and release the ring storage
 void queue_destroy(queue_t *q);
 
 // Push an item into the queue
 // Returns 0 on success, -1 if queue is full
 int queue_push(queue_t *q, sensor_reading_t item);
 
+// Push up to count items with a single slot reservation and one consumer wakeup.
+// Items that do not fit are dropped. Returns the number of items pushed.
+int queue_push_batch(queue_t *q, const sensor_reading_t *items, int count);
+
 // Blocking pop from the queue. Returns 0 on success, -1 if exit is signaled.
+// Only one thread may pop at a time.
 int queue_pop(queue_t *q, sensor_reading_t *item);
 
-// Get current queue size (thread-safe)
+// Blocking batch pop: waits until at least one item is available, then drains
+// everything available up to max_items. Returns the number of items popped,
+// or -1 if exit is signaled and the queue is empty.
+int queue_pop_batch(queue_t *q, sensor_reading_t *items, int max_items);
+
+// queue_pop_batch that gives up at deadline_ns (CLOCK_MONOTONIC nanoseconds).
+// Returns 0 if nothing arrived by then.
+int queue_pop_batch_until(queue_t *q, sensor_reading_t *items, int max_items,
+                          uint64_t deadline_ns);
+
+// Park the consumer until deadline_ns (CLOCK_MONOTONIC nanoseconds) whatever
+// arrives meanwhile, so throttling can still be cut short by queue_wakeup.
+// Returns 0 at the deadline, or -1 if exit is signaled.
+int queue_sleep_until(queue_t *q, uint64_t deadline_ns);
+
+// Get current queue size (thread-safe, approximate while producers are active)
 int queue_size(queue_t *q);
 
-#endif // QUEUE_H
\ No newline at end of file
+// Queue counters (all values are snapshots)
+typedef struct {
+    size_t depth;          // Items currently queued
+    size_t high_water;     // Largest depth seen by the consumer
+    size_t capacity;
+    unsigned long dropped; // Items rejected by queue_push / queue_push_batch
+} queue_stats_t;
+
+// Get current queue counters (thread-safe)
+void queue_get_stats(queue_t *q, queue_stats_t *stats);
+
+// Wake a consumer blocked in queue_pop (used on shutdown)
+void queue_wakeup(queue_t *q);
+
+#endif // QUEUE_H
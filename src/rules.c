@@ -0,0 +1,597 @@
+#include "rules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+typedef enum {
+    STATE_OK = 0,
+    STATE_PENDING,      // Condition holds, waiting out for_ms
+    STATE_FIRING,
+    STATE_CLEARING      // Clear condition holds, waiting out clear_for_ms
+} rule_state_t;
+
+// What a reading touches, one per rule in sensor order; the names, texts
+// and published state live in parallel arrays so the evaluation loop reads
+// one 32-byte struct per rule
+typedef struct {
+    uint8_t kind;
+    uint8_t op;
+    uint8_t clear_op;       // Without a clear condition: the negated condition
+    uint8_t state;          // Owned by the processor
+    float threshold;
+    float clear_threshold;
+    uint32_t for_ms;
+    uint32_t clear_for_ms;
+    uint64_t since_ms;      // Start of the pending or clearing period
+} rule_eval_t;
+
+// Whether a rule is firing, as the HTTP server sees it: written under the lock
+typedef struct {
+    int active;
+    float value;
+    uint64_t since_ms;
+} rule_alert_state_t;
+
+// A sensor's rules: [first, stale) on its value or rate, [stale, end) stale
+typedef struct {
+    int first;
+    int stale;
+    int end;
+    int primed;             // Has had a reading
+    uint64_t last_ms;
+    float last_value;
+} sensor_rules_t;
+
+static const char *op_names[] = { ">", ">=", "<", "<=" };
+
+static rule_t *specs;
+static rule_eval_t *evals;
+static rule_alert_state_t *alert_states;
+static int rule_total;
+static sensor_rules_t *sensors;     // Indexed by sensor id
+static int sensor_max;
+static uint64_t start_ms;           // First tick: stale timers of silent sensors run from here
+
+// Earliest stale deadline found by the last scan. Readings only push
+// deadlines later, so ticks before it skip the scan unless a stale alert
+// has cleared since (its next deadline is new).
+static uint64_t stale_next;
+static int stale_rescan;
+
+static FILE *alert_log;
+static int log_pending;             // Lines written since the last flush
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static rules_event_t events[RULES_EVENTS];
+static unsigned long event_count;
+static int active_count;
+
+const char *rule_op_name(rule_op_t op) {
+    return op_names[op];
+}
+
+static int parse_op(const char *tok, rule_op_t *op) {
+    for (int i = RULE_GT; i <= RULE_LE; i++) {
+        if (strcmp(tok, op_names[i]) == 0) {
+            *op = (rule_op_t)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Parse a threshold. Rates may be given per second ("2", "2/s") or per
+// minute ("2/min") and are stored per second.
+static int parse_threshold(const char *tok, int rate, float *result) {
+    char *endptr;
+    errno = 0;
+    float val = strtof(tok, &endptr);
+    if (endptr == tok || errno != 0 || !isfinite(val)) {
+        return 0;
+    }
+    if (rate && strcmp(endptr, "/min") == 0) {
+        val /= 60;
+    } else if (!(rate && strcmp(endptr, "/s") == 0) && *endptr != '\0') {
+        return 0;
+    }
+    *result = val;
+    return 1;
+}
+
+// Parse a duration such as "500ms", "30s", "5m" or "1h" into milliseconds
+static int parse_duration(const char *tok, uint32_t *result) {
+    char *endptr;
+    errno = 0;
+    unsigned long val = strtoul(tok, &endptr, 10);
+    if (endptr == tok || errno != 0 || !isdigit((unsigned char)*tok)) {
+        return 0;
+    }
+    unsigned long scale;
+    if (strcmp(endptr, "ms") == 0) {
+        scale = 1;
+    } else if (strcmp(endptr, "s") == 0) {
+        scale = 1000;
+    } else if (strcmp(endptr, "m") == 0) {
+        scale = 60000;
+    } else if (strcmp(endptr, "h") == 0) {
+        scale = 3600000;
+    } else {
+        return 0;
+    }
+    if (val > UINT32_MAX / scale) {
+        return 0;
+    }
+    *result = (uint32_t)(val * scale);
+    return 1;
+}
+
+static int is_above(rule_op_t op) {
+    return op == RULE_GT || op == RULE_GE;
+}
+
+int rule_parse(const char *line, rule_t *rule, char *error, size_t error_size) {
+    char buf[512];
+    char *tokens[16];
+    int n = 0;
+    snprintf(buf, sizeof(buf), "%s", line);
+    char *saveptr;
+    for (char *tok = strtok_r(buf, " \t\r\n", &saveptr); tok;
+         tok = strtok_r(NULL, " \t\r\n", &saveptr)) {
+        if (n == (int)(sizeof(tokens) / sizeof(tokens[0]))) {
+            snprintf(error, error_size, "too many words");
+            return -1;
+        }
+        tokens[n++] = tok;
+    }
+
+    memset(rule, 0, sizeof(*rule));
+    if (n < 3) {
+        snprintf(error, error_size, "expected a name and a condition");
+        return -1;
+    }
+
+    // Names go into the alert log and JSON as they are
+    size_t name_len = strlen(tokens[0]);
+    for (size_t i = 0; i < name_len; i++) {
+        char c = tokens[0][i];
+        if (!isalnum((unsigned char)c) && c != '_' && c != '-' && c != '.') {
+            snprintf(error, error_size, "rule names may only use letters, digits, '_', '-' and '.'");
+            return -1;
+        }
+    }
+    if (name_len >= sizeof(rule->name)) {
+        snprintf(error, error_size, "rule name longer than %d characters", RULES_NAME_MAX - 1);
+        return -1;
+    }
+    memcpy(rule->name, tokens[0], name_len + 1);
+
+    int id;
+    char extra;
+    if (sscanf(tokens[1], "sensor%d%c", &id, &extra) != 1 || id < 1 || id > CONFIG_MAX_SENSORS) {
+        snprintf(error, error_size, "expected sensorN (N = 1-%d), got '%s'", CONFIG_MAX_SENSORS,
+                 tokens[1]);
+        return -1;
+    }
+    rule->sensor = id;
+
+    int i = 2;
+    if (strcmp(tokens[i], "stale") == 0) {
+        rule->kind = RULE_STALE;
+        if (i + 1 >= n || !parse_duration(tokens[i + 1], &rule->for_ms) || rule->for_ms == 0) {
+            snprintf(error, error_size, "stale needs a duration such as 30s");
+            return -1;
+        }
+        i += 2;
+    } else {
+        if (strcmp(tokens[i], "rate") == 0) {
+            rule->kind = RULE_RATE;
+            i++;
+        }
+        if (i + 1 >= n || !parse_op(tokens[i], &rule->op) ||
+            !parse_threshold(tokens[i + 1], rule->kind == RULE_RATE, &rule->threshold)) {
+            snprintf(error, error_size, "expected a comparison such as '> 45'%s",
+                     rule->kind == RULE_RATE ? " or '> 2/min'" : "");
+            return -1;
+        }
+        i += 2;
+
+        if (i < n && strcmp(tokens[i], "for") == 0) {
+            if (i + 1 >= n || !parse_duration(tokens[i + 1], &rule->for_ms)) {
+                snprintf(error, error_size, "for needs a duration such as 30s");
+                return -1;
+            }
+            i += 2;
+        }
+
+        if (i < n && strcmp(tokens[i], "clear") == 0) {
+            rule->has_clear = 1;
+            if (i + 2 >= n || !parse_op(tokens[i + 1], &rule->clear_op) ||
+                !parse_threshold(tokens[i + 2], rule->kind == RULE_RATE, &rule->clear_threshold)) {
+                snprintf(error, error_size, "clear needs a comparison such as '< 43'");
+                return -1;
+            }
+            i += 3;
+            if (i < n && strcmp(tokens[i], "for") == 0) {
+                if (i + 1 >= n || !parse_duration(tokens[i + 1], &rule->clear_for_ms)) {
+                    snprintf(error, error_size, "for needs a duration such as 30s");
+                    return -1;
+                }
+                i += 2;
+            }
+
+            // The clear condition must not hold while the condition does,
+            // or the alert would clear while still firing
+            float t = rule->threshold, c = rule->clear_threshold;
+            int above = is_above(rule->op);
+            int overlap = above ? c > t || (c == t && rule->op == RULE_GE && rule->clear_op == RULE_LE)
+                                : c < t || (c == t && rule->op == RULE_LE && rule->clear_op == RULE_GE);
+            if (is_above(rule->clear_op) == above || overlap) {
+                snprintf(error, error_size, "clear must be on the other side of the threshold");
+                return -1;
+            }
+        }
+    }
+    if (i < n) {
+        snprintf(error, error_size, "unexpected '%s'", tokens[i]);
+        return -1;
+    }
+
+    // Keep the condition, one space between words
+    size_t len = 0;
+    for (int t = 1; t < n && len < sizeof(rule->expr); t++) {
+        len += (size_t)snprintf(rule->expr + len, sizeof(rule->expr) - len, "%s%s",
+                                t > 1 ? " " : "", tokens[t]);
+    }
+    return 0;
+}
+
+int rules_load_file(const char *path, rule_t **rules) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "[Rules] Could not open '%s'\n", path);
+        return -1;
+    }
+
+    rule_t *list = NULL;
+    int count = 0, capacity = 0, line_num = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        line_num++;
+        const char *p = line;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0' || *p == '#') {
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            rule_t *grown = realloc(list, (size_t)capacity * sizeof(*list));
+            if (!grown) {
+                fprintf(stderr, "[Rules] Allocation failure\n");
+                free(list);
+                fclose(file);
+                return -1;
+            }
+            list = grown;
+        }
+        char error[128];
+        if (rule_parse(p, &list[count], error, sizeof(error)) != 0) {
+            fprintf(stderr, "[Rules] %s:%d: %s, ignoring rule\n", path, line_num, error);
+            continue;
+        }
+        count++;
+    }
+    fclose(file);
+    *rules = list;
+    return count;
+}
+
+void rules_destroy(void) {
+    pthread_mutex_lock(&lock);
+    free(specs);
+    free(evals);
+    free(alert_states);
+    free(sensors);
+    specs = NULL;
+    evals = NULL;
+    alert_states = NULL;
+    sensors = NULL;
+    rule_total = 0;
+    sensor_max = 0;
+    start_ms = 0;
+    stale_next = 0;
+    stale_rescan = 1;
+    event_count = 0;
+    active_count = 0;
+    pthread_mutex_unlock(&lock);
+    if (alert_log) {
+        fclose(alert_log);
+        alert_log = NULL;
+    }
+    log_pending = 0;
+}
+
+int rules_init(const rule_t *rules, int count, int sensor_count, const char *log_path) {
+    if (sensor_count < 1 || sensor_count > CONFIG_MAX_SENSORS || count < 0) {
+        fprintf(stderr, "[Rules] Invalid rule or sensor count\n");
+        return -1;
+    }
+    rules_destroy();
+
+    sensors = calloc((size_t)sensor_count + 2, sizeof(*sensors));
+    specs = malloc(((size_t)count + 1) * sizeof(*specs));
+    evals = calloc((size_t)count + 1, sizeof(*evals));
+    alert_states = calloc((size_t)count + 1, sizeof(*alert_states));
+    if (!sensors || !specs || !evals || !alert_states) {
+        fprintf(stderr, "[Rules] Allocation failure\n");
+        rules_destroy();
+        return -1;
+    }
+    sensor_max = sensor_count;
+
+    // Counting sort by sensor, stale rules last, keeping file order within
+    // each: sensors[id].end counts first and becomes the end offset
+    for (int i = 0; i < count; i++) {
+        if (rules[i].sensor < 1 || rules[i].sensor > sensor_count) {
+            fprintf(stderr, "[Rules] Rule %s: sensor%d is not configured, ignoring rule\n",
+                    rules[i].name, rules[i].sensor);
+            continue;
+        }
+        sensor_rules_t *s = &sensors[rules[i].sensor];
+        s->end++;
+        if (rules[i].kind != RULE_STALE) {
+            s->stale++;
+        }
+    }
+    int offset = 0;
+    for (int id = 1; id <= sensor_count; id++) {
+        sensor_rules_t *s = &sensors[id];
+        int total = s->end, live = s->stale;
+        s->first = offset;
+        s->stale = offset + live;
+        s->end = offset + total;
+        offset += total;
+    }
+    int *next_live = calloc((size_t)sensor_count + 1, sizeof(int));
+    int *next_stale = calloc((size_t)sensor_count + 1, sizeof(int));
+    if (!next_live || !next_stale) {
+        fprintf(stderr, "[Rules] Allocation failure\n");
+        free(next_live);
+        free(next_stale);
+        rules_destroy();
+        return -1;
+    }
+    for (int id = 1; id <= sensor_count; id++) {
+        next_live[id] = sensors[id].first;
+        next_stale[id] = sensors[id].stale;
+    }
+    for (int i = 0; i < count; i++) {
+        const rule_t *r = &rules[i];
+        if (r->sensor < 1 || r->sensor > sensor_count) {
+            continue;
+        }
+        int slot = r->kind == RULE_STALE ? next_stale[r->sensor]++ : next_live[r->sensor]++;
+        specs[slot] = *r;
+        rule_eval_t *e = &evals[slot];
+        e->kind = (uint8_t)r->kind;
+        e->op = (uint8_t)r->op;
+        e->threshold = r->threshold;
+        e->for_ms = r->for_ms;
+        e->clear_for_ms = r->clear_for_ms;
+        if (r->has_clear) {
+            e->clear_op = (uint8_t)r->clear_op;
+            e->clear_threshold = r->clear_threshold;
+        } else {
+            static const uint8_t negated[] = { RULE_LE, RULE_LT, RULE_GE, RULE_GT };
+            e->clear_op = negated[r->op];
+            e->clear_threshold = r->threshold;
+        }
+    }
+    free(next_live);
+    free(next_stale);
+    rule_total = offset;
+
+    if (rule_total > 0 && log_path && log_path[0]) {
+        alert_log = fopen(log_path, "a");
+        if (!alert_log) {
+            fprintf(stderr, "[Rules] Could not open alert log '%s'\n", log_path);
+            rules_destroy();
+            return -1;
+        }
+        if (ftell(alert_log) == 0) {
+            fprintf(alert_log, "timestamp,rule,sensor,state,value\n");
+            log_pending = 1;
+        }
+    }
+    return 0;
+}
+
+int rules_count(void) {
+    return rule_total;
+}
+
+static int compare(int op, float x, float threshold) {
+    switch (op) {
+    case RULE_GT: return x > threshold;
+    case RULE_GE: return x >= threshold;
+    case RULE_LT: return x < threshold;
+    default:      return x <= threshold;
+    }
+}
+
+// Publish a rule firing or clearing: active flag and event under the lock,
+// then the console and the alert log
+static void transition(int i, int firing, uint64_t time_ms, float value) {
+    rule_alert_state_t *a = &alert_states[i];
+    const rule_t *r = &specs[i];
+    pthread_mutex_lock(&lock);
+    a->active = firing;
+    if (firing) {
+        a->since_ms = time_ms;
+        a->value = value;
+        active_count++;
+    } else {
+        active_count--;
+    }
+    events[event_count++ % RULES_EVENTS] = (rules_event_t){
+        .name = r->name, .sensor = r->sensor, .firing = firing, .time_ms = time_ms, .value = value
+    };
+    pthread_mutex_unlock(&lock);
+    evals[i].state = firing ? STATE_FIRING : STATE_OK;
+
+    if (r->kind == RULE_STALE && firing) {
+        printf("[Rules] FIRING %s: %s\n", r->name, r->expr);
+    } else {
+        printf("[Rules] %s %s: %s (%.2f)\n", firing ? "FIRING" : "Cleared", r->name, r->expr, value);
+    }
+    if (alert_log) {
+        time_t t = (time_t)(time_ms / 1000);
+        struct tm tm_info;
+        char time_str[32];
+        localtime_r(&t, &tm_info);
+        strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &tm_info);
+        fprintf(alert_log, "%s.%03u,%s,%d,%s,%.2f\n", time_str, (unsigned)(time_ms % 1000),
+                r->name, r->sensor, firing ? "firing" : "cleared", value);
+        log_pending++;
+    }
+}
+
+// Step a value or rate rule on x, observed at time_ms
+static void evaluate(int i, float x, uint64_t time_ms) {
+    rule_eval_t *e = &evals[i];
+    switch (e->state) {
+    case STATE_OK:
+        if (!compare(e->op, x, e->threshold)) {
+            return;
+        }
+        e->state = STATE_PENDING;
+        e->since_ms = time_ms;
+        // fall through
+    case STATE_PENDING:
+        if (!compare(e->op, x, e->threshold)) {
+            e->state = STATE_OK;
+        } else if (time_ms >= e->since_ms + e->for_ms) {
+            transition(i, 1, time_ms, x);
+        }
+        return;
+    case STATE_FIRING:
+        if (!compare(e->clear_op, x, e->clear_threshold)) {
+            return;
+        }
+        e->state = STATE_CLEARING;
+        e->since_ms = time_ms;
+        // fall through
+    default:
+        if (!compare(e->clear_op, x, e->clear_threshold)) {
+            e->state = STATE_FIRING;
+        } else if (time_ms >= e->since_ms + e->clear_for_ms) {
+            transition(i, 0, time_ms, x);
+        }
+        return;
+    }
+}
+
+void rules_reading(int sensor_id, uint64_t time_ms, float value) {
+    if (sensor_id < 1 || sensor_id > sensor_max) {
+        return;
+    }
+    sensor_rules_t *s = &sensors[sensor_id];
+    if (s->first == s->end) {
+        return;
+    }
+
+    // Rate against the previous reading, per second
+    int has_rate = s->primed && time_ms > s->last_ms;
+    float rate = has_rate ? (value - s->last_value) * 1000.0f / (float)(time_ms - s->last_ms) : 0;
+    for (int i = s->first; i < s->stale; i++) {
+        if (evals[i].kind == RULE_VALUE) {
+            evaluate(i, value, time_ms);
+        } else if (has_rate) {
+            evaluate(i, rate, time_ms);
+        }
+    }
+
+    // A reading ends every stale alert on the sensor
+    for (int i = s->stale; i < s->end; i++) {
+        if (evals[i].state == STATE_FIRING) {
+            transition(i, 0, time_ms, value);
+            stale_rescan = 1;
+        }
+    }
+    s->primed = 1;
+    s->last_ms = time_ms;
+    s->last_value = value;
+}
+
+// Lines reach the file once per batch of transitions rather than per line
+static void flush_log(void) {
+    if (log_pending) {
+        fflush(alert_log);
+        log_pending = 0;
+    }
+}
+
+uint64_t rules_tick(uint64_t now_ms) {
+    if (start_ms == 0) {
+        start_ms = now_ms;
+    }
+    if (!stale_rescan && (stale_next == 0 || now_ms < stale_next)) {
+        flush_log();
+        return stale_next;
+    }
+
+    uint64_t next = 0;
+    for (int id = 1; id <= sensor_max; id++) {
+        const sensor_rules_t *s = &sensors[id];
+        uint64_t last = s->primed ? s->last_ms : start_ms;
+        for (int i = s->stale; i < s->end; i++) {
+            if (evals[i].state != STATE_OK) {
+                continue;
+            }
+            uint64_t due = last + evals[i].for_ms;
+            if (now_ms >= due) {
+                transition(i, 1, now_ms, 0);
+            } else if (next == 0 || due < next) {
+                next = due;
+            }
+        }
+    }
+    stale_next = next;
+    stale_rescan = 0;
+    flush_log();
+    return next;
+}
+
+int rules_active(rules_alert_t *out, int max) {
+    pthread_mutex_lock(&lock);
+    int n = 0;
+    for (int i = 0; i < rule_total && n < active_count; i++) {
+        if (!alert_states[i].active) {
+            continue;
+        }
+        if (n < max) {
+            out[n] = (rules_alert_t){
+                .name = specs[i].name, .expr = specs[i].expr, .sensor = specs[i].sensor,
+                .since_ms = alert_states[i].since_ms, .value = alert_states[i].value
+            };
+        }
+        n++;
+    }
+    pthread_mutex_unlock(&lock);
+    return n;
+}
+
+int rules_events(rules_event_t *out, int max) {
+    pthread_mutex_lock(&lock);
+    unsigned long kept = event_count < RULES_EVENTS ? event_count : RULES_EVENTS;
+    int n = (unsigned long)max < kept ? max : (int)kept;
+    for (int i = 0; i < n; i++) {
+        out[i] = events[(event_count - (unsigned long)n + (unsigned long)i) % RULES_EVENTS];
+    }
+    pthread_mutex_unlock(&lock);
+    return n;
+}
@@ -0,0 +1,129 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// Alert rules evaluated by the processor on every reading.
+//
+// A rule is one line of the [alerts] rules_file: a name and a condition on
+// one sensor,
+//
+//   over_temp   sensor3 > 45 for 30s clear < 43 for 10s
+//   fast_rise   sensor1 rate > 2/min for 1m
+//   lost        sensor2 stale 30s
+//
+//   sensorN <op> V        the sensor's filtered value (op: > >= < <=)
+//   sensorN rate <op> V   its change per second between consecutive readings
+//                         (V/s or V/min)
+//   sensorN stale D       no reading for D
+//   for D                 the condition must hold for D before the alert fires
+//   clear <op> V [for D]  the alert clears once this holds (for D) rather than
+//                         as soon as the condition is false: a hysteresis band
+//
+// Durations are a whole number of ms, s, m or h. Rules are kept sorted by
+// sensor, so a reading only runs the rules for its sensor, each in O(1) from
+// the state it keeps (ok, pending, firing, clearing). Stale rules are checked
+// on rules_tick instead, and clear when a reading arrives. A rule's timers
+// advance on its sensor's readings: a condition that holds for D fires on the
+// first reading at least D after it began to hold.
+//
+// Alerts firing and clearing are printed, appended to the alert log and kept
+// in a ring of recent events; the processor is the only writer, the HTTP
+// server reads the active alerts and events under a lock taken only on
+// transitions.
+
+// Longest rule name and condition text kept
+#define RULES_NAME_MAX 32
+#define RULES_EXPR_MAX 128
+
+// Recent alert events kept for /api/alerts
+#define RULES_EVENTS 256
+
+typedef enum {
+    RULE_VALUE = 0,
+    RULE_RATE,
+    RULE_STALE
+} rule_kind_t;
+
+typedef enum {
+    RULE_GT = 0,
+    RULE_GE,
+    RULE_LT,
+    RULE_LE
+} rule_op_t;
+
+// One parsed rule
+typedef struct {
+    char name[RULES_NAME_MAX];
+    char expr[RULES_EXPR_MAX];  // The condition as written
+    int sensor;
+    rule_kind_t kind;
+    rule_op_t op;
+    float threshold;            // Value, or rate per second
+    uint32_t for_ms;            // Stale rules: how long without a reading
+    int has_clear;
+    rule_op_t clear_op;
+    float clear_threshold;
+    uint32_t clear_for_ms;
+} rule_t;
+
+// An alert that is firing
+typedef struct {
+    const char *name;           // Valid until rules_destroy
+    const char *expr;
+    int sensor;
+    uint64_t since_ms;          // Unix ms it fired at
+    float value;                // Reading (or rate) that fired it; 0 for stale rules
+} rules_alert_t;
+
+// An alert firing or clearing
+typedef struct {
+    const char *name;
+    int sensor;
+    int firing;                 // 1 = fired, 0 = cleared
+    uint64_t time_ms;
+    float value;
+} rules_event_t;
+
+// Parse a rule line ("name condition"). Returns 0 on success, -1 with a
+// message in error if the line is not a valid rule.
+int rule_parse(const char *line, rule_t *rule, char *error, size_t error_size);
+
+// Parse a rules file into a malloc'd array. Blank lines and # comments are
+// skipped; invalid rules are reported and skipped. Returns the number of
+// rules, or -1 if the file cannot be read.
+int rules_load_file(const char *path, rule_t **rules);
+
+// Start the engine with count rules for sensors 1..sensor_count, appending
+// alert events to log_path ("" = no log). Rules for other sensors are
+// reported and dropped. Returns 0 on success, -1 on failure.
+int rules_init(const rule_t *rules, int count, int sensor_count, const char *log_path);
+
+// Free the rules and close the alert log
+void rules_destroy(void);
+
+// Number of rules being evaluated
+int rules_count(void);
+
+// Evaluate the rules for a sensor on a reading taken at time_ms (Unix ms)
+void rules_reading(int sensor_id, uint64_t time_ms, float value);
+
+// Evaluate the stale rules at now_ms and flush the alert log. Call once per
+// processor batch. Returns the time (Unix ms) to call again by, no later than
+// the next stale rule can fire, or 0 if none can until a reading arrives.
+uint64_t rules_tick(uint64_t now_ms);
+
+// Copy up to max active alerts, in rule order, into out. Returns how many
+// alerts are active (which may exceed max).
+int rules_active(rules_alert_t *out, int max);
+
+// Copy up to max of the most recent events, oldest first, into out. Returns
+// the number copied.
+int rules_events(rules_event_t *out, int max);
+
+// Name of a comparison ("<", ">=", ...)
+const char *rule_op_name(rule_op_t op);
+
+#endif // RULES_H
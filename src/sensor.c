@@ -1,103 +1,281 @@
+#define _GNU_SOURCE  // pthread_setaffinity_np
 #include "sensor.h"
 #include "queue.h"
 #include "utils.h"
 #include "config.h"
+#include "metrics.h"
+#include "latency.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <time.h>
-#include <unistd.h>
-#include <fcntl.h>
-#include <sys/ioctl.h>
-#include <linux/i2c-dev.h>
-
-// Helper function to read temperature from a TMP102 sensor at a given I2C address.
-// Returns temperature in °C on success; on failure, returns -999.
-static float read_temperature(int i2c_address, const char *device_path) {
-    int file = open(device_path, O_RDWR);
-    if (file < 0) {
-        perror("Opening I2C device");
-        return -999;
+#include <pthread.h>
+#include <sched.h>
+
+// TMP102 temperature register
+#define TMP102_REG_TEMP 0x00
+
+// Convert the temperature register to °C (TMP102: 12-bit resolution)
+static float tmp102_to_celsius(const unsigned char *data) {
+    int temp_raw = ((data[0] << 4) | (data[1] >> 4));
+    if (temp_raw & 0x800) { // negative temperature
+        temp_raw = temp_raw - 4096;
     }
+    return temp_raw * 0.0625f;
+}
 
-    if (ioctl(file, I2C_SLAVE, i2c_address) < 0) {
-        perror("Setting I2C address");
-        close(file);
+float sensor_read_tmp102(i2c_bus_t *bus, int address) {
+    unsigned char data[2];
+    if (i2c_bus_read_register(bus, (uint16_t)address, TMP102_REG_TEMP, data, 2) != 0) {
         return -999;
     }
+    return tmp102_to_celsius(data);
+}
 
-    // TMP102 temperature register is at 0x00.
-    unsigned char reg = 0x00;
-    if (write(file, &reg, 1) != 1) {
-        perror("Writing register");
-        close(file);
-        return -999;
+void sensor_read_tmp102_sweep(i2c_bus_t *bus, const sensor_due_t *due, int count, float *temps) {
+    i2c_read_t reads[I2C_BUS_MAX_BATCH];
+    unsigned char data[I2C_BUS_MAX_BATCH][2];
+
+    for (int start = 0; start < count; start += I2C_BUS_MAX_BATCH) {
+        int n = count - start < I2C_BUS_MAX_BATCH ? count - start : I2C_BUS_MAX_BATCH;
+        for (int i = 0; i < n; i++) {
+            reads[i] = (i2c_read_t){ .address = (uint16_t)due[start + i].sensor->address,
+                                     .reg = TMP102_REG_TEMP, .buf = data[i], .len = 2 };
+        }
+        i2c_bus_read_registers(bus, reads, n);
+        for (int i = 0; i < n; i++) {
+            temps[start + i] = reads[i].result == 0 ? tmp102_to_celsius(data[i]) : -999;
+        }
     }
+}
 
-    unsigned char data[2];
-    if (read(file, data, 2) != 2) {
-        perror("Reading temperature");
-        close(file);
-        return -999;
+// Longest single sleep, so shutdown is noticed promptly even with long intervals
+#define SCHEDULER_MAX_SLEEP_NS 250000000ULL
+
+static void sift_down(sensor_schedule_t *schedule, int i) {
+    sensor_slot_t *slots = schedule->slots;
+    for (;;) {
+        int smallest = i;
+        int left = 2 * i + 1, right = 2 * i + 2;
+        if (left < schedule->count && slots[left].due_ns < slots[smallest].due_ns) {
+            smallest = left;
+        }
+        if (right < schedule->count && slots[right].due_ns < slots[smallest].due_ns) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            return;
+        }
+        sensor_slot_t tmp = slots[i];
+        slots[i] = slots[smallest];
+        slots[smallest] = tmp;
+        i = smallest;
     }
-    close(file);
+}
 
-    // Convert the data to temperature (TMP102: 12-bit resolution)
-    int temp_raw = ((data[0] << 4) | (data[1] >> 4));
-    if (temp_raw & 0x800) { // negative temperature
-        temp_raw = temp_raw - 4096;
+static void sift_up(sensor_schedule_t *schedule, int i) {
+    sensor_slot_t *slots = schedule->slots;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (slots[parent].due_ns <= slots[i].due_ns) {
+            return;
+        }
+        sensor_slot_t tmp = slots[i];
+        slots[i] = slots[parent];
+        slots[parent] = tmp;
+        i = parent;
     }
-    float temperature = temp_raw * 0.0625f;
-    return temperature;
 }
 
-void *sensor1_thread(void *arg) {
-    (void)arg;
-    printf("[Sensor1] Starting (address=0x%02x, interval=%ds)\n",
-           g_config.sensor1_address, g_config.sensor1_interval);
-
-    while (!should_exit()) {
-        float temp = read_temperature(g_config.sensor1_address, g_config.i2c_device);
-        if (temp != -999) {
-            sensor_reading_t reading;
-            reading.sensor_id = 1;
-            reading.temperature = temp;
-            reading.timestamp = time(NULL);
-            int result = queue_push(&sensor_queue, reading);
-            if (result == 0) {
-                printf("[Sensor1] Temperature: %.2f°C\n", temp);
-            }
-            // If queue_push fails (returns -1), it already logged an error
-        } else {
-            printf("[Sensor1] Error reading sensor.\n");
+int sensor_schedule_init(sensor_schedule_t *schedule, const sensor_config_t *sensors,
+                         int count, uint64_t start_ns) {
+    schedule->count = 0;
+    schedule->slots = malloc(sizeof(sensor_slot_t) * (size_t)(count > 0 ? count : 1));
+    if (!schedule->slots) {
+        return -1;
+    }
+    // Equal deadlines already form a heap; ties are read in table order
+    for (int i = 0; i < count; i++) {
+        schedule->slots[i].sensor = &sensors[i];
+        schedule->slots[i].due_ns = start_ns;
+    }
+    schedule->count = count;
+    return 0;
+}
+
+void sensor_schedule_destroy(sensor_schedule_t *schedule) {
+    free(schedule->slots);
+    schedule->slots = NULL;
+    schedule->count = 0;
+}
+
+// Step a slot to its next deadline. Returns the number of deadlines dropped.
+static unsigned int next_deadline(sensor_slot_t *slot, uint64_t now_ns) {
+    uint64_t interval_ns = (uint64_t)slot->sensor->interval_ms * 1000000ULL;
+    uint64_t met = slot->due_ns;
+    slot->due_ns += interval_ns;
+    if (slot->due_ns + interval_ns > now_ns) {
+        return 0;
+    }
+    // Skip every deadline in (met, now_ns] and stay on the grid
+    uint64_t skipped = (now_ns - met) / interval_ns;
+    slot->due_ns = met + (skipped + 1) * interval_ns;
+    return (unsigned int)skipped;
+}
+
+void sensor_schedule_advance(sensor_schedule_t *schedule, uint64_t now_ns) {
+    if (schedule->count == 0) {
+        return;
+    }
+    next_deadline(&schedule->slots[0], now_ns);
+    sift_down(schedule, 0);
+}
+
+int sensor_schedule_take_due(sensor_schedule_t *schedule, uint64_t now_ns, sensor_due_t *due) {
+    sensor_slot_t *slots = schedule->slots;
+    int total = schedule->count;
+
+    // Pop every due slot off the heap into the space past its end...
+    while (schedule->count > 0 && slots[0].due_ns <= now_ns) {
+        int last = --schedule->count;
+        sensor_slot_t taken = slots[0];
+        slots[0] = slots[last];
+        slots[last] = taken;
+        sift_down(schedule, 0);
+    }
+    // ...then push each back at its next deadline, so none is taken twice.
+    // The first one popped sits last.
+    int n = total - schedule->count;
+    while (schedule->count < total) {
+        sensor_slot_t *slot = &slots[schedule->count];
+        sensor_due_t *entry = &due[total - 1 - schedule->count];
+        entry->sensor = slot->sensor;
+        entry->late_ns = now_ns - slot->due_ns;
+        entry->missed = next_deadline(slot, now_ns);
+        sift_up(schedule, schedule->count++);
+    }
+    return n;
+}
+
+// Per-thread buffers for one sweep, sized for every sensor on the bus
+typedef struct {
+    sensor_due_t *due;
+    float *temps;
+    sensor_reading_t *readings;
+} sweep_t;
+
+// Read the due sensors and queue their readings as one batch
+static void read_sweep(i2c_bus_t *bus, sweep_t *sweep, int count) {
+    uint64_t read_start = latency_now_ns();
+    sensor_read_tmp102_sweep(bus, sweep->due, count, sweep->temps);
+    uint64_t read_end = latency_now_ns();
+    time_t now = time(NULL);
+
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        const sensor_config_t *sensor = sweep->due[i].sensor;
+        float temp = sweep->temps[i];
+        metrics_sensor_schedule(sensor->id, sweep->due[i].late_ns, sweep->due[i].missed);
+        metrics_sensor_read(sensor->id, temp != -999);
+        if (temp == -999) {
+            printf("[Sensor%d] Error reading sensor.\n", sensor->id);
+            continue;
         }
-        sleep(g_config.sensor1_interval);
+        sensor_reading_t *reading = &sweep->readings[n++];
+        reading->sensor_id = sensor->id;
+        reading->temperature = temp;
+        reading->timestamp = now;
+        reading->read_start_ns = read_start;
+        reading->read_end_ns = read_end;
+        reading->enqueue_ns = latency_now_ns();
+    }
+    // queue_push_batch logs any readings it has to drop
+    int pushed = queue_push_batch(&sensor_queue, sweep->readings, n);
+    for (int i = 0; i < pushed; i++) {
+        printf("[Sensor%d] Temperature: %.2f°C\n", sweep->readings[i].sensor_id,
+               sweep->readings[i].temperature);
+    }
+}
+
+// Pin the calling thread to one CPU
+static void pin_to_cpu(int bus_index, int cpu) {
+    if (cpu >= CPU_SETSIZE) {
+        fprintf(stderr, "[Sensors] Bus %d: CPU %d out of range, not pinning\n", bus_index, cpu);
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        fprintf(stderr, "[Sensors] Bus %d: cannot pin to CPU %d: %s\n", bus_index, cpu, strerror(rc));
     }
-    printf("[Sensor1] Shutting down\n");
-    return NULL;
 }
 
-void *sensor2_thread(void *arg) {
-    (void)arg;
-    printf("[Sensor2] Starting (address=0x%02x, interval=%ds)\n",
-           g_config.sensor2_address, g_config.sensor2_interval);
-
-    while (!should_exit()) {
-        float temp = read_temperature(g_config.sensor2_address, g_config.i2c_device);
-        if (temp != -999) {
-            sensor_reading_t reading;
-            reading.sensor_id = 2;
-            reading.temperature = temp;
-            reading.timestamp = time(NULL);
-            int result = queue_push(&sensor_queue, reading);
-            if (result == 0) {
-                printf("[Sensor2] Temperature: %.2f°C\n", temp);
+// One thread serves every sensor on its bus, in deadline order. Reads on a
+// bus are serialized by the hardware anyway, so more threads would only add
+// contention for it; separate buses run in parallel.
+void *sensor_bus_thread(void *arg) {
+    int bus_index = (int)(intptr_t)arg;
+    const bus_config_t *bus_config = &g_config.buses[bus_index];
+    if (bus_config->cpu >= 0) {
+        pin_to_cpu(bus_index, bus_config->cpu);
+    }
+    i2c_bus_t *bus = i2c_bus_get(bus_config->device);
+    if (!bus) {
+        return NULL;
+    }
+
+    // This bus's sensors, copied out of the table in id order
+    int count = config_bus_sensor_count(bus_index);
+    size_t slots = (size_t)(count > 0 ? count : 1);
+    sensor_config_t *sensors = malloc(sizeof(*sensors) * slots);
+    sensor_schedule_t schedule;
+    sweep_t sweep = {
+        .due = malloc(sizeof(*sweep.due) * slots),
+        .temps = malloc(sizeof(*sweep.temps) * slots),
+        .readings = malloc(sizeof(*sweep.readings) * slots),
+    };
+    if (sensors) {
+        for (int i = 0, n = 0; i < g_config.sensor_count; i++) {
+            if (g_config.sensors[i].bus == bus_index) {
+                sensors[n++] = g_config.sensors[i];
             }
-            // If queue_push fails (returns -1), it already logged an error
-        } else {
-            printf("[Sensor2] Error reading sensor.\n");
         }
-        sleep(g_config.sensor2_interval);
     }
-    printf("[Sensor2] Shutting down\n");
+    if (!sensors || !sweep.due || !sweep.temps || !sweep.readings ||
+        sensor_schedule_init(&schedule, sensors, count, latency_now_ns()) != 0) {
+        fprintf(stderr, "[Sensors] Bus %d: failed to allocate the sensor schedule\n", bus_index);
+        free(sensors);
+        free(sweep.due);
+        free(sweep.temps);
+        free(sweep.readings);
+        return NULL;
+    }
+    printf("[Sensors] Bus %d: starting (%d sensors on %s)\n", bus_index, schedule.count,
+           bus_config->device);
+
+    while (!should_exit() && schedule.count > 0) {
+        const sensor_slot_t *next = &schedule.slots[0];
+        uint64_t now = latency_now_ns();
+        if (next->due_ns > now) {
+            uint64_t wake = next->due_ns;
+            if (wake - now > SCHEDULER_MAX_SLEEP_NS) {
+                wake = now + SCHEDULER_MAX_SLEEP_NS;
+            }
+            struct timespec ts = { (time_t)(wake / 1000000000ULL), (long)(wake % 1000000000ULL) };
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+            continue;
+        }
+        read_sweep(bus, &sweep, sensor_schedule_take_due(&schedule, now, sweep.due));
+    }
+
+    sensor_schedule_destroy(&schedule);
+    free(sensors);
+    free(sweep.due);
+    free(sweep.temps);
+    free(sweep.readings);
+    printf("[Sensors] Bus %d: shutting down\n", bus_index);
     return NULL;
 }
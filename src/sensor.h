@@ -1,8 +1,61 @@
 #ifndef SENSOR_H
 #define SENSOR_H
 
-// Thread functions for sensor interfaces
-void *sensor1_thread(void *arg);
-void *sensor2_thread(void *arg);
+#include <stdint.h>
+#include "config.h"
+#include "i2c_bus.h"
 
-#endif // SENSOR_H
\ No newline at end of file
+// One sensor's place in a bus schedule
+typedef struct {
+    const sensor_config_t *sensor;
+    uint64_t due_ns;            // Next read deadline (CLOCK_MONOTONIC)
+} sensor_slot_t;
+
+// A sensor taken for a sweep
+typedef struct {
+    const sensor_config_t *sensor;
+    uint64_t late_ns;           // How long after its deadline the sweep started
+    unsigned int missed;        // Deadlines dropped because it fell behind
+} sensor_due_t;
+
+// Min-heap of next-due read deadlines for the sensors on one I2C bus. The
+// earliest deadline is always slots[0], so a single thread can serve any
+// number of sensors: sleep until slots[0] is due, then read everything that is
+// due in one sweep and advance it.
+typedef struct {
+    sensor_slot_t *slots;
+    int count;
+} sensor_schedule_t;
+
+// Schedule count sensors, all first due at start_ns. Returns 0 on success, -1 on failure.
+int sensor_schedule_init(sensor_schedule_t *schedule, const sensor_config_t *sensors,
+                         int count, uint64_t start_ns);
+
+// Free a schedule's slots
+void sensor_schedule_destroy(sensor_schedule_t *schedule);
+
+// Move the earliest sensor to its next deadline, one interval after the one it
+// just met. Deadlines are absolute, so time spent reading never accumulates as
+// drift. A sensor more than an interval behind at now_ns moves on to its first
+// deadline after now_ns rather than firing a burst of catch-up reads; the
+// deadlines it skips count as missed.
+void sensor_schedule_advance(sensor_schedule_t *schedule, uint64_t now_ns);
+
+// Take every sensor due at now_ns, each at most once, advancing it as
+// sensor_schedule_advance does. Stores them in due (room for schedule->count)
+// in deadline order and returns how many there were.
+int sensor_schedule_take_due(sensor_schedule_t *schedule, uint64_t now_ns, sensor_due_t *due);
+
+// Read a TMP102 at address on bus. Returns the temperature in °C, or -999 on failure.
+float sensor_read_tmp102(i2c_bus_t *bus, int address);
+
+// Read count TMP102s on bus, bundling their reads into as few transfers as the
+// adapter allows. temps[i] gets the temperature of due[i] in °C, or -999.
+void sensor_read_tmp102_sweep(i2c_bus_t *bus, const sensor_due_t *due, int count, float *temps);
+
+// Thread function that reads every sensor on one bus of g_config; arg is the
+// bus index cast to a pointer. The thread is pinned to the bus's cpu if one is
+// set. Sensors due at the same time are read in one sweep and queued as one batch.
+void *sensor_bus_thread(void *arg);
+
+#endif // SENSOR_H
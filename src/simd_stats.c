@@ -0,0 +1,494 @@
+#include "simd_stats.h"
+#include <math.h>
+#include <pthread.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// Float elements summed in float lanes before folding into double
+#define F32_BLOCK 4096
+
+// Fixed-point elements summed in 32-bit lanes before folding into 64 bits.
+// Each lane gains at most 2 * 32768 per vector, so 16384 vectors per lane
+// stay below 2^31.
+#define I16_BLOCK (16384 * 8)
+
+// Reduction of one float array, relative to shift
+typedef struct {
+    float min;
+    float max;
+    double sum;
+    double sum_sq;
+} f32_part_t;
+
+// Exact reduction of one fixed-point array
+typedef struct {
+    int16_t min;
+    int16_t max;
+    int64_t sum;
+    uint64_t sum_sq;
+} i16_part_t;
+
+// One kernel set; n is always at least 1
+typedef struct {
+    void (*f32)(const float *x, size_t n, float shift, f32_part_t *p);
+    void (*i16)(const int16_t *x, size_t n, i16_part_t *p);
+} kernels_t;
+
+// ---------------------------------------------------------------------------
+// Scalar reference
+// ---------------------------------------------------------------------------
+
+static void f32_scalar(const float *x, size_t n, float shift, f32_part_t *p) {
+    float min = x[0], max = x[0];
+    double sum = 0, sum_sq = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (x[i] < min) min = x[i];
+        if (x[i] > max) max = x[i];
+        double d = (double)x[i] - shift;
+        sum += d;
+        sum_sq += d * d;
+    }
+    *p = (f32_part_t){ min, max, sum, sum_sq };
+}
+
+static void i16_scalar(const int16_t *x, size_t n, i16_part_t *p) {
+    int16_t min = x[0], max = x[0];
+    int64_t sum = 0;
+    uint64_t sum_sq = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (x[i] < min) min = x[i];
+        if (x[i] > max) max = x[i];
+        sum += x[i];
+        sum_sq += (uint64_t)((int32_t)x[i] * x[i]);
+    }
+    *p = (i16_part_t){ min, max, sum, sum_sq };
+}
+
+static const kernels_t scalar_kernels = { f32_scalar, i16_scalar };
+
+// Fold the tail that does not fill a vector into a partial result
+static void f32_tail(const float *x, size_t n, float shift, f32_part_t *p) {
+    if (n > 0) {
+        f32_part_t t;
+        f32_scalar(x, n, shift, &t);
+        if (t.min < p->min) p->min = t.min;
+        if (t.max > p->max) p->max = t.max;
+        p->sum += t.sum;
+        p->sum_sq += t.sum_sq;
+    }
+}
+
+static void i16_tail(const int16_t *x, size_t n, i16_part_t *p) {
+    if (n > 0) {
+        i16_part_t t;
+        i16_scalar(x, n, &t);
+        if (t.min < p->min) p->min = t.min;
+        if (t.max > p->max) p->max = t.max;
+        p->sum += t.sum;
+        p->sum_sq += t.sum_sq;
+    }
+}
+
+// Horizontal reductions of lanes spilled to memory
+static double lanes_sum_f32(const float *lanes, int count) {
+    double sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += lanes[i];
+    }
+    return sum;
+}
+
+static void lanes_minmax_f32(const float *mins, const float *maxs, int count, f32_part_t *p) {
+    p->min = mins[0];
+    p->max = maxs[0];
+    for (int i = 1; i < count; i++) {
+        if (mins[i] < p->min) p->min = mins[i];
+        if (maxs[i] > p->max) p->max = maxs[i];
+    }
+}
+
+static void lanes_minmax_i16(const int16_t *mins, const int16_t *maxs, int count, i16_part_t *p) {
+    p->min = mins[0];
+    p->max = maxs[0];
+    for (int i = 1; i < count; i++) {
+        if (mins[i] < p->min) p->min = mins[i];
+        if (maxs[i] > p->max) p->max = maxs[i];
+    }
+}
+
+#if defined(__x86_64__)
+
+// ---------------------------------------------------------------------------
+// SSE2 (always present on x86-64)
+// ---------------------------------------------------------------------------
+
+static void f32_sse2(const float *x, size_t n, float shift, f32_part_t *p) {
+    __m128 vmin = _mm_set1_ps(x[0]), vmax = vmin;
+    __m128 vshift = _mm_set1_ps(shift);
+    double sum = 0, sum_sq = 0;
+    size_t i = 0;
+    while (i + 8 <= n) {
+        size_t end = i + F32_BLOCK < n ? i + F32_BLOCK : n;
+        // Two accumulator pairs so consecutive adds do not wait on each other
+        __m128 s0 = _mm_setzero_ps(), s1 = s0, q0 = s0, q1 = s0;
+        for (; i + 8 <= end; i += 8) {
+            __m128 a = _mm_loadu_ps(x + i);
+            __m128 b = _mm_loadu_ps(x + i + 4);
+            vmin = _mm_min_ps(vmin, _mm_min_ps(a, b));
+            vmax = _mm_max_ps(vmax, _mm_max_ps(a, b));
+            a = _mm_sub_ps(a, vshift);
+            b = _mm_sub_ps(b, vshift);
+            s0 = _mm_add_ps(s0, a);
+            s1 = _mm_add_ps(s1, b);
+            q0 = _mm_add_ps(q0, _mm_mul_ps(a, a));
+            q1 = _mm_add_ps(q1, _mm_mul_ps(b, b));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, _mm_add_ps(s0, s1));
+        sum += lanes_sum_f32(lanes, 4);
+        _mm_storeu_ps(lanes, _mm_add_ps(q0, q1));
+        sum_sq += lanes_sum_f32(lanes, 4);
+    }
+    float mins[4], maxs[4];
+    _mm_storeu_ps(mins, vmin);
+    _mm_storeu_ps(maxs, vmax);
+    lanes_minmax_f32(mins, maxs, 4, p);
+    p->sum = sum;
+    p->sum_sq = sum_sq;
+    f32_tail(x + i, n - i, shift, p);
+}
+
+static void i16_sse2(const int16_t *x, size_t n, i16_part_t *p) {
+    const __m128i ones = _mm_set1_epi16(1), zero = _mm_setzero_si128();
+    __m128i vmin = _mm_set1_epi16(x[0]), vmax = vmin;
+    __m128i q = zero;     // Two 64-bit lanes
+    int64_t sum = 0;
+    size_t i = 0;
+    while (i + 8 <= n) {
+        size_t end = i + I16_BLOCK < n ? i + I16_BLOCK : n;
+        __m128i s = zero;
+        for (; i + 8 <= end; i += 8) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(x + i));
+            vmin = _mm_min_epi16(vmin, v);
+            vmax = _mm_max_epi16(vmax, v);
+            s = _mm_add_epi32(s, _mm_madd_epi16(v, ones));
+            // Pairs of squares reach 2^31, so widen them as unsigned
+            __m128i sq = _mm_madd_epi16(v, v);
+            q = _mm_add_epi64(q, _mm_unpacklo_epi32(sq, zero));
+            q = _mm_add_epi64(q, _mm_unpackhi_epi32(sq, zero));
+        }
+        int32_t lanes[4];
+        _mm_storeu_si128((__m128i *)lanes, s);
+        sum += (int64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    int16_t mins[8], maxs[8];
+    uint64_t sq[2];
+    _mm_storeu_si128((__m128i *)mins, vmin);
+    _mm_storeu_si128((__m128i *)maxs, vmax);
+    _mm_storeu_si128((__m128i *)sq, q);
+    lanes_minmax_i16(mins, maxs, 8, p);
+    p->sum = sum;
+    p->sum_sq = sq[0] + sq[1];
+    i16_tail(x + i, n - i, p);
+}
+
+static const kernels_t sse2_kernels = { f32_sse2, i16_sse2 };
+
+// ---------------------------------------------------------------------------
+// AVX2 (compiled for it regardless of -march, run only if the CPU has it)
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static void f32_avx2(const float *x, size_t n, float shift, f32_part_t *p) {
+    __m256 vmin = _mm256_set1_ps(x[0]), vmax = vmin;
+    __m256 vshift = _mm256_set1_ps(shift);
+    double sum = 0, sum_sq = 0;
+    size_t i = 0;
+    while (i + 16 <= n) {
+        size_t end = i + F32_BLOCK < n ? i + F32_BLOCK : n;
+        __m256 s0 = _mm256_setzero_ps(), s1 = s0, q0 = s0, q1 = s0;
+        for (; i + 16 <= end; i += 16) {
+            __m256 a = _mm256_loadu_ps(x + i);
+            __m256 b = _mm256_loadu_ps(x + i + 8);
+            vmin = _mm256_min_ps(vmin, _mm256_min_ps(a, b));
+            vmax = _mm256_max_ps(vmax, _mm256_max_ps(a, b));
+            a = _mm256_sub_ps(a, vshift);
+            b = _mm256_sub_ps(b, vshift);
+            s0 = _mm256_add_ps(s0, a);
+            s1 = _mm256_add_ps(s1, b);
+            q0 = _mm256_add_ps(q0, _mm256_mul_ps(a, a));
+            q1 = _mm256_add_ps(q1, _mm256_mul_ps(b, b));
+        }
+        float lanes[8];
+        _mm256_storeu_ps(lanes, _mm256_add_ps(s0, s1));
+        sum += lanes_sum_f32(lanes, 8);
+        _mm256_storeu_ps(lanes, _mm256_add_ps(q0, q1));
+        sum_sq += lanes_sum_f32(lanes, 8);
+    }
+    float mins[8], maxs[8];
+    _mm256_storeu_ps(mins, vmin);
+    _mm256_storeu_ps(maxs, vmax);
+    lanes_minmax_f32(mins, maxs, 8, p);
+    p->sum = sum;
+    p->sum_sq = sum_sq;
+    f32_tail(x + i, n - i, shift, p);
+}
+
+__attribute__((target("avx2")))
+static void i16_avx2(const int16_t *x, size_t n, i16_part_t *p) {
+    const __m256i ones = _mm256_set1_epi16(1), zero = _mm256_setzero_si256();
+    __m256i vmin = _mm256_set1_epi16(x[0]), vmax = vmin;
+    __m256i q = zero;     // Four 64-bit lanes
+    int64_t sum = 0;
+    size_t i = 0;
+    while (i + 16 <= n) {
+        size_t end = i + I16_BLOCK < n ? i + I16_BLOCK : n;
+        __m256i s = zero;
+        for (; i + 16 <= end; i += 16) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(x + i));
+            vmin = _mm256_min_epi16(vmin, v);
+            vmax = _mm256_max_epi16(vmax, v);
+            s = _mm256_add_epi32(s, _mm256_madd_epi16(v, ones));
+            __m256i sq = _mm256_madd_epi16(v, v);
+            q = _mm256_add_epi64(q, _mm256_unpacklo_epi32(sq, zero));
+            q = _mm256_add_epi64(q, _mm256_unpackhi_epi32(sq, zero));
+        }
+        int32_t lanes[8];
+        _mm256_storeu_si256((__m256i *)lanes, s);
+        for (int l = 0; l < 8; l++) {
+            sum += lanes[l];
+        }
+    }
+    int16_t mins[16], maxs[16];
+    uint64_t sq[4];
+    _mm256_storeu_si256((__m256i *)mins, vmin);
+    _mm256_storeu_si256((__m256i *)maxs, vmax);
+    _mm256_storeu_si256((__m256i *)sq, q);
+    lanes_minmax_i16(mins, maxs, 16, p);
+    p->sum = sum;
+    p->sum_sq = sq[0] + sq[1] + sq[2] + sq[3];
+    i16_tail(x + i, n - i, p);
+}
+
+static const kernels_t avx2_kernels = { f32_avx2, i16_avx2 };
+
+#elif defined(__aarch64__)
+
+// ---------------------------------------------------------------------------
+// NEON (always present on AArch64)
+// ---------------------------------------------------------------------------
+
+static void f32_neon(const float *x, size_t n, float shift, f32_part_t *p) {
+    float32x4_t vmin = vdupq_n_f32(x[0]), vmax = vmin;
+    float32x4_t vshift = vdupq_n_f32(shift);
+    double sum = 0, sum_sq = 0;
+    size_t i = 0;
+    while (i + 8 <= n) {
+        size_t end = i + F32_BLOCK < n ? i + F32_BLOCK : n;
+        float32x4_t s0 = vdupq_n_f32(0), s1 = s0, q0 = s0, q1 = s0;
+        for (; i + 8 <= end; i += 8) {
+            float32x4_t a = vld1q_f32(x + i);
+            float32x4_t b = vld1q_f32(x + i + 4);
+            vmin = vminq_f32(vmin, vminq_f32(a, b));
+            vmax = vmaxq_f32(vmax, vmaxq_f32(a, b));
+            a = vsubq_f32(a, vshift);
+            b = vsubq_f32(b, vshift);
+            s0 = vaddq_f32(s0, a);
+            s1 = vaddq_f32(s1, b);
+            q0 = vmlaq_f32(q0, a, a);
+            q1 = vmlaq_f32(q1, b, b);
+        }
+        sum += vaddvq_f32(vaddq_f32(s0, s1));
+        sum_sq += vaddvq_f32(vaddq_f32(q0, q1));
+    }
+    p->min = vminvq_f32(vmin);
+    p->max = vmaxvq_f32(vmax);
+    p->sum = sum;
+    p->sum_sq = sum_sq;
+    f32_tail(x + i, n - i, shift, p);
+}
+
+static void i16_neon(const int16_t *x, size_t n, i16_part_t *p) {
+    int16x8_t vmin = vdupq_n_s16(x[0]), vmax = vmin;
+    uint64x2_t q = vdupq_n_u64(0);
+    int64_t sum = 0;
+    size_t i = 0;
+    while (i + 8 <= n) {
+        size_t end = i + I16_BLOCK < n ? i + I16_BLOCK : n;
+        int32x4_t s = vdupq_n_s32(0);
+        for (; i + 8 <= end; i += 8) {
+            int16x8_t v = vld1q_s16(x + i);
+            vmin = vminq_s16(vmin, v);
+            vmax = vmaxq_s16(vmax, v);
+            s = vpadalq_s16(s, v);
+            // Each square is at most 2^30, so it fits a 32-bit lane
+            int32x4_t lo = vmull_s16(vget_low_s16(v), vget_low_s16(v));
+            int32x4_t hi = vmull_high_s16(v, v);
+            q = vpadalq_u32(q, vreinterpretq_u32_s32(lo));
+            q = vpadalq_u32(q, vreinterpretq_u32_s32(hi));
+        }
+        sum += vaddlvq_s32(s);
+    }
+    p->min = vminvq_s16(vmin);
+    p->max = vmaxvq_s16(vmax);
+    p->sum = sum;
+    p->sum_sq = vaddvq_u64(q);
+    i16_tail(x + i, n - i, p);
+}
+
+static const kernels_t neon_kernels = { f32_neon, i16_neon };
+
+#endif
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+static const char *level_names[SIMD_LEVEL_COUNT] = { "scalar", "sse2", "avx2", "neon" };
+
+static pthread_once_t dispatch_once = PTHREAD_ONCE_INIT;
+static const kernels_t *kernels = &scalar_kernels;
+static simd_level_t active_level = SIMD_SCALAR;
+
+static const kernels_t *level_kernels(simd_level_t level) {
+    switch (level) {
+    case SIMD_SCALAR:
+        return &scalar_kernels;
+#if defined(__x86_64__)
+    case SIMD_SSE2:
+        return &sse2_kernels;
+    case SIMD_AVX2:
+        return __builtin_cpu_supports("avx2") ? &avx2_kernels : NULL;
+#elif defined(__aarch64__)
+    case SIMD_NEON:
+        return &neon_kernels;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+// Pick the widest kernel set the CPU runs
+static void pick_kernels(void) {
+    for (int level = SIMD_LEVEL_COUNT - 1; level >= 0; level--) {
+        const kernels_t *k = level_kernels((simd_level_t)level);
+        if (k) {
+            kernels = k;
+            active_level = (simd_level_t)level;
+            return;
+        }
+    }
+}
+
+static const kernels_t *get_kernels(void) {
+    pthread_once(&dispatch_once, pick_kernels);
+    return kernels;
+}
+
+simd_level_t simd_stats_level(void) {
+    get_kernels();
+    return active_level;
+}
+
+int simd_stats_supported(simd_level_t level) {
+    return level_kernels(level) != NULL;
+}
+
+int simd_stats_use(simd_level_t level) {
+    const kernels_t *k = level_kernels(level);
+    if (!k) {
+        return -1;
+    }
+    get_kernels();
+    kernels = k;
+    active_level = level;
+    return 0;
+}
+
+const char *simd_stats_level_name(simd_level_t level) {
+    if (level < 0 || level >= SIMD_LEVEL_COUNT) {
+        return "unknown";
+    }
+    return level_names[level];
+}
+
+// ---------------------------------------------------------------------------
+// Accumulators
+// ---------------------------------------------------------------------------
+
+void simd_stats_begin(simd_stats_acc_t *acc) {
+    *acc = (simd_stats_acc_t){ 0 };
+}
+
+void simd_stats_add_f32(simd_stats_acc_t *acc, const float *x, size_t n) {
+    if (n == 0) {
+        return;
+    }
+    if (acc->count == 0) {
+        acc->shift = acc->min = acc->max = x[0];
+    }
+    f32_part_t part;
+    get_kernels()->f32(x, n, acc->shift, &part);
+    if (part.min < acc->min) acc->min = part.min;
+    if (part.max > acc->max) acc->max = part.max;
+    acc->sum += part.sum;
+    acc->sum_sq += part.sum_sq;
+    acc->count += n;
+}
+
+void simd_stats_add_i16(simd_stats_acc_t *acc, const int16_t *x, size_t n, float scale) {
+    if (n == 0) {
+        return;
+    }
+    if (acc->count == 0) {
+        acc->shift = acc->min = acc->max = x[0] * scale;
+    }
+    i16_part_t part;
+    get_kernels()->i16(x, n, &part);
+
+    // A negative scale swaps which end is the minimum
+    float lo = part.min * scale, hi = part.max * scale;
+    if (lo > hi) {
+        float t = lo;
+        lo = hi;
+        hi = t;
+    }
+    if (lo < acc->min) acc->min = lo;
+    if (hi > acc->max) acc->max = hi;
+
+    // Center the integer sums on the first element, exactly (modulo 2^64, and
+    // the true values are small and non-negative), then take
+    // scale * x - shift = scale * (x - k) + e for the sums of the accumulator
+    uint64_t k = (uint64_t)(int64_t)x[0], cnt = n;
+    int64_t dsum = part.sum - (int64_t)(cnt * k);
+    uint64_t dsum_sq = part.sum_sq - 2 * k * (uint64_t)part.sum + cnt * k * k;
+    double s = scale, e = s * x[0] - acc->shift;
+    acc->sum += s * (double)dsum + (double)n * e;
+    acc->sum_sq += s * s * (double)dsum_sq + 2 * s * e * (double)dsum + (double)n * e * e;
+    acc->count += n;
+}
+
+void simd_stats_end(const simd_stats_acc_t *acc, simd_stats_t *out) {
+    *out = (simd_stats_t){ 0 };
+    if (acc->count == 0) {
+        return;
+    }
+    double mean = acc->sum / (double)acc->count;
+    double var = acc->sum_sq / (double)acc->count - mean * mean;
+    out->count = acc->count;
+    out->min = acc->min;
+    out->max = acc->max;
+    out->mean = acc->shift + mean;
+    out->stddev = var > 0 ? sqrt(var) : 0;
+}
+
+void simd_stats_f32(const float *x, size_t n, simd_stats_t *out) {
+    simd_stats_acc_t acc;
+    simd_stats_begin(&acc);
+    simd_stats_add_f32(&acc, x, n);
+    simd_stats_end(&acc, out);
+}
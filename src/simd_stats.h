@@ -0,0 +1,74 @@
+#ifndef SIMD_STATS_H
+#define SIMD_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Vectorized min/max/mean/stddev over temperature arrays.
+//
+// Float arrays and 16-bit fixed-point arrays (value = raw * scale, e.g.
+// centi-degrees as in binary logs) are reduced by SSE2 or AVX2 kernels on
+// x86-64 and NEON kernels on AArch64, picked at first use from what the CPU
+// supports; everything else runs the scalar reference. All kernels give the
+// same min, max and count and agree on mean and stddev to float rounding:
+// float kernels accumulate in float lanes relative to the first value, and
+// fold into double every few thousand elements, so long arrays do not lose
+// precision; fixed-point kernels sum exactly in integers.
+//
+// An accumulator can take several arrays (e.g. the two halves of a ring
+// buffer) before the statistics are read out.
+
+typedef enum {
+    SIMD_SCALAR = 0,
+    SIMD_SSE2,
+    SIMD_AVX2,
+    SIMD_NEON,
+    SIMD_LEVEL_COUNT
+} simd_level_t;
+
+typedef struct {
+    size_t count;
+    float min;
+    float max;
+    double mean;
+    double stddev;      // Population standard deviation
+} simd_stats_t;
+
+typedef struct {
+    size_t count;
+    float min;
+    float max;
+    float shift;        // First value added; sums are relative to it
+    double sum;         // Sum of (x - shift)
+    double sum_sq;      // Sum of (x - shift)^2
+} simd_stats_acc_t;
+
+// Start an empty accumulator
+void simd_stats_begin(simd_stats_acc_t *acc);
+
+// Add n float values
+void simd_stats_add_f32(simd_stats_acc_t *acc, const float *x, size_t n);
+
+// Add n fixed-point values, each standing for x[i] * scale
+void simd_stats_add_i16(simd_stats_acc_t *acc, const int16_t *x, size_t n, float scale);
+
+// Read out the statistics. All fields are 0 if nothing was added.
+void simd_stats_end(const simd_stats_acc_t *acc, simd_stats_t *out);
+
+// Statistics of one float array in one call
+void simd_stats_f32(const float *x, size_t n, simd_stats_t *out);
+
+// Kernel set in use
+simd_level_t simd_stats_level(void);
+
+// Whether this build and CPU can run a kernel set
+int simd_stats_supported(simd_level_t level);
+
+// Switch kernel sets, for tests and benchmarks. Returns 0 on success, -1 if
+// the level is not supported. Not thread-safe against concurrent reductions.
+int simd_stats_use(simd_level_t level);
+
+// "scalar", "sse2", "avx2" or "neon"
+const char *simd_stats_level_name(simd_level_t level);
+
+#endif // SIMD_STATS_H
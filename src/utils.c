@@ -1,5 +1,9 @@
 #include "utils.h"
 #include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
 
 // Global exit flag using C11 atomics for proper thread safety
 static atomic_int exit_flag = ATOMIC_VAR_INIT(0);
@@ -19,6 +23,97 @@ void set_exit_flag(void) {
 // Instantiate the global sensor queue
 queue_t sensor_queue;
 
-// Instantiate latest_reading and latest_mutex
-latest_reading_t latest_reading = { "", 0.0f, 0.0f, 0.0f };
-pthread_mutex_t latest_mutex = PTHREAD_MUTEX_INITIALIZER;
\ No newline at end of file
+// The latest reading is published through a seqlock. The sequence is odd
+// while the writer is copying a new value in; a reader copies the words out and
+// retries if the sequence was odd or changed meanwhile. The payload is held in
+// atomic words (accessed relaxed, ordered by fences) so concurrent copies are
+// not data races; 32-bit words keep them lock-free on 32-bit ARM as well.
+// Only the words covering the sensors in use are copied, so a two-sensor
+// reading costs the same however large CONFIG_MAX_SENSORS is.
+#define LATEST_WORDS ((sizeof(latest_reading_t) + sizeof(uint32_t) - 1) / sizeof(uint32_t))
+
+static atomic_ulong latest_seq = ATOMIC_VAR_INIT(0);
+static _Atomic uint32_t latest_words[LATEST_WORDS];
+static atomic_size_t latest_len = ATOMIC_VAR_INIT(LATEST_WORDS);  // Words in use
+
+_Static_assert(LATEST_READING_SIZE(0) % sizeof(uint32_t) == 0, "latest reading is not word-sized");
+
+// Words of a reading that carry data
+static size_t used_words(int sensor_count) {
+    if (sensor_count < 0) sensor_count = 0;
+    if (sensor_count > CONFIG_MAX_SENSORS) sensor_count = CONFIG_MAX_SENSORS;
+    return LATEST_READING_SIZE(sensor_count) / sizeof(uint32_t);
+}
+
+static atomic_int notify_fd = ATOMIC_VAR_INIT(-1);
+static atomic_int notify_pending = ATOMIC_VAR_INIT(0);
+
+void latest_reading_publish(const latest_reading_t *reading) {
+    size_t len = used_words(reading->sensor_count);
+    uint32_t words[LATEST_WORDS];
+    memcpy(words, reading, len * sizeof(uint32_t));
+
+    unsigned long seq = atomic_load_explicit(&latest_seq, memory_order_relaxed);
+    atomic_store_explicit(&latest_seq, seq + 1, memory_order_relaxed);
+    // Readers that see any of the new words must also see the odd sequence
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&latest_len, len, memory_order_relaxed);
+    for (size_t i = 0; i < len; i++) {
+        atomic_store_explicit(&latest_words[i], words[i], memory_order_relaxed);
+    }
+    atomic_store_explicit(&latest_seq, seq + 2, memory_order_release);
+
+    // Pairs with the fence in latest_reading_notify_ack: either we see the ack
+    // and signal, or the consumer sees the new sequence after acking
+    atomic_thread_fence(memory_order_seq_cst);
+    int fd = atomic_load_explicit(&notify_fd, memory_order_acquire);
+    if (fd >= 0 && !atomic_exchange_explicit(&notify_pending, 1, memory_order_acq_rel)) {
+        uint64_t one = 1;
+        ssize_t n = write(fd, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+unsigned long latest_reading_read(latest_reading_t *out) {
+    uint32_t words[LATEST_WORDS];
+    size_t len;
+    unsigned long begin, end;
+    for (;;) {
+        begin = atomic_load_explicit(&latest_seq, memory_order_acquire);
+        if (begin & 1) {
+            // Writer mid-update; on a single core it cannot finish until we yield
+            sched_yield();
+            continue;
+        }
+        len = atomic_load_explicit(&latest_len, memory_order_relaxed);
+        for (size_t i = 0; i < len; i++) {
+            words[i] = atomic_load_explicit(&latest_words[i], memory_order_relaxed);
+        }
+        // Order the copy before the second sequence check
+        atomic_thread_fence(memory_order_acquire);
+        end = atomic_load_explicit(&latest_seq, memory_order_relaxed);
+        if (begin == end) {
+            break;
+        }
+    }
+
+    memcpy(out, words, len * sizeof(uint32_t));
+    return begin / 2;
+}
+
+unsigned long latest_reading_version(void) {
+    return atomic_load_explicit(&latest_seq, memory_order_acquire) / 2;
+}
+
+void latest_reading_set_notify_fd(int fd) {
+    atomic_store_explicit(&notify_pending, 0, memory_order_relaxed);
+    atomic_store_explicit(&notify_fd, fd, memory_order_release);
+    // Same pairing as latest_reading_notify_ack, for a consumer that checks the
+    // version right after registering
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+void latest_reading_notify_ack(void) {
+    atomic_store_explicit(&notify_pending, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+}
@@ -3,23 +3,49 @@
 
 #include <pthread.h>
 #include <stdatomic.h>
+#include <stddef.h>
 #include "queue.h"
+#include "config.h"
 
 // Global shared sensor data queue
 extern queue_t sensor_queue;
 
-// Latest reading structure for network monitoring
+// Latest reading structure for network monitoring. Only the first
+// sensor_count entries of sensors[] are published and read back.
 typedef struct {
     char time_str[64];
-    float sensor1;
-    float sensor2;
-    float average;
+    float average;                      // Mean of the live sensors, -999 if none
+    int sensor_count;                   // Entries in use (the highest sensor id)
+    float sensors[CONFIG_MAX_SENSORS];  // Indexed by sensor id - 1, -999 if unavailable
 } latest_reading_t;
 
-// Global variable for the latest processed sensor reading
-extern latest_reading_t latest_reading;
-// Mutex to protect latest_reading
-extern pthread_mutex_t latest_mutex;
+// Bytes of a latest_reading_t that carry data
+#define LATEST_READING_SIZE(count) \
+    (offsetof(latest_reading_t, sensors) + (size_t)(count) * sizeof(float))
+
+// Publish a new latest reading. Single writer (the processor); never waits
+// for readers.
+void latest_reading_publish(const latest_reading_t *reading);
+
+// Copy a consistent snapshot of the latest reading into out. Never blocks the
+// writer; retries only if an update lands mid-copy. Entries of out->sensors
+// past out->sensor_count are left untouched. Returns the snapshot's version
+// (the number of publishes so far).
+unsigned long latest_reading_read(latest_reading_t *out);
+
+// Version of the latest reading, without copying it. Changes on every publish,
+// so readers can tell whether anything derived from a snapshot is still current.
+unsigned long latest_reading_version(void);
+
+// Have latest_reading_publish signal an eventfd after each publish (-1 to stop).
+// Signals are coalesced: after one write, no more are sent until the consumer
+// calls latest_reading_notify_ack, so the publisher pays at most one write(2)
+// per consumer wakeup and nothing while no fd is set. A publish that a
+// latest_reading_version call made after this returns does not see will signal fd.
+void latest_reading_set_notify_fd(int fd);
+
+// Re-arm notifications. Call before reading the new version so no publish is missed.
+void latest_reading_notify_ack(void);
 
 // Initialize utilities and global flags
 void init_utils(void);
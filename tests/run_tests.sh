@@ -43,6 +43,18 @@ run_test() {
 run_test "test_utils"
 run_test "test_config"
 run_test "test_queue"
+run_test "test_log_writer"
+run_test "test_binlog"
+run_test "test_log_segment"
+run_test "test_history"
+run_test "test_latency"
+run_test "test_sensor"
+run_test "test_i2c_bus"
+run_test "test_fusion"
+run_test "test_filter"
+run_test "test_simd_stats"
+run_test "test_quantile"
+run_test "test_rules"
 
 echo ""
 echo "================================"
@@ -0,0 +1,143 @@
+#include "../src/binlog.h"
+#include "../src/log_writer.h"
+#include "../src/config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+
+void test_binlog_centi() {
+    printf("Testing fixed-point conversion...\n");
+
+    assert(binlog_to_centi(23.5f) == 2350);
+    assert(binlog_to_centi(-12.0625f) == -1206);
+    assert(binlog_to_centi(0.004f) == 0);
+    assert(binlog_to_centi(1000.0f) == INT16_MAX);
+    assert(binlog_to_centi(-1000.0f) == INT16_MIN);
+    assert(binlog_from_centi(2425) == 24.25f);
+
+    printf("  PASSED\n");
+}
+
+void test_binlog_encode_reading() {
+    printf("Testing binlog_encode_reading...\n");
+
+    binlog_header_t header;
+    binlog_header_init(&header, 2, 1000);
+    assert(binlog_header_check(&header) == 0);
+
+    binlog_record_t out;
+
+    // A single reading from any sensor id is a row of its own
+    binlog_encode_reading(&header, 1012, 200, -5.5f, &out);
+    assert(out.time_offset == 12);
+    assert(out.sensor_id == 200);
+    assert(out.flags == (BINLOG_FLAG_VALID | BINLOG_FLAG_ROW_START));
+    assert(out.temp_centi == -550);
+    assert(binlog_record_time(&header, &out) == 1012);
+
+    // Timestamps before the base time are pinned to it
+    binlog_encode_reading(&header, 900, 1, 23.5f, &out);
+    assert(out.time_offset == 0);
+    assert(out.temp_centi == 2350);
+
+    // Corrupt headers are rejected
+    header.version = BINLOG_VERSION + 1;
+    assert(binlog_header_check(&header) == -1);
+
+    printf("  PASSED\n");
+}
+
+void test_binlog_writer_reader() {
+    printf("Testing binary log writer and mmap reader...\n");
+
+    char path[] = "/tmp/test_binlog_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    config_load_defaults();
+    g_config.log_format = LOG_FORMAT_BINARY;
+
+    assert(log_writer_start(path) == 0);
+    time_t now = time(NULL);
+    log_record_t first = { .timestamp = now, .sensor_id = 1, .temperature = 23.5f };
+    log_record_t second = { .timestamp = now, .sensor_id = 2, .temperature = 24.25f };
+    log_record_t third = { .timestamp = now + 1, .sensor_id = 1, .temperature = 21.0f };
+    assert(log_writer_append(&first) == 0);
+    assert(log_writer_append(&second) == 0);
+    assert(log_writer_append(&third) == 0);
+    log_writer_stop();
+
+    // Reopening appends to the same file without a second header
+    assert(log_writer_start(path) == 0);
+    assert(log_writer_append(&first) == 0);
+    log_writer_stop();
+
+    binlog_reader_t reader;
+    assert(binlog_open(path, &reader) == 0);
+    assert(reader.header->sensor_count == 2);
+    assert(reader.count == 4);
+    for (size_t i = 0; i < reader.count; i++) {
+        // Every reading is a row of its own
+        assert(reader.records[i].flags == (BINLOG_FLAG_VALID | BINLOG_FLAG_ROW_START));
+    }
+    assert(reader.records[1].sensor_id == 2);
+    assert(reader.records[1].temp_centi == 2425);
+    assert(reader.records[2].sensor_id == 1);
+    assert(binlog_record_time(reader.header, &reader.records[2]) == now + 1);
+    binlog_close(&reader);
+
+    unlink(path);
+    printf("  PASSED\n");
+}
+
+void test_binlog_writer_rows() {
+    printf("Testing binary log rows of several records...\n");
+
+    char path[] = "/tmp/test_binlog_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    config_load_defaults();
+    g_config.log_format = LOG_FORMAT_BINARY;
+
+    assert(log_writer_start(path) == 0);
+    time_t now = time(NULL);
+    log_record_t row[2] = {
+        { .timestamp = now, .sensor_id = 1, .temperature = 23.5f },
+        { .timestamp = now, .sensor_id = 2, .temperature = 24.25f },
+    };
+    assert(log_writer_append_row(row, 2) == 0);
+    assert(log_writer_append_row(row, 2) == 0);
+    log_writer_stop();
+
+    binlog_reader_t reader;
+    assert(binlog_open(path, &reader) == 0);
+    assert(reader.count == 4);
+    // Only the first record of each row starts it
+    for (size_t i = 0; i < reader.count; i++) {
+        uint8_t expected = i % 2 == 0 ? (BINLOG_FLAG_VALID | BINLOG_FLAG_ROW_START)
+                                      : BINLOG_FLAG_VALID;
+        assert(reader.records[i].flags == expected);
+        assert(reader.records[i].sensor_id == i % 2 + 1);
+    }
+    binlog_close(&reader);
+
+    unlink(path);
+    printf("  PASSED\n");
+}
+
+int main(void) {
+    printf("\n=== Binary Log Tests ===\n");
+
+    test_binlog_centi();
+    test_binlog_encode_reading();
+    test_binlog_writer_reader();
+    test_binlog_writer_rows();
+
+    printf("\nAll binary log tests passed!\n\n");
+    return 0;
+}
@@ -1,22 +1,50 @@
 #include "../src/config.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <unistd.h>
 
 void test_config_defaults() {
     printf("Testing config_load_defaults...\n");
     config_load_defaults();
 
-    assert(strcmp(g_config.i2c_device, "/dev/i2c-1") == 0);
-    assert(g_config.sensor1_address == 0x48);
-    assert(g_config.sensor1_interval == 1);
-    assert(g_config.sensor2_address == 0x49);
-    assert(g_config.sensor2_interval == 2);
+    assert(strcmp(g_config.buses[0].device, "/dev/i2c-1") == 0);
+    assert(g_config.buses[0].cpu == -1);
+    assert(g_config.buses[1].device[0] == '\0');
+    assert(g_config.sensors[0].bus == 0 && g_config.sensors[1].bus == 0);
+    assert(g_config.sensor_count == 2);
+    assert(g_config.sensor_max_id == 2);
+    assert(g_config.sensors[0].id == 1);
+    assert(g_config.sensors[0].address == 0x48);
+    assert(g_config.sensors[0].interval_ms == 1000);
+    assert(g_config.sensors[1].id == 2);
+    assert(g_config.sensors[1].address == 0x49);
+    assert(g_config.sensors[1].interval_ms == 2000);
     assert(g_config.sensor_timeout == 10);
     assert(g_config.network_port == 8080);
     assert(g_config.network_backlog == 5);
+    assert(g_config.network_max_connections == 128);
+    assert(g_config.network_idle_timeout_ms == 10000);
     assert(g_config.queue_max_size == 100);
+    assert(g_config.processor_min_period_ms == 0);
+    assert(g_config.processor_window_ms == 1000);
     assert(strcmp(g_config.log_file, "sensor_log.csv") == 0);
+    assert(g_config.log_format == LOG_FORMAT_CSV);
+    assert(g_config.log_buffer_records == 1024);
+    assert(g_config.log_flush_records == 64);
+    assert(g_config.log_flush_interval_ms == 1000);
+    assert(g_config.log_fsync_on_rotate == 0);
+    assert(g_config.log_segment_max_bytes == 0);
+    assert(g_config.log_segment_interval_s == 0);
+    assert(g_config.log_retention_segments == 0);
+    assert(g_config.log_retention_s == 0);
+    assert(g_config.history_raw_samples == 3600);
+    assert(g_config.history_seconds == 3600);
+    assert(g_config.history_minutes == 1440);
+    assert(g_config.history_hours == 168);
+    assert(g_config.alerts_rules_file[0] == '\0');
+    assert(strcmp(g_config.alerts_log_file, "alerts.log") == 0);
 
     printf("  PASSED\n");
 }
@@ -31,11 +59,11 @@ void test_config_load() {
     // If file doesn't exist (result == -1), defaults should be loaded
     if (result == 0) {
         // File loaded successfully, check it has valid configuration
-        assert(g_config.sensor1_address == 0x48);  // Verify expected value from config.ini
+        assert(g_config.sensors[0].address == 0x48);  // Verify expected value from config.ini
         assert(g_config.network_port > 0 && g_config.network_port <= 65535);
     } else {
         // File not found, defaults should be loaded
-        assert(g_config.sensor1_address == 0x48);  // Default value
+        assert(g_config.sensors[0].address == 0x48);  // Default value
         assert(g_config.network_port == 8080);     // Default value
     }
 
@@ -50,11 +78,11 @@ void test_config_validation() {
 
     // Test invalid sensor interval (should fail validation)
     config_load_defaults();
-    g_config.sensor1_interval = -1;  // Invalid
+    g_config.sensors[0].interval_ms = -1;  // Invalid
     // Note: We can't directly test validate_config as it's static,
     // but we can verify defaults are sane
     config_load_defaults();
-    assert(g_config.sensor1_interval > 0);
+    assert(g_config.sensors[0].interval_ms > 0);
 
     // Test invalid port (should fail validation)
     config_load_defaults();
@@ -66,12 +94,185 @@ void test_config_validation() {
     printf("  PASSED\n");
 }
 
+// Write text to a temporary config file and load it
+static int load_text(const char *text) {
+    char path[] = "/tmp/test_config_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    assert(write(fd, text, strlen(text)) == (ssize_t)strlen(text));
+    close(fd);
+    int result = config_load(path);
+    unlink(path);
+    return result;
+}
+
+void test_config_sensor_sections() {
+    printf("Testing [sensor.N] sections...\n");
+
+    // Sections replace the default sensors and are sorted by id
+    assert(load_text("[sensor.3]\n"
+                     "address = 0x4a\n"
+                     "interval = 5\n"
+                     "name = Rack A inlet\n"
+                     "[sensor.0]\n"          // Invalid id: ignored
+                     "address = 0x10\n"
+                     "[sensor.1]\n"
+                     "address = 0x48\n") == 0);
+    assert(g_config.sensor_count == 2);
+    assert(g_config.sensor_max_id == 3);
+    assert(g_config.sensors[0].id == 1 && g_config.sensors[0].interval_ms == 1000);
+    assert(g_config.sensors[1].id == 3 && g_config.sensors[1].address == 0x4a);
+    assert(g_config.sensors[1].interval_ms == 5000);
+    assert(strcmp(g_config.sensors[1].name, "Rack A inlet") == 0);
+    assert(config_find_sensor(3) == &g_config.sensors[1]);
+    assert(config_find_sensor(2) == NULL);
+
+    // Legacy sensorN_* keys still configure the sensor table
+    assert(load_text("[sensors]\n"
+                     "sensor1_address = 0x4b\n"
+                     "sensor3_address = 0x4c\n"
+                     "sensor3_interval = 4\n") == 0);
+    assert(g_config.sensor_count == 3);
+    assert(g_config.sensors[0].address == 0x4b);
+    assert(g_config.sensors[1].address == 0x49);
+    assert(g_config.sensors[2].id == 3 && g_config.sensors[2].interval_ms == 4000);
+
+    // interval_ms allows sub-second rates and wins over interval when later
+    assert(load_text("[sensor.1]\n"
+                     "address = 0x48\n"
+                     "interval = 1\n"
+                     "interval_ms = 125\n"
+                     "[sensor.2]\n"
+                     "address = 0x49\n"
+                     "interval = 9999999\n") == 0);   // Too many ms: default kept
+    assert(g_config.sensors[0].interval_ms == 125);
+    assert(g_config.sensors[1].interval_ms == 1000);
+    assert(load_text("[sensor.1]\n"
+                     "address = 0x48\n"
+                     "interval_ms = 0\n") == -1);
+
+    // [bus.N] sections add adapters; sensors pick one with bus =
+    assert(load_text("[sensors]\n"
+                     "i2c_device = /dev/i2c-0\n"
+                     "[bus.2]\n"
+                     "device = /dev/i2c-3\n"
+                     "cpu = 1\n"
+                     "[sensor.1]\n"
+                     "address = 0x48\n"
+                     "[sensor.2]\n"
+                     "address = 0x48\n"   // Same address, other bus
+                     "bus = 2\n") == 0);
+    assert(strcmp(g_config.buses[0].device, "/dev/i2c-0") == 0);
+    assert(strcmp(g_config.buses[2].device, "/dev/i2c-3") == 0 && g_config.buses[2].cpu == 1);
+    assert(g_config.sensors[1].bus == 2);
+    assert(config_bus_sensor_count(0) == 1 && config_bus_sensor_count(2) == 1);
+    assert(config_bus_sensor_count(1) == 0);
+
+    // A bus without a device, or two buses on one device, fail validation
+    assert(load_text("[sensor.1]\n"
+                     "address = 0x48\n"
+                     "bus = 1\n") == -1);
+    assert(load_text("[bus.1]\n"
+                     "device = /dev/i2c-1\n"
+                     "[sensor.1]\n"
+                     "address = 0x48\n"
+                     "[sensor.2]\n"
+                     "address = 0x49\n"
+                     "bus = 1\n") == -1);
+
+    // Two sensors on one address fail validation and fall back to defaults
+    assert(load_text("[sensor.1]\n"
+                     "address = 0x48\n"
+                     "[sensor.2]\n"
+                     "address = 0x48\n") == -1);
+    assert(g_config.sensor_count == 2 && g_config.sensors[1].address == 0x49);
+
+    printf("  PASSED\n");
+}
+
+void test_config_filters() {
+    printf("Testing sensor filter chains...\n");
+
+    assert(load_text("[sensor.1]\n"
+                     "address = 0x48\n"
+                     "filter = spike:2.5, median:5,ewma:0.3 , slew:1\n"
+                     "[sensor.2]\n"
+                     "address = 0x49\n"
+                     "filter = none\n") == 0);
+    const sensor_config_t *sensor = &g_config.sensors[0];
+    assert(sensor->filter_count == 4);
+    assert(sensor->filters[0].type == FILTER_SPIKE && sensor->filters[0].param == 2.5f);
+    assert(sensor->filters[1].type == FILTER_MEDIAN && sensor->filters[1].param == 5);
+    assert(sensor->filters[2].type == FILTER_EWMA && sensor->filters[2].param == 0.3f);
+    assert(sensor->filters[3].type == FILTER_SLEW && sensor->filters[3].param == 1);
+    assert(g_config.sensors[1].filter_count == 0);
+
+    // Bad chains are ignored as a whole and the sensor runs unfiltered
+    const char *bad[] = {
+        "median:0", "median:32", "median:2.5", "ewma:0", "ewma:1.5", "spike:-1",
+        "slew", "lowpass:3", "median:5, ewma:x", "ewma:1,ewma:1,ewma:1,ewma:1,ewma:1",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        char text[256];
+        snprintf(text, sizeof(text), "[sensor.1]\naddress = 0x48\nfilter = %s\n", bad[i]);
+        assert(load_text(text) == 0);
+        assert(g_config.sensors[0].filter_count == 0);
+    }
+
+    printf("  PASSED\n");
+}
+
+void test_config_processor() {
+    printf("Testing [processor] section...\n");
+
+    assert(load_text("[processor]\n"
+                     "window_ms = 250\n") == 0);
+    assert(g_config.processor_window_ms == 250);
+    assert(load_text("[processor]\n"
+                     "window_ms = 0\n") == 0);
+    assert(g_config.processor_window_ms == 0);
+    assert(load_text("[processor]\n"
+                     "window_ms = -1\n") == -1);
+
+    // A row of every sensor must fit in one writer buffer, fused or not
+    assert(load_text("[processor]\n"
+                     "window_ms = 1000\n"
+                     "[logging]\n"
+                     "buffer_records = 1\n") == -1);
+    assert(load_text("[processor]\n"
+                     "window_ms = 0\n"
+                     "[logging]\n"
+                     "buffer_records = 1\n") == -1);
+    assert(load_text("[processor]\n"
+                     "window_ms = 0\n"
+                     "[logging]\n"
+                     "buffer_records = 3\n") == 0);
+
+    printf("  PASSED\n");
+}
+
+void test_config_alerts() {
+    printf("Testing [alerts] section...\n");
+
+    assert(load_text("[alerts]\n"
+                     "rules_file = /etc/sensorhub/alerts.rules\n"
+                     "log_file =\n") == 0);
+    assert(strcmp(g_config.alerts_rules_file, "/etc/sensorhub/alerts.rules") == 0);
+    assert(g_config.alerts_log_file[0] == '\0');
+
+    printf("  PASSED\n");
+}
+
 int main(void) {
     printf("\n=== Config Tests ===\n");
 
     test_config_defaults();
     test_config_load();
     test_config_validation();
+    test_config_sensor_sections();
+    test_config_filters();
+    test_config_processor();
+    test_config_alerts();
 
     printf("\nAll config tests passed!\n\n");
     return 0;
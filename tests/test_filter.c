@@ -0,0 +1,215 @@
+#include "../src/filter.h"
+#include <stdio.h>
+#include <assert.h>
+#include <math.h>
+
+// TMP102 at 1 Hz on a board with a flaky I2C cable, slowly warming up. The
+// glitches are what the bus returned on bad reads: 0x000 (0 °C), 0x7FF
+// (127.94 °C) and 0xFFF (-0.06 °C), once twice in a row.
+static const float trace_glitches[] = {
+    22.5000f, 22.5625f, 22.5000f, 22.5625f, 22.5625f, 0.0000f,  22.6250f, 22.5625f,
+    22.6250f, 22.6250f, 127.9375f, 22.6875f, 22.6250f, 22.6875f, 22.7500f, 22.6875f,
+    22.7500f, -0.0625f, 22.7500f, 22.8125f, 22.7500f, 22.8125f, 22.8750f, 22.8125f,
+    22.8750f, 22.8750f, 0.0000f,  0.0000f,  22.9375f, 22.8750f, 22.9375f, 23.0000f,
+    22.9375f, 23.0000f,
+};
+static const int glitch_index[] = { 5, 10, 17, 26, 27 };
+
+// The same sensor when a door opens: a real 4.5 °C drop that stays
+static const float trace_step[] = {
+    22.5000f, 22.5625f, 22.5000f, 22.5625f, 18.0625f, 18.0000f, 18.0625f, 18.0000f,
+    17.9375f, 18.0000f,
+};
+
+#define TRACE_LEN(t) ((int)(sizeof(t) / sizeof((t)[0])))
+
+static int is_glitch(int i) {
+    for (int g = 0; g < TRACE_LEN(glitch_index); g++) {
+        if (glitch_index[g] == i) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// The true level at sample i: the sample itself, or the last good one before a glitch
+static float true_level(int i) {
+    while (is_glitch(i)) {
+        i--;
+    }
+    return trace_glitches[i];
+}
+
+void test_filter_passthrough() {
+    printf("Testing an empty filter chain...\n");
+
+    filter_chain_t chain;
+    filter_chain_init(&chain, NULL, 0);
+    for (int i = 0; i < TRACE_LEN(trace_glitches); i++) {
+        float value = trace_glitches[i];
+        assert(filter_chain_apply(&chain, (uint64_t)i * 1000, &value) == 0);
+        assert(value == trace_glitches[i]);
+    }
+
+    printf("  PASSED\n");
+}
+
+void test_filter_median() {
+    printf("Testing median filter on a glitchy trace...\n");
+
+    filter_spec_t spec = { .type = FILTER_MEDIAN, .param = 5 };
+    filter_chain_t chain;
+    filter_chain_init(&chain, &spec, 1);
+
+    // Until the window fills, the median is over what has been seen
+    float value = 1.0f;
+    filter_chain_apply(&chain, 0, &value);
+    assert(value == 1.0f);
+    value = 3.0f;
+    filter_chain_apply(&chain, 1000, &value);
+    assert(value == 2.0f);
+    filter_chain_reset(&chain);
+
+    float worst = 0;
+    for (int i = 0; i < TRACE_LEN(trace_glitches); i++) {
+        float value = trace_glitches[i];
+        assert(filter_chain_apply(&chain, (uint64_t)i * 1000, &value) == 0);
+        float error = fabsf(value - true_level(i));
+        if (error > worst) {
+            worst = error;
+        }
+    }
+    // Every glitch, even two in a row, is gone; what is left is lag on the ramp
+    assert(worst <= 0.1251f);
+
+    printf("  PASSED\n");
+}
+
+void test_filter_spike() {
+    printf("Testing spike rejection...\n");
+
+    filter_spec_t spec = { .type = FILTER_SPIKE, .param = 1.0f };
+    filter_chain_t chain;
+    filter_chain_init(&chain, &spec, 1);
+
+    // Exactly the glitches are rejected; the rest pass unchanged
+    for (int i = 0; i < TRACE_LEN(trace_glitches); i++) {
+        float value = trace_glitches[i];
+        int rc = filter_chain_apply(&chain, (uint64_t)i * 1000, &value);
+        if (is_glitch(i)) {
+            assert(rc == -1);
+        } else {
+            assert(rc == 0 && value == trace_glitches[i]);
+        }
+    }
+
+    // A real step is held back FILTER_SPIKE_MAX_REJECTS samples, then followed
+    filter_chain_reset(&chain);
+    int rejected = 0;
+    for (int i = 0; i < TRACE_LEN(trace_step); i++) {
+        float value = trace_step[i];
+        if (filter_chain_apply(&chain, (uint64_t)i * 1000, &value) != 0) {
+            rejected++;
+            assert(i >= 4 && i < 4 + FILTER_SPIKE_MAX_REJECTS);
+        } else if (i >= 4) {
+            assert(value == trace_step[i]);
+        }
+    }
+    assert(rejected == FILTER_SPIKE_MAX_REJECTS);
+
+    printf("  PASSED\n");
+}
+
+void test_filter_ewma() {
+    printf("Testing EWMA filter...\n");
+
+    filter_spec_t spec = { .type = FILTER_EWMA, .param = 0.5f };
+    filter_chain_t chain;
+    filter_chain_init(&chain, &spec, 1);
+
+    const float in[] = { 0.0f, 10.0f, 10.0f, 10.0f };
+    const float out[] = { 0.0f, 5.0f, 7.5f, 8.75f };
+    for (int i = 0; i < 4; i++) {
+        float value = in[i];
+        assert(filter_chain_apply(&chain, (uint64_t)i * 1000, &value) == 0);
+        assert(fabsf(value - out[i]) < 1e-6f);
+    }
+
+    printf("  PASSED\n");
+}
+
+void test_filter_slew() {
+    printf("Testing slew rate limit...\n");
+
+    filter_spec_t spec = { .type = FILTER_SLEW, .param = 0.5f };   // °C per second
+    filter_chain_t chain;
+    filter_chain_init(&chain, &spec, 1);
+
+    float value = 20.0f;
+    filter_chain_apply(&chain, 0, &value);
+    assert(value == 20.0f);
+    value = 30.0f;
+    filter_chain_apply(&chain, 1000, &value);
+    assert(fabsf(value - 20.5f) < 1e-6f);
+    value = 30.0f;
+    filter_chain_apply(&chain, 3000, &value);
+    assert(fabsf(value - 21.5f) < 1e-6f);
+
+    // No time has passed (or it went backwards): no movement at all
+    value = 10.0f;
+    filter_chain_apply(&chain, 3000, &value);
+    assert(fabsf(value - 21.5f) < 1e-6f);
+    value = 10.0f;
+    filter_chain_apply(&chain, 2000, &value);
+    assert(fabsf(value - 21.5f) < 1e-6f);
+
+    // Small changes pass through
+    value = 21.25f;
+    filter_chain_apply(&chain, 4000, &value);
+    assert(value == 21.25f);
+
+    printf("  PASSED\n");
+}
+
+void test_filter_chain() {
+    printf("Testing a full chain on a glitchy trace...\n");
+
+    filter_spec_t specs[] = {
+        { .type = FILTER_SPIKE, .param = 1.0f },
+        { .type = FILTER_MEDIAN, .param = 3 },
+        { .type = FILTER_EWMA, .param = 0.5f },
+        { .type = FILTER_SLEW, .param = 0.5f },
+    };
+    filter_chain_t chain;
+    filter_chain_init(&chain, specs, 4);
+
+    int passed = 0;
+    float raw_worst = 0, worst = 0;
+    for (int i = 0; i < TRACE_LEN(trace_glitches); i++) {
+        float value = trace_glitches[i];
+        raw_worst = fmaxf(raw_worst, fabsf(value - true_level(i)));
+        if (filter_chain_apply(&chain, (uint64_t)i * 1000, &value) == 0) {
+            passed++;
+            worst = fmaxf(worst, fabsf(value - true_level(i)));
+        }
+    }
+    assert(passed == TRACE_LEN(trace_glitches) - TRACE_LEN(glitch_index));
+    assert(raw_worst > 100.0f);
+    assert(worst < 0.15f);
+
+    printf("  PASSED\n");
+}
+
+int main(void) {
+    printf("\n=== Filter Tests ===\n");
+
+    test_filter_passthrough();
+    test_filter_median();
+    test_filter_spike();
+    test_filter_ewma();
+    test_filter_slew();
+    test_filter_chain();
+
+    printf("\nAll filter tests passed!\n\n");
+    return 0;
+}
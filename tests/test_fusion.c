@@ -0,0 +1,194 @@
+#include "../src/fusion.h"
+#include <stdio.h>
+#include <assert.h>
+#include <math.h>
+
+#define MAX_RECORDS 64
+
+static fusion_record_t records[MAX_RECORDS];
+static int record_count;
+
+static void collect(const fusion_record_t *record, void *ctx) {
+    (void)ctx;
+    assert(record_count < MAX_RECORDS);
+    records[record_count++] = *record;
+}
+
+static int near(float a, float b) {
+    return fabsf(a - b) < 0.001f;
+}
+
+void test_fusion_window() {
+    printf("Testing one record per window...\n");
+
+    fusion_t f;
+    record_count = 0;
+    assert(fusion_init(&f, 2, 1000, 10000, collect, NULL) == 0);
+    assert(fusion_next_close_ms(&f) == 0);
+
+    assert(fusion_add(&f, 1, 1000, 20.0f) == 0);
+    assert(fusion_add(&f, 2, 1200, 30.0f) == 0);
+    assert(fusion_add(&f, 1, 1500, 22.0f) == 0);
+    assert(fusion_next_close_ms(&f) == 2000);
+
+    // Nothing closes before the window has ended
+    fusion_advance(&f, 1999);
+    assert(record_count == 0);
+    fusion_advance(&f, 2000);
+    assert(record_count == 1);
+
+    fusion_record_t *r = &records[0];
+    assert(r->start_ms == 1000);
+    assert(r->sensor_count == 2);
+    assert(r->fresh == 2 && r->carried == 0);
+    assert(near(r->values[0], 21.0f));
+    assert(near(r->values[1], 30.0f));
+    assert(r->sources[0] == FUSION_SOURCE_FRESH && r->sources[1] == FUSION_SOURCE_FRESH);
+    assert(near(r->average, 25.5f));
+
+    fusion_destroy(&f);
+    printf("  PASSED\n");
+}
+
+void test_fusion_mixed_rates() {
+    printf("Testing sensors at different rates...\n");
+
+    // Sensor 1 every second, sensor 2 every other second: every window still
+    // yields exactly one record with both values
+    fusion_t f;
+    record_count = 0;
+    assert(fusion_init(&f, 2, 1000, 5000, collect, NULL) == 0);
+    for (uint64_t t = 0; t < 10000; t += 1000) {
+        assert(fusion_add(&f, 1, t + 100, (float)t / 1000) == 0);
+        if (t % 2000 == 0) {
+            assert(fusion_add(&f, 2, t + 300, 50.0f + (float)t / 1000) == 0);
+        }
+        fusion_advance(&f, t + 1000);
+    }
+    assert(record_count == 10);
+    for (int i = 0; i < 10; i++) {
+        fusion_record_t *r = &records[i];
+        assert(r->start_ms == (uint64_t)i * 1000);
+        assert(near(r->values[0], (float)i));
+        if (i % 2 == 0) {
+            assert(r->fresh == 2 && r->carried == 0);
+            assert(near(r->values[1], 50.0f + i));
+        } else {
+            // Carried forward from the window before
+            assert(r->fresh == 1 && r->carried == 1);
+            assert(r->sources[1] == FUSION_SOURCE_CARRIED);
+            assert(near(r->values[1], 50.0f + i - 1));
+        }
+    }
+
+    fusion_destroy(&f);
+    printf("  PASSED\n");
+}
+
+void test_fusion_staleness() {
+    printf("Testing carried values going stale...\n");
+
+    // Sensor 2 reports once at 100 ms; with a 2 s age limit it is carried
+    // into the window ending at 2000 but missing from the one ending at 3000
+    fusion_t f;
+    record_count = 0;
+    assert(fusion_init(&f, 2, 1000, 2000, collect, NULL) == 0);
+    assert(fusion_add(&f, 2, 100, 40.0f) == 0);
+    for (uint64_t t = 0; t < 3000; t += 1000) {
+        assert(fusion_add(&f, 1, t + 500, 20.0f) == 0);
+    }
+    fusion_advance(&f, 3000);
+    assert(record_count == 3);
+
+    assert(records[0].sources[1] == FUSION_SOURCE_FRESH);
+    assert(records[1].sources[1] == FUSION_SOURCE_CARRIED);
+    assert(near(records[1].values[1], 40.0f));
+    assert(near(records[1].average, 30.0f));
+    assert(records[2].sources[1] == FUSION_SOURCE_NONE);
+    assert(records[2].values[1] == FUSION_MISSING);
+    assert(records[2].fresh == 1 && records[2].carried == 0);
+    assert(near(records[2].average, 20.0f));
+
+    // Sensor 1 stops too: carried records until it goes stale, then nothing
+    fusion_advance(&f, 10000);
+    assert(record_count == 4);
+    assert(records[3].start_ms == 3000 && records[3].carried == 1);
+    assert(fusion_next_close_ms(&f) == 0);
+
+    fusion_destroy(&f);
+    printf("  PASSED\n");
+}
+
+void test_fusion_late_and_ahead() {
+    printf("Testing late readings and readings ahead of the open window...\n");
+
+    fusion_t f;
+    record_count = 0;
+    assert(fusion_init(&f, 2, 1000, 0, collect, NULL) == 0);
+    assert(fusion_add(&f, 1, 100, 20.0f) == 0);
+
+    // The next window can fill up while the open one waits
+    assert(fusion_add(&f, 1, 1100, 21.0f) == 0);
+    assert(record_count == 0);
+
+    // Two windows ahead closes the open one to make room
+    assert(fusion_add(&f, 1, 2100, 22.0f) == 0);
+    assert(record_count == 1);
+    assert(records[0].start_ms == 0 && near(records[0].values[0], 20.0f));
+
+    // Its window has closed: dropped and counted
+    assert(fusion_add(&f, 2, 900, 30.0f) == -1);
+    assert(f.late == 1);
+
+    // Unknown sensors are rejected without counting as late
+    assert(fusion_add(&f, 0, 1100, 30.0f) == -1);
+    assert(fusion_add(&f, 3, 1100, 30.0f) == -1);
+    assert(f.late == 1);
+
+    fusion_advance(&f, 3000);
+    assert(record_count == 3);
+    assert(records[1].start_ms == 1000 && near(records[1].values[0], 21.0f));
+    assert(records[2].start_ms == 2000 && near(records[2].values[0], 22.0f));
+    // Without an age limit nothing is carried forward
+    assert(records[1].values[1] == FUSION_MISSING);
+
+    fusion_destroy(&f);
+    printf("  PASSED\n");
+}
+
+void test_fusion_gap() {
+    printf("Testing gaps without readings...\n");
+
+    // Hours without readings are skipped rather than closed window by window
+    fusion_t f;
+    record_count = 0;
+    assert(fusion_init(&f, 1, 1000, 1000, collect, NULL) == 0);
+    assert(fusion_add(&f, 1, 100, 20.0f) == 0);
+    fusion_advance(&f, 1000);
+    assert(record_count == 1);
+    // Too old to carry into the next window: nothing left to close
+    assert(fusion_next_close_ms(&f) == 0);
+
+    uint64_t later = 1000ULL * 3600 * 1000;
+    assert(fusion_add(&f, 1, later + 100, 25.0f) == 0);
+    assert(f.open == later / 1000 - 1);
+    fusion_advance(&f, later + 1000);
+    assert(record_count == 2);
+    assert(records[1].start_ms == later && near(records[1].values[0], 25.0f));
+
+    fusion_destroy(&f);
+    printf("  PASSED\n");
+}
+
+int main(void) {
+    printf("\n=== Fusion Tests ===\n");
+
+    test_fusion_window();
+    test_fusion_mixed_rates();
+    test_fusion_staleness();
+    test_fusion_late_and_ahead();
+    test_fusion_gap();
+
+    printf("\nAll fusion tests passed!\n\n");
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include "../src/history.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+
+static int near(float a, float b) {
+    return fabsf(a - b) < 0.001f;
+}
+
+void test_history_raw_ring() {
+    printf("Testing raw sample ring...\n");
+
+    assert(history_init(2, 8, 60, 60, 24) == 0);
+
+    history_sample_t out[16];
+    assert(history_query_raw(1, 0, LLONG_MAX, out, 16) == 0);
+    assert(history_query_raw(3, 0, LLONG_MAX, out, 16) == -1);
+
+    // 12 samples into an 8-sample ring: the 8 newest remain, oldest first
+    for (int i = 0; i < 12; i++) {
+        history_add(1, 1000 + i, 20.0f + i);
+    }
+    int n = history_query_raw(1, 0, LLONG_MAX, out, 16);
+    assert(n == 8);
+    assert(out[0].timestamp == 1004);
+    assert(out[7].timestamp == 1011);
+    assert(near(out[7].value, 31.0f));
+
+    // Range and limit: the newest matches are kept
+    n = history_query_raw(1, 1005, 1008, out, 16);
+    assert(n == 4);
+    assert(out[0].timestamp == 1005 && out[3].timestamp == 1008);
+    n = history_query_raw(1, 0, LLONG_MAX, out, 3);
+    assert(n == 3);
+    assert(out[0].timestamp == 1009 && out[2].timestamp == 1011);
+
+    // Sensors are independent; unknown sensors are ignored
+    assert(history_query_raw(2, 0, LLONG_MAX, out, 16) == 0);
+    history_add(7, 1000, 1.0f);
+
+    history_destroy();
+    printf("  PASSED\n");
+}
+
+void test_history_rollups() {
+    printf("Testing rollup buckets...\n");
+
+    assert(history_init(1, 16, 60, 60, 24) == 0);
+
+    // Two readings per second for 3 minutes, starting on a minute boundary
+    time_t base = 1700000040;
+    assert(base % 60 == 0);
+    for (int s = 0; s < 180; s++) {
+        history_add(1, base + s, 10.0f + s);
+        history_add(1, base + s, 12.0f + s);
+    }
+
+    history_bucket_t out[64];
+    // 1 s buckets: only the last 60 seconds are kept
+    int n = history_query_buckets(1, HISTORY_RES_1S, 0, LLONG_MAX, out, 64);
+    assert(n == 60);
+    assert(out[0].start == base + 120);
+    assert(out[59].start == base + 179);
+    assert(out[59].count == 2);
+    assert(near(out[59].min, 189.0f) && near(out[59].max, 191.0f));
+    assert(near(out[59].mean, 190.0f));
+
+    // 1 min buckets
+    n = history_query_buckets(1, HISTORY_RES_1M, 0, LLONG_MAX, out, 64);
+    assert(n == 3);
+    assert(out[0].start == base && out[0].count == 120);
+    assert(near(out[0].min, 10.0f) && near(out[0].max, 71.0f));
+    assert(near(out[0].mean, 40.5f));
+    assert(out[2].start == base + 120);
+
+    // Range selects buckets overlapping [from, to]
+    n = history_query_buckets(1, HISTORY_RES_1M, base + 61, base + 120, out, 64);
+    assert(n == 2 && out[0].start == base + 60 && out[1].start == base + 120);
+    n = history_query_buckets(1, HISTORY_RES_1M, 0, LLONG_MAX, out, 2);
+    assert(n == 2 && out[0].start == base + 60);
+
+    // 1 h bucket holds everything
+    n = history_query_buckets(1, HISTORY_RES_1H, 0, LLONG_MAX, out, 64);
+    assert(n == 1);
+    assert(out[0].start == base - base % 3600);
+    assert(out[0].count == 360);
+    assert(near(out[0].min, 10.0f) && near(out[0].max, 191.0f));
+
+    // A reading older than the 1 s ring does not clobber newer buckets
+    history_add(1, base, 500.0f);
+    n = history_query_buckets(1, HISTORY_RES_1S, 0, LLONG_MAX, out, 64);
+    assert(n == 60);
+    assert(out[0].start == base + 120 && out[0].count == 2);
+    n = history_query_buckets(1, HISTORY_RES_1M, base, base, out, 64);
+    assert(n == 1 && out[0].count == 121 && near(out[0].max, 500.0f));
+
+    // Invalid resolutions are rejected
+    assert(history_query_buckets(1, HISTORY_RES_RAW, 0, LLONG_MAX, out, 64) == -1);
+
+    history_destroy();
+    printf("  PASSED\n");
+}
+
+void test_history_stats() {
+    printf("Testing raw range statistics...\n");
+
+    assert(history_init(2, 8, 60, 60, 24) == 0);
+
+    simd_stats_t st;
+    assert(history_query_stats(3, 0, LLONG_MAX, &st) == -1);
+    assert(history_query_stats(1, 0, LLONG_MAX, &st) == 0);
+    assert(st.count == 0);
+
+    // 12 samples into an 8-sample ring, so the stored run wraps: 24..31 remain
+    for (int i = 0; i < 12; i++) {
+        history_add(1, 1000 + i, 20.0f + i);
+    }
+    assert(history_query_stats(1, 0, LLONG_MAX, &st) == 0);
+    assert(st.count == 8);
+    assert(near(st.min, 24.0f) && near(st.max, 31.0f));
+    assert(fabs(st.mean - 27.5) < 1e-6);
+    assert(fabs(st.stddev - sqrt(5.25)) < 1e-6);
+
+    // Bounds are inclusive on both ends, across the wrap
+    assert(history_query_stats(1, 1006, 1009, &st) == 0);
+    assert(st.count == 4);
+    assert(near(st.min, 26.0f) && near(st.max, 29.0f));
+    assert(fabs(st.mean - 27.5) < 1e-6);
+
+    // Outside the stored range, or an empty range
+    assert(history_query_stats(1, 0, 1003, &st) == 0 && st.count == 0);
+    assert(history_query_stats(1, 2000, 3000, &st) == 0 && st.count == 0);
+    assert(history_query_stats(1, 1009, 1006, &st) == 0 && st.count == 0);
+
+    // Several readings in the same second all count
+    history_add(2, 500, 1.0f);
+    history_add(2, 500, 3.0f);
+    history_add(2, 501, 5.0f);
+    assert(history_query_stats(2, 500, 500, &st) == 0);
+    assert(st.count == 2 && fabs(st.mean - 2.0) < 1e-6 && fabs(st.stddev - 1.0) < 1e-6);
+
+    history_destroy();
+    printf("  PASSED\n");
+}
+
+void test_history_resolution_names() {
+    printf("Testing resolution names...\n");
+
+    assert(history_parse_resolution("raw") == HISTORY_RES_RAW);
+    assert(history_parse_resolution("1s") == HISTORY_RES_1S);
+    assert(history_parse_resolution("1m") == HISTORY_RES_1M);
+    assert(history_parse_resolution("1h") == HISTORY_RES_1H);
+    assert(history_parse_resolution("1d") == -1);
+
+    printf("  PASSED\n");
+}
+
+int main(void) {
+    printf("\n=== History Tests ===\n");
+
+    test_history_raw_ring();
+    test_history_rollups();
+    test_history_stats();
+    test_history_resolution_names();
+
+    printf("\nAll history tests passed!\n\n");
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include "../src/i2c_bus.h"
+#include <stdio.h>
+#include <assert.h>
+#include <errno.h>
+
+void test_i2c_read_register() {
+    printf("Testing register reads on a persistent handle...\n");
+
+    i2c_fake_t fake;
+    i2c_fake_init(&fake);
+    uint8_t temp[2] = { 0x19, 0x00 };
+    i2c_fake_set_register(&fake, 0x48, 0x00, temp, 2);
+
+    i2c_bus_t bus;
+    assert(i2c_bus_init(&bus, "/dev/i2c-fake", &i2c_fake_backend, &fake) == 0);
+    for (int i = 0; i < 100; i++) {
+        uint8_t data[2] = {0};
+        assert(i2c_bus_read_register(&bus, 0x48, 0x00, data, 2) == 0);
+        assert(data[0] == 0x19 && data[1] == 0x00);
+    }
+
+    // Opened once, then one system call per sample
+    i2c_bus_stats_t stats;
+    i2c_bus_get_stats(&bus, &stats);
+    assert(stats.opens == 1);
+    assert(stats.transfers == 100);
+    assert(stats.errors == 0);
+    assert(stats.syscalls == 1 + 100);
+
+    i2c_bus_destroy(&bus);
+    printf("  PASSED\n");
+}
+
+void test_i2c_errors() {
+    printf("Testing NACKs and reopening after handle errors...\n");
+
+    i2c_fake_t fake;
+    i2c_fake_init(&fake);
+    uint8_t value = 0x42;
+    i2c_fake_set_register(&fake, 0x49, 0x01, &value, 1);
+
+    i2c_bus_t bus;
+    assert(i2c_bus_init(&bus, "/dev/i2c-fake", &i2c_fake_backend, &fake) == 0);
+    uint8_t data = 0;
+
+    // An absent device NACKs without costing a reopen
+    assert(i2c_bus_read_register(&bus, 0x50, 0x00, &data, 1) == -ENXIO);
+    assert(i2c_bus_read_register(&bus, 0x49, 0x01, &data, 1) == 0);
+    assert(data == 0x42);
+    i2c_bus_stats_t stats;
+    i2c_bus_get_stats(&bus, &stats);
+    assert(stats.opens == 1 && stats.errors == 1);
+
+    // A broken handle is closed, reopened and the transfer retried
+    fake.fail_next = -ENODEV;
+    data = 0;
+    assert(i2c_bus_read_register(&bus, 0x49, 0x01, &data, 1) == 0);
+    assert(data == 0x42);
+    i2c_bus_get_stats(&bus, &stats);
+    assert(stats.opens == 2 && stats.errors == 2);
+    assert(stats.transfers == 4);
+
+    i2c_bus_destroy(&bus);
+    printf("  PASSED\n");
+}
+
+void test_i2c_register_write() {
+    printf("Testing register writes...\n");
+
+    i2c_fake_t fake;
+    i2c_fake_init(&fake);
+    uint8_t zero[2] = {0};
+    i2c_fake_set_register(&fake, 0x48, 0x00, zero, 2);
+
+    i2c_bus_t bus;
+    assert(i2c_bus_init(&bus, "/dev/i2c-fake", &i2c_fake_backend, &fake) == 0);
+    uint8_t config[3] = { 0x01, 0x60, 0xa0 };
+    struct i2c_msg msg = { .addr = 0x48, .flags = 0, .len = 3, .buf = config };
+    assert(i2c_bus_transfer(&bus, &msg, 1) == 0);
+
+    uint8_t data[2] = {0};
+    assert(i2c_bus_read_register(&bus, 0x48, 0x01, data, 2) == 0);
+    assert(data[0] == 0x60 && data[1] == 0xa0);
+
+    i2c_bus_destroy(&bus);
+    printf("  PASSED\n");
+}
+
+// Devices 0x48..0x48+count-1, each with a distinct temperature register
+static void add_devices(i2c_fake_t *fake, int count) {
+    i2c_fake_init(fake);
+    for (int i = 0; i < count; i++) {
+        uint8_t value[2] = { (uint8_t)(0x10 + i), 0x00 };
+        i2c_fake_set_register(fake, (uint16_t)(0x48 + i), 0x00, value, 2);
+    }
+}
+
+static void setup_reads(i2c_read_t *reads, uint8_t (*data)[2], int count) {
+    for (int i = 0; i < count; i++) {
+        reads[i] = (i2c_read_t){ .address = (uint16_t)(0x48 + i), .reg = 0x00,
+                                 .buf = data[i], .len = 2, .result = 1 };
+        data[i][0] = 0;
+    }
+}
+
+void test_i2c_batched_reads() {
+    printf("Testing batched register reads...\n");
+
+    i2c_fake_t fake;
+    add_devices(&fake, 30);
+    i2c_bus_t bus;
+    assert(i2c_bus_init(&bus, "/dev/i2c-fake", &i2c_fake_backend, &fake) == 0);
+
+    // 30 reads fit in two transfers of at most I2C_BUS_MAX_BATCH
+    i2c_read_t reads[30];
+    uint8_t data[30][2];
+    setup_reads(reads, data, 30);
+    assert(i2c_bus_read_registers(&bus, reads, 30) == 30);
+    for (int i = 0; i < 30; i++) {
+        assert(reads[i].result == 0);
+        assert(data[i][0] == 0x10 + i);
+    }
+    i2c_bus_stats_t stats;
+    i2c_bus_get_stats(&bus, &stats);
+    assert(stats.transfers == 2 && stats.syscalls == 1 + 2);
+    assert(stats.fallbacks == 0);
+
+    // A NACK anywhere fails the transfer; the batch is redone per device so
+    // the others still get through
+    setup_reads(reads, data, 4);
+    reads[2].address = 0x70;
+    assert(i2c_bus_read_registers(&bus, reads, 4) == 3);
+    assert(reads[0].result == 0 && reads[1].result == 0 && reads[3].result == 0);
+    assert(reads[2].result == -ENXIO);
+    assert(data[3][0] == 0x13);
+    i2c_bus_get_stats(&bus, &stats);
+    assert(stats.fallbacks == 1 && stats.transfers == 2 + 1 + 4);
+    assert(bus.max_batch == I2C_BUS_MAX_BATCH);
+
+    // The absent device is then read on its own: the batch of the other three
+    // goes through at once and there is no fallback
+    setup_reads(reads, data, 4);
+    reads[2].address = 0x70;
+    assert(i2c_bus_read_registers(&bus, reads, 4) == 3);
+    assert(reads[2].result == -ENXIO && data[3][0] == 0x13);
+    i2c_bus_get_stats(&bus, &stats);
+    assert(stats.fallbacks == 1 && stats.transfers == 7 + 2);
+
+    // Once it answers its own read it rejoins the batch
+    uint8_t value[2] = { 0x55, 0x00 };
+    i2c_fake_set_register(&fake, 0x70, 0x00, value, 2);
+    setup_reads(reads, data, 4);
+    reads[2].address = 0x70;
+    assert(i2c_bus_read_registers(&bus, reads, 4) == 4);
+    assert(data[2][0] == 0x55);
+    setup_reads(reads, data, 4);
+    reads[2].address = 0x70;
+    assert(i2c_bus_read_registers(&bus, reads, 4) == 4);
+    i2c_bus_get_stats(&bus, &stats);
+    assert(stats.fallbacks == 1 && stats.transfers == 9 + 2 + 1);
+
+    i2c_bus_destroy(&bus);
+    printf("  PASSED\n");
+}
+
+void test_i2c_batch_rejected() {
+    printf("Testing fallback when the adapter rejects batches...\n");
+
+    i2c_fake_t fake;
+    add_devices(&fake, 4);
+    fake.max_msgs = 2;
+    i2c_bus_t bus;
+    assert(i2c_bus_init(&bus, "/dev/i2c-fake", &i2c_fake_backend, &fake) == 0);
+
+    i2c_read_t reads[4];
+    uint8_t data[4][2];
+    setup_reads(reads, data, 4);
+    assert(i2c_bus_read_registers(&bus, reads, 4) == 4);
+    assert(data[3][0] == 0x13);
+    assert(bus.max_batch == 1);
+
+    // Later sweeps go straight to one read per transfer, without a handle reopen
+    setup_reads(reads, data, 4);
+    assert(i2c_bus_read_registers(&bus, reads, 4) == 4);
+    i2c_bus_stats_t stats;
+    i2c_bus_get_stats(&bus, &stats);
+    assert(stats.fallbacks == 1 && stats.errors == 1);
+    assert(stats.transfers == 1 + 4 + 4);
+    assert(stats.opens == 1);
+
+    i2c_bus_destroy(&bus);
+    printf("  PASSED\n");
+}
+
+void test_i2c_shared_handles() {
+    printf("Testing shared bus handles...\n");
+
+    i2c_bus_t *a = i2c_bus_get("/dev/i2c-test-a");
+    i2c_bus_t *b = i2c_bus_get("/dev/i2c-test-b");
+    assert(a != NULL && b != NULL && a != b);
+    assert(i2c_bus_get("/dev/i2c-test-a") == a);
+    assert(a->backend == &i2c_linux_backend);
+    i2c_bus_release_all();
+
+    printf("  PASSED\n");
+}
+
+int main(void) {
+    printf("\n=== I2C Bus Tests ===\n");
+
+    test_i2c_read_register();
+    test_i2c_errors();
+    test_i2c_register_write();
+    test_i2c_batched_reads();
+    test_i2c_batch_rejected();
+    test_i2c_shared_handles();
+
+    printf("\nAll I2C bus tests passed!\n\n");
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "../src/latency.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+static latency_hist_t hist;
+
+// Reported values may exceed the true one by at most one bucket width (1/32)
+static int within(uint64_t reported, uint64_t actual) {
+    return reported >= actual && reported <= actual + actual / 32;
+}
+
+void test_latency_exact_small_values() {
+    printf("Testing small values are exact...\n");
+    latency_hist_reset(&hist);
+
+    latency_summary_t sum;
+    latency_hist_summary(&hist, &sum);
+    assert(sum.count == 0 && sum.p50_ns == 0 && sum.max_ns == 0);
+
+    for (uint64_t v = 1; v <= 20; v++) {
+        latency_hist_record(&hist, v);
+    }
+    assert(latency_hist_quantile(&hist, 0.5) == 10);
+    assert(latency_hist_quantile(&hist, 0.0) == 1);
+    assert(latency_hist_quantile(&hist, 1.0) == 20);
+
+    printf("  PASSED\n");
+}
+
+void test_latency_quantiles() {
+    printf("Testing quantiles over a wide range...\n");
+    latency_hist_reset(&hist);
+
+    // 1..100000 us: every quantile is known exactly
+    for (uint64_t us = 1; us <= 100000; us++) {
+        latency_hist_record(&hist, us * 1000);
+    }
+    latency_summary_t sum;
+    latency_hist_summary(&hist, &sum);
+    assert(sum.count == 100000);
+    assert(within(sum.p50_ns, 50000 * 1000ULL));
+    assert(within(sum.p99_ns, 99000 * 1000ULL));
+    assert(within(sum.p999_ns, 99900 * 1000ULL));
+    assert(sum.max_ns == 100000 * 1000ULL);
+
+    // A single outlier moves the max but not the tail quantiles
+    latency_hist_record(&hist, 5000000000ULL);
+    latency_hist_summary(&hist, &sum);
+    assert(sum.max_ns == 5000000000ULL);
+    assert(within(sum.p999_ns, 99901 * 1000ULL));
+
+    printf("  PASSED\n");
+}
+
+void test_latency_huge_values() {
+    printf("Testing values beyond the top bucket...\n");
+    latency_hist_reset(&hist);
+
+    // Clamped into the top bucket, but the max is kept exactly
+    latency_hist_record(&hist, 1ULL << 50);
+    latency_summary_t sum;
+    latency_hist_summary(&hist, &sum);
+    assert(sum.count == 1);
+    assert(sum.max_ns == 1ULL << 50);
+    assert(sum.p50_ns > (1ULL << 39) && sum.p50_ns <= sum.max_ns);
+
+    printf("  PASSED\n");
+}
+
+void test_latency_stages() {
+    printf("Testing stage recording...\n");
+
+    latency_record(LATENCY_QUEUE_WAIT, 1000, 3000);
+    latency_record(LATENCY_QUEUE_WAIT, 0, 3000);      // Missing start stamp
+    latency_record(LATENCY_QUEUE_WAIT, 5000, 4000);   // End before start
+    latency_summary_t sum;
+    latency_stage_summary(LATENCY_QUEUE_WAIT, &sum);
+    assert(sum.count == 1 && sum.max_ns == 2000);
+    latency_stage_summary(LATENCY_PROCESS, &sum);
+    assert(sum.count == 0);
+
+    assert(latency_stage_name(LATENCY_END_TO_END)[0] == 'e');
+    latency_dump(stdout);
+
+    printf("  PASSED\n");
+}
+
+int main(void) {
+    printf("\n=== Latency Histogram Tests ===\n");
+
+    test_latency_exact_small_values();
+    test_latency_quantiles();
+    test_latency_huge_values();
+    test_latency_stages();
+
+    printf("\nAll latency tests passed!\n\n");
+    return 0;
+}
@@ -0,0 +1,196 @@
+#include "../src/log_segment.h"
+#include "../src/log_writer.h"
+#include "../src/binlog.h"
+#include "../src/config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#define TEST_ROWS 1000
+
+static char test_dir[] = "/tmp/test_log_segment_XXXXXX";
+static char log_file[256];
+
+static int count_files(const char *suffix) {
+    DIR *d = opendir(test_dir);
+    assert(d != NULL);
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        size_t suffix_len = strlen(suffix);
+        if (len > suffix_len && strcmp(entry->d_name + len - suffix_len, suffix) == 0) {
+            count++;
+        }
+    }
+    closedir(d);
+    return count;
+}
+
+static void remove_test_dir(void) {
+    DIR *d = opendir(test_dir);
+    if (!d) return;
+    struct dirent *entry;
+    char path[512];
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", test_dir, entry->d_name);
+        unlink(path);
+    }
+    closedir(d);
+    rmdir(test_dir);
+}
+
+void test_logseg_path() {
+    printf("Testing segment naming...\n");
+
+    char path[512];
+    assert(logseg_path("logs/sensor_log.csv", 1700000000, path, sizeof(path)) == 0);
+    assert(strcmp(path, "logs/sensor_log-1700000000.csv") == 0);
+    assert(logseg_path("sensor_log", 42, path, sizeof(path)) == 0);
+    assert(strcmp(path, "./sensor_log-42") == 0);
+    assert(logseg_path("/var/log/sensors.bin", 7, path, sizeof(path)) == 0);
+    assert(strcmp(path, "/var/log/sensors-7.bin") == 0);
+    assert(logseg_path("logs/sensor_log.csv", 1700000000, path, 8) == -1);
+
+    printf("  PASSED\n");
+}
+
+void test_segment_rotation(time_t base) {
+    printf("Testing size-based rotation...\n");
+
+    config_load_defaults();
+    g_config.log_format = LOG_FORMAT_BINARY;
+    g_config.log_buffer_records = 2 * TEST_ROWS;
+    // Header plus 100 seconds of readings from both sensors per segment
+    g_config.log_segment_max_bytes = sizeof(binlog_header_t) + 100 * 2 * sizeof(binlog_record_t);
+
+    assert(log_writer_start(log_file) == 0);
+    for (int i = 0; i < TEST_ROWS; i++) {
+        log_record_t r1 = { .timestamp = base + i, .sensor_id = 1, .temperature = 20.0f + i * 0.01f };
+        log_record_t r2 = { .timestamp = base + i, .sensor_id = 2, .temperature = 21.0f };
+        assert(log_writer_append(&r1) == 0);
+        assert(log_writer_append(&r2) == 0);
+    }
+    log_writer_stop();
+
+    log_writer_stats_t stats;
+    log_writer_get_stats(&stats);
+    assert(stats.written == 2 * TEST_ROWS);
+    assert(stats.dropped == 0);
+    assert(stats.rotations == TEST_ROWS / 100 - 1);
+
+    logseg_info_t *segments;
+    int count = logseg_list(log_file, &segments);
+    assert(count == TEST_ROWS / 100);
+    assert(count_files(LOGSEG_INDEX_SUFFIX) == count);
+    for (int i = 1; i < count; i++) {
+        assert(segments[i].start > segments[i - 1].start);
+    }
+
+    // Every row is in exactly one segment, in order
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        binlog_reader_t reader;
+        assert(binlog_open(segments[i].path, &reader) == 0);
+        assert(reader.count == 200);
+        assert(binlog_record_time(reader.header, &reader.records[0]) == base + (time_t)(total / 2));
+        total += reader.count;
+        binlog_close(&reader);
+    }
+    assert(total == 2 * TEST_ROWS);
+    free(segments);
+
+    printf("  PASSED\n");
+}
+
+void test_segment_seek(time_t base) {
+    printf("Testing time-range seek...\n");
+
+    // Rows at or after from begin in the returned segment, at or after the offset
+    time_t queries[] = { base - 100, base, base + 1, base + 99, base + 100, base + 555,
+                         base + TEST_ROWS - 1, base + TEST_ROWS + 50 };
+    for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        time_t from = queries[q];
+        char path[512];
+        uint64_t offset;
+        assert(logseg_seek(log_file, from, path, sizeof(path), &offset) == 0);
+
+        binlog_reader_t reader;
+        assert(binlog_open(path, &reader) == 0);
+        size_t first = 0;
+        if (offset > 0) {
+            assert(offset >= sizeof(binlog_header_t));
+            assert((offset - sizeof(binlog_header_t)) % sizeof(binlog_record_t) == 0);
+            first = (size_t)(offset - sizeof(binlog_header_t)) / sizeof(binlog_record_t);
+            assert(first < reader.count);
+            assert(reader.records[first].flags & BINLOG_FLAG_ROW_START);
+            // The seek never lands past the first wanted row
+            assert(binlog_record_time(reader.header, &reader.records[first]) < from);
+        }
+        time_t last = binlog_record_time(reader.header, &reader.records[reader.count - 1]);
+        if (from >= base && from < base + TEST_ROWS) {
+            assert(last >= from);
+            // Skipping ahead avoids all but one index interval of rows
+            size_t scanned = 0;
+            for (size_t i = first; i < reader.count &&
+                 binlog_record_time(reader.header, &reader.records[i]) < from; i++) {
+                scanned++;
+            }
+            assert(scanned <= 2 * LOGSEG_INDEX_INTERVAL);
+        }
+        binlog_close(&reader);
+    }
+
+    printf("  PASSED\n");
+}
+
+void test_segment_retention(time_t base) {
+    printf("Testing retention...\n");
+
+    // By age: segments holding only rows older than now - 550 go
+    int removed = logseg_apply_retention(log_file, 0, 550, base + TEST_ROWS);
+    assert(removed == 4);
+
+    logseg_info_t *segments;
+    int count = logseg_list(log_file, &segments);
+    assert(count == 6);
+    free(segments);
+
+    // By count, keeping the newest
+    assert(logseg_apply_retention(log_file, 2, 0, base + TEST_ROWS) == 4);
+    count = logseg_list(log_file, &segments);
+    assert(count == 2);
+    assert(segments[1].start >= base + TEST_ROWS - 100);
+    free(segments);
+    assert(count_files(LOGSEG_INDEX_SUFFIX) == 2);
+
+    // The newest segment is never removed
+    assert(logseg_apply_retention(log_file, 1, 1, base + 10 * TEST_ROWS) == 1);
+    assert(logseg_apply_retention(log_file, 1, 1, base + 10 * TEST_ROWS) == 0);
+    count = logseg_list(log_file, &segments);
+    assert(count == 1);
+    free(segments);
+
+    printf("  PASSED\n");
+}
+
+int main(void) {
+    printf("\n=== Log Segment Tests ===\n");
+
+    assert(mkdtemp(test_dir) != NULL);
+    snprintf(log_file, sizeof(log_file), "%s/sensor_log.bin", test_dir);
+    time_t base = time(NULL);
+
+    test_logseg_path();
+    test_segment_rotation(base);
+    test_segment_seek(base);
+    test_segment_retention(base);
+
+    remove_test_dir();
+    printf("\nAll log segment tests passed!\n\n");
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include "../src/log_writer.h"
+#include "../src/config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+
+static char log_path[64];
+
+static void make_log_path(void) {
+    snprintf(log_path, sizeof(log_path), "/tmp/test_log_writer_XXXXXX");
+    int fd = mkstemp(log_path);
+    assert(fd >= 0);
+    close(fd);
+}
+
+// Read the whole log file into a static buffer
+static const char *read_log(void) {
+    static char content[8192];
+    FILE *f = fopen(log_path, "r");
+    assert(f != NULL);
+    size_t n = fread(content, 1, sizeof(content) - 1, f);
+    content[n] = '\0';
+    fclose(f);
+    return content;
+}
+
+void test_log_writer_rows() {
+    printf("Testing log writer CSV output...\n");
+    make_log_path();
+    config_load_defaults();
+
+    assert(log_writer_start(log_path) == 0);
+
+    log_record_t first = { .timestamp = 0, .sensor_id = 1, .temperature = 23.5f };
+    log_record_t second = { .timestamp = 0, .sensor_id = 2, .temperature = 24.25f };
+    log_record_t third = { .timestamp = 0, .sensor_id = 1, .temperature = 21.0f };
+    assert(log_writer_append(&first) == 0);
+    assert(log_writer_append(&second) == 0);
+    assert(log_writer_append(&third) == 0);
+
+    log_writer_stop();
+
+    log_writer_stats_t stats;
+    log_writer_get_stats(&stats);
+    assert(stats.appended == 3);
+    assert(stats.written == 3);
+    assert(stats.pending == 0);
+    assert(stats.dropped == 0);
+
+    const char *content = read_log();
+    assert(strncmp(content, "timestamp,sensor1,sensor2,average\n", 34) == 0);
+    assert(strstr(content, ",23.50,N/A,23.50\n") != NULL);
+    assert(strstr(content, ",N/A,24.25,24.25\n") != NULL);
+    assert(strstr(content, ",21.00,N/A,21.00\n") != NULL);
+    assert((unsigned long)strlen(content) == 34 + stats.bytes_written);
+
+    unlink(log_path);
+    printf("  PASSED\n");
+}
+
+void test_log_writer_fused_rows() {
+    printf("Testing log writer rows of several records...\n");
+    make_log_path();
+    config_load_defaults();
+
+    assert(log_writer_start(log_path) == 0);
+
+    log_record_t row[2] = {
+        { .timestamp = 0, .sensor_id = 1, .temperature = 23.5f },
+        { .timestamp = 0, .sensor_id = 2, .temperature = 24.5f },
+    };
+    log_record_t single = { .timestamp = 0, .sensor_id = 2, .temperature = 21.0f };
+    assert(log_writer_append_row(row, 2) == 0);
+    assert(log_writer_append(&single) == 0);
+    log_writer_stop();
+
+    log_writer_stats_t stats;
+    log_writer_get_stats(&stats);
+    assert(stats.appended == 3);
+    assert(stats.written == 3);
+
+    // One line per row, averaged over the row's values
+    const char *content = read_log();
+    assert(strstr(content, ",23.50,24.50,24.00\n") != NULL);
+    assert(strstr(content, ",N/A,21.00,21.00\n") != NULL);
+    int lines = 0;
+    for (const char *p = content; *p; p++) {
+        lines += *p == '\n';
+    }
+    assert(lines == 3);
+    assert((unsigned long)strlen(content) == 34 + stats.bytes_written);
+
+    unlink(log_path);
+    printf("  PASSED\n");
+}
+
+void test_log_writer_columns() {
+    printf("Testing log writer CSV columns follow the sensor table...\n");
+    make_log_path();
+    config_load_defaults();
+    g_config.sensors[1].id = 4;
+    g_config.sensor_max_id = 4;
+
+    assert(log_writer_start(log_path) == 0);
+    log_record_t rec = { .timestamp = 0, .sensor_id = 4, .temperature = 19.5f };
+    assert(log_writer_append(&rec) == 0);
+    log_writer_stop();
+
+    const char *content = read_log();
+    assert(strncmp(content, "timestamp,sensor1,sensor2,sensor3,sensor4,average\n", 50) == 0);
+    assert(strstr(content, ",N/A,N/A,N/A,19.50,19.50\n") != NULL);
+
+    unlink(log_path);
+    printf("  PASSED\n");
+}
+
+void test_log_writer_drops() {
+    printf("Testing log writer drops when buffers are full...\n");
+    make_log_path();
+    config_load_defaults();
+    // Tiny buffers and no flush trigger short of a full buffer
+    g_config.log_buffer_records = 4;
+    g_config.log_flush_records = 0;
+    g_config.log_flush_interval_ms = 60000;
+
+    assert(log_writer_start(log_path) == 0);
+
+    log_record_t rec = { .timestamp = 0, .sensor_id = 1, .temperature = 20.0f };
+    int accepted = 0;
+    for (int i = 0; i < 1000; i++) {
+        if (log_writer_append(&rec) == 0) {
+            accepted++;
+        }
+    }
+
+    log_writer_stop();
+
+    log_writer_stats_t stats;
+    log_writer_get_stats(&stats);
+    assert(stats.appended == (unsigned long)accepted);
+    assert(stats.appended + stats.dropped == 1000);
+    assert(stats.written == stats.appended);
+
+    unlink(log_path);
+    printf("  PASSED\n");
+}
+
+int main(void) {
+    printf("\n=== Log Writer Tests ===\n");
+
+    test_log_writer_rows();
+    test_log_writer_fused_rows();
+    test_log_writer_columns();
+    test_log_writer_drops();
+
+    printf("\nAll log writer tests passed!\n\n");
+    return 0;
+}
@@ -0,0 +1,209 @@
+#include "../src/quantile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+
+#define STREAM_LEN 100000
+
+static float stream[STREAM_LEN];
+static float sorted[STREAM_LEN];
+
+static int compare_floats(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+// A day of a room sensor: 21 °C +/- 3 with a warm afternoon and noise,
+// quantized to the TMP102's 1/16 °C
+static void make_stream(void) {
+    uint32_t seed = 12345;
+    for (int i = 0; i < STREAM_LEN; i++) {
+        seed = seed * 1103515245u + 12345u;
+        float noise = (float)((seed >> 16) % 1000) / 1000.0f - 0.5f;
+        float level = 21.0f + 3.0f * sinf((float)i / STREAM_LEN * 6.2832f) + noise;
+        stream[i] = (float)(int)(level * 16) / 16;
+        sorted[i] = stream[i];
+    }
+    qsort(sorted, STREAM_LEN, sizeof(float), compare_floats);
+}
+
+// How far an estimate is from the exact quantile, in degrees
+static double value_error(double estimate, double q) {
+    return fabs(estimate - sorted[(int)(q * (STREAM_LEN - 1))]);
+}
+
+// The stream's resolution: estimates within one step are as good as exact
+#define LSB 0.0625
+
+static const double test_qs[] = { 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99, 0.999 };
+#define TEST_QS ((int)(sizeof(test_qs) / sizeof(test_qs[0])))
+
+void test_tdigest_empty() {
+    printf("Testing empty and single-value digests...\n");
+
+    tdigest_t t;
+    tdigest_init(&t);
+    assert(isnan(tdigest_quantile(&t, 0.5)));
+
+    tdigest_add(&t, 23.5f, 1);
+    assert(tdigest_quantile(&t, 0) == 23.5f);
+    assert(tdigest_quantile(&t, 0.5) == 23.5f);
+    assert(tdigest_quantile(&t, 1) == 23.5f);
+
+    tdigest_add(&t, 24.5f, 0);      // No weight, no effect
+    assert(t.total == 1 && tdigest_quantile(&t, 1) == 23.5f);
+
+    printf("  PASSED\n");
+}
+
+void test_tdigest_accuracy() {
+    printf("Testing t-digest accuracy on a day of readings...\n");
+
+    tdigest_t t;
+    tdigest_init(&t);
+    for (int i = 0; i < STREAM_LEN; i++) {
+        tdigest_add(&t, stream[i], 1);
+    }
+    assert(t.total == STREAM_LEN);
+    assert(tdigest_quantile(&t, 0) == sorted[0]);
+    assert(tdigest_quantile(&t, 1) == sorted[STREAM_LEN - 1]);
+    for (int i = 0; i < TEST_QS; i++) {
+        assert(value_error(tdigest_quantile(&t, test_qs[i]), test_qs[i]) <= LSB);
+    }
+
+    // Constant memory however much goes in
+    tdigest_compress(&t);
+    assert(t.count <= TDIGEST_CENTROIDS && t.buffered == 0);
+
+    // Estimates never decrease with q
+    double last = tdigest_quantile(&t, 0);
+    for (double q = 0.001; q <= 1; q += 0.001) {
+        double v = tdigest_quantile(&t, q);
+        assert(v >= last);
+        last = v;
+    }
+
+    printf("  PASSED\n");
+}
+
+void test_tdigest_merge() {
+    printf("Testing merged digests...\n");
+
+    // 60 digests of consecutive slices, as panes of a window would be
+    tdigest_t panes[60], merged;
+    for (int p = 0; p < 60; p++) {
+        tdigest_init(&panes[p]);
+    }
+    for (int i = 0; i < STREAM_LEN; i++) {
+        tdigest_add(&panes[i * 60 / STREAM_LEN], stream[i], 1);
+    }
+    tdigest_init(&merged);
+    for (int p = 0; p < 60; p++) {
+        tdigest_merge(&merged, &panes[p]);
+    }
+    assert(merged.total == STREAM_LEN);
+    assert(merged.min == sorted[0] && merged.max == sorted[STREAM_LEN - 1]);
+    for (int i = 0; i < TEST_QS; i++) {
+        assert(value_error(tdigest_quantile(&merged, test_qs[i]), test_qs[i]) <= LSB);
+    }
+
+    // Merging an empty digest changes nothing
+    tdigest_t empty;
+    tdigest_init(&empty);
+    tdigest_merge(&merged, &empty);
+    assert(merged.total == STREAM_LEN);
+
+    printf("  PASSED\n");
+}
+
+void test_quantile_windows() {
+    printf("Testing per-sensor windows...\n");
+
+    assert(quantile_init(2) == 0);
+
+    double qs[] = { 0, 0.5, 1 }, out[3];
+    assert(quantile_query(3, QUANTILE_WIN_1M, 0, qs, 3, out) == -1);
+    assert(quantile_query(1, QUANTILE_WIN_COUNT, 0, qs, 3, out) == -1);
+
+    // Ten minutes at 1 Hz, each minute one degree warmer: 20, 21, ... 29
+    time_t base = 1700000040;
+    assert(base % 60 == 0);
+    for (int s = 0; s < 600; s++) {
+        quantile_add(1, base + s, 20.0f + s / 60);
+    }
+    time_t now = base + 599;
+
+    // The last minute is 12 panes of 5 s: only the 29s
+    assert(quantile_query(1, QUANTILE_WIN_1M, now, qs, 3, out) == 60);
+    assert(out[0] == 29.0f && out[1] == 29.0f && out[2] == 29.0f);
+
+    // The hour and day hold everything
+    assert(quantile_query(1, QUANTILE_WIN_1H, now, qs, 3, out) == 600);
+    assert(out[0] == 20.0f && out[2] == 29.0f);
+    assert(out[1] >= 24.0f && out[1] <= 25.0f);
+    assert(quantile_query(1, QUANTILE_WIN_24H, now, qs, 3, out) == 600);
+
+    // Late readings land in their closed panes and count once in each window
+    quantile_add(1, now - 30, 29.0f);
+    quantile_add(1, now - 300, 25.0f);
+    assert(quantile_query(1, QUANTILE_WIN_1M, now, qs, 3, out) == 61);
+    assert(quantile_query(1, QUANTILE_WIN_1H, now, qs, 3, out) == 602);
+    assert(quantile_query(1, QUANTILE_WIN_24H, now, qs, 3, out) == 602);
+    quantile_add(1, now + 1, 29.0f);
+    assert(quantile_query(1, QUANTILE_WIN_1H, now + 1, qs, 3, out) == 603);
+    assert(quantile_query(1, QUANTILE_WIN_24H, now + 1, qs, 3, out) == 603);
+
+    // Two minutes later with nothing new, the minute window is empty
+    assert(quantile_query(1, QUANTILE_WIN_1M, now + 120, qs, 3, out) == 0);
+    assert(isnan(out[1]));
+    assert(quantile_query(1, QUANTILE_WIN_1H, now + 120, qs, 3, out) == 603);
+
+    // Sensors are independent; unknown sensors are ignored
+    assert(quantile_query(2, QUANTILE_WIN_1H, now, qs, 3, out) == 0);
+    quantile_add(7, now, 1.0f);
+
+    // Readings older than a ring covers only reach the longer windows
+    quantile_add(2, now - 600, 10.0f);
+    assert(quantile_query(2, QUANTILE_WIN_1M, now, qs, 3, out) == 0);
+    assert(quantile_query(2, QUANTILE_WIN_1H, now, qs, 3, out) == 1);
+
+    // Two days on, the slots are reused and only new readings count
+    time_t later = now + 2 * 86400;
+    quantile_add(1, later, 35.0f);
+    assert(quantile_query(1, QUANTILE_WIN_24H, later, qs, 3, out) == 1);
+    assert(out[1] == 35.0f);
+    assert(quantile_query(1, QUANTILE_WIN_1M, later, qs, 3, out) == 1);
+
+    quantile_destroy();
+    assert(quantile_query(1, QUANTILE_WIN_1M, later, qs, 3, out) == -1);
+    printf("  PASSED\n");
+}
+
+void test_quantile_window_names() {
+    printf("Testing window names...\n");
+
+    assert(quantile_parse_window("1m") == QUANTILE_WIN_1M);
+    assert(quantile_parse_window("1h") == QUANTILE_WIN_1H);
+    assert(quantile_parse_window("24h") == QUANTILE_WIN_24H);
+    assert(quantile_parse_window("1d") == -1);
+    for (int w = 0; w < QUANTILE_WIN_COUNT; w++) {
+        assert(quantile_parse_window(quantile_window_name((quantile_window_t)w)) == w);
+    }
+
+    printf("  PASSED\n");
+}
+
+int main(void) {
+    printf("\n=== Quantile Tests ===\n");
+
+    make_stream();
+    test_tdigest_empty();
+    test_tdigest_accuracy();
+    test_tdigest_merge();
+    test_quantile_windows();
+    test_quantile_window_names();
+
+    printf("\nAll quantile tests passed!\n\n");
+    return 0;
+}
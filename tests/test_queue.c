@@ -4,15 +4,19 @@
 #include <assert.h>
 #include <string.h>
 #include <time.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
 
 void test_queue_init() {
     printf("Testing queue_init...\n");
     queue_t q;
-    queue_init(&q, 10);
-    assert(q.head == NULL);
-    assert(q.tail == NULL);
-    assert(q.size == 0);
+    assert(queue_init(&q, 10) == 0);
+    assert(q.cells != NULL);
+    assert(((uintptr_t)q.cells % QUEUE_CACHE_LINE) == 0);
+    assert(q.capacity == 10);
     assert(q.max_size == 10);
+    assert(queue_size(&q) == 0);
     queue_destroy(&q);
     printf("  PASSED\n");
 }
@@ -22,8 +26,8 @@ void test_queue_push_pop() {
     queue_t q;
     queue_init(&q, 10);
 
-    sensor_reading_t reading1 = {1, 23.5f, time(NULL)};
-    sensor_reading_t reading2 = {2, 24.6f, time(NULL)};
+    sensor_reading_t reading1 = {.sensor_id = 1, .temperature = 23.5f, .timestamp = time(NULL)};
+    sensor_reading_t reading2 = {.sensor_id = 2, .temperature = 24.6f, .timestamp = time(NULL)};
 
     // Push items
     assert(queue_push(&q, reading1) == 0);
@@ -52,7 +56,7 @@ void test_queue_max_size() {
     queue_t q;
     queue_init(&q, 3);
 
-    sensor_reading_t reading = {1, 23.5f, time(NULL)};
+    sensor_reading_t reading = {.sensor_id = 1, .temperature = 23.5f, .timestamp = time(NULL)};
 
     // Fill queue to max
     assert(queue_push(&q, reading) == 0);
@@ -73,7 +77,7 @@ void test_queue_unbounded() {
     queue_t q;
     queue_init(&q, 0);  // Unbounded
 
-    sensor_reading_t reading = {1, 23.5f, time(NULL)};
+    sensor_reading_t reading = {.sensor_id = 1, .temperature = 23.5f, .timestamp = time(NULL)};
 
     // Push many items
     for (int i = 0; i < 100; i++) {
@@ -85,6 +89,237 @@ void test_queue_unbounded() {
     printf("  PASSED\n");
 }
 
+void test_queue_wraparound() {
+    printf("Testing queue wraparound...\n");
+    queue_t q;
+    queue_init(&q, 4);
+
+    // Cycle through the ring several times; FIFO order must hold across laps
+    sensor_reading_t reading = {.sensor_id = 1, .temperature = 0.0f, .timestamp = time(NULL)};
+    sensor_reading_t popped;
+    for (int lap = 0; lap < 10; lap++) {
+        for (int i = 0; i < 3; i++) {
+            reading.temperature = (float)(lap * 3 + i);
+            assert(queue_push(&q, reading) == 0);
+        }
+        for (int i = 0; i < 3; i++) {
+            assert(queue_pop(&q, &popped) == 0);
+            assert(popped.temperature == (float)(lap * 3 + i));
+        }
+    }
+    assert(queue_size(&q) == 0);
+
+    queue_destroy(&q);
+    printf("  PASSED\n");
+}
+
+#define MP_PRODUCERS 4
+#define MP_ITEMS 20000
+
+static queue_t mp_queue;
+
+static void *mp_producer(void *arg) {
+    int id = (int)(intptr_t)arg;
+    for (int i = 0; i < MP_ITEMS; i++) {
+        sensor_reading_t reading = {.sensor_id = id, .temperature = (float)i, .timestamp = 0};
+        // Retry while full; the consumer keeps draining
+        while (queue_size(&mp_queue) >= (int)mp_queue.capacity ||
+               queue_push(&mp_queue, reading) != 0) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void test_queue_multi_producer() {
+    printf("Testing queue with multiple producers...\n");
+    queue_init(&mp_queue, 64);
+
+    pthread_t producers[MP_PRODUCERS];
+    for (int p = 0; p < MP_PRODUCERS; p++) {
+        pthread_create(&producers[p], NULL, mp_producer, (void *)(intptr_t)p);
+    }
+
+    // Each producer's items must arrive complete and in order
+    int next[MP_PRODUCERS] = {0};
+    for (int n = 0; n < MP_PRODUCERS * MP_ITEMS; n++) {
+        sensor_reading_t popped;
+        assert(queue_pop(&mp_queue, &popped) == 0);
+        assert(popped.sensor_id >= 0 && popped.sensor_id < MP_PRODUCERS);
+        assert(popped.temperature == (float)next[popped.sensor_id]);
+        next[popped.sensor_id]++;
+    }
+
+    for (int p = 0; p < MP_PRODUCERS; p++) {
+        pthread_join(producers[p], NULL);
+        assert(next[p] == MP_ITEMS);
+    }
+    assert(queue_size(&mp_queue) == 0);
+
+    queue_destroy(&mp_queue);
+    printf("  PASSED\n");
+}
+
+void test_queue_batch() {
+    printf("Testing queue_push_batch and queue_pop_batch...\n");
+    queue_t q;
+    queue_init(&q, 8);
+
+    sensor_reading_t in[10];
+    for (int i = 0; i < 10; i++) {
+        in[i].sensor_id = 1;
+        in[i].temperature = (float)i;
+        in[i].timestamp = time(NULL);
+    }
+
+    // Batch larger than the free space is truncated
+    assert(queue_push_batch(&q, in, 5) == 5);
+    assert(queue_push_batch(&q, in + 5, 5) == 3);
+    assert(queue_size(&q) == 8);
+    assert(queue_push_batch(&q, in, 1) == 0);
+
+    // Drain is capped by max_items and preserves order
+    sensor_reading_t out[16];
+    assert(queue_pop_batch(&q, out, 4) == 4);
+    for (int i = 0; i < 4; i++) {
+        assert(out[i].temperature == (float)i);
+    }
+    assert(queue_pop_batch(&q, out, 16) == 4);
+    for (int i = 0; i < 4; i++) {
+        assert(out[i].temperature == (float)(i + 4));
+    }
+    assert(queue_size(&q) == 0);
+
+    // Batches can straddle the end of the ring
+    assert(queue_push_batch(&q, in, 6) == 6);
+    assert(queue_pop_batch(&q, out, 16) == 6);
+    assert(out[5].temperature == 5.0f);
+
+    // Empty queue with exit signaled returns -1
+    set_exit_flag();
+    assert(queue_pop_batch(&q, out, 16) == -1);
+    init_utils();
+
+    queue_destroy(&q);
+    printf("  PASSED\n");
+}
+
+void test_queue_stats() {
+    printf("Testing queue_get_stats...\n");
+    queue_t q;
+    queue_init(&q, 4);
+
+    queue_stats_t stats;
+    queue_get_stats(&q, &stats);
+    assert(stats.depth == 0 && stats.high_water == 0 && stats.dropped == 0);
+    assert(stats.capacity == 4);
+
+    // Drops from both push paths are counted
+    sensor_reading_t in[6] = {{.sensor_id = 1, .temperature = 20.0f, .timestamp = 0}};
+    assert(queue_push_batch(&q, in, 3) == 3);
+    assert(queue_push_batch(&q, in, 3) == 1);
+    assert(queue_push(&q, in[0]) == -1);
+    queue_get_stats(&q, &stats);
+    assert(stats.depth == 4 && stats.dropped == 3);
+
+    // High water is the depth the consumer found, and outlives the drain
+    sensor_reading_t out[8];
+    assert(queue_pop_batch(&q, out, 1) == 1);
+    assert(queue_pop_batch(&q, out, 8) == 3);
+    assert(queue_push(&q, in[0]) == 0);
+    assert(queue_pop(&q, out) == 0);
+    queue_get_stats(&q, &stats);
+    assert(stats.depth == 0 && stats.high_water == 4);
+
+    queue_destroy(&q);
+    printf("  PASSED\n");
+}
+
+void test_queue_pop_exit() {
+    printf("Testing queue_pop returns on exit...\n");
+    queue_t q;
+    queue_init(&q, 4);
+
+    // Pending items are still drained after exit is signaled
+    sensor_reading_t reading = {.sensor_id = 1, .temperature = 23.5f, .timestamp = time(NULL)};
+    sensor_reading_t popped;
+    assert(queue_push(&q, reading) == 0);
+    set_exit_flag();
+    assert(queue_pop(&q, &popped) == 0);
+    assert(queue_pop(&q, &popped) == -1);
+    init_utils();
+
+    queue_destroy(&q);
+    printf("  PASSED\n");
+}
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void test_queue_pop_until() {
+    printf("Testing queue_pop_batch_until...\n");
+    queue_t q;
+    queue_init(&q, 4);
+    sensor_reading_t out[4];
+
+    // Empty: gives up at the deadline
+    uint64_t start = monotonic_ns();
+    assert(queue_pop_batch_until(&q, out, 4, start + 20000000ULL) == 0);
+    assert(monotonic_ns() - start >= 20000000ULL);
+
+    // A deadline in the past still returns what is there
+    sensor_reading_t reading = {.sensor_id = 2, .temperature = 21.5f, .timestamp = 0};
+    assert(queue_push(&q, reading) == 0);
+    assert(queue_pop_batch_until(&q, out, 4, 0) == 1);
+    assert(out[0].sensor_id == 2);
+    assert(queue_pop_batch_until(&q, out, 4, 0) == 0);
+
+    set_exit_flag();
+    assert(queue_pop_batch_until(&q, out, 4, monotonic_ns() + 1000000000ULL) == -1);
+    init_utils();
+
+    queue_destroy(&q);
+    printf("  PASSED\n");
+}
+
+static void *signal_exit(void *arg) {
+    struct timespec delay = { 0, 20000000L };
+    nanosleep(&delay, NULL);
+    set_exit_flag();
+    queue_wakeup(arg);
+    return NULL;
+}
+
+void test_queue_sleep_until() {
+    printf("Testing queue_sleep_until...\n");
+    queue_t q;
+    queue_init(&q, 4);
+    sensor_reading_t out[4];
+
+    // Sleeps through arrivals and leaves them queued
+    sensor_reading_t reading = {.sensor_id = 3, .temperature = 20.0f, .timestamp = 0};
+    assert(queue_push(&q, reading) == 0);
+    uint64_t start = monotonic_ns();
+    assert(queue_sleep_until(&q, start + 20000000ULL) == 0);
+    assert(monotonic_ns() - start >= 20000000ULL);
+    assert(queue_pop_batch_until(&q, out, 4, 0) == 1);
+
+    // Shutdown cuts a long sleep short
+    pthread_t thread;
+    start = monotonic_ns();
+    pthread_create(&thread, NULL, signal_exit, &q);
+    assert(queue_sleep_until(&q, start + 10000000000ULL) == -1);
+    assert(monotonic_ns() - start < 5000000000ULL);
+    pthread_join(thread, NULL);
+    init_utils();
+
+    queue_destroy(&q);
+    printf("  PASSED\n");
+}
+
 int main(void) {
     printf("\n=== Queue Tests ===\n");
 
@@ -94,6 +329,13 @@ int main(void) {
     test_queue_push_pop();
     test_queue_max_size();
     test_queue_unbounded();
+    test_queue_wraparound();
+    test_queue_multi_producer();
+    test_queue_batch();
+    test_queue_stats();
+    test_queue_pop_exit();
+    test_queue_pop_until();
+    test_queue_sleep_until();
 
     printf("\nAll queue tests passed!\n\n");
     return 0;
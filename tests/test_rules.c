@@ -0,0 +1,317 @@
+#include "../src/rules.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+
+#define T0 1700000000000ULL     // Unix ms
+
+// Parse a rule that must be valid
+static rule_t parse(const char *line) {
+    rule_t rule;
+    char error[128];
+    int rc = rule_parse(line, &rule, error, sizeof(error));
+    if (rc != 0) {
+        fprintf(stderr, "'%s': %s\n", line, error);
+    }
+    assert(rc == 0);
+    return rule;
+}
+
+// Start the engine on the given rules for sensors 1-4, without a log
+static void start(const char **lines, int count) {
+    rule_t rules[16];
+    for (int i = 0; i < count; i++) {
+        rules[i] = parse(lines[i]);
+    }
+    assert(rules_init(rules, count, 4, "") == 0);
+}
+
+static int active_count(void) {
+    rules_alert_t alerts[16];
+    return rules_active(alerts, 16);
+}
+
+void test_rule_parse() {
+    printf("Testing rule parsing...\n");
+
+    rule_t r = parse("over_temp  sensor3 >  45 for 30s   clear < 43 for 10s");
+    assert(strcmp(r.name, "over_temp") == 0 && r.sensor == 3);
+    assert(strcmp(r.expr, "sensor3 > 45 for 30s clear < 43 for 10s") == 0);
+    assert(r.kind == RULE_VALUE && r.op == RULE_GT && r.threshold == 45);
+    assert(r.for_ms == 30000 && r.has_clear && r.clear_op == RULE_LT);
+    assert(r.clear_threshold == 43 && r.clear_for_ms == 10000);
+
+    r = parse("fast_rise sensor1 rate >= 3/min for 1m");
+    assert(r.kind == RULE_RATE && r.op == RULE_GE && r.threshold == 0.05f && r.for_ms == 60000);
+    r = parse("cooling sensor1 rate < -0.5/s");
+    assert(r.threshold == -0.5f && r.for_ms == 0 && !r.has_clear);
+    r = parse("lost sensor255 stale 1500ms");
+    assert(r.kind == RULE_STALE && r.sensor == 255 && r.for_ms == 1500);
+    r = parse("frozen sensor2 <= -10.5 for 2h");
+    assert(r.op == RULE_LE && r.threshold == -10.5f && r.for_ms == 7200000);
+
+    const char *bad[] = {
+        "",                                     // Nothing
+        "lonely",                               // No condition
+        "x sensor0 > 1",                        // Sensor out of range
+        "x sensor256 > 1",
+        "x sensorA > 1",
+        "x sensor1x > 1",
+        "x sensor1 = 1",                        // Unknown comparison
+        "x sensor1 > warm",
+        "x sensor1 > 1/min",                    // Units only on rates
+        "x sensor1 rate > 1/h",
+        "x sensor1 > 1 for 30",                 // Durations need a unit
+        "x sensor1 > 1 for -5s",
+        "x sensor1 > 1 for 5d",
+        "x sensor1 > 1 for",
+        "x sensor1 stale 0s",
+        "x sensor1 stale 5s for 1s",            // Stale takes no other clauses
+        "x sensor1 > 45 clear < 47",            // Clear overlaps the condition
+        "x sensor1 > 45 clear > 40",            // Clear on the same side
+        "x sensor1 >= 45 clear <= 45",
+        "x sensor1 < 5 clear > 4",
+        "x sensor1 > 45 clear < 43 for",
+        "x sensor1 > 45 maybe",                 // Trailing words
+        "x,y sensor1 > 45",                     // Names go into CSV and JSON
+        "a_name_that_is_far_too_long_for_the_log sensor1 > 45",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        rule_t rule;
+        char error[128] = "";
+        assert(rule_parse(bad[i], &rule, error, sizeof(error)) == -1);
+        assert(error[0] != '\0');
+    }
+    assert(parse("x sensor1 > 45 clear <= 45").has_clear);   // Touching is fine
+
+    printf("  PASSED\n");
+}
+
+void test_rules_threshold() {
+    printf("Testing threshold for a duration with hysteresis...\n");
+
+    const char *lines[] = { "hot sensor3 > 45 for 30s clear < 43 for 10s" };
+    start(lines, 1);
+    assert(rules_count() == 1);
+
+    // Above the threshold, but not for 30 s: a dip resets the timer
+    rules_reading(3, T0, 46);
+    rules_reading(3, T0 + 20000, 47);
+    rules_reading(3, T0 + 25000, 44);
+    rules_reading(3, T0 + 40000, 46);
+    rules_reading(3, T0 + 69000, 46);
+    assert(active_count() == 0);
+    rules_reading(3, T0 + 70000, 45.5f);
+    rules_alert_t alert;
+    assert(rules_active(&alert, 1) == 1);
+    assert(strcmp(alert.name, "hot") == 0 && alert.sensor == 3);
+    assert(alert.since_ms == T0 + 70000 && alert.value == 45.5f);
+
+    // Inside the hysteresis band the alert stays on
+    rules_reading(3, T0 + 80000, 44);
+    rules_reading(3, T0 + 200000, 43.5f);
+    assert(active_count() == 1);
+
+    // Below the clear threshold, but not for 10 s
+    rules_reading(3, T0 + 201000, 42);
+    rules_reading(3, T0 + 205000, 43.5f);
+    rules_reading(3, T0 + 206000, 42);
+    rules_reading(3, T0 + 215000, 42);
+    assert(active_count() == 1);
+    rules_reading(3, T0 + 216000, 41);
+    assert(active_count() == 0);
+
+    rules_event_t events[4];
+    assert(rules_events(events, 4) == 2);
+    assert(events[0].firing == 1 && events[0].time_ms == T0 + 70000);
+    assert(events[1].firing == 0 && events[1].time_ms == T0 + 216000 && events[1].value == 41);
+
+    // Readings of other sensors never touch the rule
+    rules_reading(1, T0 + 300000, 99);
+    rules_reading(4, T0 + 300000, 99);
+    rules_reading(9, T0 + 300000, 99);
+    assert(rules_events(events, 4) == 2);
+
+    // Without a clear condition an alert clears as soon as the condition is false
+    const char *plain[] = { "cold sensor1 <= 5", "warm sensor1 > 20" };
+    start(plain, 2);
+    rules_reading(1, T0, 5);
+    assert(active_count() == 1);
+    rules_reading(1, T0 + 1000, 5.1f);
+    assert(active_count() == 0);
+
+    rules_destroy();
+    printf("  PASSED\n");
+}
+
+void test_rules_rate() {
+    printf("Testing rate-of-change rules...\n");
+
+    const char *lines[] = { "rising sensor2 rate > 6/min for 5s", "falling sensor2 rate < -1" };
+    start(lines, 2);
+
+    // 0.05 °C/s: below 0.1 °C/s
+    for (int s = 0; s <= 10; s++) {
+        rules_reading(2, T0 + (uint64_t)s * 1000, 20.0f + s * 0.05f);
+    }
+    assert(active_count() == 0);
+
+    // 0.2 °C/s for 5 s fires, steady clears
+    float v = 20.5f;
+    for (int s = 11; s <= 16; s++) {
+        v += 0.2f;
+        rules_reading(2, T0 + (uint64_t)s * 1000, v);
+    }
+    rules_alert_t alerts[2];
+    assert(rules_active(alerts, 2) == 1 && strcmp(alerts[0].name, "rising") == 0);
+    assert(alerts[0].value > 0.19f && alerts[0].value < 0.21f);
+    rules_reading(2, T0 + 17000, v);
+    assert(active_count() == 0);
+
+    // A 3 °C drop in 2 s fires immediately
+    rules_reading(2, T0 + 19000, v - 3);
+    assert(rules_active(alerts, 2) == 1 && strcmp(alerts[0].name, "falling") == 0);
+
+    // Two readings at the same time have no rate
+    rules_reading(2, T0 + 19000, v + 50);
+    assert(rules_active(alerts, 2) == 1 && strcmp(alerts[0].name, "falling") == 0);
+
+    rules_destroy();
+    printf("  PASSED\n");
+}
+
+void test_rules_stale() {
+    printf("Testing stale rules...\n");
+
+    const char *lines[] = { "lost1 sensor1 stale 10s", "lost2 sensor2 stale 30s",
+                            "hot1 sensor1 > 40" };
+    start(lines, 3);
+
+    // Sensors that never report go stale from the first tick
+    assert(rules_tick(T0) == T0 + 10000);
+    rules_reading(1, T0 + 5000, 20);
+    assert(rules_tick(T0 + 6000) == T0 + 10000);     // Not rescanned until then
+    assert(rules_tick(T0 + 10000) == T0 + 15000);
+    assert(rules_tick(T0 + 15000) == T0 + 30000);
+    rules_alert_t alerts[4];
+    assert(rules_active(alerts, 4) == 1 && strcmp(alerts[0].name, "lost1") == 0);
+    assert(alerts[0].since_ms == T0 + 15000);
+
+    // Firing rules are not due again; a reading clears them
+    assert(rules_tick(T0 + 16000) == T0 + 30000);
+    rules_reading(1, T0 + 17000, 41);
+    assert(rules_active(alerts, 4) == 1 && strcmp(alerts[0].name, "hot1") == 0);
+
+    // Both stale again: lost1 10 s after that reading, lost2 30 s after start
+    assert(rules_tick(T0 + 30000) == 0);
+    assert(rules_active(alerts, 4) == 3);
+    assert(strcmp(alerts[1].name, "lost1") == 0 && alerts[1].since_ms == T0 + 30000);
+    assert(strcmp(alerts[2].name, "lost2") == 0);
+
+    rules_event_t events[8];
+    assert(rules_events(events, 8) == 5);
+    assert(strcmp(events[2].name, "lost1") == 0 && events[2].firing == 0);
+    assert(events[2].time_ms == T0 + 17000);
+
+    rules_destroy();
+    assert(rules_count() == 0 && active_count() == 0);
+    printf("  PASSED\n");
+}
+
+void test_rules_index() {
+    printf("Testing rule indexing and the event ring...\n");
+
+    // Rules are grouped by sensor whatever the file order, and rules for
+    // sensors that are not configured are dropped
+    const char *lines[] = { "a4 sensor4 > 1", "a1 sensor1 > 1", "b4 sensor4 > 2",
+                            "lost4 sensor4 stale 1h", "c4 sensor4 > 3", "x9 sensor9 > 1" };
+    start(lines, 6);
+    assert(rules_count() == 5);
+    rules_reading(4, T0, 10);
+    rules_alert_t alerts[8];
+    assert(rules_active(alerts, 8) == 3);
+    assert(strcmp(alerts[0].name, "a4") == 0 && strcmp(alerts[1].name, "b4") == 0);
+    assert(strcmp(alerts[2].name, "c4") == 0);
+    assert(rules_active(alerts, 1) == 3);
+
+    // The ring keeps the newest RULES_EVENTS events, oldest first
+    for (int i = 1; i <= RULES_EVENTS; i++) {
+        rules_reading(4, T0 + (uint64_t)i * 1000, (i % 2) ? 0 : 10);
+    }
+    static rules_event_t events[RULES_EVENTS + 1];
+    assert(rules_events(events, RULES_EVENTS + 1) == RULES_EVENTS);
+    assert(events[RULES_EVENTS - 1].time_ms == T0 + RULES_EVENTS * 1000);
+    assert(events[RULES_EVENTS - 1].firing == 1);
+    assert(events[0].time_ms < events[RULES_EVENTS - 1].time_ms);
+    assert(rules_events(events, 2) == 2 && events[1].time_ms == T0 + RULES_EVENTS * 1000);
+
+    rules_destroy();
+    printf("  PASSED\n");
+}
+
+void test_rules_files() {
+    printf("Testing rules files and the alert log...\n");
+
+    char rules_path[] = "/tmp/test_rules_XXXXXX";
+    int fd = mkstemp(rules_path);
+    assert(fd >= 0);
+    const char *text = "# Rack alerts\n"
+                       "\n"
+                       "hot   sensor1 > 30 clear < 28\n"
+                       "  broken sensor1 >\n"           // Reported and skipped
+                       "lost  sensor2 stale 5s\n";
+    assert(write(fd, text, strlen(text)) == (ssize_t)strlen(text));
+    close(fd);
+
+    rule_t *rules = NULL;
+    int count = rules_load_file(rules_path, &rules);
+    assert(count == 2);
+    assert(strcmp(rules[0].name, "hot") == 0 && strcmp(rules[1].name, "lost") == 0);
+    assert(rules_load_file("/nonexistent/rules", &rules) == -1);
+
+    char log_path[] = "/tmp/test_alerts_XXXXXX";
+    fd = mkstemp(log_path);
+    assert(fd >= 0);
+    close(fd);
+    assert(rules_init(rules, count, 2, log_path) == 0);
+    free(rules);
+
+    rules_tick(T0);
+    rules_reading(1, T0 + 1000, 31);
+    rules_reading(1, T0 + 2000, 29);
+    rules_reading(1, T0 + 3000, 27.5f);
+    rules_tick(T0 + 6000);
+    rules_destroy();
+
+    FILE *log = fopen(log_path, "r");
+    assert(log);
+    char line[128];
+    const char *expected[] = { "timestamp,rule,sensor,state,value\n", ".000,hot,1,firing,31.00\n",
+                               ".000,hot,1,cleared,27.50\n", ".000,lost,2,firing,0.00\n" };
+    for (int i = 0; i < 4; i++) {
+        assert(fgets(line, sizeof(line), log));
+        assert(strstr(line, expected[i]) != NULL);
+    }
+    assert(!fgets(line, sizeof(line), log));
+    fclose(log);
+
+    unlink(rules_path);
+    unlink(log_path);
+    printf("  PASSED\n");
+}
+
+int main(void) {
+    printf("\n=== Rules Tests ===\n");
+
+    test_rule_parse();
+    test_rules_threshold();
+    test_rules_rate();
+    test_rules_stale();
+    test_rules_index();
+    test_rules_files();
+
+    printf("\nAll rules tests passed!\n\n");
+    return 0;
+}
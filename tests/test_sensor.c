@@ -0,0 +1,187 @@
+#include "../src/sensor.h"
+#include <stdio.h>
+#include <assert.h>
+
+#define SEC 1000000000ULL
+
+void test_schedule_order() {
+    printf("Testing sensor schedule deadline order...\n");
+
+    sensor_config_t sensors[] = {
+        { .id = 1, .address = 0x48, .interval_ms = 1000 },
+        { .id = 2, .address = 0x49, .interval_ms = 2000 },
+        { .id = 7, .address = 0x4a, .interval_ms = 3000 },
+    };
+    sensor_schedule_t schedule;
+    assert(sensor_schedule_init(&schedule, sensors, 3, 10 * SEC) == 0);
+    assert(schedule.count == 3);
+
+    // Over 6 s the sensors are read 6, 3 and 2 times, never out of deadline order
+    int reads[8] = {0};
+    uint64_t last_due = 0;
+    while (schedule.slots[0].due_ns < 16 * SEC) {
+        const sensor_slot_t *next = &schedule.slots[0];
+        assert(next->due_ns >= last_due);
+        last_due = next->due_ns;
+        reads[next->sensor->id]++;
+        // Reads finish on time, so deadlines stay on the interval grid
+        sensor_schedule_advance(&schedule, next->due_ns);
+    }
+    assert(reads[1] == 6);
+    assert(reads[2] == 3);
+    assert(reads[7] == 2);
+
+    sensor_schedule_destroy(&schedule);
+    printf("  PASSED\n");
+}
+
+void test_schedule_late() {
+    printf("Testing sensor schedule after a stall...\n");
+
+    sensor_config_t sensors[] = {
+        { .id = 1, .address = 0x48, .interval_ms = 1000 },
+        { .id = 2, .address = 0x49, .interval_ms = 10000 },
+    };
+    sensor_schedule_t schedule;
+    assert(sensor_schedule_init(&schedule, sensors, 2, 0) == 0);
+
+    // Sensor 1 is read 5 s late: it moves on to the first deadline after now
+    // instead of catching up
+    assert(schedule.slots[0].sensor->id == 1);
+    sensor_schedule_advance(&schedule, 5 * SEC);
+    assert(schedule.slots[0].sensor->id == 2);
+    sensor_schedule_advance(&schedule, 5 * SEC);
+    assert(schedule.slots[0].sensor->id == 1);
+    assert(schedule.slots[0].due_ns == 6 * SEC);
+
+    // Less than an interval late: the next deadline stays on the grid
+    sensor_schedule_advance(&schedule, 6 * SEC + SEC / 2);
+    assert(schedule.slots[0].due_ns == 7 * SEC);
+    assert(schedule.slots[1].due_ns == 10 * SEC);
+
+    sensor_schedule_destroy(&schedule);
+    printf("  PASSED\n");
+}
+
+void test_schedule_take_due() {
+    printf("Testing sensor schedule sweeps...\n");
+
+    sensor_config_t sensors[] = {
+        { .id = 1, .address = 0x48, .interval_ms = 1000 },
+        { .id = 2, .address = 0x49, .interval_ms = 2000 },
+        { .id = 3, .address = 0x4a, .interval_ms = 2000 },
+    };
+    sensor_schedule_t schedule;
+    assert(sensor_schedule_init(&schedule, sensors, 3, 0) == 0);
+    sensor_due_t due[3];
+
+    // Everything starts due together
+    assert(sensor_schedule_take_due(&schedule, 0, due) == 3);
+    assert(sensor_schedule_take_due(&schedule, SEC / 2, due) == 0);
+    assert(sensor_schedule_take_due(&schedule, SEC, due) == 1);
+    assert(due[0].sensor->id == 1 && due[0].late_ns == 0 && due[0].missed == 0);
+    assert(sensor_schedule_take_due(&schedule, 2 * SEC, due) == 3);
+
+    // A second late, sensor 1 is still due after advancing but is only taken
+    // once per sweep. Sweeps list sensors in deadline order.
+    assert(sensor_schedule_take_due(&schedule, 4 * SEC + SEC / 2, due) == 3);
+    assert(due[0].sensor->id == 1 && due[0].late_ns == SEC + SEC / 2);
+    assert(due[1].late_ns == SEC / 2 && due[2].late_ns == SEC / 2);
+    assert(due[0].missed == 0);
+    assert(schedule.slots[0].sensor->id == 1 && schedule.slots[0].due_ns == 4 * SEC);
+    assert(sensor_schedule_take_due(&schedule, 4 * SEC + SEC / 2, due) == 1);
+    assert(schedule.slots[0].due_ns == 5 * SEC);
+
+    // Three and a half seconds behind: the deadlines at 6, 7 and 8 s are
+    // dropped and sensor 1 waits for 9 s rather than being read again at once
+    assert(sensor_schedule_take_due(&schedule, 8 * SEC + SEC / 2, due) == 3);
+    assert(due[0].sensor->id == 1 && due[0].missed == 3);
+    assert(due[1].missed == 0 && due[2].missed == 0);
+    assert(sensor_schedule_take_due(&schedule, 8 * SEC + SEC / 2, due) == 2);
+    assert(due[0].sensor->id != 1 && due[1].sensor->id != 1);
+    assert(schedule.slots[0].sensor->id == 1 && schedule.slots[0].due_ns == 9 * SEC);
+
+    sensor_schedule_destroy(&schedule);
+    printf("  PASSED\n");
+}
+
+void test_schedule_no_drift() {
+    printf("Testing 8 Hz schedule without drift...\n");
+
+    sensor_config_t sensors[] = {
+        { .id = 1, .address = 0x48, .interval_ms = 125 },
+        { .id = 2, .address = 0x49, .interval_ms = 250 },
+    };
+    sensor_schedule_t schedule;
+    assert(sensor_schedule_init(&schedule, sensors, 2, 0) == 0);
+    sensor_due_t due[2];
+
+    // Each sweep takes 30 ms and wakes 1 ms late; deadlines stay on the grid
+    // regardless, so 60 s gives exactly 480 and 240 reads
+    int reads[3] = {0};
+    uint64_t now = 0;
+    while (schedule.slots[0].due_ns < 60 * SEC) {
+        now = schedule.slots[0].due_ns + SEC / 1000;
+        int n = sensor_schedule_take_due(&schedule, now, due);
+        for (int i = 0; i < n; i++) {
+            assert(due[i].late_ns == SEC / 1000 && due[i].missed == 0);
+            reads[due[i].sensor->id]++;
+        }
+        now += 30 * SEC / 1000;
+    }
+    assert(reads[1] == 480 && reads[2] == 240);
+    assert(schedule.slots[0].due_ns == 60 * SEC);
+
+    sensor_schedule_destroy(&schedule);
+    printf("  PASSED\n");
+}
+
+void test_read_tmp102() {
+    printf("Testing TMP102 reads on a fake bus...\n");
+
+    i2c_fake_t fake;
+    i2c_fake_init(&fake);
+    uint8_t warm[2] = { 0x19, 0x40 };   // 25.25 °C
+    uint8_t cold[2] = { 0xe7, 0x00 };   // -25 °C
+    i2c_fake_set_register(&fake, 0x48, 0x00, warm, 2);
+    i2c_fake_set_register(&fake, 0x49, 0x00, cold, 2);
+
+    i2c_bus_t bus;
+    assert(i2c_bus_init(&bus, "/dev/i2c-fake", &i2c_fake_backend, &fake) == 0);
+    assert(sensor_read_tmp102(&bus, 0x48) == 25.25f);
+    assert(sensor_read_tmp102(&bus, 0x49) == -25.0f);
+    assert(sensor_read_tmp102(&bus, 0x4a) == -999);
+
+    // A sweep reads both in one transfer; a missing sensor does not spoil it
+    sensor_config_t sensors[] = {
+        { .id = 1, .address = 0x48 }, { .id = 2, .address = 0x49 }, { .id = 3, .address = 0x4a },
+    };
+    sensor_due_t sweep[] = { { .sensor = &sensors[0] }, { .sensor = &sensors[1] },
+                             { .sensor = &sensors[2] } };
+    float temps[3];
+    i2c_bus_stats_t before, after;
+    i2c_bus_get_stats(&bus, &before);
+    sensor_read_tmp102_sweep(&bus, sweep, 2, temps);
+    i2c_bus_get_stats(&bus, &after);
+    assert(temps[0] == 25.25f && temps[1] == -25.0f);
+    assert(after.transfers == before.transfers + 1);
+
+    sensor_read_tmp102_sweep(&bus, sweep, 3, temps);
+    assert(temps[0] == 25.25f && temps[1] == -25.0f && temps[2] == -999);
+    i2c_bus_destroy(&bus);
+
+    printf("  PASSED\n");
+}
+
+int main(void) {
+    printf("\n=== Sensor Tests ===\n");
+
+    test_schedule_order();
+    test_schedule_late();
+    test_schedule_take_due();
+    test_schedule_no_drift();
+    test_read_tmp102();
+
+    printf("\nAll sensor tests passed!\n\n");
+    return 0;
+}
@@ -0,0 +1,296 @@
+#include "../src/simd_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <math.h>
+
+#define MAX_LEN 200003
+
+static float fdata[MAX_LEN + 8];
+static int16_t idata[MAX_LEN + 8];
+
+static uint32_t seed = 12345;
+
+static uint32_t next_random(void) {
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+// A thermistor-like trace: around 25 °C, drifting, with noise
+static void fill_float(float *x, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        x[i] = 25.0f + (float)(i % 1000) / 500.0f + (float)(next_random() % 1000) / 4000.0f;
+    }
+}
+
+// Two-pass reference in double
+static void reference(const float *x, size_t n, simd_stats_t *out) {
+    double sum = 0, sq = 0;
+    float min = x[0], max = x[0];
+    for (size_t i = 0; i < n; i++) {
+        sum += x[i];
+        if (x[i] < min) min = x[i];
+        if (x[i] > max) max = x[i];
+    }
+    double mean = sum / n;
+    for (size_t i = 0; i < n; i++) {
+        sq += (x[i] - mean) * (x[i] - mean);
+    }
+    *out = (simd_stats_t){ n, min, max, mean, sqrt(sq / n) };
+}
+
+static void check_close(const simd_stats_t *a, const simd_stats_t *b, double tolerance) {
+    assert(a->count == b->count);
+    assert(a->min == b->min);
+    assert(a->max == b->max);
+    assert(fabs(a->mean - b->mean) <= tolerance * (1 + fabs(b->mean)));
+    assert(fabs(a->stddev - b->stddev) <= tolerance * (1 + b->stddev));
+}
+
+// Run fn under every kernel set this machine supports
+static void for_each_level(void (*fn)(simd_level_t level)) {
+    simd_level_t best = simd_stats_level();
+    for (int level = 0; level < SIMD_LEVEL_COUNT; level++) {
+        if (simd_stats_use((simd_level_t)level) == 0) {
+            fn((simd_level_t)level);
+        }
+    }
+    assert(simd_stats_use(best) == 0);
+}
+
+void test_simd_dispatch() {
+    printf("Testing kernel dispatch...\n");
+
+    simd_level_t best = simd_stats_level();
+    assert(simd_stats_supported(best));
+    assert(simd_stats_supported(SIMD_SCALAR));
+    assert(simd_stats_use(SIMD_LEVEL_COUNT) == -1);
+#if defined(__x86_64__)
+    assert(best == SIMD_SSE2 || best == SIMD_AVX2);
+    assert(!simd_stats_supported(SIMD_NEON));
+#elif defined(__aarch64__)
+    assert(best == SIMD_NEON);
+#endif
+    for (int level = 0; level < SIMD_LEVEL_COUNT; level++) {
+        printf("  %-6s %s\n", simd_stats_level_name((simd_level_t)level),
+               simd_stats_supported((simd_level_t)level) ? "supported" : "-");
+    }
+    assert(simd_stats_use(SIMD_SCALAR) == 0);
+    assert(simd_stats_level() == SIMD_SCALAR);
+    assert(simd_stats_use(best) == 0);
+
+    printf("  PASSED\n");
+}
+
+static void empty_and_single(simd_level_t level) {
+    (void)level;
+    simd_stats_t st;
+    simd_stats_f32(fdata, 0, &st);
+    assert(st.count == 0 && st.min == 0 && st.max == 0 && st.mean == 0 && st.stddev == 0);
+
+    float one = 21.5f;
+    simd_stats_f32(&one, 1, &st);
+    assert(st.count == 1 && st.min == one && st.max == one && st.mean == one && st.stddev == 0);
+
+    int16_t raw = -1234;
+    simd_stats_acc_t acc;
+    simd_stats_begin(&acc);
+    simd_stats_add_i16(&acc, &raw, 1, 0.01f);
+    simd_stats_end(&acc, &st);
+    assert(st.count == 1 && st.min == raw * 0.01f && st.stddev == 0);
+    assert(fabs(st.mean - raw * 0.01f) < 1e-6);
+}
+
+void test_simd_empty() {
+    printf("Testing empty and single-element arrays...\n");
+    for_each_level(empty_and_single);
+    printf("  PASSED\n");
+}
+
+static void float_lengths(simd_level_t level) {
+    static const size_t lengths[] = { 2, 3, 7, 8, 9, 15, 16, 17, 31, 33, 63, 64, 65, 100,
+                                      4095, 4096, 4097, 8193, 65536, 100003 };
+    // Every length at every alignment, so vector bodies and scalar tails both run
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        for (int offset = 0; offset < 4; offset++) {
+            const float *x = fdata + offset;
+            size_t n = lengths[l];
+            simd_stats_t got, want, scalar;
+            simd_stats_f32(x, n, &got);
+            reference(x, n, &want);
+            check_close(&got, &want, 1e-6);
+
+            simd_stats_use(SIMD_SCALAR);
+            simd_stats_f32(x, n, &scalar);
+            simd_stats_use(level);
+            check_close(&got, &scalar, 1e-6);
+        }
+    }
+
+    // The extremes anywhere in the array, including the tail
+    for (size_t pos = 0; pos < 37; pos++) {
+        fill_float(fdata, 37);
+        fdata[pos] = -40.0f;
+        fdata[36 - pos] = 125.0f;
+        simd_stats_t st;
+        simd_stats_f32(fdata, 37, &st);
+        if (pos != 18) {
+            assert(st.min == -40.0f && st.max == 125.0f);
+        }
+    }
+    fill_float(fdata, MAX_LEN + 8);
+}
+
+void test_simd_float() {
+    printf("Testing float kernels against the scalar reference...\n");
+    fill_float(fdata, MAX_LEN + 8);
+    for_each_level(float_lengths);
+    printf("  PASSED\n");
+}
+
+static void float_precision(simd_level_t level) {
+    // 200k readings of 25 °C +/- 0.005: a naive float sum would drift by
+    // far more than the spread
+    for (size_t i = 0; i < MAX_LEN; i++) {
+        fdata[i] = 25.0f + ((i % 3) == 0 ? 0.005f : (i % 3) == 1 ? -0.005f : 0.0f);
+    }
+    simd_stats_t got, want;
+    simd_stats_f32(fdata, MAX_LEN, &got);
+    reference(fdata, MAX_LEN, &want);
+    assert(fabs(got.mean - want.mean) < 1e-6);
+    assert(fabs(got.stddev - want.stddev) < 1e-6);
+    assert(fabs(got.stddev - 0.0040825) < 1e-5);
+    (void)level;
+
+    // A constant array has no spread at all
+    for (size_t i = 0; i < MAX_LEN; i++) {
+        fdata[i] = 23.4375f;
+    }
+    simd_stats_f32(fdata, MAX_LEN, &got);
+    assert(got.mean == 23.4375 && got.stddev == 0);
+    fill_float(fdata, MAX_LEN + 8);
+}
+
+void test_simd_precision() {
+    printf("Testing precision on long arrays...\n");
+    for_each_level(float_precision);
+    printf("  PASSED\n");
+}
+
+// Exact integer reference for fixed-point arrays
+static void i16_reference(const int16_t *x, size_t n, float scale, simd_stats_t *out) {
+    int64_t sum = 0;
+    int16_t min = x[0], max = x[0];
+    for (size_t i = 0; i < n; i++) {
+        sum += x[i];
+        if (x[i] < min) min = x[i];
+        if (x[i] > max) max = x[i];
+    }
+    double mean = (double)sum / n, sq = 0;
+    for (size_t i = 0; i < n; i++) {
+        sq += (x[i] - mean) * (x[i] - mean);
+    }
+    float lo = min * scale, hi = max * scale;
+    *out = (simd_stats_t){ n, lo < hi ? lo : hi, lo < hi ? hi : lo, mean * scale,
+                           sqrt(sq / n) * fabs(scale) };
+}
+
+static simd_stats_t i16_stats(const int16_t *x, size_t n, float scale) {
+    simd_stats_acc_t acc;
+    simd_stats_t st;
+    simd_stats_begin(&acc);
+    simd_stats_add_i16(&acc, x, n, scale);
+    simd_stats_end(&acc, &st);
+    return st;
+}
+
+static void fixed_point(simd_level_t level) {
+    (void)level;
+    // Centi-degrees around 25 °C, every length and alignment
+    for (size_t i = 0; i < MAX_LEN + 8; i++) {
+        idata[i] = (int16_t)(2500 + (int)(next_random() % 400) - 200);
+    }
+    static const size_t lengths[] = { 2, 7, 8, 9, 15, 16, 17, 33, 4097, 131072, 131081, MAX_LEN };
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        for (int offset = 0; offset < 3; offset++) {
+            simd_stats_t got = i16_stats(idata + offset, lengths[l], 0.01f), want;
+            i16_reference(idata + offset, lengths[l], 0.01f, &want);
+            check_close(&got, &want, 1e-9);
+        }
+    }
+
+    // Full-scale values: pairs of squares fill 32-bit lanes, and sums run
+    // well past a block
+    for (size_t i = 0; i < MAX_LEN; i++) {
+        idata[i] = -32768;
+    }
+    simd_stats_t got = i16_stats(idata, MAX_LEN, 1.0f);
+    assert(got.count == MAX_LEN && got.min == -32768 && got.max == -32768);
+    assert(got.mean == -32768 && got.stddev == 0);
+
+    for (size_t i = 0; i < MAX_LEN; i++) {
+        idata[i] = (i % 2) ? 32767 : -32768;
+    }
+    simd_stats_t want;
+    got = i16_stats(idata, MAX_LEN, 1.0f);
+    i16_reference(idata, MAX_LEN, 1.0f, &want);
+    check_close(&got, &want, 1e-9);
+
+    // A negative scale swaps min and max
+    got = i16_stats(idata, 2, -0.5f);
+    assert(got.min == -16383.5f && got.max == 16384.0f);
+}
+
+void test_simd_fixed_point() {
+    printf("Testing fixed-point kernels...\n");
+    for_each_level(fixed_point);
+    printf("  PASSED\n");
+}
+
+static void accumulate(simd_level_t level) {
+    (void)level;
+    // Pieces add up to the whole, for floats and mixed with fixed point
+    simd_stats_t whole, pieces;
+    simd_stats_f32(fdata, 10000, &whole);
+
+    simd_stats_acc_t acc;
+    simd_stats_begin(&acc);
+    simd_stats_add_f32(&acc, fdata, 3);
+    simd_stats_add_f32(&acc, fdata + 3, 0);
+    simd_stats_add_f32(&acc, fdata + 3, 6000);
+    simd_stats_add_f32(&acc, fdata + 6003, 3997);
+    simd_stats_end(&acc, &pieces);
+    check_close(&pieces, &whole, 1e-6);
+
+    int16_t raw[4] = { 2000, 2100, 2200, 2300 };
+    float values[4] = { 20.0f, 21.0f, 22.0f, 23.0f };
+    simd_stats_begin(&acc);
+    simd_stats_add_f32(&acc, values, 2);
+    simd_stats_add_i16(&acc, raw + 2, 2, 0.01f);
+    simd_stats_end(&acc, &pieces);
+    simd_stats_f32(values, 4, &whole);
+    assert(pieces.count == 4 && pieces.min == 20.0f && fabsf(pieces.max - 23.0f) < 1e-5f);
+    assert(fabs(pieces.mean - whole.mean) < 1e-5 && fabs(pieces.stddev - whole.stddev) < 1e-5);
+}
+
+void test_simd_accumulate() {
+    printf("Testing accumulation over several arrays...\n");
+    fill_float(fdata, MAX_LEN + 8);
+    for_each_level(accumulate);
+    printf("  PASSED\n");
+}
+
+int main(void) {
+    printf("\n=== SIMD Statistics Tests ===\n");
+
+    test_simd_dispatch();
+    test_simd_empty();
+    test_simd_float();
+    test_simd_precision();
+    test_simd_fixed_point();
+    test_simd_accumulate();
+
+    printf("\nAll SIMD statistics tests passed!\n\n");
+    return 0;
+}
@@ -1,6 +1,8 @@
 #include "../src/utils.h"
 #include <stdio.h>
 #include <assert.h>
+#include <string.h>
+#include <pthread.h>
 
 void test_exit_flag() {
     printf("Testing exit flag (C11 atomics)...\n");
@@ -19,11 +21,110 @@ void test_exit_flag() {
 }
 
 void test_latest_reading() {
-    printf("Testing latest_reading structure...\n");
+    printf("Testing latest_reading publish/read...\n");
 
-    assert(latest_reading.sensor1 == 0.0f);
-    assert(latest_reading.sensor2 == 0.0f);
-    assert(latest_reading.average == 0.0f);
+    // Starts out empty at version 0
+    latest_reading_t snap;
+    assert(latest_reading_read(&snap) == 0);
+    assert(latest_reading_version() == 0);
+    assert(snap.time_str[0] == '\0');
+    assert(snap.sensor_count == 0);
+    assert(snap.average == 0.0f);
+
+    latest_reading_t r = { .time_str = "2025-01-01 12:00:00", .average = 23.5f,
+                           .sensor_count = 2, .sensors = { 23.5f, -999.0f } };
+    latest_reading_publish(&r);
+    assert(latest_reading_version() == 1);
+    assert(latest_reading_read(&snap) == 1);
+    assert(strcmp(snap.time_str, r.time_str) == 0);
+    assert(snap.sensor_count == 2);
+    assert(snap.sensors[0] == 23.5f && snap.sensors[1] == -999.0f && snap.average == 23.5f);
+
+    // Only the sensors in use are copied; the rest of the snapshot is left alone
+    latest_reading_t wide = { .time_str = "2025-01-01 12:00:01", .average = 20.0f,
+                              .sensor_count = CONFIG_MAX_SENSORS };
+    for (int i = 0; i < CONFIG_MAX_SENSORS; i++) {
+        wide.sensors[i] = (float)i;
+    }
+    latest_reading_publish(&wide);
+    assert(latest_reading_read(&snap) == 2);
+    assert(snap.sensor_count == CONFIG_MAX_SENSORS);
+    assert(snap.sensors[CONFIG_MAX_SENSORS - 1] == (float)(CONFIG_MAX_SENSORS - 1));
+    latest_reading_publish(&r);
+    snap.sensors[2] = 1234.0f;
+    assert(latest_reading_read(&snap) == 3);
+    assert(snap.sensor_count == 2 && snap.sensors[1] == -999.0f);
+    assert(snap.sensors[2] == 1234.0f);
+
+    printf("  PASSED\n");
+}
+
+#define SEQLOCK_WRITES 200000
+#define SEQLOCK_READERS 4
+#define SEQLOCK_SENSORS 8
+
+static atomic_int writer_done;
+
+static void *seqlock_writer(void *arg) {
+    (void)arg;
+    for (int i = 1; i <= SEQLOCK_WRITES; i++) {
+        latest_reading_t r;
+        snprintf(r.time_str, sizeof(r.time_str), "%d", i);
+        r.sensor_count = SEQLOCK_SENSORS;
+        for (int s = 0; s < SEQLOCK_SENSORS; s++) {
+            r.sensors[s] = (float)i;
+        }
+        r.average = (float)i;
+        latest_reading_publish(&r);
+    }
+    atomic_store(&writer_done, 1);
+    return NULL;
+}
+
+static void *seqlock_reader(void *arg) {
+    long *reads = arg;
+    unsigned long last_version = 0;
+    while (!atomic_load(&writer_done)) {
+        latest_reading_t snap;
+        unsigned long version = latest_reading_read(&snap);
+        // Every field must come from the same publish, and versions never go back
+        assert(version >= last_version);
+        last_version = version;
+        char expected[64];
+        snprintf(expected, sizeof(expected), "%d", (int)snap.average);
+        assert(strcmp(snap.time_str, expected) == 0);
+        assert(snap.sensor_count == SEQLOCK_SENSORS);
+        for (int s = 0; s < SEQLOCK_SENSORS; s++) {
+            assert(snap.sensors[s] == snap.average);
+        }
+        (*reads)++;
+    }
+    return NULL;
+}
+
+void test_latest_reading_concurrent() {
+    printf("Testing latest_reading consistency under concurrent updates...\n");
+
+    // Start from a reading that follows the writer's pattern
+    latest_reading_t initial = { .time_str = "0", .sensor_count = SEQLOCK_SENSORS };
+    latest_reading_publish(&initial);
+    unsigned long start_version = latest_reading_version();
+    atomic_store(&writer_done, 0);
+    pthread_t writer, readers[SEQLOCK_READERS];
+    long reads[SEQLOCK_READERS] = {0};
+    for (int i = 0; i < SEQLOCK_READERS; i++) {
+        pthread_create(&readers[i], NULL, seqlock_reader, &reads[i]);
+    }
+    pthread_create(&writer, NULL, seqlock_writer, NULL);
+    pthread_join(writer, NULL);
+    for (int i = 0; i < SEQLOCK_READERS; i++) {
+        pthread_join(readers[i], NULL);
+    }
+
+    assert(latest_reading_version() == start_version + SEQLOCK_WRITES);
+    latest_reading_t snap;
+    latest_reading_read(&snap);
+    assert(snap.average == (float)SEQLOCK_WRITES);
 
     printf("  PASSED\n");
 }
@@ -33,6 +134,7 @@ int main(void) {
 
     test_exit_flag();
     test_latest_reading();
+    test_latest_reading_concurrent();
 
     printf("\nAll utils tests passed!\n\n");
     return 0;
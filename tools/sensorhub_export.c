@@ -0,0 +1,217 @@
+// sensorhub-export: convert a binary sensor log to the CSV layout written by
+// the CSV log format (timestamp,sensor1,...,sensorN,average).
+//
+// The input is either a single binary log file or, for segmented logs, the
+// configured log_file name. With --from/--to only rows in that time range are
+// exported, using the segment names and sparse indexes to skip ahead.
+#include "../src/binlog.h"
+#include "../src/log_segment.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <limits.h>
+
+#define EXPORT_MAX_SENSORS 255
+
+typedef struct {
+    time_t timestamp;
+    int16_t centi[EXPORT_MAX_SENSORS];
+    unsigned char valid[EXPORT_MAX_SENSORS];
+    int open;
+} export_row_t;
+
+typedef struct {
+    FILE *out;
+    int sensor_count;      // Columns in the output, from the first file exported
+    time_t from;
+    time_t to;
+    export_row_t row;
+    time_t cached_ts;
+    char time_str[64];
+    size_t skipped;
+} export_state_t;
+
+static void write_csv_header(export_state_t *st) {
+    fputs("timestamp", st->out);
+    for (int i = 1; i <= st->sensor_count; i++) {
+        fprintf(st->out, ",sensor%d", i);
+    }
+    fputs(",average\n", st->out);
+}
+
+static void emit_row(export_state_t *st) {
+    export_row_t *row = &st->row;
+    row->open = 0;
+    if (row->timestamp < st->from || row->timestamp > st->to) {
+        memset(row->valid, 0, sizeof(row->valid));
+        return;
+    }
+
+    if (row->timestamp != st->cached_ts) {
+        struct tm tm_info;
+        localtime_r(&row->timestamp, &tm_info);
+        strftime(st->time_str, sizeof(st->time_str), "%Y-%m-%d %H:%M:%S", &tm_info);
+        st->cached_ts = row->timestamp;
+    }
+
+    fputs(st->time_str, st->out);
+    long sum = 0;
+    int n = 0;
+    for (int i = 0; i < st->sensor_count; i++) {
+        if (row->valid[i]) {
+            fprintf(st->out, ",%.2f", binlog_from_centi(row->centi[i]));
+            sum += row->centi[i];
+            n++;
+        } else {
+            fputs(",N/A", st->out);
+        }
+    }
+    // The average is not stored; it is the mean of the row's valid values
+    fprintf(st->out, ",%.2f\n", n > 0 ? (float)sum / n / 100.0f : 0.0f);
+    memset(row->valid, 0, sizeof(row->valid));
+}
+
+// Export one binary log file starting at a byte offset (0 = first record).
+// Returns 1 once a row past st->to has been seen, 0 to continue, -1 on error.
+static int export_file(export_state_t *st, const char *path, uint64_t offset) {
+    binlog_reader_t reader;
+    if (binlog_open(path, &reader) != 0) {
+        return -1;
+    }
+
+    if (st->sensor_count == 0) {
+        st->sensor_count = reader.header->sensor_count;
+        if (st->sensor_count > EXPORT_MAX_SENSORS) {
+            st->sensor_count = EXPORT_MAX_SENSORS;
+        }
+        write_csv_header(st);
+    }
+
+    size_t first = 0;
+    if (offset > sizeof(binlog_header_t)) {
+        first = (size_t)(offset - sizeof(binlog_header_t)) / sizeof(binlog_record_t);
+    }
+
+    int done = 0;
+    for (size_t i = first; i < reader.count && !done; i++) {
+        const binlog_record_t *rec = &reader.records[i];
+        if ((rec->flags & BINLOG_FLAG_ROW_START) && st->row.open) {
+            done = st->row.timestamp > st->to;
+            emit_row(st);
+            if (done) break;
+        }
+        if (rec->sensor_id < 1 || rec->sensor_id > st->sensor_count) {
+            st->skipped++;
+            continue;
+        }
+        st->row.timestamp = binlog_record_time(reader.header, rec);
+        st->row.centi[rec->sensor_id - 1] = rec->temp_centi;
+        st->row.valid[rec->sensor_id - 1] = (rec->flags & BINLOG_FLAG_VALID) != 0;
+        st->row.open = 1;
+    }
+    // Rows never span files
+    if (st->row.open) {
+        done = done || st->row.timestamp > st->to;
+        emit_row(st);
+    }
+
+    binlog_close(&reader);
+    return done;
+}
+
+// Export a segmented log family, starting at the segment holding st->from
+static int export_segments(export_state_t *st, const char *log_file) {
+    char start_path[512];
+    uint64_t offset = 0;
+    if (logseg_seek(log_file, st->from, start_path, sizeof(start_path), &offset) != 0) {
+        fprintf(stderr, "No log file or segments found for '%s'\n", log_file);
+        return -1;
+    }
+
+    logseg_info_t *segments;
+    int count = logseg_list(log_file, &segments);
+    int started = 0, rc = 0;
+    for (int i = 0; i < count && rc == 0; i++) {
+        if (!started) {
+            if (strcmp(segments[i].path, start_path) != 0) {
+                continue;
+            }
+            started = 1;
+            rc = export_file(st, segments[i].path, offset);
+        } else {
+            if (segments[i].start > st->to) {
+                break;
+            }
+            rc = export_file(st, segments[i].path, 0);
+        }
+    }
+    free(segments);
+    return rc < 0 ? -1 : 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--from EPOCH] [--to EPOCH] <binary_log> [output.csv]\n"
+                    "  <binary_log> is a binary log file or the log_file name of a segmented log\n",
+            prog);
+}
+
+int main(int argc, char *argv[]) {
+    static export_state_t st;
+    st.from = 0;
+    st.to = (time_t)LLONG_MAX;
+    st.cached_ts = (time_t)-1;
+
+    const char *input = NULL, *output = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+            st.from = (time_t)strtoll(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--to") == 0 && i + 1 < argc) {
+            st.to = (time_t)strtoll(argv[++i], NULL, 10);
+        } else if (!input) {
+            input = argv[i];
+        } else if (!output) {
+            output = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!input) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    st.out = stdout;
+    if (output) {
+        st.out = fopen(output, "w");
+        if (!st.out) {
+            perror("Opening output file");
+            return 1;
+        }
+    }
+    static char out_buf[1 << 16];
+    setvbuf(st.out, out_buf, _IOFBF, sizeof(out_buf));
+
+    int rc;
+    if (access(input, F_OK) == 0) {
+        // A single file; its index (if it is a segment) lets us skip ahead
+        uint64_t offset = st.from > 0 ? logseg_index_lookup(input, st.from) : 0;
+        rc = export_file(&st, input, offset) < 0 ? -1 : 0;
+    } else {
+        rc = export_segments(&st, input);
+    }
+
+    if (st.skipped > 0) {
+        fprintf(stderr, "Warning: skipped %zu records with out-of-range sensor ids\n", st.skipped);
+    }
+    if (fflush(st.out) != 0) {
+        perror("Writing output");
+        rc = -1;
+    }
+    if (st.out != stdout) {
+        fclose(st.out);
+    }
+    return rc == 0 ? 0 : 1;
+}